@@ -63,8 +63,21 @@ static void Cmd_FileCopyRelativePath(void *u) {
   explorer_state *e = GET_ACTIVE_EXPLORER();
   if (e) {
     fs_entry *entry = Explorer_GetSelected(e);
-    if (entry)
-      Platform_SetClipboard(entry->name); /* For now, just name */
+    if (entry) {
+      /* Relative to the open folder, from the full path (a recursive
+       * filter result's name may be truncated) */
+      const char *current = e->fs.current_path;
+      usize current_len = strlen(current);
+      const char *relative = entry->path;
+      if (current_len > 0 && strncmp(entry->path, current, current_len) == 0) {
+        if (FS_IsPathSeparator(current[current_len - 1])) {
+          relative = entry->path + current_len; /* Root folder */
+        } else if (FS_IsPathSeparator(entry->path[current_len])) {
+          relative = entry->path + current_len + 1;
+        }
+      }
+      Platform_SetClipboard(relative);
+    }
   }
 }
 
@@ -74,7 +87,7 @@ static void Cmd_FileCopyName(void *u) {
   if (e) {
     fs_entry *entry = Explorer_GetSelected(e);
     if (entry)
-      Platform_SetClipboard(entry->name);
+      Platform_SetClipboard(FS_GetFilename(entry->path));
   }
 }
 
@@ -174,6 +187,18 @@ static void Cmd_TerminalClear(void *u) {
   }
 }
 
+static void Cmd_TerminalFind(void *u) {
+  (void)u;
+  if (g_layout) {
+    panel *p = Layout_GetActivePanel(g_layout);
+    if (!p)
+      return;
+    if (!p->terminal.visible)
+      Layout_ToggleTerminal(g_layout);
+    TerminalPanel_OpenSearch(&p->terminal);
+  }
+}
+
 /* ===== Window & Layout ===== */
 
 void Cmd_ViewToggleSplit(void *u) {
@@ -226,6 +251,13 @@ static void Cmd_ToggleHiddenFiles(void *u) {
     Explorer_ToggleHidden(e);
 }
 
+static void Cmd_ViewToggleGrid(void *u) {
+  (void)u;
+  explorer_state *e = GET_ACTIVE_EXPLORER();
+  if (e)
+    Explorer_ToggleGridView(e);
+}
+
 static void Cmd_ToggleAnimations(void *u) {
   (void)u;
   g_animations_enabled = !g_animations_enabled;
@@ -238,6 +270,45 @@ static void Cmd_ViewTogglePreview(void *u) {
   }
 }
 
+static void Cmd_PreviewJumpToStart(void *u) {
+  (void)u;
+  if (g_layout) {
+    PreviewPanel_Jump(&g_layout->preview, WB_PREVIEW_JUMP_START, 0);
+  }
+}
+
+static void Cmd_PreviewJumpToEnd(void *u) {
+  (void)u;
+  if (g_layout) {
+    PreviewPanel_Jump(&g_layout->preview, WB_PREVIEW_JUMP_END, 0);
+  }
+}
+
+static void Cmd_PreviewToggleFollow(void *u) {
+  (void)u;
+  if (g_layout) {
+    PreviewPanel_ToggleFollow(&g_layout->preview);
+  }
+}
+
+/* Palette ':<line>' and ':0x<offset>' entries */
+static void Cmd_PreviewGoToPosition(void *u, u64 value, b32 is_offset) {
+  (void)u;
+  if (g_layout) {
+    PreviewPanel_Jump(&g_layout->preview,
+                      is_offset ? WB_PREVIEW_JUMP_OFFSET : WB_PREVIEW_JUMP_LINE,
+                      value);
+  }
+}
+
+/* Palette '#<bytes>' entries */
+static void Cmd_PreviewFindBytes(void *u, const u8 *pattern, usize length) {
+  (void)u;
+  if (g_layout) {
+    PreviewPanel_Find(&g_layout->preview, pattern, length);
+  }
+}
+
 /* ===== Sorting ===== */
 
 static void Cmd_SortByName(void *u) {
@@ -369,6 +440,8 @@ static const CommandDef g_commands[] = {
      Cmd_SortDescending},
     {"Terminal: Clear", "Ctrl + L", "Terminal", "reset console clear",
      Cmd_TerminalClear},
+    {"Terminal: Find", "Ctrl + Shift + F", "Terminal", "search scrollback find",
+     Cmd_TerminalFind},
     {"Terminal: Toggle", "`", "Terminal", "show hide console terminal",
      Cmd_TerminalToggle},
 
@@ -379,8 +452,16 @@ static const CommandDef g_commands[] = {
      Cmd_ViewFocusNextPane},
     {"View: Toggle Fullscreen", "F11", "View", "maximize fullscreen",
      Cmd_ViewToggleFullscreen},
+    {"View: Toggle Grid", "palette", "View",
+     "grid tiles thumbnails icons gallery list", Cmd_ViewToggleGrid},
     {"View: Toggle Preview", "palette", "View",
      "preview peek inspector side pane", Cmd_ViewTogglePreview},
+    {"Preview: Jump to Start", "palette", "View",
+     "preview top beginning first line", Cmd_PreviewJumpToStart},
+    {"Preview: Jump to End", "palette", "View",
+     "preview bottom last line tail", Cmd_PreviewJumpToEnd},
+    {"Preview: Toggle Follow", "palette", "View",
+     "preview tail follow live log watch", Cmd_PreviewToggleFollow},
     {"View: Toggle Split", "Ctrl + \\", "Layout", "divide panel dual split",
      Cmd_ViewToggleSplit},
 
@@ -402,4 +483,6 @@ void Commands_Register(command_palette_state *palette) {
     CommandPalette_RegisterCommand(palette, cmd->name, shortcut, cmd->category,
                                    cmd->tags, cmd->callback, NULL);
   }
+  palette->goto_position = Cmd_PreviewGoToPosition;
+  palette->find_bytes = Cmd_PreviewFindBytes;
 }
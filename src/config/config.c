@@ -72,6 +72,12 @@ static void SetDefaults(void) {
   Config_SetF64("ui.scroll_speed", 3.0);
   Config_SetBool("explorer.show_hidden", (b32) false);
   Config_SetBool("explorer.confirm_delete", (b32) true);
+  Config_SetBool("explorer.recursive_filter", (b32) false);
+  Config_SetBool("explorer.browse_archives", (b32) true);
+  Config_SetBool("explorer.grid_view", (b32) false);
+  Config_SetI64("explorer.grid.tile_size", 128);
+  Config_SetI64("explorer.grid.decode_threads", 0);
+  Config_SetI64("explorer.grid.max_bytes", 67108864);
   Config_SetString("explorer.start_directory", "~");
   Config_SetString("explorer.sort_type", "name");
   Config_SetString("explorer.sort_order", "ascending");
@@ -79,8 +85,21 @@ static void SetDefaults(void) {
   Config_SetF64("preview.width_ratio", 0.40);
   Config_SetI64("preview.text.max_bytes", 262144);
   Config_SetI64("preview.image.max_decode_bytes", 33554432);
-  Config_SetI64("preview.image.max_dimension", 4096);
+  Config_SetI64("preview.image.max_dimension", 8192);
+  Config_SetI64("preview.image.thumbnail_size", 1024);
+  Config_SetBool("preview.image.thumbnail_cache", true);
   Config_SetI64("preview.selection_debounce_ms", 60);
+  Config_SetI64("preview.prefetch_count", 2);
+  Config_SetI64("preview.workers", 2);
+  Config_SetBool("preview.syntax_highlight", true);
+  Config_SetI64("preview.directory.time_budget_ms", 2000);
+  Config_SetI64("preview.archive.max_member_bytes", 67108864);
+  Config_SetBool("preview.follow", (b32) true);
+  Config_SetI64("preview.cache.max_bytes", 67108864);
+  Config_SetI64("search.max_file_bytes", 16777216);
+  Config_SetBool("search.index.enabled", (b32) false);
+  Config_SetI64("search.index.max_memory_bytes", 268435456);
+  Config_SetI64("search.index.max_disk_bytes", 1073741824);
   Config_SetI64("terminal.font_size", 14);
   Config_SetI64("terminal.scrollback_lines", 10000);
 
@@ -101,16 +101,53 @@ static const char *DEFAULT_CONFIG_CONTENT =
     "# Explorer\n"
     "explorer.show_hidden = false\n"
     "explorer.confirm_delete = true\n"
+    "# Quick filter matches names in the whole subtree, not just the folder\n"
+    "explorer.recursive_filter = false\n"
+    "# Open zip archives (.zip, .jar, ...) like read-only folders\n"
+    "explorer.browse_archives = true\n"
+    "# Thumbnail grid instead of the list (View: Toggle Grid)\n"
+    "explorer.grid_view = false\n"
+    "explorer.grid.tile_size = 128\n"
+    "# Thumbnail decoders (0 = half the processors)\n"
+    "explorer.grid.decode_threads = 0\n"
+    "# Memory for decoded thumbnails, per panel\n"
+    "explorer.grid.max_bytes = 67108864\n"
     "# Used at startup when no path arguments are passed\n"
     "explorer.start_directory = ~\n"
     "\n"
     "# Preview\n"
     "preview.enabled = false\n"
     "preview.width_ratio = 0.40\n"
+    "# Larger text files are memory-mapped and indexed on demand\n"
     "preview.text.max_bytes = 262144\n"
     "preview.image.max_decode_bytes = 33554432\n"
-    "preview.image.max_dimension = 4096\n"
+    "preview.image.max_dimension = 8192\n"
+    "# Decoded images are shrunk to fit this box (or the preview if larger)\n"
+    "preview.image.thumbnail_size = 1024\n"
+    "# Share thumbnails with other apps through ~/.cache/thumbnails\n"
+    "preview.image.thumbnail_cache = true\n"
     "preview.selection_debounce_ms = 60\n"
+    "# Neighbours loaded ahead of the selection while navigating (0 = off)\n"
+    "preview.prefetch_count = 2\n"
+    "# Threads loading previews; a stale load stops early (1-4)\n"
+    "preview.workers = 2\n"
+    "# Colour source files (C, Python, JS, shell, JSON, YAML, Markdown)\n"
+    "preview.syntax_highlight = true\n"
+    "# Time a folder summary may spend counting children\n"
+    "preview.directory.time_budget_ms = 2000\n"
+    "# Largest zip member inflated in memory to preview it\n"
+    "preview.archive.max_member_bytes = 67108864\n"
+    "# Keep previewed text files live as they grow (tail -f)\n"
+    "preview.follow = true\n"
+    "# Memory kept for recently shown previews (LRU)\n"
+    "preview.cache.max_bytes = 67108864\n"
+    "\n"
+    "# Content search (type / in the file palette)\n"
+    "search.max_file_bytes = 16777216\n"
+    "# Trigram index for large trees (stored in the user cache directory)\n"
+    "search.index.enabled = false\n"
+    "search.index.max_memory_bytes = 268435456\n"
+    "search.index.max_disk_bytes = 1073741824\n"
     "\n"
     "# Terminal\n"
     "terminal.font_size = 14\n"
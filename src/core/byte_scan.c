@@ -0,0 +1,231 @@
+/*
+ * byte_scan.c - Vectorized byte scanning implementation
+ *
+ * The literal finder is the "generic SIMD" substring search: compare a block
+ * of candidate positions against the first and last needle byte at once and
+ * only verify positions where both agree.
+ * C99, handmade hero style.
+ */
+
+#include "byte_scan.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BYTE_SCAN_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BYTE_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* ===== Internal Helpers ===== */
+
+static inline u8 ByteScan_Lower(u8 c) {
+  return (c >= 'A' && c <= 'Z') ? (u8)(c + 32) : c;
+}
+
+static inline b32 ByteScan_IsAlpha(u8 c) {
+  c = ByteScan_Lower(c);
+  return c >= 'a' && c <= 'z';
+}
+
+static b32 ByteScan_Equal(const u8 *a, const u8 *b, usize len,
+                          b32 ignore_case) {
+  if (!ignore_case) {
+    return memcmp(a, b, len) == 0;
+  }
+  for (usize i = 0; i < len; i++) {
+    if (ByteScan_Lower(a[i]) != ByteScan_Lower(b[i]))
+      return false;
+  }
+  return true;
+}
+
+#if defined(BYTE_SCAN_SSE2)
+static inline u32 ByteScan_LowestBit(u32 mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (u32)index;
+#else
+  return (u32)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+/* ===== Public API ===== */
+
+isize ByteScan_FindLiteral(const u8 *haystack, usize haystack_len,
+                           const u8 *needle, usize needle_len,
+                           b32 ignore_case) {
+  if (needle_len == 0)
+    return 0;
+  if (!haystack || haystack_len < needle_len)
+    return -1;
+
+  u8 first = needle[0];
+  u8 last = needle[needle_len - 1];
+  /* Case folding by OR-ing 0x20 is only valid for letters; non-letters may
+   * produce false candidates, which the verify step rejects. */
+  u8 first_fold = (ignore_case && ByteScan_IsAlpha(first)) ? 0x20 : 0;
+  u8 last_fold = (ignore_case && ByteScan_IsAlpha(last)) ? 0x20 : 0;
+  if (first_fold)
+    first = ByteScan_Lower(first);
+  if (last_fold)
+    last = ByteScan_Lower(last);
+
+  usize last_start = haystack_len - needle_len; /* Last valid match offset */
+  usize i = 0;
+
+#if defined(BYTE_SCAN_SSE2)
+  {
+    __m128i v_first = _mm_set1_epi8((char)first);
+    __m128i v_last = _mm_set1_epi8((char)last);
+    __m128i v_first_fold = _mm_set1_epi8((char)first_fold);
+    __m128i v_last_fold = _mm_set1_epi8((char)last_fold);
+
+    for (; i + 16 <= last_start + 1; i += 16) {
+      __m128i block_first =
+          _mm_loadu_si128((const __m128i *)(haystack + i));
+      __m128i block_last =
+          _mm_loadu_si128((const __m128i *)(haystack + i + needle_len - 1));
+      block_first = _mm_or_si128(block_first, v_first_fold);
+      block_last = _mm_or_si128(block_last, v_last_fold);
+
+      __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(block_first, v_first),
+                                 _mm_cmpeq_epi8(block_last, v_last));
+      u32 mask = (u32)_mm_movemask_epi8(eq);
+
+      while (mask) {
+        u32 bit = ByteScan_LowestBit(mask);
+        if (ByteScan_Equal(haystack + i + bit, needle, needle_len,
+                           ignore_case)) {
+          return (isize)(i + bit);
+        }
+        mask &= mask - 1;
+      }
+    }
+  }
+#elif defined(BYTE_SCAN_NEON)
+  {
+    uint8x16_t v_first = vdupq_n_u8(first);
+    uint8x16_t v_last = vdupq_n_u8(last);
+    uint8x16_t v_first_fold = vdupq_n_u8(first_fold);
+    uint8x16_t v_last_fold = vdupq_n_u8(last_fold);
+
+    for (; i + 16 <= last_start + 1; i += 16) {
+      uint8x16_t block_first = vorrq_u8(vld1q_u8(haystack + i), v_first_fold);
+      uint8x16_t block_last =
+          vorrq_u8(vld1q_u8(haystack + i + needle_len - 1), v_last_fold);
+      uint8x16_t eq = vandq_u8(vceqq_u8(block_first, v_first),
+                               vceqq_u8(block_last, v_last));
+
+      if (vmaxvq_u8(eq) == 0)
+        continue;
+
+      for (usize k = 0; k < 16; k++) {
+        if (ByteScan_Equal(haystack + i + k, needle, needle_len,
+                           ignore_case)) {
+          return (isize)(i + k);
+        }
+      }
+    }
+  }
+#endif
+
+  /* Scalar tail (and the whole scan without SIMD) */
+  for (; i <= last_start; i++) {
+    u8 c = haystack[i] | first_fold;
+    if (c != first)
+      continue;
+    if ((u8)(haystack[i + needle_len - 1] | last_fold) != last)
+      continue;
+    if (ByteScan_Equal(haystack + i, needle, needle_len, ignore_case))
+      return (isize)i;
+  }
+
+  return -1;
+}
+
+usize ByteScan_CountByte(const u8 *data, usize len, u8 value) {
+  usize count = 0;
+  usize i = 0;
+
+#if defined(BYTE_SCAN_SSE2)
+  {
+    __m128i v_value = _mm_set1_epi8((char)value);
+    while (i + 16 <= len) {
+      /* Accumulate per-lane counts for up to 255 blocks before widening */
+      __m128i acc = _mm_setzero_si128();
+      usize blocks = Min((len - i) / 16, (usize)255);
+      for (usize b = 0; b < blocks; b++, i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+        acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(block, v_value));
+      }
+      __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+      count += (usize)_mm_cvtsi128_si32(sums) +
+               (usize)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+  }
+#elif defined(BYTE_SCAN_NEON)
+  {
+    uint8x16_t v_value = vdupq_n_u8(value);
+    while (i + 16 <= len) {
+      uint8x16_t acc = vdupq_n_u8(0);
+      usize blocks = Min((len - i) / 16, (usize)255);
+      for (usize b = 0; b < blocks; b++, i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(data + i), v_value);
+        acc = vsubq_u8(acc, eq);
+      }
+      count += (usize)vaddlvq_u8(acc);
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    count += (data[i] == value);
+  }
+  return count;
+}
+
+b32 ByteScan_HasNul(const u8 *data, usize len) {
+  return len > 0 && memchr(data, 0, len) != NULL;
+}
+
+usize ByteScan_PrintableRun(const u8 *data, usize len) {
+  usize i = 0;
+
+#if defined(BYTE_SCAN_SSE2)
+  {
+    /* Signed compares: high-bit bytes are negative, so they fail > 0x1F */
+    __m128i v_low = _mm_set1_epi8(0x1F);
+    __m128i v_high = _mm_set1_epi8(0x7F);
+    for (; i + 16 <= len; i += 16) {
+      __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, v_low),
+                                        _mm_cmplt_epi8(block, v_high));
+      u32 mask = (u32)_mm_movemask_epi8(printable);
+      if (mask != 0xFFFF)
+        return i + ByteScan_LowestBit(~mask);
+    }
+  }
+#elif defined(BYTE_SCAN_NEON)
+  {
+    /* c - 0x20 < 0x5F (unsigned) exactly for printable bytes */
+    uint8x16_t v_space = vdupq_n_u8(0x20);
+    uint8x16_t v_span = vdupq_n_u8(0x5F);
+    for (; i + 16 <= len; i += 16) {
+      uint8x16_t printable =
+          vcltq_u8(vsubq_u8(vld1q_u8(data + i), v_space), v_span);
+      if (vminvq_u8(printable) != 0xFF)
+        break; /* The scalar loop finds the byte within this block */
+    }
+  }
+#endif
+
+  while (i < len && data[i] >= 0x20 && data[i] < 0x7F) {
+    i++;
+  }
+  return i;
+}
@@ -0,0 +1,32 @@
+/*
+ * byte_scan.h - Vectorized byte scanning primitives
+ *
+ * memchr/memmem-style helpers used by content search and other hot loops
+ * over large buffers. Uses SSE2 on x86-64 and NEON on AArch64, with a scalar
+ * fallback elsewhere.
+ * C99, handmade hero style.
+ */
+
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+
+#include "types.h"
+
+/* Find the first occurrence of 'needle' in 'haystack'.
+ * ignore_case folds ASCII letters only.
+ * Returns the byte offset of the match, or -1 if not found. */
+isize ByteScan_FindLiteral(const u8 *haystack, usize haystack_len,
+                           const u8 *needle, usize needle_len,
+                           b32 ignore_case);
+
+/* Count occurrences of 'value' in data (e.g. newlines) */
+usize ByteScan_CountByte(const u8 *data, usize len, u8 value);
+
+/* Returns true if data contains a NUL byte (binary file heuristic) */
+b32 ByteScan_HasNul(const u8 *data, usize len);
+
+/* Length of the run of printable ASCII (0x20-0x7E) at the start of data:
+ * stops at the first control, DEL or high-bit byte */
+usize ByteScan_PrintableRun(const u8 *data, usize len);
+
+#endif /* BYTE_SCAN_H */
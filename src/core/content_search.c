@@ -0,0 +1,574 @@
+/*
+ * content_search.c - Parallel file content search implementation
+ *
+ * Workers share one stack of pending paths. A directory item is enumerated
+ * and its children pushed back on the stack; a file item is mapped and
+ * scanned. Every item carries the generation it was queued for, so a new
+ * search simply bumps the generation and stale work is dropped as soon as a
+ * worker notices.
+ * C99, handmade hero style.
+ */
+
+#include "content_search.h"
+#include "../platform/platform.h"
+#include "byte_scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+extern void *Platform_CreateCondVar(void);
+extern void Platform_CondWait(void *cond, void *mutex);
+extern void Platform_CondBroadcast(void *cond);
+extern i32 Platform_GetProcessorCount(void);
+
+/* ===== Configuration ===== */
+
+#define CONTENT_SEARCH_BINARY_PROBE Kilobytes(8) /* NUL check window */
+#define CONTENT_SEARCH_CHUNK_SIZE Megabytes(4)   /* Cancellation granularity */
+
+/* ===== Types ===== */
+
+typedef enum {
+  CONTENT_SEARCH_ITEM_FILE = 0,
+  CONTENT_SEARCH_ITEM_DIRECTORY,         /* Walk recursively */
+  CONTENT_SEARCH_ITEM_CHANGED_DIRECTORY, /* Only what the index missed */
+} content_search_item_kind;
+
+struct content_search_work_item {
+  content_search_work_item *next;
+  u32 generation;
+  content_search_item_kind kind;
+  char path[1]; /* Allocated to fit */
+};
+
+/* Work items collected before they are pushed with a single lock */
+typedef struct {
+  const char *parent;
+  u32 generation;
+  trigram_index *index; /* Set when rescanning a changed directory */
+  content_search_work_item *head;
+  content_search_work_item *tail;
+} content_search_dir_batch;
+
+/* Per-file scan state of one worker */
+typedef struct {
+  content_search_state *search;
+  u32 generation;
+  const char *path;
+  i64 path_offset; /* -1 until the first hit stores the path */
+  const char *query;
+  usize query_len;
+  b32 ignore_case;
+} content_search_file_ctx;
+
+/* ===== Internal Helpers ===== */
+
+static content_search_work_item *
+ContentSearch_NewItem(const char *path, u32 generation,
+                      content_search_item_kind kind) {
+  usize len = strlen(path);
+  content_search_work_item *item = (content_search_work_item *)malloc(
+      sizeof(content_search_work_item) + len);
+  if (!item)
+    return NULL;
+  item->next = NULL;
+  item->generation = generation;
+  item->kind = kind;
+  memcpy(item->path, path, len + 1);
+  return item;
+}
+
+static void ContentSearch_FreeItems(content_search_work_item *item) {
+  while (item) {
+    content_search_work_item *next = item->next;
+    free(item);
+    item = next;
+  }
+}
+
+/* Called with the mutex held */
+static b32 ContentSearch_IsStale(content_search_state *search,
+                                 u32 generation) {
+  return search->shutdown_requested || search->generation != generation;
+}
+
+static b32 ContentSearch_CheckStale(content_search_state *search,
+                                    u32 generation) {
+  Platform_LockMutex(search->mutex);
+  b32 stale = ContentSearch_IsStale(search, generation);
+  Platform_UnlockMutex(search->mutex);
+  return stale;
+}
+
+static b32 ContentSearch_BatchAdd(content_search_dir_batch *batch,
+                                  const char *path,
+                                  content_search_item_kind kind) {
+  content_search_work_item *item =
+      ContentSearch_NewItem(path, batch->generation, kind);
+  if (!item)
+    return false;
+
+  if (batch->tail) {
+    batch->tail->next = item;
+  } else {
+    batch->head = item;
+  }
+  batch->tail = item;
+  return true;
+}
+
+static b32 ContentSearch_CollectChild(void *user_data, const char *name,
+                                      file_type type) {
+  content_search_dir_batch *batch = (content_search_dir_batch *)user_data;
+
+  /* Hidden entries (.git, .cache, ...) and symlinks (cycles) are skipped */
+  if (name[0] == '.')
+    return true;
+  if (type != WB_FILE_TYPE_DIRECTORY && type != WB_FILE_TYPE_FILE)
+    return true;
+
+  char path[FS_MAX_PATH];
+  FS_JoinPath(path, sizeof(path), batch->parent, name);
+
+  if (batch->index) {
+    /* Changed directory: the index already answered for unchanged files
+     * and for folders it knows (those are marked on their own) */
+    if (type == WB_FILE_TYPE_DIRECTORY) {
+      if (TrigramIndex_HasDirectory(batch->index, path))
+        return true;
+    } else {
+      file_info info;
+      if (Platform_GetFileInfo(path, &info) &&
+          TrigramIndex_IsFileCurrent(batch->index, path, info.size,
+                                     info.modified_time))
+        return true;
+    }
+  }
+
+  return ContentSearch_BatchAdd(batch, path,
+                                type == WB_FILE_TYPE_DIRECTORY
+                                    ? CONTENT_SEARCH_ITEM_DIRECTORY
+                                    : CONTENT_SEARCH_ITEM_FILE);
+}
+
+/* Queue a candidate returned by the trigram index */
+static b32 ContentSearch_CollectCandidate(void *user_data, const char *path,
+                                          trigram_index_candidate_kind kind) {
+  content_search_dir_batch *batch = (content_search_dir_batch *)user_data;
+  return ContentSearch_BatchAdd(batch, path,
+                                kind == TRIGRAM_INDEX_CANDIDATE_CHANGED_DIR
+                                    ? CONTENT_SEARCH_ITEM_CHANGED_DIRECTORY
+                                    : CONTENT_SEARCH_ITEM_FILE);
+}
+
+static void ContentSearch_ProcessDirectory(content_search_state *search,
+                                           content_search_work_item *item,
+                                           trigram_index *index) {
+  content_search_dir_batch batch = {0};
+  batch.parent = item->path;
+  batch.generation = item->generation;
+  if (item->kind == CONTENT_SEARCH_ITEM_CHANGED_DIRECTORY) {
+    batch.index = index;
+  }
+  Platform_EnumerateDirectory(item->path, ContentSearch_CollectChild, &batch);
+
+  if (!batch.head)
+    return;
+
+  /* Splice the whole batch onto the stack with a single lock */
+  Platform_LockMutex(search->mutex);
+  if (ContentSearch_IsStale(search, item->generation)) {
+    Platform_UnlockMutex(search->mutex);
+    ContentSearch_FreeItems(batch.head);
+    return;
+  }
+  batch.tail->next = search->work_stack;
+  search->work_stack = batch.head;
+  Platform_CondBroadcast(search->work_cond);
+  Platform_UnlockMutex(search->mutex);
+}
+
+/* Copy a line into a snippet, keeping the match visible and replacing
+ * control characters so the label renders on one line */
+static void ContentSearch_MakeSnippet(char *out, usize out_size,
+                                      const u8 *line, usize line_len,
+                                      usize column) {
+  usize start = 0;
+  while (start < line_len && start < column &&
+         (line[start] == ' ' || line[start] == '\t'))
+    start++;
+
+  /* Long line: start a little before the match instead */
+  if (column > start + out_size / 2) {
+    start = column - out_size / 4;
+  }
+
+  usize written = 0;
+  for (usize i = start; i < line_len && written + 1 < out_size; i++) {
+    u8 c = line[i];
+    out[written++] = (c < 0x20 || c == 0x7F) ? ' ' : (char)c;
+  }
+  while (written > 0 && (out[written - 1] == ' ' || out[written - 1] == '\r'))
+    written--;
+  out[written] = '\0';
+}
+
+/* Record one hit. Returns false when the search is stale or full. */
+static b32 ContentSearch_AddHit(content_search_file_ctx *ctx, u32 line,
+                                u32 column, const char *snippet) {
+  content_search_state *search = ctx->search;
+  b32 keep_going = true;
+
+  Platform_LockMutex(search->mutex);
+  if (ContentSearch_IsStale(search, ctx->generation)) {
+    keep_going = false;
+  } else {
+    if (ctx->path_offset < 0) {
+      usize path_size = strlen(ctx->path) + 1;
+      if (search->path_pool_used + path_size <= CONTENT_SEARCH_PATH_POOL_SIZE) {
+        ctx->path_offset = search->path_pool_used;
+        memcpy(search->path_pool + search->path_pool_used, ctx->path,
+               path_size);
+        search->path_pool_used += (u32)path_size;
+        search->files_matched++;
+      }
+    }
+
+    if (ctx->path_offset < 0 ||
+        search->hit_count >= CONTENT_SEARCH_MAX_HITS) {
+      search->truncated = true;
+      keep_going = false;
+    } else {
+      content_search_hit *hit = &search->hits[search->hit_count];
+      hit->path_offset = (u32)ctx->path_offset;
+      hit->line = line;
+      hit->column = column;
+      memcpy(hit->snippet, snippet, sizeof(hit->snippet));
+      search->hit_count++;
+    }
+  }
+  Platform_UnlockMutex(search->mutex);
+  return keep_going;
+}
+
+/* Scan a mapped file, one hit per matching line */
+static void ContentSearch_ScanBuffer(content_search_file_ctx *ctx,
+                                     const u8 *data, usize size) {
+  usize pos = 0;
+  usize counted_to = 0; /* Newlines before this offset are in 'line' */
+  u32 line = 1;
+
+  while (pos < size) {
+    usize chunk_end = Min(size, pos + CONTENT_SEARCH_CHUNK_SIZE);
+    /* Let a match straddle the chunk boundary */
+    usize scan_end = Min(size, chunk_end + ctx->query_len - 1);
+
+    isize found = ByteScan_FindLiteral(data + pos, scan_end - pos,
+                                       (const u8 *)ctx->query, ctx->query_len,
+                                       ctx->ignore_case);
+    if (found < 0) {
+      pos = chunk_end;
+      if (pos < size && ContentSearch_CheckStale(ctx->search, ctx->generation))
+        return;
+      continue;
+    }
+
+    usize match = pos + (usize)found;
+
+    usize line_start = match;
+    while (line_start > pos && data[line_start - 1] != '\n')
+      line_start--;
+    if (line_start == pos && pos > 0 && data[pos - 1] != '\n') {
+      /* Only reachable after a chunk boundary inside a long line */
+      while (line_start > 0 && data[line_start - 1] != '\n')
+        line_start--;
+    }
+
+    const u8 *newline =
+        (const u8 *)memchr(data + match, '\n', size - match);
+    usize line_end = newline ? (usize)(newline - data) : size;
+
+    line += (u32)ByteScan_CountByte(data + counted_to, line_start - counted_to,
+                                    '\n');
+    counted_to = line_start;
+
+    char snippet[CONTENT_SEARCH_SNIPPET_SIZE];
+    ContentSearch_MakeSnippet(snippet, sizeof(snippet), data + line_start,
+                              line_end - line_start, match - line_start);
+
+    if (!ContentSearch_AddHit(ctx, line, (u32)(match - line_start), snippet))
+      return;
+
+    pos = line_end + 1;
+  }
+}
+
+static void ContentSearch_ProcessFile(content_search_state *search,
+                                      content_search_work_item *item,
+                                      const char *query, b32 ignore_case,
+                                      u64 max_file_bytes) {
+  platform_file_map map;
+  if (!Platform_MapFile(item->path, &map))
+    return;
+
+  b32 binary = false;
+  if (map.size > 0 && map.size <= max_file_bytes) {
+    usize probe = (usize)Min(map.size, (u64)CONTENT_SEARCH_BINARY_PROBE);
+    binary = ByteScan_HasNul(map.data, probe);
+    if (!binary) {
+      content_search_file_ctx ctx = {0};
+      ctx.search = search;
+      ctx.generation = item->generation;
+      ctx.path = item->path;
+      ctx.path_offset = -1;
+      ctx.query = query;
+      ctx.query_len = strlen(query);
+      ctx.ignore_case = ignore_case;
+      ContentSearch_ScanBuffer(&ctx, map.data, (usize)map.size);
+    }
+  }
+
+  Platform_LockMutex(search->mutex);
+  if (!ContentSearch_IsStale(search, item->generation)) {
+    if (binary) {
+      search->binary_skipped++;
+    } else if (map.size <= max_file_bytes) {
+      search->files_scanned++;
+      search->bytes_scanned += map.size;
+    }
+  }
+  Platform_UnlockMutex(search->mutex);
+
+  Platform_UnmapFile(&map);
+}
+
+static void *ContentSearch_WorkerThread(void *arg) {
+  content_search_state *search = (content_search_state *)arg;
+  char query[CONTENT_SEARCH_MAX_QUERY];
+
+  Platform_LockMutex(search->mutex);
+  for (;;) {
+    while (!search->shutdown_requested && !search->work_stack) {
+      Platform_CondWait(search->work_cond, search->mutex);
+    }
+    if (search->shutdown_requested)
+      break;
+
+    content_search_work_item *item = search->work_stack;
+    search->work_stack = item->next;
+    item->next = NULL;
+
+    /* Items are only queued for the current generation */
+    memcpy(query, search->query, sizeof(query));
+    b32 ignore_case = search->ignore_case;
+    u64 max_file_bytes = search->max_file_bytes;
+    trigram_index *index = search->index;
+    search->busy_workers++;
+    Platform_UnlockMutex(search->mutex);
+
+    if (item->kind != CONTENT_SEARCH_ITEM_FILE) {
+      ContentSearch_ProcessDirectory(search, item, index);
+    } else {
+      ContentSearch_ProcessFile(search, item, query, ignore_case,
+                                max_file_bytes);
+    }
+    free(item);
+
+    Platform_LockMutex(search->mutex);
+    search->busy_workers--;
+    if (search->busy_workers == 0 && !search->work_stack &&
+        search->finished_ms == 0) {
+      search->finished_ms = Platform_GetTimeMs();
+    }
+  }
+  Platform_UnlockMutex(search->mutex);
+  return NULL;
+}
+
+static b32 ContentSearch_StartWorkers(content_search_state *search) {
+  if (search->worker_count > 0)
+    return true;
+
+  search->hits = (content_search_hit *)malloc(sizeof(content_search_hit) *
+                                              CONTENT_SEARCH_MAX_HITS);
+  search->path_pool = (char *)malloc(CONTENT_SEARCH_PATH_POOL_SIZE);
+  search->mutex = Platform_CreateMutex();
+  search->work_cond = Platform_CreateCondVar();
+  if (!search->hits || !search->path_pool || !search->mutex ||
+      !search->work_cond) {
+    return false;
+  }
+
+  /* Leave a core for the UI thread */
+  i32 count = Clamp(Platform_GetProcessorCount() - 1, 1,
+                    CONTENT_SEARCH_MAX_WORKERS);
+  for (i32 i = 0; i < count; i++) {
+    void *thread = Platform_CreateThread(ContentSearch_WorkerThread, search);
+    if (!thread)
+      break;
+    search->workers[search->worker_count++] = thread;
+  }
+  return search->worker_count > 0;
+}
+
+/* Called with the mutex held */
+static void ContentSearch_ResetLocked(content_search_state *search) {
+  search->generation++;
+  ContentSearch_FreeItems(search->work_stack);
+  search->work_stack = NULL;
+  search->hit_count = 0;
+  search->path_pool_used = 0;
+  search->truncated = false;
+  search->files_scanned = 0;
+  search->bytes_scanned = 0;
+  search->binary_skipped = 0;
+  search->files_matched = 0;
+  search->used_index = false;
+  search->started_ms = Platform_GetTimeMs();
+  search->finished_ms = 0;
+}
+
+/* ===== Public API ===== */
+
+void ContentSearch_Init(content_search_state *search) {
+  memset(search, 0, sizeof(*search));
+}
+
+void ContentSearch_Shutdown(content_search_state *search) {
+  if (!search->mutex || !search->work_cond)
+    return;
+
+  /* Workers may still be inside a file, so the shared buffers are left
+   * allocated (same as the preview worker) */
+  Platform_LockMutex(search->mutex);
+  ContentSearch_ResetLocked(search);
+  search->shutdown_requested = true;
+  Platform_CondBroadcast(search->work_cond);
+  Platform_UnlockMutex(search->mutex);
+
+  for (i32 i = 0; i < search->worker_count; i++) {
+    Platform_DestroyThread(search->workers[i]);
+    search->workers[i] = NULL;
+  }
+}
+
+void ContentSearch_SetIndex(content_search_state *search,
+                            trigram_index *index) {
+  if (search->mutex) {
+    Platform_LockMutex(search->mutex);
+    search->index = index;
+    Platform_UnlockMutex(search->mutex);
+  } else {
+    search->index = index;
+  }
+}
+
+void ContentSearch_Start(content_search_state *search, const char *root,
+                         const char *query, u64 max_file_bytes) {
+  if (!root || !query || query[0] == '\0') {
+    ContentSearch_Cancel(search);
+    return;
+  }
+  if (search->shutdown_requested || !ContentSearch_StartWorkers(search))
+    return;
+
+  /* Ask the index first, outside our lock. Only this thread changes the
+   * generation, so the items can be tagged with the next one up front. */
+  content_search_dir_batch candidates = {0};
+  candidates.generation = search->generation + 1;
+  b32 indexed = search->index &&
+                TrigramIndex_Query(search->index, root, query,
+                                   ContentSearch_CollectCandidate, &candidates);
+  if (!indexed) {
+    ContentSearch_FreeItems(candidates.head);
+    candidates.head = NULL;
+  }
+
+  Platform_LockMutex(search->mutex);
+  ContentSearch_ResetLocked(search);
+
+  snprintf(search->root, sizeof(search->root), "%s", root);
+  snprintf(search->query, sizeof(search->query), "%s", query);
+  search->max_file_bytes = max_file_bytes;
+
+  /* Smart case: any uppercase letter makes the search case-sensitive */
+  search->ignore_case = true;
+  for (const char *c = search->query; *c; c++) {
+    if (*c >= 'A' && *c <= 'Z') {
+      search->ignore_case = false;
+      break;
+    }
+  }
+
+  if (indexed) {
+    search->used_index = true;
+    search->work_stack = candidates.head;
+  } else {
+    search->work_stack = ContentSearch_NewItem(
+        search->root, search->generation, CONTENT_SEARCH_ITEM_DIRECTORY);
+  }
+
+  if (search->work_stack) {
+    Platform_CondBroadcast(search->work_cond);
+  } else {
+    search->finished_ms = search->started_ms; /* Nothing to scan */
+  }
+  Platform_UnlockMutex(search->mutex);
+}
+
+void ContentSearch_Cancel(content_search_state *search) {
+  if (!search->mutex)
+    return;
+  Platform_LockMutex(search->mutex);
+  ContentSearch_ResetLocked(search);
+  search->query[0] = '\0';
+  Platform_UnlockMutex(search->mutex);
+}
+
+content_search_status ContentSearch_GetStatus(content_search_state *search) {
+  content_search_status status = {0};
+  if (!search->mutex)
+    return status;
+
+  Platform_LockMutex(search->mutex);
+  status.hit_count = search->hit_count;
+  status.files_scanned = search->files_scanned;
+  status.files_matched = search->files_matched;
+  status.binary_skipped = search->binary_skipped;
+  status.truncated = search->truncated;
+  status.running = search->query[0] != '\0' && search->finished_ms == 0;
+  status.used_index = search->used_index;
+  status.elapsed_ms =
+      (search->finished_ms ? search->finished_ms : Platform_GetTimeMs()) -
+      search->started_ms;
+  Platform_UnlockMutex(search->mutex);
+  return status;
+}
+
+b32 ContentSearch_GetHit(content_search_state *search, i32 index,
+                         content_search_hit *out_hit, char *out_path,
+                         usize out_path_size) {
+  if (!search->mutex)
+    return false;
+
+  b32 found = false;
+  Platform_LockMutex(search->mutex);
+  if (index >= 0 && index < search->hit_count) {
+    content_search_hit *hit = &search->hits[index];
+    if (out_hit)
+      *out_hit = *hit;
+    if (out_path && out_path_size > 0)
+      snprintf(out_path, out_path_size, "%s",
+               search->path_pool + hit->path_offset);
+    found = true;
+  }
+  Platform_UnlockMutex(search->mutex);
+  return found;
+}
@@ -0,0 +1,119 @@
+/*
+ * content_search.h - Parallel file content search (grep)
+ *
+ * Walks a directory tree on a pool of worker threads, memory-maps each file
+ * and scans it with the vectorized literal finder. Hits stream into a shared
+ * buffer that the UI polls every frame; starting a new search cancels the
+ * previous one. With a trigram index attached, only the candidate files it
+ * returns (plus changed folders) are scanned instead of the whole tree.
+ * C99, handmade hero style.
+ */
+
+#ifndef CONTENT_SEARCH_H
+#define CONTENT_SEARCH_H
+
+#include "fs.h"
+#include "trigram_index.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define CONTENT_SEARCH_MAX_WORKERS 8
+#define CONTENT_SEARCH_MAX_HITS 1024
+#define CONTENT_SEARCH_MAX_QUERY 256
+#define CONTENT_SEARCH_SNIPPET_SIZE 160
+#define CONTENT_SEARCH_PATH_POOL_SIZE Kilobytes(256)
+
+/* ===== Types ===== */
+
+typedef struct {
+  u32 path_offset; /* Full path, offset into the path pool */
+  u32 line;        /* 1-based line number */
+  u32 column;      /* 0-based byte column of the match */
+  char snippet[CONTENT_SEARCH_SNIPPET_SIZE]; /* Matching line, sanitized */
+} content_search_hit;
+
+typedef struct content_search_work_item content_search_work_item;
+
+typedef struct {
+  /* Guards everything below except the immutable worker handles */
+  void *mutex;
+  void *work_cond;
+  void *workers[CONTENT_SEARCH_MAX_WORKERS];
+  i32 worker_count;
+  b32 shutdown_requested;
+
+  /* Current search (a new generation cancels the previous one) */
+  u32 generation;
+  char root[FS_MAX_PATH];
+  char query[CONTENT_SEARCH_MAX_QUERY];
+  b32 ignore_case;
+  u64 max_file_bytes;
+  trigram_index *index; /* Optional, narrows the files to scan */
+  b32 used_index;       /* Current search came from the index */
+  u64 started_ms;
+  u64 finished_ms; /* 0 while running */
+
+  /* Pending directories and files (LIFO keeps the walk depth-first) */
+  content_search_work_item *work_stack;
+  i32 busy_workers;
+
+  /* Results. Entries below hit_count never change within a generation. */
+  content_search_hit *hits;
+  i32 hit_count;
+  char *path_pool;
+  u32 path_pool_used;
+  b32 truncated; /* Hit or path storage ran out */
+
+  /* Counters */
+  u64 files_scanned;
+  u64 bytes_scanned;
+  u64 binary_skipped;
+  u64 files_matched;
+} content_search_state;
+
+/* Snapshot of the search progress for the UI */
+typedef struct {
+  i32 hit_count;
+  u64 files_scanned;
+  u64 files_matched;
+  u64 binary_skipped;
+  b32 running;
+  b32 truncated;
+  b32 used_index;
+  u64 elapsed_ms; /* Since start, frozen once the search finishes */
+} content_search_status;
+
+/* ===== Content Search API =====
+ * Init/Start/Cancel/Shutdown must be called from a single (UI) thread.
+ */
+
+/* Initialize state. Worker threads are created on the first search. */
+void ContentSearch_Init(content_search_state *search);
+
+/* Stop the workers. Threads exit after finishing their current file. */
+void ContentSearch_Shutdown(content_search_state *search);
+
+/* Attach a trigram index used by the following searches (NULL to scan).
+ * The index must outlive the search state. */
+void ContentSearch_SetIndex(content_search_state *search, trigram_index *index);
+
+/* Start searching every file below 'root' for 'query' (a literal string).
+ * Lowercase queries match case-insensitively (smart case). Files larger
+ * than max_file_bytes and files that look binary are skipped. Any search
+ * already running is cancelled. */
+void ContentSearch_Start(content_search_state *search, const char *root,
+                         const char *query, u64 max_file_bytes);
+
+/* Cancel the running search and drop its results */
+void ContentSearch_Cancel(content_search_state *search);
+
+/* Current progress */
+content_search_status ContentSearch_GetStatus(content_search_state *search);
+
+/* Access a hit below status.hit_count. Returns false if out of range. */
+b32 ContentSearch_GetHit(content_search_state *search, i32 index,
+                         content_search_hit *out_hit, char *out_path,
+                         usize out_path_size);
+
+#endif /* CONTENT_SEARCH_H */
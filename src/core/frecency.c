@@ -0,0 +1,433 @@
+/*
+ * frecency.c - Frecency database implementation
+ *
+ * Log format, one record per line:
+ *   v <time> <path>          visit: rank += 1, last visit = time
+ *   s <rank> <time> <path>   snapshot of one entry (written by compaction)
+ * Replaying the log reproduces the table exactly, aging included.
+ * C99, handmade hero style.
+ */
+
+#include "frecency.h"
+#include "../platform/platform.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+
+/* ===== Configuration ===== */
+
+#define FRECENCY_HOUR 3600
+#define FRECENCY_DAY (24 * FRECENCY_HOUR)
+#define FRECENCY_WEEK (7 * FRECENCY_DAY)
+#define FRECENCY_COMPACT_SLACK 256 /* Extra log records tolerated */
+#define FRECENCY_RECORD_SIZE (FS_MAX_PATH + 64)
+
+/* ===== Types ===== */
+
+typedef struct {
+  frecency_db *db;
+  char *text;
+  usize size;
+} frecency_compaction;
+
+/* ===== Table ===== */
+
+static u64 Frecency_Hash(const char *path, usize length) {
+  u64 hash = 14695981039346656037ull;
+  for (usize i = 0; i < length; i++) {
+    hash ^= (u8)path[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/* Find the entry for 'path'. Returns its index, or -1 with *out_slot set to
+ * the empty slot where it would be inserted. */
+static i32 Frecency_Find(frecency_db *db, const char *path, u32 length,
+                         u64 hash, u32 *out_slot) {
+  if (db->slot_count == 0)
+    return -1;
+
+  u32 mask = db->slot_count - 1;
+  u32 slot = (u32)hash & mask;
+  for (;;) {
+    i32 index = db->slots[slot];
+    if (index < 0) {
+      if (out_slot)
+        *out_slot = slot;
+      return -1;
+    }
+    frecency_entry *entry = &db->entries[index];
+    if (entry->hash == hash && entry->path_length == length &&
+        memcmp(db->path_pool + entry->path_offset, path, length) == 0)
+      return index;
+    slot = (slot + 1) & mask;
+  }
+}
+
+/* Clear the existing slots and insert the current entries again */
+static void Frecency_Refill(frecency_db *db) {
+  memset(db->slots, 0xFF, sizeof(i32) * db->slot_count);
+
+  u32 mask = db->slot_count - 1;
+  for (u32 i = 0; i < db->entry_count; i++) {
+    u32 slot = (u32)db->entries[i].hash & mask;
+    while (db->slots[slot] >= 0)
+      slot = (slot + 1) & mask;
+    db->slots[slot] = (i32)i;
+  }
+}
+
+/* Rebuild the slots for the current entries */
+static b32 Frecency_Rehash(frecency_db *db, u32 slot_count) {
+  i32 *slots = (i32 *)malloc(sizeof(i32) * slot_count);
+  if (!slots)
+    return false;
+  free(db->slots);
+  db->slots = slots;
+  db->slot_count = slot_count;
+  Frecency_Refill(db);
+  return true;
+}
+
+/* Insert a new entry with rank 0. Returns its index or -1 on failure. */
+static i32 Frecency_Insert(frecency_db *db, const char *path, u32 length,
+                           u64 hash) {
+  /* Keep the load factor at or below 1/2 */
+  if ((db->entry_count + 1) * 2 > db->slot_count) {
+    if (!Frecency_Rehash(db, db->slot_count ? db->slot_count * 2 : 256))
+      return -1;
+  }
+  if (db->entry_count == db->entry_capacity) {
+    u32 capacity = db->entry_capacity ? db->entry_capacity * 2 : 128;
+    frecency_entry *grown = (frecency_entry *)realloc(
+        db->entries, sizeof(frecency_entry) * capacity);
+    if (!grown)
+      return -1;
+    db->entries = grown;
+    db->entry_capacity = capacity;
+  }
+  if (db->path_pool_used + length + 1 > db->path_pool_capacity) {
+    u32 capacity = db->path_pool_capacity ? db->path_pool_capacity : 16384;
+    while (db->path_pool_used + length + 1 > capacity)
+      capacity *= 2;
+    char *grown = (char *)realloc(db->path_pool, capacity);
+    if (!grown)
+      return -1;
+    db->path_pool = grown;
+    db->path_pool_capacity = capacity;
+  }
+
+  u32 slot = 0;
+  Frecency_Find(db, path, length, hash, &slot);
+
+  i32 index = (i32)db->entry_count++;
+  frecency_entry *entry = &db->entries[index];
+  entry->hash = hash;
+  entry->path_offset = db->path_pool_used;
+  entry->path_length = length;
+  entry->rank = 0.0f;
+  entry->last_visit = 0;
+  memcpy(db->path_pool + db->path_pool_used, path, length);
+  db->path_pool[db->path_pool_used + length] = '\0';
+  db->path_pool_used += length + 1;
+  db->slots[slot] = index;
+  return index;
+}
+
+/* Scale every rank down and forget entries that fall below one visit.
+ * Entries keep their order, so the pool can be compacted in place. */
+static void Frecency_Age(frecency_db *db) {
+  f32 factor = 0.9f * FRECENCY_MAX_AGE / db->total_rank;
+  u32 kept = 0;
+  u32 pool_used = 0;
+  db->total_rank = 0.0f;
+
+  for (u32 i = 0; i < db->entry_count; i++) {
+    frecency_entry entry = db->entries[i];
+    entry.rank *= factor;
+    if (entry.rank < 1.0f)
+      continue;
+
+    memmove(db->path_pool + pool_used, db->path_pool + entry.path_offset,
+            entry.path_length + 1);
+    entry.path_offset = pool_used;
+    pool_used += entry.path_length + 1;
+    db->entries[kept++] = entry;
+    db->total_rank += entry.rank;
+  }
+
+  db->entry_count = kept;
+  db->path_pool_used = pool_used;
+  Frecency_Refill(db);
+}
+
+/* Apply one record to the table */
+static void Frecency_Apply(frecency_db *db, const char *path, b32 is_visit,
+                           f32 rank, u64 time_s) {
+  u32 length = (u32)strlen(path);
+  if (length == 0)
+    return;
+  u64 hash = Frecency_Hash(path, length);
+  i32 index = Frecency_Find(db, path, length, hash, NULL);
+  if (index < 0) {
+    index = Frecency_Insert(db, path, length, hash);
+    if (index < 0)
+      return;
+  }
+
+  frecency_entry *entry = &db->entries[index];
+  f32 new_rank = is_visit ? entry->rank + 1.0f : rank;
+  db->total_rank += new_rank - entry->rank;
+  entry->rank = new_rank;
+  if (time_s > entry->last_visit)
+    entry->last_visit = time_s;
+
+  if (db->total_rank > FRECENCY_MAX_AGE)
+    Frecency_Age(db);
+}
+
+/* Parse one log line. Malformed lines are ignored. */
+static void Frecency_ReplayLine(frecency_db *db, char *line) {
+  usize length = strlen(line);
+  while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+    line[--length] = '\0';
+
+  char *cursor = line + 1;
+  if (line[0] == 'v' && *cursor == ' ') {
+    u64 time_s = strtoull(cursor + 1, &cursor, 10);
+    if (*cursor == ' ')
+      Frecency_Apply(db, cursor + 1, true, 0.0f, time_s);
+  } else if (line[0] == 's' && *cursor == ' ') {
+    f32 rank = strtof(cursor + 1, &cursor);
+    if (*cursor != ' ')
+      return;
+    u64 time_s = strtoull(cursor + 1, &cursor, 10);
+    if (*cursor == ' ' && rank > 0.0f)
+      Frecency_Apply(db, cursor + 1, false, rank, time_s);
+  }
+}
+
+/* ===== Log ===== */
+
+/* Append one record. Called without the mutex held. */
+static void Frecency_AppendRecord(frecency_db *db, const char *record,
+                                  usize size) {
+  if (!db->mutex)
+    return;
+
+  Platform_LockMutex(db->mutex);
+  if (!db->log && !db->shutdown_requested) {
+    db->log = fopen(db->log_path, "ab");
+  }
+  if (db->log) {
+    fwrite(record, 1, size, db->log);
+    fflush(db->log);
+  }
+  if (db->compacting) {
+    /* Also goes into the compacted log once it replaces this one */
+    if (db->pending_size + size > db->pending_capacity) {
+      usize capacity = Max(db->pending_capacity * 2, db->pending_size + size);
+      char *grown = (char *)realloc(db->pending, capacity);
+      if (grown) {
+        db->pending = grown;
+        db->pending_capacity = capacity;
+      }
+    }
+    if (db->pending_size + size <= db->pending_capacity) {
+      memcpy(db->pending + db->pending_size, record, size);
+      db->pending_size += size;
+    }
+  }
+  Platform_UnlockMutex(db->mutex);
+  db->log_records++;
+}
+
+static void *Frecency_CompactThread(void *arg) {
+  frecency_compaction *job = (frecency_compaction *)arg;
+  frecency_db *db = job->db;
+
+  char temp_path[FS_MAX_PATH + 8];
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", db->log_path);
+  FILE *file = fopen(temp_path, "wb");
+  b32 ok = file && fwrite(job->text, 1, job->size, file) == job->size;
+  if (file && fclose(file) != 0)
+    ok = false;
+
+  Platform_LockMutex(db->mutex);
+  if (ok && !db->shutdown_requested) {
+    if (db->log) {
+      fclose(db->log);
+      db->log = NULL;
+    }
+    /* Windows can't rename over an existing file */
+    ok = Platform_Rename(temp_path, db->log_path);
+    if (!ok) {
+      Platform_Delete(db->log_path);
+      ok = Platform_Rename(temp_path, db->log_path);
+    }
+    db->log = fopen(db->log_path, "ab");
+    if (ok && db->log && db->pending_size > 0) {
+      fwrite(db->pending, 1, db->pending_size, db->log);
+      fflush(db->log);
+    }
+  } else {
+    ok = false;
+  }
+  if (!ok)
+    Platform_Delete(temp_path);
+  db->pending_size = 0;
+  db->compacting = false;
+  Platform_UnlockMutex(db->mutex);
+
+  free(job->text);
+  free(job);
+  return NULL;
+}
+
+/* Rewrite the log as one snapshot record per entry, in the background */
+static void Frecency_StartCompaction(frecency_db *db) {
+  usize capacity = 1;
+  for (u32 i = 0; i < db->entry_count; i++)
+    capacity += db->entries[i].path_length + 48;
+
+  frecency_compaction *job =
+      (frecency_compaction *)malloc(sizeof(frecency_compaction));
+  char *text = (char *)malloc(capacity);
+  if (!job || !text) {
+    free(job);
+    free(text);
+    return;
+  }
+
+  usize size = 0;
+  for (u32 i = 0; i < db->entry_count; i++) {
+    frecency_entry *entry = &db->entries[i];
+    i32 written = snprintf(text + size, capacity - size, "s %.3f %llu %s\n",
+                           entry->rank, (unsigned long long)entry->last_visit,
+                           db->path_pool + entry->path_offset);
+    if (written < 0 || (usize)written >= capacity - size)
+      break;
+    size += (usize)written;
+  }
+  job->db = db;
+  job->text = text;
+  job->size = size;
+
+  Platform_LockMutex(db->mutex);
+  db->compacting = true;
+  db->pending_size = 0;
+  Platform_UnlockMutex(db->mutex);
+
+  void *thread = Platform_CreateThread(Frecency_CompactThread, job);
+  if (!thread) {
+    Platform_LockMutex(db->mutex);
+    db->compacting = false;
+    Platform_UnlockMutex(db->mutex);
+    free(text);
+    free(job);
+    return;
+  }
+  Platform_DestroyThread(thread);
+  db->log_records = db->entry_count;
+}
+
+/* ===== Public API ===== */
+
+void Frecency_Init(frecency_db *db, const char *log_path) {
+  memset(db, 0, sizeof(*db));
+  snprintf(db->log_path, sizeof(db->log_path), "%s", log_path);
+  db->mutex = Platform_CreateMutex();
+
+  FILE *file = fopen(db->log_path, "rb");
+  if (!file)
+    return;
+
+  char *line = (char *)malloc(FRECENCY_RECORD_SIZE);
+  if (line) {
+    while (fgets(line, FRECENCY_RECORD_SIZE, file)) {
+      Frecency_ReplayLine(db, line);
+      db->log_records++;
+    }
+    free(line);
+  }
+  fclose(file);
+}
+
+void Frecency_Shutdown(frecency_db *db) {
+  if (!db->mutex)
+    return;
+
+  /* A compaction still writing sees the flag and leaves the log alone */
+  Platform_LockMutex(db->mutex);
+  db->shutdown_requested = true;
+  if (db->log) {
+    fclose(db->log);
+    db->log = NULL;
+  }
+  Platform_UnlockMutex(db->mutex);
+}
+
+void Frecency_Visit(frecency_db *db, const char *path) {
+  usize length = path ? strlen(path) : 0;
+  if (length == 0 || length >= FS_MAX_PATH || strchr(path, '\n'))
+    return;
+
+  u64 now = (u64)time(NULL);
+  Frecency_Apply(db, path, true, 0.0f, now);
+
+  char record[FRECENCY_RECORD_SIZE];
+  i32 size = snprintf(record, sizeof(record), "v %llu %s\n",
+                      (unsigned long long)now, path);
+  if (size > 0 && (usize)size < sizeof(record))
+    Frecency_AppendRecord(db, record, (usize)size);
+
+  if (db->log_records > db->entry_count * 2 + FRECENCY_COMPACT_SLACK &&
+      db->mutex) {
+    Platform_LockMutex(db->mutex);
+    b32 compacting = db->compacting;
+    Platform_UnlockMutex(db->mutex);
+    if (!compacting)
+      Frecency_StartCompaction(db);
+  }
+}
+
+f32 Frecency_Score(frecency_db *db, const char *path) {
+  if (db->entry_count == 0)
+    return 0.0f;
+
+  u32 length = (u32)strlen(path);
+  i32 index =
+      Frecency_Find(db, path, length, Frecency_Hash(path, length), NULL);
+  if (index < 0)
+    return 0.0f;
+
+  frecency_entry *entry = &db->entries[index];
+  u64 now = (u64)time(NULL);
+  u64 age = now > entry->last_visit ? now - entry->last_visit : 0;
+  if (age < FRECENCY_HOUR)
+    return entry->rank * 4.0f;
+  if (age < FRECENCY_DAY)
+    return entry->rank * 2.0f;
+  if (age < FRECENCY_WEEK)
+    return entry->rank * 0.5f;
+  return entry->rank * 0.25f;
+}
+
+i32 Frecency_Boost(frecency_db *db, const char *path) {
+  f32 score = Frecency_Score(db, path);
+  if (score <= 0.0f)
+    return 0;
+  /* Logarithmic: the first visits matter most */
+  i32 boost = (i32)(200.0f * log2f(1.0f + score));
+  return Min(boost, FRECENCY_MAX_BOOST);
+}
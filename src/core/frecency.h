@@ -0,0 +1,78 @@
+/*
+ * frecency.h - Frecency database for visited directories and files
+ *
+ * Tracks how often and how recently paths were visited (zoxide-style: every
+ * visit adds 1 to a path's rank, ranks age once their total grows too large,
+ * and the score weighs the rank by how recent the last visit was). Lookups
+ * and visits are O(1) through an open-addressing hash table.
+ *
+ * Visits are appended to a text log; when the log has grown well past the
+ * number of live entries it is rewritten from a snapshot on a background
+ * thread.
+ * C99, handmade hero style.
+ */
+
+#ifndef FRECENCY_H
+#define FRECENCY_H
+
+#include "types.h"
+
+#include <stdio.h>
+
+/* ===== Configuration ===== */
+
+#define FRECENCY_MAX_AGE 10000.0f /* Total rank that triggers aging */
+#define FRECENCY_MAX_BOOST 1000   /* Largest ranking bonus (= prefix match) */
+
+/* ===== Types ===== */
+
+typedef struct {
+  u64 hash;
+  u32 path_offset; /* Into the path pool */
+  u32 path_length;
+  f32 rank;         /* Visit count, scaled down by aging */
+  u64 last_visit;   /* Unix time in seconds */
+} frecency_entry;
+
+typedef struct {
+  /* Table (UI thread only) */
+  frecency_entry *entries;
+  u32 entry_count;
+  u32 entry_capacity;
+  i32 *slots; /* Entry index per slot, -1 if empty */
+  u32 slot_count; /* Power of two */
+  char *path_pool;
+  u32 path_pool_used;
+  u32 path_pool_capacity;
+  f32 total_rank;
+  u32 log_records; /* Records in the log, compared to entry_count */
+
+  /* Log file, shared with the compaction thread */
+  void *mutex;
+  char log_path[FS_MAX_PATH];
+  FILE *log;
+  b32 compacting;
+  b32 shutdown_requested;
+  char *pending; /* Records written while compacting, replayed after */
+  usize pending_size;
+  usize pending_capacity;
+} frecency_db;
+
+/* ===== Frecency API ===== */
+
+/* Load the log at 'log_path' (created on the first visit) */
+void Frecency_Init(frecency_db *db, const char *log_path);
+
+/* Close the log. A running compaction is abandoned (the log stays valid). */
+void Frecency_Shutdown(frecency_db *db);
+
+/* Record a visit of 'path' (a directory entered or a file opened) */
+void Frecency_Visit(frecency_db *db, const char *path);
+
+/* Frecency of 'path' at the current time, 0 if never visited */
+f32 Frecency_Score(frecency_db *db, const char *path);
+
+/* Ranking bonus for fuzzy match scores, 0 .. FRECENCY_MAX_BOOST */
+i32 Frecency_Boost(frecency_db *db, const char *path);
+
+#endif /* FRECENCY_H */
@@ -6,6 +6,7 @@
 
 #include "fs.h"
 #include "../platform/platform.h"
+#include "zip_archive.h"
 #include <strings.h>
 
 #include <stdio.h>
@@ -374,7 +375,108 @@ void FS_Init(fs_state *state, memory_arena *arena) {
   state->sort_dir = WB_SORT_ASCENDING;
 }
 
+/* Sort freshly loaded entries and select the first one (after "..") */
+static void FS_FinishLoad(fs_state *state) {
+  /* Sort entries */
+  if (state->entry_count > 0) {
+    g_sort_type = state->sort_by;
+    g_sort_order = state->sort_dir;
+    qsort(state->entries, state->entry_count, sizeof(fs_entry), CompareEntries);
+  }
+
+  /* Reset selection to first entry (after ..) or 0 */
+  state->selected_index = 0;
+  if (state->entry_count > 1 && strcmp(state->entries[0].name, "..") == 0) {
+    state->selected_index = 1;
+  }
+
+  /* Clear multi-selection when loading new directory */
+  FS_ClearSelection(state);
+  state->selection_anchor = -1;
+
+  /* Sync single selection with multi-selection */
+  if (state->entry_count > 0) {
+    SetSelectionBit(state, state->selected_index, 1);
+    state->selection_count = 1;
+  }
+}
+
+static void FS_AddArchiveEntry(void *user_data, const char *name,
+                               usize name_len, b32 is_directory, u64 size,
+                               u64 modified_time) {
+  fs_state *state = (fs_state *)user_data;
+  fs_entry *entry;
+
+  if (state->entry_count >= state->entry_capacity) {
+    return;
+  }
+  entry = &state->entries[state->entry_count++];
+
+  name_len = Min(name_len, (usize)FS_MAX_NAME - 1);
+  memcpy(entry->name, name, name_len);
+  entry->name[name_len] = '\0';
+  FS_JoinPath(entry->path, FS_MAX_PATH, state->current_path, entry->name);
+  entry->is_directory = is_directory;
+  entry->is_special = false;
+  entry->size = size;
+  entry->modified_time = modified_time;
+  entry->icon = FS_GetIconType(entry->name, is_directory);
+}
+
+/* List a folder of a zip archive ('member' is "" for its root) */
+static b32 FS_LoadArchiveDirectory(fs_state *state, const char *path,
+                                   const char *archive_path,
+                                   const char *member) {
+  zip_archive zip;
+  char dir[FS_MAX_PATH];
+
+  if (!ZipArchive_Open(&zip, archive_path)) {
+    return false;
+  }
+  strncpy(dir, member, FS_MAX_PATH - 1);
+  dir[FS_MAX_PATH - 1] = '\0';
+  FS_NormalizePath(dir);
+  if (dir[0] && !ZipArchive_IsDirectory(&zip, dir)) {
+    ZipArchive_Close(&zip);
+    return false;
+  }
+
+  strncpy(state->current_path, path, FS_MAX_PATH - 1);
+  state->current_path[FS_MAX_PATH - 1] = '\0';
+  FS_NormalizePath(state->current_path);
+  state->in_archive = true;
+  state->entry_count = 0;
+  state->generation++;
+
+  /* ".." leads out of the folder, and out of the archive at its root */
+  {
+    fs_entry *up = &state->entries[state->entry_count++];
+    memset(up, 0, sizeof(*up));
+    strcpy(up->name, "..");
+    snprintf(up->path, sizeof(up->path), "%s", state->current_path);
+    char *separator = (char *)FS_FindLastSeparator(up->path);
+    if (separator) {
+      separator[separator == up->path ? 1 : 0] = '\0';
+    }
+    up->is_directory = true;
+    up->icon = WB_FILE_ICON_DIRECTORY;
+  }
+
+  ZipArchive_ListDirectory(&zip, dir, FS_AddArchiveEntry, state);
+  ZipArchive_Close(&zip);
+
+  FS_FinishLoad(state);
+  return true;
+}
+
 b32 FS_LoadDirectory(fs_state *state, const char *path) {
+  char archive[FS_MAX_PATH];
+  const char *member;
+
+  if (ZipArchive_SplitPath(path, archive, sizeof(archive), &member)) {
+    return FS_LoadArchiveDirectory(state, path, archive, member);
+  }
+
   /* Resolve to absolute path */
   char resolved[FS_MAX_PATH];
   if (!Platform_GetRealPath(path, resolved, FS_MAX_PATH)) {
@@ -397,9 +499,11 @@ b32 FS_LoadDirectory(fs_state *state, const char *path) {
   strncpy(state->current_path, resolved, FS_MAX_PATH - 1);
   state->current_path[FS_MAX_PATH - 1] = '\0';
   FS_NormalizePath(state->current_path);
+  state->in_archive = false;
 
   /* Clear existing entries */
   state->entry_count = 0;
+  state->generation++;
 
   /* Process entries from platform listing */
   for (usize i = 0;
@@ -416,6 +520,7 @@ b32 FS_LoadDirectory(fs_state *state, const char *path) {
 
     /* Set properties */
     entry->is_directory = (info->type == WB_FILE_TYPE_DIRECTORY);
+    entry->is_special = (info->type == WB_FILE_TYPE_UNKNOWN);
     entry->size = info->size;
     entry->modified_time = info->modified_time;
 
@@ -429,28 +534,7 @@ b32 FS_LoadDirectory(fs_state *state, const char *path) {
     state->entry_count++;
   }
 
-  /* Sort entries */
-  if (state->entry_count > 0) {
-    g_sort_type = state->sort_by;
-    g_sort_order = state->sort_dir;
-    qsort(state->entries, state->entry_count, sizeof(fs_entry), CompareEntries);
-  }
-
-  /* Reset selection to first entry (after ..) or 0 */
-  state->selected_index = 0;
-  if (state->entry_count > 1 && strcmp(state->entries[0].name, "..") == 0) {
-    state->selected_index = 1;
-  }
-
-  /* Clear multi-selection when loading new directory */
-  FS_ClearSelection(state);
-  state->selection_anchor = -1;
-
-  /* Sync single selection with multi-selection */
-  if (state->entry_count > 0) {
-    SetSelectionBit(state, state->selected_index, 1);
-    state->selection_count = 1;
-  }
+  FS_FinishLoad(state);
 
   Platform_FreeDirectoryListing(&listing);
   EndTemporaryMemory(temp);
@@ -514,6 +598,7 @@ void FS_Resort(fs_state *state) {
     g_sort_type = state->sort_by;
     g_sort_order = state->sort_dir;
     qsort(state->entries, state->entry_count, sizeof(fs_entry), CompareEntries);
+    state->generation++;
 
     /* Restore selection */
     if (selected_name[0]) {
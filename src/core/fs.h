@@ -50,6 +50,7 @@ typedef struct {
   char name[FS_MAX_NAME];
   char path[FS_MAX_PATH];
   b32 is_directory;
+  b32 is_special; /* FIFO, socket or device: never opened to preview */
   u64 size;
   u64 modified_time;
   file_icon_type icon;
@@ -62,11 +63,17 @@ typedef struct {
   fs_entry *entries;
   u32 entry_count;
   u32 entry_capacity;
+  u32 generation; /* Bumped whenever entries are reloaded or reordered */
+  u32 change_count; /* Bumped when the watcher reports external changes */
   i32 selected_index; /* Primary selection (for single-click nav) */
 
   sort_type sort_by;   /* Current sort field */
   sort_order sort_dir; /* Current sort direction */
 
+  /* current_path is a folder inside a zip archive (read-only, listed
+   * from its central directory) */
+  b32 in_archive;
+
   /* === NEW: Multi-selection support === */
   u8 selected[FS_MAX_ENTRIES / 8]; /* Bitmask: 1 bit per entry */
   i32 selection_count;             /* Number of selected items */
@@ -81,7 +88,8 @@ typedef struct {
 /* Initialize file system state */
 void FS_Init(fs_state *state, memory_arena *arena);
 
-/* Load directory contents into state */
+/* Load directory contents into state. Paths that run through (or name) a
+ * zip archive list its members. */
 b32 FS_LoadDirectory(fs_state *state, const char *path);
 
 /* Navigate to parent directory */
@@ -0,0 +1,210 @@
+/*
+ * fuzzy_filter.c - Incremental fuzzy filtering implementation
+ *
+ * C99, handmade hero style.
+ */
+
+#include "fuzzy_filter.h"
+
+#include <string.h>
+
+/* ===== Internal Helpers ===== */
+
+/* Strict ordering: higher score first, then lower source index */
+static inline b32 FuzzyFilter_Better(fuzzy_candidate a, fuzzy_candidate b) {
+  if (a.score != b.score)
+    return a.score > b.score;
+  return a.index < b.index;
+}
+
+/* Restore min-heap order (worst candidate at the root) below 'i' */
+static void FuzzyFilter_SiftDown(fuzzy_candidate *heap, i32 count, i32 i) {
+  for (;;) {
+    i32 worst = i;
+    i32 left = i * 2 + 1;
+    i32 right = left + 1;
+
+    if (left < count && FuzzyFilter_Better(heap[worst], heap[left]))
+      worst = left;
+    if (right < count && FuzzyFilter_Better(heap[worst], heap[right]))
+      worst = right;
+    if (worst == i)
+      return;
+
+    fuzzy_candidate tmp = heap[i];
+    heap[i] = heap[worst];
+    heap[worst] = tmp;
+    i = worst;
+  }
+}
+
+static b32 FuzzyFilter_IsPrefix(const char *prefix, const char *text) {
+  while (*prefix) {
+    if (*prefix != *text)
+      return false;
+    prefix++;
+    text++;
+  }
+  return true;
+}
+
+/* Push a new empty level, recycling the oldest one when the stack is full */
+static fuzzy_filter_level *FuzzyFilter_PushLevel(fuzzy_filter *filter) {
+  if (filter->depth == FUZZY_FILTER_MAX_DEPTH) {
+    fuzzy_filter_level oldest = filter->levels[0];
+    memmove(&filter->levels[0], &filter->levels[1],
+            sizeof(fuzzy_filter_level) * (FUZZY_FILTER_MAX_DEPTH - 1));
+    filter->levels[FUZZY_FILTER_MAX_DEPTH - 1] = oldest;
+    filter->depth--;
+  }
+
+  fuzzy_filter_level *level = &filter->levels[filter->depth++];
+  level->count = 0;
+  level->query[0] = '\0';
+  return level;
+}
+
+/* ===== Public API ===== */
+
+void FuzzyFilter_Init(fuzzy_filter *filter, fuzzy_candidate *storage,
+                      i32 capacity) {
+  memset(filter, 0, sizeof(*filter));
+  filter->capacity = storage ? capacity : 0;
+
+  for (i32 i = 0; i < FUZZY_FILTER_MAX_DEPTH; i++) {
+    filter->levels[i].matches = storage ? storage + (usize)i * capacity : NULL;
+  }
+}
+
+void FuzzyFilter_Reset(fuzzy_filter *filter) { filter->depth = 0; }
+
+const fuzzy_candidate *FuzzyFilter_Apply(fuzzy_filter *filter,
+                                         const char *query, i32 source_count,
+                                         u32 source_generation,
+                                         fuzzy_filter_score_fn score_fn,
+                                         void *user_data, i32 *out_count) {
+  *out_count = 0;
+  if (filter->capacity <= 0 || !query)
+    return NULL;
+
+  if (source_count > filter->capacity)
+    source_count = filter->capacity;
+
+  /* Source list changed - nothing cached is valid anymore */
+  if (filter->source_generation != source_generation ||
+      filter->source_count != source_count) {
+    filter->source_generation = source_generation;
+    filter->source_count = source_count;
+    filter->depth = 0;
+  }
+
+  /* Pop levels that are not a prefix of the new query (backspace/edits) */
+  while (filter->depth > 0 &&
+         !FuzzyFilter_IsPrefix(filter->levels[filter->depth - 1].query,
+                               query)) {
+    filter->depth--;
+  }
+
+  /* Same query as the top level - reuse it as is */
+  if (filter->depth > 0) {
+    fuzzy_filter_level *top = &filter->levels[filter->depth - 1];
+    if (strcmp(top->query, query) == 0) {
+      filter->cache_hits++;
+      *out_count = top->count;
+      return top->matches;
+    }
+  }
+
+  /* Copy the parent slice before the push may recycle its storage.
+   * Recycling only happens with a full stack, where the parent is the newest
+   * level and never the recycled oldest one. */
+  fuzzy_filter_level parent = {0};
+  b32 has_parent = filter->depth > 0;
+  if (has_parent) {
+    parent = filter->levels[filter->depth - 1];
+  }
+
+  fuzzy_filter_level *level;
+  if (strlen(query) < FUZZY_FILTER_MAX_QUERY) {
+    level = FuzzyFilter_PushLevel(filter);
+    memcpy(level->query, query, strlen(query) + 1);
+  } else {
+    /* Too long to cache - match from scratch into the bottom level */
+    filter->depth = 0;
+    has_parent = false;
+    level = &filter->levels[0];
+    level->count = 0;
+  }
+
+  if (has_parent) {
+    /* Refinement: only the previous matches can still match */
+    filter->refinements++;
+    for (i32 i = 0; i < parent.count; i++) {
+      i32 index = parent.matches[i].index;
+      fuzzy_match_result result = score_fn(user_data, index, query);
+      if (result.matches) {
+        level->matches[level->count].index = index;
+        level->matches[level->count].score = result.score;
+        level->count++;
+      }
+    }
+  } else {
+    filter->full_scans++;
+    for (i32 i = 0; i < source_count; i++) {
+      fuzzy_match_result result = score_fn(user_data, i, query);
+      if (result.matches) {
+        level->matches[level->count].index = i;
+        level->matches[level->count].score = result.score;
+        level->count++;
+      }
+    }
+  }
+
+  *out_count = level->count;
+  return level->matches;
+}
+
+i32 FuzzyFilter_SelectTop(const fuzzy_candidate *matches, i32 count,
+                          i32 top_k, fuzzy_candidate *out) {
+  if (count <= 0)
+    return 0;
+  if (top_k > count)
+    top_k = count;
+  if (top_k <= 0) {
+    memcpy(out, matches, sizeof(fuzzy_candidate) * (usize)count);
+    return 0;
+  }
+
+  /* Bounded min-heap of the best top_k, built in place at the front of out */
+  for (i32 i = 0; i < top_k; i++) {
+    out[i] = matches[i];
+  }
+  for (i32 i = top_k / 2 - 1; i >= 0; i--) {
+    FuzzyFilter_SiftDown(out, top_k, i);
+  }
+  for (i32 i = top_k; i < count; i++) {
+    if (FuzzyFilter_Better(matches[i], out[0])) {
+      out[0] = matches[i];
+      FuzzyFilter_SiftDown(out, top_k, 0);
+    }
+  }
+
+  /* Heap sort: popping the worst to the back leaves the best at the front */
+  for (i32 end = top_k - 1; end > 0; end--) {
+    fuzzy_candidate tmp = out[0];
+    out[0] = out[end];
+    out[end] = tmp;
+    FuzzyFilter_SiftDown(out, end, 0);
+  }
+
+  /* Append everything below the cut in original order */
+  fuzzy_candidate cut = out[top_k - 1];
+  i32 written = top_k;
+  for (i32 i = 0; i < count; i++) {
+    if (FuzzyFilter_Better(cut, matches[i])) {
+      out[written++] = matches[i];
+    }
+  }
+
+  return top_k;
+}
@@ -0,0 +1,86 @@
+/*
+ * fuzzy_filter.h - Incremental fuzzy filtering with cached refinement
+ *
+ * Caches the match set for each query on a small stack so that typing a
+ * character only rescores the previous matches, and backspace restores a
+ * previous result without rescoring anything.
+ * C99, handmade hero style.
+ */
+
+#ifndef FUZZY_FILTER_H
+#define FUZZY_FILTER_H
+
+#include "fuzzy_match.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define FUZZY_FILTER_MAX_DEPTH 8    /* Cached queries kept for backspace */
+#define FUZZY_FILTER_MAX_QUERY 256  /* Longest query that can be cached */
+
+/* ===== Types ===== */
+
+typedef struct {
+  i32 index; /* Index into the caller's source list */
+  i32 score; /* Fuzzy match score (higher is better) */
+} fuzzy_candidate;
+
+/* Score the source item at 'index' against 'query'.
+ * The match set must shrink as the query grows (true for subsequence
+ * matching), otherwise refinement would drop valid matches. */
+typedef fuzzy_match_result (*fuzzy_filter_score_fn)(void *user_data,
+                                                    i32 index,
+                                                    const char *query);
+
+typedef struct {
+  char query[FUZZY_FILTER_MAX_QUERY];
+  fuzzy_candidate *matches; /* Slice of the filter storage */
+  i32 count;
+} fuzzy_filter_level;
+
+typedef struct {
+  fuzzy_filter_level levels[FUZZY_FILTER_MAX_DEPTH];
+  i32 depth; /* Number of valid levels (top is depth - 1) */
+
+  i32 capacity; /* Max candidates per level */
+
+  /* Source identity the cached levels were computed against */
+  u32 source_generation;
+  i32 source_count;
+
+  /* Counters for tuning */
+  u32 full_scans;
+  u32 refinements;
+  u32 cache_hits;
+} fuzzy_filter;
+
+/* ===== Fuzzy Filter API ===== */
+
+/* Initialize a filter. 'storage' must hold capacity * FUZZY_FILTER_MAX_DEPTH
+ * candidates and stay valid for the lifetime of the filter. */
+void FuzzyFilter_Init(fuzzy_filter *filter, fuzzy_candidate *storage,
+                      i32 capacity);
+
+/* Drop every cached level (e.g. when the source list is replaced) */
+void FuzzyFilter_Reset(fuzzy_filter *filter);
+
+/* Return the matches for 'query' over source items [0, source_count).
+ * Extending the previous query rescores only the previous matches; a query
+ * already on the stack is returned directly. A change in source_generation
+ * or source_count invalidates the cache. Matches are in source order.
+ * The returned array is owned by the filter and valid until the next call. */
+const fuzzy_candidate *FuzzyFilter_Apply(fuzzy_filter *filter,
+                                         const char *query, i32 source_count,
+                                         u32 source_generation,
+                                         fuzzy_filter_score_fn score_fn,
+                                         void *user_data, i32 *out_count);
+
+/* Copy 'matches' into 'out' with the best 'top_k' fully sorted at the front
+ * (score descending, then index ascending) followed by the remaining matches
+ * in their original order. Uses partial selection, so the cost is
+ * O(n log top_k) instead of sorting the whole set.
+ * Returns the number of sorted entries at the front of 'out'. */
+i32 FuzzyFilter_SelectTop(const fuzzy_candidate *matches, i32 count,
+                          i32 top_k, fuzzy_candidate *out);
+
+#endif /* FUZZY_FILTER_H */
@@ -6,6 +6,12 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 image *Image_Load(const char *path) {
   if (!path)
@@ -35,6 +41,109 @@ image *Image_Load(const char *path) {
   return img;
 }
 
+/* ===== Cancellable Loading ===== */
+
+#define IMAGE_CANCEL_CHECK_BYTES Kilobytes(64)
+
+typedef struct {
+  FILE *file;
+  b32 (*cancelled)(void *);
+  void *user_data;
+  usize unchecked; /* Bytes read since the last check */
+  b32 stopped;
+} image_reader;
+
+/* stb asks for whole chunks at once (a PNG's IDAT can be megabytes), so
+ * large reads are split up to check in between. A short read makes the
+ * decoder give up. */
+static int Image_ReaderRead(void *user, char *data, int size) {
+  image_reader *reader = (image_reader *)user;
+  usize total = 0;
+
+  while (total < (usize)size && !reader->stopped) {
+    if (reader->unchecked >= IMAGE_CANCEL_CHECK_BYTES) {
+      reader->unchecked = 0;
+      if (reader->cancelled(reader->user_data)) {
+        reader->stopped = true;
+        break;
+      }
+    }
+
+    usize want = Min((usize)size - total,
+                     IMAGE_CANCEL_CHECK_BYTES - reader->unchecked);
+    usize n = fread(data + total, 1, want, reader->file);
+    reader->unchecked += n;
+    total += n;
+    if (n < want)
+      break;
+  }
+  return (int)total;
+}
+
+static void Image_ReaderSkip(void *user, int n) {
+  image_reader *reader = (image_reader *)user;
+  fseek(reader->file, n, SEEK_CUR);
+}
+
+static int Image_ReaderEof(void *user) {
+  image_reader *reader = (image_reader *)user;
+  return reader->stopped || feof(reader->file);
+}
+
+image *Image_LoadCancellable(const char *path, b32 (*cancelled)(void *),
+                             void *user_data) {
+  static const stbi_io_callbacks callbacks = {Image_ReaderRead,
+                                              Image_ReaderSkip, Image_ReaderEof};
+  image_reader reader = {0};
+  int w, h, n;
+
+  if (!cancelled)
+    return Image_Load(path);
+
+  reader.file = fopen(path, "rb");
+  if (!reader.file)
+    return NULL;
+  reader.cancelled = cancelled;
+  reader.user_data = user_data;
+
+  u8 *data = stbi_load_from_callbacks(&callbacks, &reader, &w, &h, &n, 4);
+  fclose(reader.file);
+  if (data && reader.stopped) {
+    /* Decoded from a truncated stream */
+    stbi_image_free(data);
+    data = NULL;
+  }
+  if (!data) {
+    if (!reader.stopped)
+      fprintf(stderr, "Failed to load image: %s\n", path);
+    return NULL;
+  }
+
+  image *img = (image *)malloc(sizeof(image));
+  if (!img) {
+    stbi_image_free(data);
+    return NULL;
+  }
+
+  img->width = w;
+  img->height = h;
+  img->channels = 4;
+  img->pixels = data;
+  img->texture_id = 0;
+  return img;
+}
+
+b32 Image_GetSize(const char *path, i32 *out_width, i32 *out_height) {
+  int w, h, n;
+
+  if (!path || !stbi_info(path, &w, &h, &n))
+    return false;
+
+  *out_width = w;
+  *out_height = h;
+  return true;
+}
+
 image *Image_LoadFromMemory(const u8 *data, usize len) {
   if (!data || len == 0)
     return NULL;
@@ -61,6 +170,145 @@ image *Image_LoadFromMemory(const u8 *data, usize len) {
   return img;
 }
 
+image *Image_Copy(const image *img) {
+  usize bytes;
+
+  if (!img || !img->pixels)
+    return NULL;
+
+  bytes = (usize)img->width * (usize)img->height * 4;
+  image *copy = (image *)malloc(sizeof(image));
+  u8 *pixels = (u8 *)malloc(bytes);
+  if (!copy || !pixels) {
+    free(copy);
+    free(pixels);
+    return NULL;
+  }
+
+  memcpy(pixels, img->pixels, bytes);
+  *copy = *img;
+  copy->pixels = pixels;
+  copy->texture_id = 0;
+  return copy;
+}
+
+/* ===== Downscaling =====
+ * Two passes per output row: the source rows it covers are summed into a
+ * row of per-channel u32 sums, then each output pixel averages the columns
+ * it covers. Sums go through floats so boxes of any size can't overflow.
+ */
+
+/* sums[i] += row[i] for 4 * width channels */
+static void Image_AccumulateRow(u32 *sums, const u8 *row, i32 width) {
+  i32 count = width * 4;
+  i32 i = 0;
+
+#if defined(IMAGE_SSE2)
+  __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= count; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(row + i));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    __m128i *dst = (__m128i *)(sums + i);
+    _mm_storeu_si128(dst + 0, _mm_add_epi32(_mm_loadu_si128(dst + 0),
+                                            _mm_unpacklo_epi16(lo, zero)));
+    _mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1),
+                                            _mm_unpackhi_epi16(lo, zero)));
+    _mm_storeu_si128(dst + 2, _mm_add_epi32(_mm_loadu_si128(dst + 2),
+                                            _mm_unpacklo_epi16(hi, zero)));
+    _mm_storeu_si128(dst + 3, _mm_add_epi32(_mm_loadu_si128(dst + 3),
+                                            _mm_unpackhi_epi16(hi, zero)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    sums[i] += row[i];
+  }
+}
+
+/* Average sums[x0..x1) (whole pixels) scaled by 'scale' into one pixel */
+static void Image_ResolvePixel(u8 *out, const u32 *sums, i32 x0, i32 x1,
+                               f32 scale) {
+#if defined(IMAGE_SSE2)
+  __m128 total = _mm_setzero_ps();
+  for (i32 x = x0; x < x1; x++) {
+    __m128i pixel = _mm_loadu_si128((const __m128i *)(sums + x * 4));
+    total = _mm_add_ps(total, _mm_cvtepi32_ps(pixel));
+  }
+  __m128i rounded = _mm_cvtps_epi32(_mm_mul_ps(total, _mm_set1_ps(scale)));
+  __m128i packed = _mm_packs_epi32(rounded, rounded);
+  packed = _mm_packus_epi16(packed, packed);
+  i32 value = _mm_cvtsi128_si32(packed);
+  memcpy(out, &value, 4);
+#else
+  for (i32 c = 0; c < 4; c++) {
+    f32 total = 0.0f;
+    for (i32 x = x0; x < x1; x++) {
+      total += (f32)sums[x * 4 + c];
+    }
+    f32 value = total * scale + 0.5f;
+    out[c] = (u8)(value > 255.0f ? 255.0f : value);
+  }
+#endif
+}
+
+b32 Image_Downscale(image *img, i32 max_width, i32 max_height) {
+  if (!img || !img->pixels || max_width <= 0 || max_height <= 0 ||
+      (img->width <= max_width && img->height <= max_height))
+    return false;
+
+  i32 src_w = img->width;
+  i32 src_h = img->height;
+  f64 fit = (f64)max_width / (f64)src_w;
+  if ((f64)max_height / (f64)src_h < fit)
+    fit = (f64)max_height / (f64)src_h;
+  i32 dst_w = (i32)((f64)src_w * fit + 0.5);
+  i32 dst_h = (i32)((f64)src_h * fit + 0.5);
+  if (dst_w < 1)
+    dst_w = 1;
+  if (dst_h < 1)
+    dst_h = 1;
+
+  /* Freed through stbi_image_free like decoded pixels (plain free) */
+  u8 *pixels = (u8 *)malloc((usize)dst_w * (usize)dst_h * 4);
+  u32 *sums = (u32 *)malloc((usize)src_w * 4 * sizeof(u32));
+  if (!pixels || !sums) {
+    free(pixels);
+    free(sums);
+    return false;
+  }
+
+  for (i32 oy = 0; oy < dst_h; oy++) {
+    i32 y0 = (i32)((i64)oy * src_h / dst_h);
+    i32 y1 = (i32)((i64)(oy + 1) * src_h / dst_h);
+    if (y1 <= y0)
+      y1 = y0 + 1;
+
+    memset(sums, 0, (usize)src_w * 4 * sizeof(u32));
+    for (i32 y = y0; y < y1; y++) {
+      Image_AccumulateRow(sums, img->pixels + (usize)y * (usize)src_w * 4,
+                          src_w);
+    }
+
+    u8 *out = pixels + (usize)oy * (usize)dst_w * 4;
+    for (i32 ox = 0; ox < dst_w; ox++) {
+      i32 x0 = (i32)((i64)ox * src_w / dst_w);
+      i32 x1 = (i32)((i64)(ox + 1) * src_w / dst_w);
+      if (x1 <= x0)
+        x1 = x0 + 1;
+      Image_ResolvePixel(out + ox * 4, sums, x0, x1,
+                         1.0f / ((f32)(x1 - x0) * (f32)(y1 - y0)));
+    }
+  }
+
+  free(sums);
+  stbi_image_free(img->pixels);
+  img->pixels = pixels;
+  img->width = dst_w;
+  img->height = dst_h;
+  return true;
+}
+
 void Image_Free(image *img) {
   if (!img)
     return;
@@ -20,9 +20,27 @@ typedef struct image_s {
 /* Load image from file path */
 image *Image_Load(const char *path);
 
+/* Load an image, reading the file in chunks and asking 'cancelled' before
+ * each one. Returns NULL (quietly) once it says yes. Formats that decode
+ * as they read stop at once; others stop when reading is done. */
+image *Image_LoadCancellable(const char *path, b32 (*cancelled)(void *),
+                             void *user_data);
+
+/* Read the dimensions from the file header without decoding */
+b32 Image_GetSize(const char *path, i32 *out_width, i32 *out_height);
+
 /* Load image from memory buffer */
 image *Image_LoadFromMemory(const u8 *data, usize len);
 
+/* Copy the pixels into a new image (not uploaded). NULL on failure. */
+image *Image_Copy(const image *img);
+
+/* Shrink an image in place to fit within max_width x max_height, keeping
+ * its aspect ratio. Each output pixel is the box average of the source
+ * pixels it covers. The full-size pixels are freed. Returns false (image
+ * untouched) if it already fits or memory runs out. */
+b32 Image_Downscale(image *img, i32 max_width, i32 max_height);
+
 /* Free image resources */
 void Image_Free(image *img);
 
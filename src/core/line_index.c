@@ -0,0 +1,281 @@
+/*
+ * line_index.c - Sparse line index implementation
+ *
+ * The worker scans the mapping in chunks, counting newlines with the
+ * vectorized byte counter and only walking the 64 KB blocks that contain a
+ * checkpoint. The index is heap-allocated and owned by its worker once
+ * released, so the owner never has to wait for a scan to finish.
+ * C99, handmade hero style.
+ */
+
+#include "line_index.h"
+#include "byte_scan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_DestroyMutex(void *mutex);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+extern void *Platform_CreateCondVar(void);
+extern void Platform_DestroyCondVar(void *cond);
+extern void Platform_CondWait(void *cond, void *mutex);
+extern void Platform_CondSignal(void *cond);
+
+#define LINE_INDEX_BLOCK Kilobytes(64)
+#define LINE_INDEX_MAX_FOUND (LINE_INDEX_CHUNK / LINE_INDEX_STRIDE + 1)
+
+/* ===== Internal Helpers ===== */
+
+static void LineIndex_Free(line_index *index) {
+  Platform_UnmapFile(&index->map);
+  Platform_UnmapFile(&index->retired);
+  free(index->checkpoints);
+  if (index->work_cond)
+    Platform_DestroyCondVar(index->work_cond);
+  if (index->mutex)
+    Platform_DestroyMutex(index->mutex);
+  free(index);
+}
+
+/* Called with the mutex held */
+static b32 LineIndex_NeedsWorkLocked(line_index *index) {
+  return !index->complete && (index->indexed_offset < index->want_offset ||
+                              index->indexed_lines < index->want_line);
+}
+
+/* Count the newlines in [from, to), adding to *lines. The start offsets of
+ * lines that are a multiple of the stride go to 'found'. */
+static u32 LineIndex_ScanChunk(const u8 *data, u64 from, u64 to, u64 *lines,
+                               u64 *found) {
+  u32 found_count = 0;
+  u64 pos = from;
+
+  while (pos < to) {
+    u64 end = Min(pos + LINE_INDEX_BLOCK, to);
+    u64 count = ByteScan_CountByte(data + pos, (usize)(end - pos), '\n');
+    u64 next_checkpoint = (*lines / LINE_INDEX_STRIDE + 1) * LINE_INDEX_STRIDE;
+
+    if (*lines + count < next_checkpoint) {
+      *lines += count;
+      pos = end;
+      continue;
+    }
+
+    while (pos < end) {
+      const u8 *newline =
+          (const u8 *)memchr(data + pos, '\n', (usize)(end - pos));
+      if (!newline)
+        break;
+      pos = (u64)(newline - data) + 1;
+      (*lines)++;
+      if (*lines % LINE_INDEX_STRIDE == 0)
+        found[found_count++] = pos;
+    }
+    pos = end;
+  }
+
+  return found_count;
+}
+
+static void *LineIndex_WorkerThread(void *arg) {
+  line_index *index = (line_index *)arg;
+  u64 found[LINE_INDEX_MAX_FOUND];
+
+  Platform_LockMutex(index->mutex);
+  for (;;) {
+    while (!index->released && !LineIndex_NeedsWorkLocked(index)) {
+      Platform_CondWait(index->work_cond, index->mutex);
+    }
+    if (index->released)
+      break;
+
+    platform_file_map map = index->map;
+    u64 from = index->indexed_offset;
+    u64 lines = index->indexed_lines;
+    index->scan_data = map.data;
+    Platform_UnlockMutex(index->mutex);
+
+    u64 to = Min(from + LINE_INDEX_CHUNK, map.size);
+    u32 found_count = LineIndex_ScanChunk(map.data, from, to, &lines, found);
+    /* Scanned pages are not needed again unless the user scrolls there */
+    Platform_ReleaseFileMapRange(&map, from, to - from);
+
+    Platform_LockMutex(index->mutex);
+    index->scan_data = NULL;
+    Platform_UnmapFile(&index->retired);
+    if (index->checkpoint_count + found_count > index->checkpoint_capacity) {
+      u32 capacity = Max(index->checkpoint_capacity * 2,
+                         index->checkpoint_count + found_count);
+      u64 *grown =
+          (u64 *)realloc(index->checkpoints, sizeof(u64) * capacity);
+      if (!grown) {
+        /* Keep what is indexed; queries past it keep returning false */
+        index->want_offset = index->indexed_offset;
+        index->want_line = index->indexed_lines;
+        continue;
+      }
+      index->checkpoints = grown;
+      index->checkpoint_capacity = capacity;
+    }
+    memcpy(index->checkpoints + index->checkpoint_count, found,
+           sizeof(u64) * found_count);
+    index->checkpoint_count += found_count;
+    index->indexed_offset = to;
+    index->indexed_lines = lines;
+    index->complete = to >= index->map.size;
+  }
+  Platform_UnlockMutex(index->mutex);
+
+  LineIndex_Free(index);
+  return NULL;
+}
+
+/* ===== Public API ===== */
+
+line_index *LineIndex_Create(platform_file_map map) {
+  line_index *index = (line_index *)calloc(1, sizeof(line_index));
+  if (!index)
+    return NULL;
+
+  index->checkpoint_capacity = 256;
+  index->checkpoints = (u64 *)malloc(sizeof(u64) * index->checkpoint_capacity);
+  index->mutex = Platform_CreateMutex();
+  index->work_cond = Platform_CreateCondVar();
+  if (index->checkpoints && index->mutex && index->work_cond) {
+    index->map = map;
+    index->checkpoints[0] = 0; /* Line 0 */
+    index->checkpoint_count = 1;
+    index->complete = map.size == 0;
+    index->thread = Platform_CreateThread(LineIndex_WorkerThread, index);
+  }
+
+  if (!index->thread) {
+    /* The map still belongs to the caller */
+    memset(&index->map, 0, sizeof(index->map));
+    LineIndex_Free(index);
+    return NULL;
+  }
+  return index;
+}
+
+void LineIndex_Release(line_index *index) {
+  if (!index)
+    return;
+
+  Platform_DestroyThread(index->thread);
+  Platform_LockMutex(index->mutex);
+  index->released = true;
+  Platform_CondSignal(index->work_cond);
+  Platform_UnlockMutex(index->mutex);
+}
+
+void LineIndex_Remap(line_index *index, platform_file_map map) {
+  platform_file_map unused = {0};
+
+  Platform_LockMutex(index->mutex);
+  if (index->scan_data && index->scan_data == index->map.data) {
+    /* The worker holds the current map until its chunk is done. Anything
+     * retired earlier is no longer read. */
+    unused = index->retired;
+    index->retired = index->map;
+  } else {
+    unused = index->map;
+  }
+  index->map = map;
+  index->complete = index->indexed_offset >= map.size;
+  if (LineIndex_NeedsWorkLocked(index))
+    Platform_CondSignal(index->work_cond);
+  Platform_UnlockMutex(index->mutex);
+
+  Platform_UnmapFile(&unused);
+}
+
+void LineIndex_RequestOffset(line_index *index, u64 offset) {
+  u64 target = Min(offset + LINE_INDEX_LOOKAHEAD, index->map.size);
+
+  Platform_LockMutex(index->mutex);
+  if (target > index->want_offset) {
+    index->want_offset = target;
+    Platform_CondSignal(index->work_cond);
+  }
+  Platform_UnlockMutex(index->mutex);
+}
+
+b32 LineIndex_FindLine(line_index *index, u64 line, u64 *out_offset) {
+  const u8 *data = index->map.data;
+  u64 size = index->map.size;
+  u64 offset = 0;
+
+  Platform_LockMutex(index->mutex);
+  if (index->complete) {
+    /* Text after the last newline is a line of its own */
+    u64 total = index->indexed_lines +
+                ((size > 0 && data[size - 1] != '\n') ? 1 : 0);
+    line = Min(line, total > 0 ? total - 1 : 0);
+  }
+  if (line > index->indexed_lines) {
+    if (line > index->want_line) {
+      index->want_line = line;
+      Platform_CondSignal(index->work_cond);
+    }
+    Platform_UnlockMutex(index->mutex);
+    return false;
+  }
+  offset = index->checkpoints[line / LINE_INDEX_STRIDE];
+  Platform_UnlockMutex(index->mutex);
+
+  /* At most one stride of lines past the checkpoint */
+  for (u64 i = line % LINE_INDEX_STRIDE; i > 0 && offset < size; i--) {
+    const u8 *newline =
+        (const u8 *)memchr(data + offset, '\n', (usize)(size - offset));
+    if (!newline)
+      break;
+    offset = (u64)(newline - data) + 1;
+  }
+
+  *out_offset = offset;
+  return true;
+}
+
+b32 LineIndex_LineAt(line_index *index, u64 offset, u64 *out_line) {
+  u64 checkpoint = 0;
+  u32 low = 0;
+
+  Platform_LockMutex(index->mutex);
+  if (offset > index->indexed_offset) {
+    Platform_UnlockMutex(index->mutex);
+    LineIndex_RequestOffset(index, offset);
+    return false;
+  }
+
+  /* Last checkpoint at or before offset */
+  u32 high = index->checkpoint_count - 1;
+  while (low < high) {
+    u32 mid = low + (high - low + 1) / 2;
+    if (index->checkpoints[mid] <= offset)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+  checkpoint = index->checkpoints[low];
+  Platform_UnlockMutex(index->mutex);
+
+  *out_line = (u64)low * LINE_INDEX_STRIDE +
+              ByteScan_CountByte(index->map.data + checkpoint,
+                                 (usize)(offset - checkpoint), '\n');
+  return true;
+}
+
+u64 LineIndex_GetProgress(line_index *index, b32 *out_complete) {
+  Platform_LockMutex(index->mutex);
+  u64 indexed = index->indexed_offset;
+  if (out_complete)
+    *out_complete = index->complete;
+  Platform_UnlockMutex(index->mutex);
+  return indexed;
+}
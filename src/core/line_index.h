@@ -0,0 +1,78 @@
+/*
+ * line_index.h - Sparse line index over a memory-mapped text file
+ *
+ * Lets the preview show files far larger than RAM: the file stays mapped
+ * and only the pages being looked at are resident. A worker thread records
+ * the byte offset of every LINE_INDEX_STRIDE-th line, on demand, only as
+ * far as the viewer has asked for (the scroll position or a line to jump
+ * to). Pages it has scanned are released again, so resident memory stays
+ * at the visible window plus the checkpoint array.
+ * C99, handmade hero style.
+ */
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include "../platform/platform.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define LINE_INDEX_STRIDE 4096          /* Lines between checkpoints */
+#define LINE_INDEX_CHUNK Megabytes(4)   /* Bytes scanned per lock round trip */
+#define LINE_INDEX_LOOKAHEAD Megabytes(64) /* Indexed past the scroll position */
+
+/* ===== Types ===== */
+
+typedef struct {
+  void *thread; /* Immutable after LineIndex_Create */
+
+  /* Guards everything below. The owner may read 'map' without it. */
+  void *mutex;
+  void *work_cond;
+  platform_file_map map; /* Replaced by LineIndex_Remap when a file grows */
+  platform_file_map retired; /* Previous map, still being scanned */
+  const u8 *scan_data;       /* Map the worker is reading, NULL when idle */
+  b32 released; /* Owner is gone, the worker frees the index */
+  u64 want_offset; /* Index at least up to this byte... */
+  u64 want_line;   /* ...and this line */
+
+  u64 *checkpoints; /* Start offset of line i * LINE_INDEX_STRIDE */
+  u32 checkpoint_count;
+  u32 checkpoint_capacity;
+  u64 indexed_offset; /* Bytes scanned so far */
+  u64 indexed_lines;  /* Newlines in the scanned bytes */
+  b32 complete;
+} line_index;
+
+/* ===== Line Index API =====
+ * All calls must come from the owner (UI) thread.
+ */
+
+/* Take ownership of 'map' and start the worker. Returns NULL on failure
+ * (the map is left to the caller then). */
+line_index *LineIndex_Create(platform_file_map map);
+
+/* Stop the worker and free the index and the mapping. The worker may still
+ * be scanning, so it does the freeing once it notices. */
+void LineIndex_Release(line_index *index);
+
+/* Swap in a new mapping of the same file after it grew. Lines indexed so
+ * far are kept and indexing continues into the appended bytes. */
+void LineIndex_Remap(line_index *index, platform_file_map map);
+
+/* Make sure the index covers 'offset' plus the lookahead */
+void LineIndex_RequestOffset(line_index *index, u64 offset);
+
+/* Byte offset where the 0-based 'line' starts. Lines past the end resolve
+ * to the last line. Returns false (and asks the worker to index that far)
+ * if the line is not indexed yet. */
+b32 LineIndex_FindLine(line_index *index, u64 line, u64 *out_offset);
+
+/* 0-based line containing 'offset'. Returns false if not indexed yet. */
+b32 LineIndex_LineAt(line_index *index, u64 offset, u64 *out_line);
+
+/* Indexing progress: scanned bytes, and whether the whole file is done */
+u64 LineIndex_GetProgress(line_index *index, b32 *out_complete);
+
+#endif /* LINE_INDEX_H */
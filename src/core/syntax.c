@@ -0,0 +1,728 @@
+/*
+ * syntax.c - Table-driven syntax highlighting implementation
+ *
+ * C99, handmade hero style.
+ */
+
+#include "syntax.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ===== Line States ===== */
+
+enum {
+  SYNTAX_STATE_NORMAL,
+  SYNTAX_STATE_BLOCK_COMMENT,
+  SYNTAX_STATE_TRIPLE_DOUBLE, /* Python """ */
+  SYNTAX_STATE_TRIPLE_SINGLE, /* Python ''' */
+  SYNTAX_STATE_BACKTICK,      /* JavaScript template literal */
+  SYNTAX_STATE_DOUBLE,        /* Shell strings run across lines */
+  SYNTAX_STATE_SINGLE,
+  SYNTAX_STATE_FENCE, /* Markdown code block */
+};
+
+/* ===== Language Tables ===== */
+
+typedef struct {
+  const char *extensions; /* Space separated, without the dot */
+  const char *names;      /* Whole file names (dotfiles) */
+  const char *interpreters; /* Matched in a "#!" line */
+  const char *line_comment;
+  b32 comment_after_space; /* '#' only starts a comment after a blank */
+  const char *block_open;
+  const char *block_close;
+  const char *quotes;           /* Characters that open a string */
+  const char *multiline_quotes; /* Those whose strings run across lines */
+  char raw_quote;               /* Strings without backslash escapes */
+  b32 triple_quotes;
+  char meta;               /* '#' directive, '@' decorator, '$' variable */
+  b32 meta_at_line_start;  /* Only as the first character of a line */
+  b32 meta_to_line_end;    /* Takes the rest of the line */
+  const char *word_chars;  /* Allowed in words besides [A-Za-z0-9_] */
+  b32 keys;                /* A word or string before ':' is a key */
+  const char *const *keywords;
+  i32 keyword_count;
+  const char *const *types;
+  i32 type_count;
+} syntax_rules;
+
+static const char *const g_c_keywords[] = {
+    "NULL",     "auto",      "break",    "case",     "catch",   "class",
+    "const",    "constexpr", "continue", "default",  "delete",  "do",
+    "else",     "enum",      "extern",   "false",    "for",     "goto",
+    "if",       "inline",    "namespace", "new",     "nullptr", "operator",
+    "private",  "protected", "public",   "register", "restrict", "return",
+    "sizeof",   "static",    "struct",   "switch",   "template", "this",
+    "throw",    "true",      "try",      "typedef",  "typename", "union",
+    "using",    "virtual",   "volatile", "while"};
+
+static const char *const g_c_types[] = {
+    "b32",      "bool",     "char",    "double",   "f32",      "f64",
+    "float",    "i16",      "i32",     "i64",      "i8",       "int",
+    "int16_t",  "int32_t",  "int64_t", "int8_t",   "isize",    "long",
+    "ptrdiff_t", "short",   "signed",  "size_t",   "ssize_t",  "u16",
+    "u32",      "u64",      "u8",      "uint16_t", "uint32_t", "uint64_t",
+    "uint8_t",  "uintptr_t", "unsigned", "usize",  "void",     "wchar_t"};
+
+static const char *const g_python_keywords[] = {
+    "False",  "None",   "True",     "and",    "as",     "assert", "async",
+    "await",  "break",  "class",    "continue", "def",  "del",    "elif",
+    "else",   "except", "finally",  "for",    "from",   "global", "if",
+    "import", "in",     "is",       "lambda", "nonlocal", "not",  "or",
+    "pass",   "raise",  "return",   "try",    "while",  "with",   "yield"};
+
+static const char *const g_python_types[] = {
+    "bool", "bytes", "dict", "float", "int", "list",
+    "object", "self", "set", "str", "tuple"};
+
+static const char *const g_javascript_keywords[] = {
+    "async",     "await",     "break",  "case",      "catch",  "class",
+    "const",     "continue",  "debugger", "default", "delete", "do",
+    "else",      "enum",      "export", "extends",   "false",  "finally",
+    "for",       "function",  "if",     "implements", "import", "in",
+    "instanceof", "interface", "let",   "new",       "null",   "of",
+    "return",    "static",    "super",  "switch",    "this",   "throw",
+    "true",      "try",       "type",   "typeof",    "undefined", "var",
+    "void",      "while",     "with",   "yield"};
+
+static const char *const g_javascript_types[] = {
+    "any",    "boolean", "never", "number", "object",
+    "string", "symbol",  "unknown"};
+
+static const char *const g_shell_keywords[] = {
+    "break",  "case",   "continue", "do",     "done",     "elif",
+    "else",   "esac",   "exit",     "export", "fi",       "for",
+    "function", "if",   "in",       "local",  "readonly", "return",
+    "select", "shift",  "then",     "until",  "unset",    "while"};
+
+static const char *const g_shell_types[] = {
+    "alias", "cd",   "echo", "eval", "exec", "printf",
+    "read",  "set",  "source", "test", "trap"};
+
+static const char *const g_json_keywords[] = {"false", "null", "true"};
+
+static const char *const g_yaml_keywords[] = {"false", "no",  "null", "off",
+                                              "on",    "true", "yes"};
+
+#define SYNTAX_WORDS(list) list, (i32)ArrayCount(list)
+
+static const syntax_rules g_syntax_rules[SYNTAX_LANGUAGE_COUNT] = {
+    [SYNTAX_LANGUAGE_C] =
+        {.extensions = "c h cc cpp cxx hh hpp hxx inl m mm",
+         .line_comment = "//",
+         .block_open = "/*",
+         .block_close = "*/",
+         .quotes = "\"'",
+         .meta = '#',
+         .meta_at_line_start = true,
+         .meta_to_line_end = true,
+         .keywords = SYNTAX_WORDS(g_c_keywords),
+         .types = SYNTAX_WORDS(g_c_types)},
+    [SYNTAX_LANGUAGE_PYTHON] =
+        {.extensions = "py pyw pyi",
+         .interpreters = "python",
+         .line_comment = "#",
+         .quotes = "\"'",
+         .triple_quotes = true,
+         .meta = '@',
+         .meta_at_line_start = true,
+         .keywords = SYNTAX_WORDS(g_python_keywords),
+         .types = SYNTAX_WORDS(g_python_types)},
+    [SYNTAX_LANGUAGE_JAVASCRIPT] =
+        {.extensions = "js mjs cjs jsx ts mts cts tsx",
+         .interpreters = "node deno bun",
+         .line_comment = "//",
+         .block_open = "/*",
+         .block_close = "*/",
+         .quotes = "\"'`",
+         .multiline_quotes = "`",
+         .word_chars = "$",
+         .keywords = SYNTAX_WORDS(g_javascript_keywords),
+         .types = SYNTAX_WORDS(g_javascript_types)},
+    [SYNTAX_LANGUAGE_SHELL] =
+        {.extensions = "sh bash zsh ksh",
+         .names = ".bashrc .bash_profile .bash_aliases .profile .zshrc "
+                  ".zprofile .zshenv PKGBUILD",
+         .interpreters = "sh bash zsh ksh dash",
+         .line_comment = "#",
+         .comment_after_space = true,
+         .quotes = "\"'",
+         .multiline_quotes = "\"'",
+         .raw_quote = '\'',
+         .meta = '$',
+         .keywords = SYNTAX_WORDS(g_shell_keywords),
+         .types = SYNTAX_WORDS(g_shell_types)},
+    [SYNTAX_LANGUAGE_JSON] =
+        {.extensions = "json jsonc geojson webmanifest",
+         .line_comment = "//",
+         .quotes = "\"",
+         .keys = true,
+         .keywords = SYNTAX_WORDS(g_json_keywords)},
+    [SYNTAX_LANGUAGE_YAML] =
+        {.extensions = "yml yaml",
+         .line_comment = "#",
+         .comment_after_space = true,
+         .quotes = "\"'",
+         .raw_quote = '\'',
+         .word_chars = "-.",
+         .keys = true,
+         .keywords = SYNTAX_WORDS(g_yaml_keywords)},
+    [SYNTAX_LANGUAGE_MARKDOWN] = {.extensions = "md markdown mdown mkd"},
+};
+
+/* ===== Helpers ===== */
+
+static b32 Syntax_IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+static b32 Syntax_IsAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static b32 Syntax_IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+/* c is one of 'set' (never the terminator) */
+static b32 Syntax_InSet(const char *set, char c) {
+  return set && c != '\0' && strchr(set, c) != NULL;
+}
+
+static b32 Syntax_IsWordChar(const syntax_rules *rules, char c) {
+  return Syntax_IsAlpha(c) || Syntax_IsDigit(c) ||
+         Syntax_InSet(rules->word_chars, c);
+}
+
+static b32 Syntax_StartsWith(const char *line, usize len, usize at,
+                             const char *prefix) {
+  usize prefix_len = strlen(prefix);
+  return at + prefix_len <= len && memcmp(line + at, prefix, prefix_len) == 0;
+}
+
+static char Syntax_Lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+/* Whether the space separated 'list' holds word[0..len) */
+static b32 Syntax_ListContains(const char *list, const char *word, usize len,
+                               b32 ignore_case) {
+  while (list && *list) {
+    usize item_len = strcspn(list, " ");
+    if (item_len == len) {
+      usize i = 0;
+      while (i < len && (ignore_case ? Syntax_Lower(list[i]) ==
+                                           Syntax_Lower(word[i])
+                                     : list[i] == word[i])) {
+        i++;
+      }
+      if (i == len) {
+        return true;
+      }
+    }
+    list += item_len;
+    while (*list == ' ') {
+      list++;
+    }
+  }
+  return false;
+}
+
+static b32 Syntax_WordIn(const char *const *words, i32 count, const char *word,
+                         usize len) {
+  for (i32 i = 0; i < count; i++) {
+    if (words[i][0] == word[0] && strlen(words[i]) == len &&
+        memcmp(words[i], word, len) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* ===== Language Detection ===== */
+
+static syntax_language Syntax_DetectInterpreter(const char *text,
+                                                usize text_len) {
+  const char *end;
+  usize len;
+
+  if (text_len < 2 || text[0] != '#' || text[1] != '!') {
+    return SYNTAX_LANGUAGE_NONE;
+  }
+  end = (const char *)memchr(text, '\n', text_len);
+  len = end ? (usize)(end - text) : text_len;
+
+  /* The last word of the command, or the one after "env" */
+  for (usize i = 2; i < len;) {
+    while (i < len && (text[i] == ' ' || text[i] == '/')) {
+      i++;
+    }
+    usize start = i;
+    while (i < len && text[i] != ' ' && text[i] != '/') {
+      i++;
+    }
+    usize word_len = i - start;
+
+    /* Version suffixes: python3, python3.12 */
+    while (word_len > 0 && (Syntax_IsDigit(text[start + word_len - 1]) ||
+                            text[start + word_len - 1] == '.')) {
+      word_len--;
+    }
+    for (i32 language = 0; language < SYNTAX_LANGUAGE_COUNT; language++) {
+      if (word_len > 0 &&
+          Syntax_ListContains(g_syntax_rules[language].interpreters,
+                              text + start, word_len, false)) {
+        return (syntax_language)language;
+      }
+    }
+  }
+  return SYNTAX_LANGUAGE_NONE;
+}
+
+syntax_language Syntax_DetectLanguage(const char *name, const char *text,
+                                      usize text_len) {
+  const char *dot = name ? strrchr(name, '.') : NULL;
+
+  for (i32 language = 0; name && language < SYNTAX_LANGUAGE_COUNT;
+       language++) {
+    const syntax_rules *rules = &g_syntax_rules[language];
+    if (Syntax_ListContains(rules->names, name, strlen(name), false) ||
+        (dot && dot != name &&
+         Syntax_ListContains(rules->extensions, dot + 1, strlen(dot + 1),
+                             true))) {
+      return (syntax_language)language;
+    }
+  }
+  return text ? Syntax_DetectInterpreter(text, text_len) : SYNTAX_LANGUAGE_NONE;
+}
+
+/* ===== Span Output ===== */
+
+typedef struct {
+  syntax_span *spans;
+  i32 max_spans;
+  i32 count;
+} syntax_output;
+
+static void Syntax_Emit(syntax_output *out, usize start, usize end,
+                        syntax_token token) {
+  if (!out->spans || end <= start) {
+    return;
+  }
+  if (out->count > 0) {
+    syntax_span *last = &out->spans[out->count - 1];
+    if (last->token == token || out->count == out->max_spans) {
+      last->length = (u32)(end - last->start);
+      return;
+    }
+  }
+  if (out->max_spans > 0) {
+    out->spans[out->count++] = (syntax_span){(u32)start, (u32)(end - start),
+                                             token};
+  }
+}
+
+/* Past the 'close' that ends a construct running from 'at', or the end of
+ * the line (*out_closed false) */
+static usize Syntax_ScanTo(const char *line, usize len, usize at,
+                           const char *close, b32 escapes, b32 *out_closed) {
+  while (at < len) {
+    if (escapes && line[at] == '\\') {
+      at += 2;
+      continue;
+    }
+    if (Syntax_StartsWith(line, len, at, close)) {
+      *out_closed = true;
+      return at + strlen(close);
+    }
+    at++;
+  }
+  *out_closed = false;
+  return len;
+}
+
+/* ===== Lexer ===== */
+
+static const char *Syntax_StateClose(const syntax_rules *rules,
+                                     syntax_state state) {
+  switch (state) {
+  case SYNTAX_STATE_BLOCK_COMMENT:
+    return rules->block_close;
+  case SYNTAX_STATE_TRIPLE_DOUBLE:
+    return "\"\"\"";
+  case SYNTAX_STATE_TRIPLE_SINGLE:
+    return "'''";
+  case SYNTAX_STATE_BACKTICK:
+    return "`";
+  case SYNTAX_STATE_DOUBLE:
+    return "\"";
+  case SYNTAX_STATE_SINGLE:
+    return "'";
+  default:
+    return NULL;
+  }
+}
+
+static syntax_state Syntax_QuoteState(char quote) {
+  switch (quote) {
+  case '"':
+    return SYNTAX_STATE_DOUBLE;
+  case '\'':
+    return SYNTAX_STATE_SINGLE;
+  default:
+    return SYNTAX_STATE_BACKTICK;
+  }
+}
+
+/* Whether ':' follows 'at' (after blanks). Bare YAML words need a blank
+ * or the line end after it, so "http://" is no key. */
+static b32 Syntax_KeyFollows(const char *line, usize len, usize at,
+                             b32 quoted) {
+  while (at < len && Syntax_IsBlank(line[at])) {
+    at++;
+  }
+  return at < len && line[at] == ':' &&
+         (quoted || at + 1 == len || Syntax_IsBlank(line[at + 1]));
+}
+
+static usize Syntax_ScanNumber(const char *line, usize len, usize at) {
+  b32 hex = at + 1 < len && line[at] == '0' &&
+            (line[at + 1] == 'x' || line[at + 1] == 'X');
+
+  while (at < len) {
+    char c = line[at];
+    if (!hex && (c == 'e' || c == 'E') && at + 1 < len &&
+        (line[at + 1] == '+' || line[at + 1] == '-')) {
+      at += 2;
+    } else if (Syntax_IsAlpha(c) || Syntax_IsDigit(c) || c == '.') {
+      at++;
+    } else {
+      break;
+    }
+  }
+  return at;
+}
+
+static syntax_state Syntax_TokenizeCode(const syntax_rules *rules,
+                                        syntax_state state, const char *line,
+                                        usize len, syntax_output *out) {
+  usize first = 0;
+  usize i = 0;
+
+  /* Finish what the previous line left open */
+  if (state != SYNTAX_STATE_NORMAL) {
+    const char *close = Syntax_StateClose(rules, state);
+    b32 closed = false;
+    if (close) {
+      i = Syntax_ScanTo(line, len, 0, close,
+                        state != SYNTAX_STATE_BLOCK_COMMENT &&
+                            close[0] != rules->raw_quote,
+                        &closed);
+    }
+    Syntax_Emit(out, 0, i,
+                state == SYNTAX_STATE_BLOCK_COMMENT ? SYNTAX_TOKEN_COMMENT
+                                                    : SYNTAX_TOKEN_STRING);
+    if (!closed) {
+      return close ? state : SYNTAX_STATE_NORMAL;
+    }
+    state = SYNTAX_STATE_NORMAL;
+  }
+
+  while (first < len && Syntax_IsBlank(line[first])) {
+    first++;
+  }
+
+  while (i < len) {
+    usize start = i;
+    char c = line[i];
+    syntax_token token = SYNTAX_TOKEN_TEXT;
+
+    if (Syntax_IsBlank(c)) {
+      i++;
+    } else if (rules->line_comment &&
+               Syntax_StartsWith(line, len, i, rules->line_comment) &&
+               (!rules->comment_after_space || i == 0 ||
+                Syntax_IsBlank(line[i - 1]))) {
+      i = len;
+      token = SYNTAX_TOKEN_COMMENT;
+    } else if (rules->block_open &&
+               Syntax_StartsWith(line, len, i, rules->block_open)) {
+      b32 closed;
+      i = Syntax_ScanTo(line, len, i + strlen(rules->block_open),
+                        rules->block_close, false, &closed);
+      token = SYNTAX_TOKEN_COMMENT;
+      if (!closed) {
+        state = SYNTAX_STATE_BLOCK_COMMENT;
+      }
+    } else if (rules->meta && c == rules->meta &&
+               (!rules->meta_at_line_start || i == first)) {
+      i++;
+      if (rules->meta_to_line_end) {
+        i = len;
+      } else if (i < len && line[i] == '{') {
+        b32 closed;
+        i = Syntax_ScanTo(line, len, i, "}", false, &closed);
+      } else if (rules->meta_at_line_start) {
+        while (i < len && line[i] != '(' && !Syntax_IsBlank(line[i])) {
+          i++; /* @app.route */
+        }
+      } else if (i < len && Syntax_IsWordChar(rules, line[i])) {
+        while (i < len && Syntax_IsWordChar(rules, line[i])) {
+          i++;
+        }
+      } else if (i < len && !Syntax_IsBlank(line[i])) {
+        i++; /* $?, $#, $1 */
+      }
+      token = SYNTAX_TOKEN_META;
+    } else if (Syntax_InSet(rules->quotes, c)) {
+      b32 triple = rules->triple_quotes && i + 2 < len && line[i + 1] == c &&
+                   line[i + 2] == c;
+      char close[4] = {c, triple ? c : '\0', triple ? c : '\0', '\0'};
+      b32 closed;
+      i = Syntax_ScanTo(line, len, i + strlen(close), close,
+                        c != rules->raw_quote, &closed);
+      token = rules->keys && Syntax_KeyFollows(line, len, i, true)
+                  ? SYNTAX_TOKEN_KEY
+                  : SYNTAX_TOKEN_STRING;
+      if (!closed && triple) {
+        state = c == '"' ? SYNTAX_STATE_TRIPLE_DOUBLE
+                         : SYNTAX_STATE_TRIPLE_SINGLE;
+      } else if (!closed && Syntax_InSet(rules->multiline_quotes, c)) {
+        state = Syntax_QuoteState(c);
+      }
+    } else if (Syntax_IsDigit(c) ||
+               (c == '.' && i + 1 < len && Syntax_IsDigit(line[i + 1]))) {
+      i = Syntax_ScanNumber(line, len, i);
+      token = SYNTAX_TOKEN_NUMBER;
+    } else if (Syntax_IsWordChar(rules, c) && !Syntax_IsDigit(c)) {
+      while (i < len && Syntax_IsWordChar(rules, line[i])) {
+        i++;
+      }
+      if (rules->keys && Syntax_KeyFollows(line, len, i, false)) {
+        token = SYNTAX_TOKEN_KEY;
+      } else if (Syntax_WordIn(rules->keywords, rules->keyword_count,
+                               line + start, i - start)) {
+        token = SYNTAX_TOKEN_KEYWORD;
+      } else if (Syntax_WordIn(rules->types, rules->type_count, line + start,
+                               i - start)) {
+        token = SYNTAX_TOKEN_TYPE;
+      }
+    } else {
+      i++;
+    }
+
+    Syntax_Emit(out, start, i, token);
+  }
+
+  return state;
+}
+
+/* Headings, quotes and code fences are whole lines; inline code, emphasis
+ * and links are found within the others */
+static syntax_state Syntax_TokenizeMarkdown(syntax_state state,
+                                            const char *line, usize len,
+                                            syntax_output *out) {
+  usize first = 0;
+  usize i;
+
+  while (first < len && Syntax_IsBlank(line[first])) {
+    first++;
+  }
+
+  b32 fence = Syntax_StartsWith(line, len, first, "```") ||
+              Syntax_StartsWith(line, len, first, "~~~");
+  if (state == SYNTAX_STATE_FENCE) {
+    Syntax_Emit(out, 0, len, fence ? SYNTAX_TOKEN_META : SYNTAX_TOKEN_STRING);
+    return fence ? SYNTAX_STATE_NORMAL : SYNTAX_STATE_FENCE;
+  }
+  if (fence) {
+    Syntax_Emit(out, 0, len, SYNTAX_TOKEN_META);
+    return SYNTAX_STATE_FENCE;
+  }
+  if (first < len && (line[first] == '#' || line[first] == '>')) {
+    Syntax_Emit(out, 0, len,
+                line[first] == '#' ? SYNTAX_TOKEN_KEYWORD
+                                   : SYNTAX_TOKEN_COMMENT);
+    return SYNTAX_STATE_NORMAL;
+  }
+
+  /* List marker: "- ", "* ", "+ ", "1. ", "1) " */
+  Syntax_Emit(out, 0, first, SYNTAX_TOKEN_TEXT);
+  i = first;
+  while (i < len && Syntax_IsDigit(line[i])) {
+    i++;
+  }
+  if (i < len && ((i > first && (line[i] == '.' || line[i] == ')')) ||
+                  (i == first && (line[i] == '-' || line[i] == '*' ||
+                                  line[i] == '+'))) &&
+      (i + 1 == len || line[i + 1] == ' ')) {
+    Syntax_Emit(out, first, i + 1, SYNTAX_TOKEN_META);
+    i++;
+  } else {
+    i = first;
+  }
+
+  while (i < len) {
+    usize start = i;
+    syntax_token token = SYNTAX_TOKEN_TEXT;
+    b32 closed = false;
+
+    if (line[i] == '`') {
+      i = Syntax_ScanTo(line, len, i + 1, "`", false, &closed);
+      token = SYNTAX_TOKEN_STRING;
+    } else if (Syntax_StartsWith(line, len, i, "**")) {
+      i = Syntax_ScanTo(line, len, i + 2, "**", false, &closed);
+      token = SYNTAX_TOKEN_TYPE;
+    } else if (line[i] == '*' && i + 1 < len && !Syntax_IsBlank(line[i + 1])) {
+      i = Syntax_ScanTo(line, len, i + 1, "*", false, &closed);
+      token = SYNTAX_TOKEN_TYPE;
+    } else if (line[i] == '[') {
+      i = Syntax_ScanTo(line, len, i + 1, "]", false, &closed);
+      token = SYNTAX_TOKEN_KEY;
+      if (closed && i < len && line[i] == '(') {
+        Syntax_Emit(out, start, i, token);
+        start = i;
+        i = Syntax_ScanTo(line, len, i + 1, ")", false, &closed);
+        token = SYNTAX_TOKEN_META;
+      }
+    } else {
+      i++;
+    }
+
+    Syntax_Emit(out, start, i, token);
+  }
+
+  return SYNTAX_STATE_NORMAL;
+}
+
+syntax_state Syntax_TokenizeLine(syntax_language language, syntax_state state,
+                                 const char *line, usize len,
+                                 syntax_span *spans, i32 max_spans,
+                                 i32 *out_count) {
+  syntax_output out = {spans, max_spans, 0};
+
+  if (language <= SYNTAX_LANGUAGE_NONE || language >= SYNTAX_LANGUAGE_COUNT) {
+    Syntax_Emit(&out, 0, len, SYNTAX_TOKEN_TEXT);
+    state = SYNTAX_STATE_NORMAL;
+  } else if (language == SYNTAX_LANGUAGE_MARKDOWN) {
+    state = Syntax_TokenizeMarkdown(state, line, len, &out);
+  } else {
+    state = Syntax_TokenizeCode(&g_syntax_rules[language], state, line, len,
+                                &out);
+  }
+
+  if (out_count) {
+    *out_count = out.count;
+  }
+  return state;
+}
+
+/* ===== Line State Cache ===== */
+
+void SyntaxLines_Init(syntax_lines *lines, syntax_language language) {
+  memset(lines, 0, sizeof(*lines));
+  lines->language = language;
+}
+
+void SyntaxLines_Free(syntax_lines *lines) {
+  free(lines->offsets);
+  free(lines->states);
+  memset(lines, 0, sizeof(*lines));
+}
+
+/* First entry at or after 'offset' */
+static u32 SyntaxLines_Search(const syntax_lines *lines, u64 offset) {
+  u32 low = 0;
+  u32 high = lines->count;
+
+  while (low < high) {
+    u32 mid = low + (high - low) / 2;
+    if (lines->offsets[mid] < offset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+void SyntaxLines_Record(syntax_lines *lines, u64 offset, syntax_state state) {
+  u32 at = SyntaxLines_Search(lines, offset);
+
+  if (at < lines->count && lines->offsets[at] == offset) {
+    lines->states[at] = state;
+    return;
+  }
+
+  if (lines->count == lines->capacity) {
+    u32 capacity = lines->capacity ? lines->capacity * 2 : 256;
+    u64 *offsets = (u64 *)realloc(lines->offsets, sizeof(u64) * capacity);
+    if (!offsets) {
+      return; /* Only a cache */
+    }
+    lines->offsets = offsets;
+    syntax_state *states =
+        (syntax_state *)realloc(lines->states, sizeof(syntax_state) * capacity);
+    if (!states) {
+      return;
+    }
+    lines->states = states;
+    lines->capacity = capacity;
+  }
+
+  memmove(lines->offsets + at + 1, lines->offsets + at,
+          sizeof(u64) * (lines->count - at));
+  memmove(lines->states + at + 1, lines->states + at,
+          sizeof(syntax_state) * (lines->count - at));
+  lines->offsets[at] = offset;
+  lines->states[at] = state;
+  lines->count++;
+}
+
+syntax_state SyntaxLines_StateAt(syntax_lines *lines, const char *text,
+                                 usize text_len, u64 offset) {
+  u64 at = 0;
+  u64 last_kept;
+  syntax_state state = SYNTAX_STATE_NORMAL;
+  u32 index;
+
+  if (offset == 0 || lines->language == SYNTAX_LANGUAGE_NONE) {
+    return SYNTAX_STATE_NORMAL;
+  }
+  offset = Min(offset, (u64)text_len);
+
+  index = SyntaxLines_Search(lines, offset);
+  if (index < lines->count && lines->offsets[index] == offset) {
+    return lines->states[index];
+  }
+  if (index > 0) {
+    at = lines->offsets[index - 1];
+    state = lines->states[index - 1];
+  }
+
+  /* Too far to catch up: start over at a line nearer by */
+  if (offset - at > SYNTAX_CATCHUP_BYTES) {
+    const char *newline;
+    at = offset - SYNTAX_CATCHUP_BYTES;
+    newline = (const char *)memchr(text + at, '\n', (usize)(offset - at));
+    at = newline ? (u64)(newline - text) + 1 : offset;
+    state = SYNTAX_STATE_NORMAL;
+  }
+
+  last_kept = at;
+  lines->lexed_bytes += offset - at;
+  while (at < offset) {
+    const char *newline =
+        (const char *)memchr(text + at, '\n', (usize)(offset - at));
+    u64 end = newline ? (u64)(newline - text) : offset;
+
+    /* A split long line: 'offset' is not after a newline */
+    state = Syntax_TokenizeLine(lines->language, state, text + at,
+                                (usize)(end - at), NULL, 0, NULL);
+    at = newline ? end + 1 : offset;
+    if (at < offset && at - last_kept >= SYNTAX_CHECKPOINT_BYTES) {
+      SyntaxLines_Record(lines, at, state);
+      last_kept = at;
+    }
+  }
+
+  SyntaxLines_Record(lines, offset, state);
+  return state;
+}
@@ -0,0 +1,102 @@
+/*
+ * syntax.h - Table-driven syntax highlighting for text previews
+ *
+ * Every language is a table (comment markers, quotes, word lists) read by
+ * one small lexer that works a line at a time. The only thing carried from
+ * one line to the next is a syntax_state (inside a block comment, a
+ * multi-line string, a code fence), so a viewer can cache it at line
+ * starts and lex just the lines it shows rather than the file from the top.
+ * C99, handmade hero style.
+ */
+
+#ifndef SYNTAX_H
+#define SYNTAX_H
+
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define SYNTAX_CHECKPOINT_BYTES Kilobytes(4) /* States kept while catching up */
+#define SYNTAX_CATCHUP_BYTES Megabytes(1)    /* Lexed at most to reach a line */
+
+/* ===== Types ===== */
+
+typedef enum {
+  SYNTAX_LANGUAGE_NONE,
+  SYNTAX_LANGUAGE_C,
+  SYNTAX_LANGUAGE_PYTHON,
+  SYNTAX_LANGUAGE_JAVASCRIPT,
+  SYNTAX_LANGUAGE_SHELL,
+  SYNTAX_LANGUAGE_JSON,
+  SYNTAX_LANGUAGE_YAML,
+  SYNTAX_LANGUAGE_MARKDOWN,
+  SYNTAX_LANGUAGE_COUNT,
+} syntax_language;
+
+typedef enum {
+  SYNTAX_TOKEN_TEXT,
+  SYNTAX_TOKEN_KEYWORD, /* Also Markdown headings */
+  SYNTAX_TOKEN_TYPE,    /* Also Markdown emphasis */
+  SYNTAX_TOKEN_STRING,  /* Also Markdown code */
+  SYNTAX_TOKEN_NUMBER,
+  SYNTAX_TOKEN_COMMENT, /* Also Markdown quotes */
+  SYNTAX_TOKEN_META,    /* Directives, decorators, shell variables */
+  SYNTAX_TOKEN_KEY,     /* JSON and YAML keys, Markdown links */
+  SYNTAX_TOKEN_COUNT,
+} syntax_token;
+
+/* Lexer state at a line start. 0 is the state at the start of a file. */
+typedef u8 syntax_state;
+
+/* A run of one token, relative to the start of its line */
+typedef struct {
+  u32 start;
+  u32 length;
+  syntax_token token;
+} syntax_span;
+
+/* Lexer states at line starts of one text, learned lazily: every line a
+ * viewer draws, plus one every SYNTAX_CHECKPOINT_BYTES of the lines lexed
+ * to get there. The text may grow at the end (states stay valid) but must
+ * not otherwise change. */
+typedef struct {
+  syntax_language language;
+  u64 *offsets; /* Line starts with a known state, ascending */
+  syntax_state *states;
+  u32 count;
+  u32 capacity;
+
+  /* Counter for tuning */
+  u64 lexed_bytes; /* Lexed to reach lines not cached yet */
+} syntax_lines;
+
+/* ===== Syntax API ===== */
+
+/* Language from the file name, or the "#!" line at the start of 'text'
+ * (NONE if unknown) */
+syntax_language Syntax_DetectLanguage(const char *name, const char *text,
+                                      usize text_len);
+
+/* Lex one line (without its newline) that starts in 'state'. Writes spans
+ * covering the whole line, merging the rest into the last one past
+ * max_spans; spans may be NULL to only follow the state. Returns the state
+ * at the start of the next line. */
+syntax_state Syntax_TokenizeLine(syntax_language language, syntax_state state,
+                                 const char *line, usize len,
+                                 syntax_span *spans, i32 max_spans,
+                                 i32 *out_count);
+
+void SyntaxLines_Init(syntax_lines *lines, syntax_language language);
+void SyntaxLines_Free(syntax_lines *lines);
+
+/* Remember the state at the line starting at 'offset' */
+void SyntaxLines_Record(syntax_lines *lines, u64 offset, syntax_state state);
+
+/* State at the line starting at 'offset' of 'text'. Lexes forward from the
+ * closest line start known before it; from more than SYNTAX_CATCHUP_BYTES
+ * away it starts over that far back instead, assuming nothing is open
+ * there. */
+syntax_state SyntaxLines_StateAt(syntax_lines *lines, const char *text,
+                                 usize text_len, u64 offset);
+
+#endif /* SYNTAX_H */
@@ -159,6 +159,143 @@ i32 Text_UTF8ByteOffset(const char *str, i32 char_index) {
   return byte;
 }
 
+i32 Text_UTF8Decode(const char *text, usize len, u32 *out_codepoint) {
+  const u8 *s = (const u8 *)text;
+  u32 codepoint;
+  u32 minimum;
+  i32 length;
+
+  if (s[0] < 0x80) {
+    *out_codepoint = s[0];
+    return 1;
+  }
+  if (s[0] >= 0xC2 && s[0] <= 0xDF) {
+    codepoint = s[0] & 0x1F;
+    minimum = 0x80;
+    length = 2;
+  } else if (s[0] >= 0xE0 && s[0] <= 0xEF) {
+    codepoint = s[0] & 0x0F;
+    minimum = 0x800;
+    length = 3;
+  } else if (s[0] >= 0xF0 && s[0] <= 0xF4) {
+    codepoint = s[0] & 0x07;
+    minimum = 0x10000;
+    length = 4;
+  } else {
+    *out_codepoint = TEXT_REPLACEMENT_CHARACTER;
+    return 1;
+  }
+
+  for (i32 i = 1; i < length; i++) {
+    if ((usize)i >= len || (s[i] & 0xC0) != 0x80) {
+      *out_codepoint = TEXT_REPLACEMENT_CHARACTER;
+      return i;
+    }
+    codepoint = (codepoint << 6) | (s[i] & 0x3F);
+  }
+
+  /* Overlong forms, surrogates and values past Unicode */
+  if (codepoint < minimum || codepoint > 0x10FFFF ||
+      (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+    codepoint = TEXT_REPLACEMENT_CHARACTER;
+  }
+  *out_codepoint = codepoint;
+  return length;
+}
+
+i32 Text_UTF8Encode(u32 codepoint, char *out) {
+  if (codepoint < 0x80) {
+    out[0] = (char)codepoint;
+    return 1;
+  }
+  if (codepoint < 0x800) {
+    out[0] = (char)(0xC0 | (codepoint >> 6));
+    out[1] = (char)(0x80 | (codepoint & 0x3F));
+    return 2;
+  }
+  if (codepoint < 0x10000) {
+    out[0] = (char)(0xE0 | (codepoint >> 12));
+    out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (codepoint & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (codepoint >> 18));
+  out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (codepoint & 0x3F));
+  return 4;
+}
+
+typedef struct {
+  u32 first;
+  u32 last;
+} text_codepoint_range;
+
+static b32 Text_InRanges(const text_codepoint_range *ranges, i32 count,
+                         u32 codepoint) {
+  i32 low = 0;
+  i32 high = count - 1;
+
+  while (low <= high) {
+    i32 mid = (low + high) / 2;
+    if (codepoint < ranges[mid].first) {
+      high = mid - 1;
+    } else if (codepoint > ranges[mid].last) {
+      low = mid + 1;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+i32 Text_CodepointColumns(u32 codepoint) {
+  /* Combining marks, zero-width spaces and joiners, variation selectors */
+  static const text_codepoint_range zero_width[] = {
+      {0x0300, 0x036F},   {0x0483, 0x0489},   {0x0591, 0x05BD},
+      {0x0610, 0x061A},   {0x064B, 0x065F},   {0x0E31, 0x0E31},
+      {0x0E34, 0x0E3A},   {0x0E47, 0x0E4E},   {0x1AB0, 0x1AFF},
+      {0x1DC0, 0x1DFF},   {0x200B, 0x200F},   {0x202A, 0x202E},
+      {0x2060, 0x2064},   {0x20D0, 0x20FF},   {0xFE00, 0xFE0F},
+      {0xFE20, 0xFE2F},   {0xFEFF, 0xFEFF},   {0xE0100, 0xE01EF},
+  };
+  /* East Asian wide and fullwidth, emoji */
+  static const text_codepoint_range wide[] = {
+      {0x1100, 0x115F},   {0x231A, 0x231B},   {0x2329, 0x232A},
+      {0x23E9, 0x23EC},   {0x23F0, 0x23F0},   {0x23F3, 0x23F3},
+      {0x25FD, 0x25FE},   {0x2614, 0x2615},   {0x2648, 0x2653},
+      {0x267F, 0x267F},   {0x2693, 0x2693},   {0x26A1, 0x26A1},
+      {0x26AA, 0x26AB},   {0x26BD, 0x26BE},   {0x26C4, 0x26C5},
+      {0x26CE, 0x26CE},   {0x26D4, 0x26D4},   {0x26EA, 0x26EA},
+      {0x26F2, 0x26F3},   {0x26F5, 0x26F5},   {0x26FA, 0x26FA},
+      {0x26FD, 0x26FD},   {0x2705, 0x2705},   {0x270A, 0x270B},
+      {0x2728, 0x2728},   {0x274C, 0x274C},   {0x274E, 0x274E},
+      {0x2753, 0x2755},   {0x2757, 0x2757},   {0x2795, 0x2797},
+      {0x27B0, 0x27B0},   {0x27BF, 0x27BF},   {0x2B1B, 0x2B1C},
+      {0x2B50, 0x2B50},   {0x2B55, 0x2B55},   {0x2E80, 0x303E},
+      {0x3041, 0x33FF},   {0x3400, 0x4DBF},   {0x4E00, 0x9FFF},
+      {0xA000, 0xA4CF},   {0xA960, 0xA97F},   {0xAC00, 0xD7A3},
+      {0xF900, 0xFAFF},   {0xFE10, 0xFE19},   {0xFE30, 0xFE6F},
+      {0xFF00, 0xFF60},   {0xFFE0, 0xFFE6},   {0x16FE0, 0x16FE4},
+      {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004},
+      {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A},
+      {0x1F200, 0x1F251}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF},
+      {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+      {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+  };
+
+  if (codepoint < 0x0300) {
+    return 1;
+  }
+  if (Text_InRanges(zero_width, (i32)ArrayCount(zero_width), codepoint)) {
+    return 0;
+  }
+  if (Text_InRanges(wide, (i32)ArrayCount(wide), codepoint)) {
+    return 2;
+  }
+  return 1;
+}
+
 static b32 IsSeparator(char c) { return c == ' ' || c == '/'; }
 
 i32 Text_FindWordBoundaryLeft(const char *text, i32 start_pos) {
@@ -44,6 +44,21 @@ i32 Text_GetWrappedHeight(i32 line_count, font *f);
 i32 Text_UTF8Length(const char *str);
 i32 Text_UTF8ByteOffset(const char *str, i32 char_index);
 
+#define TEXT_REPLACEMENT_CHARACTER 0xFFFD
+
+/* Decode the codepoint starting text[0..len) (len > 0). Returns the bytes
+ * it takes. A malformed sequence decodes as U+FFFD and takes the bytes up
+ * to the first one that doesn't continue it, which is never read past: a
+ * NUL-terminated string can pass any len >= 4. */
+i32 Text_UTF8Decode(const char *text, usize len, u32 *out_codepoint);
+
+/* Encode a codepoint into out[0..4). Returns the bytes written. */
+i32 Text_UTF8Encode(u32 codepoint, char *out);
+
+/* Cells a codepoint takes in a monospace grid: 0 for combining marks and
+ * zero-width characters, 2 for East Asian wide and emoji, 1 otherwise */
+i32 Text_CodepointColumns(u32 codepoint);
+
 /* Word boundary helpers (treats ' ' and '/' as separators) */
 i32 Text_FindWordBoundaryLeft(const char *text, i32 start_pos);
 i32 Text_FindWordBoundaryRight(const char *text, i32 start_pos);
@@ -35,6 +35,15 @@ static theme g_dark_theme = {
     .warning = {249, 226, 175, 255}, /* #F9E2AF (yellow) */
     .error = {243, 139, 168, 255},   /* #F38BA8 (red) */
 
+    /* Syntax highlighting */
+    .syntax_keyword = {203, 166, 247, 255}, /* #CBA6F7 (mauve) */
+    .syntax_type = {249, 226, 175, 255},    /* #F9E2AF (yellow) */
+    .syntax_string = {166, 227, 161, 255},  /* #A6E3A1 (green) */
+    .syntax_number = {250, 179, 135, 255},  /* #FAB387 (peach) */
+    .syntax_comment = {127, 132, 156, 255}, /* #7F849C (overlay) */
+    .syntax_meta = {245, 194, 231, 255},    /* #F5C2E7 (pink) */
+    .syntax_key = {137, 180, 250, 255},     /* #89B4FA (blue) */
+
     /* Spacing (pixels) */
     .spacing_xs = 4,
     .spacing_sm = 8,
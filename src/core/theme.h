@@ -38,6 +38,15 @@ typedef struct {
   color warning;
   color error;
 
+  /* Syntax highlighting */
+  color syntax_keyword;
+  color syntax_type;
+  color syntax_string;
+  color syntax_number;
+  color syntax_comment;
+  color syntax_meta;
+  color syntax_key;
+
   /* Spacing (pixels) */
   i32 spacing_xs;
   i32 spacing_sm;
@@ -0,0 +1,858 @@
+/*
+ * thumbnail_cache.c - Shared on-disk thumbnail cache implementation
+ *
+ * Thumbnails are named after the MD5 of the file URI and written as RGBA
+ * PNGs: each row gets the adaptive filter with the smallest residuals and
+ * the image data is deflated with fixed Huffman codes over a hash-chain
+ * LZ77. Reading goes through stb_image after the text chunks validated.
+ * C99, handmade hero style.
+ */
+
+#include "thumbnail_cache.h"
+#include "../platform/platform.h"
+#include "fs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_DestroyMutex(void *mutex);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+extern void *Platform_CreateCondVar(void);
+extern void Platform_DestroyCondVar(void *cond);
+extern void Platform_CondWait(void *cond, void *mutex);
+extern void Platform_CondSignal(void *cond);
+
+#define THUMBNAIL_MAX_FILE Megabytes(32) /* Larger cache files are ignored */
+#define THUMBNAIL_URI_MAX (FS_MAX_PATH * 3 + 8)
+#define THUMBNAIL_HASH_BITS 15
+#define THUMBNAIL_WINDOW 32768 /* Deflate window */
+#define THUMBNAIL_CHAIN_DEPTH 4
+#define THUMBNAIL_MAX_MATCH 258
+
+static const char *g_thumbnail_dirs[THUMBNAIL_SIZE_COUNT] = {
+    "normal", "large", "x-large", "xx-large"};
+
+/* ===== MD5 (for file names) ===== */
+
+static const u32 g_md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const u8 g_md5_shift[16] = {7, 12, 17, 22, 5, 9,  14, 20,
+                                   4, 11, 16, 23, 6, 10, 15, 21};
+
+static void Thumbnail_Md5Block(u32 state[4], const u8 *block) {
+  u32 m[16];
+  u32 a = state[0], b = state[1], c = state[2], d = state[3];
+
+  for (i32 i = 0; i < 16; i++) {
+    m[i] = (u32)block[i * 4] | ((u32)block[i * 4 + 1] << 8) |
+           ((u32)block[i * 4 + 2] << 16) | ((u32)block[i * 4 + 3] << 24);
+  }
+
+  for (i32 i = 0; i < 64; i++) {
+    u32 f, g;
+    if (i < 16) {
+      f = (b & c) | (~b & d);
+      g = (u32)i;
+    } else if (i < 32) {
+      f = (d & b) | (~d & c);
+      g = (u32)(5 * i + 1) % 16;
+    } else if (i < 48) {
+      f = b ^ c ^ d;
+      g = (u32)(3 * i + 5) % 16;
+    } else {
+      f = c ^ (b | ~d);
+      g = (u32)(7 * i) % 16;
+    }
+    u32 shift = g_md5_shift[(i / 16) * 4 + i % 4];
+    f += a + g_md5_k[i] + m[g];
+    a = d;
+    d = c;
+    c = b;
+    b += (f << shift) | (f >> (32 - shift));
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+}
+
+/* Lowercase hex MD5 of a string (33 bytes with the terminator) */
+static void Thumbnail_Md5Hex(const char *text, char out[33]) {
+  static const char digits[] = "0123456789abcdef";
+  u32 state[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  usize len = strlen(text);
+  usize full = len & ~(usize)63;
+  u8 tail[128];
+  usize tail_len = len - full;
+  u64 bits = (u64)len * 8;
+
+  for (usize i = 0; i < full; i += 64) {
+    Thumbnail_Md5Block(state, (const u8 *)text + i);
+  }
+
+  memset(tail, 0, sizeof(tail));
+  memcpy(tail, text + full, tail_len);
+  tail[tail_len] = 0x80;
+  usize padded = tail_len + 1 + 8 <= 64 ? 64 : 128;
+  for (i32 i = 0; i < 8; i++) {
+    tail[padded - 8 + i] = (u8)(bits >> (i * 8));
+  }
+  Thumbnail_Md5Block(state, tail);
+  if (padded == 128) {
+    Thumbnail_Md5Block(state, tail + 64);
+  }
+
+  for (i32 i = 0; i < 16; i++) {
+    u8 byte = (u8)(state[i / 4] >> ((i % 4) * 8));
+    out[i * 2] = digits[byte >> 4];
+    out[i * 2 + 1] = digits[byte & 0xF];
+  }
+  out[32] = '\0';
+}
+
+/* ===== Paths ===== */
+
+/* file:// URI of an absolute path, escaped like GLib does so the hash
+ * matches thumbnails made by other applications */
+static b32 Thumbnail_FileUri(const char *path, char *out, usize out_size) {
+  static const char digits[] = "0123456789ABCDEF";
+  usize len = 0;
+
+#if defined(_WIN32)
+  if (!path[0] || path[1] != ':')
+    return false;
+  len = (usize)snprintf(out, out_size, "file:///");
+#else
+  if (path[0] != '/')
+    return false;
+  len = (usize)snprintf(out, out_size, "file://");
+#endif
+
+  for (const u8 *p = (const u8 *)path; *p; p++) {
+    u8 c = *p == '\\' ? '/' : *p;
+    b32 plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                (c >= '0' && c <= '9') || strchr("-._~!$&'()*+,;=:@/", c);
+    if (len + 4 >= out_size)
+      return false;
+    if (plain) {
+      out[len++] = (char)c;
+    } else {
+      out[len++] = '%';
+      out[len++] = digits[c >> 4];
+      out[len++] = digits[c & 0xF];
+    }
+  }
+  out[len] = '\0';
+  return true;
+}
+
+/* Root of the thumbnail cache ("<cache>/thumbnails") */
+static b32 Thumbnail_RootDir(char *out, usize out_size) {
+  char cache[FS_MAX_PATH];
+  if (!Platform_GetCachePath(cache, sizeof(cache)))
+    return false;
+  FS_JoinPath(out, out_size, cache, "thumbnails");
+  return true;
+}
+
+static b32 Thumbnail_GetPaths(const char *path, thumbnail_size size,
+                              char *uri, usize uri_size, char *out,
+                              usize out_size) {
+  char root[FS_MAX_PATH];
+  char dir[FS_MAX_PATH];
+  char name[40];
+  char hash[33];
+
+  if (!Thumbnail_FileUri(path, uri, uri_size) ||
+      !Thumbnail_RootDir(root, sizeof(root)))
+    return false;
+
+  Thumbnail_Md5Hex(uri, hash);
+  snprintf(name, sizeof(name), "%s.png", hash);
+  FS_JoinPath(dir, sizeof(dir), root, g_thumbnail_dirs[size]);
+  FS_JoinPath(out, out_size, dir, name);
+  return true;
+}
+
+/* ===== PNG Writing ===== */
+
+typedef struct {
+  u8 *data;
+  usize len;
+  usize cap;
+  b32 failed;
+} thumbnail_buffer;
+
+/* Make room for n more bytes */
+static b32 ThumbnailBuf_Reserve(thumbnail_buffer *buf, usize n) {
+  if (buf->failed)
+    return false;
+  if (buf->len + n > buf->cap) {
+    usize cap = Max(buf->cap * 2, buf->len + n + 4096);
+    u8 *grown = (u8 *)realloc(buf->data, cap);
+    if (!grown) {
+      buf->failed = true;
+      return false;
+    }
+    buf->data = grown;
+    buf->cap = cap;
+  }
+  return true;
+}
+
+static void ThumbnailBuf_Put(thumbnail_buffer *buf, const void *src, usize n) {
+  if (n == 0 || !ThumbnailBuf_Reserve(buf, n))
+    return;
+  memcpy(buf->data + buf->len, src, n);
+  buf->len += n;
+}
+
+static void ThumbnailBuf_PutU32BE(thumbnail_buffer *buf, u32 value) {
+  u8 bytes[4] = {(u8)(value >> 24), (u8)(value >> 16), (u8)(value >> 8),
+                 (u8)value};
+  ThumbnailBuf_Put(buf, bytes, 4);
+}
+
+static u32 Thumbnail_Crc32(const u32 table[256], const u8 *data, usize len) {
+  u32 crc = 0xFFFFFFFFu;
+  for (usize i = 0; i < len; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static void Thumbnail_PutChunk(thumbnail_buffer *buf, const u32 crc_table[256],
+                               const char *type, const void *data, usize len) {
+  ThumbnailBuf_PutU32BE(buf, (u32)len);
+  usize start = buf->len;
+  ThumbnailBuf_Put(buf, type, 4);
+  ThumbnailBuf_Put(buf, data, len);
+  if (!buf->failed) {
+    ThumbnailBuf_PutU32BE(
+        buf, Thumbnail_Crc32(crc_table, buf->data + start, buf->len - start));
+  }
+}
+
+static void Thumbnail_PutText(thumbnail_buffer *buf, const u32 crc_table[256],
+                              const char *key, const char *value) {
+  char text[THUMBNAIL_URI_MAX + 32];
+  usize key_len = strlen(key);
+  usize value_len = Min(strlen(value), sizeof(text) - key_len - 1);
+
+  memcpy(text, key, key_len + 1); /* Keyword, NUL separator */
+  memcpy(text + key_len + 1, value, value_len);
+  Thumbnail_PutChunk(buf, crc_table, "tEXt", text, key_len + 1 + value_len);
+}
+
+/* LSB-first bit writer for the deflate stream. The output is reserved up
+ * front for the worst case, so bytes are stored without checks. */
+typedef struct {
+  u8 *out;
+  u64 bits;
+  u32 count;
+  u16 codes[288]; /* Fixed literal/length codes, bit-reversed */
+  u8 lengths[288];
+} thumbnail_bits;
+
+static void ThumbnailBits_Put(thumbnail_bits *w, u32 value, u32 n) {
+  w->bits |= (u64)value << w->count;
+  w->count += n;
+  while (w->count >= 8) {
+    *w->out++ = (u8)w->bits;
+    w->bits >>= 8;
+    w->count -= 8;
+  }
+}
+
+/* Huffman codes are stored most significant bit first */
+static u32 Thumbnail_Reverse(u32 code, u32 n) {
+  u32 reversed = 0;
+  for (u32 i = 0; i < n; i++) {
+    reversed |= ((code >> i) & 1) << (n - 1 - i);
+  }
+  return reversed;
+}
+
+/* Fixed Huffman literal/length alphabet (RFC 1951, 3.2.6) */
+static void ThumbnailBits_Init(thumbnail_bits *w, u8 *out) {
+  w->out = out;
+  w->bits = 0;
+  w->count = 0;
+  for (u32 symbol = 0; symbol < 288; symbol++) {
+    u32 code, n;
+    if (symbol < 144) {
+      code = 0x30 + symbol;
+      n = 8;
+    } else if (symbol < 256) {
+      code = 0x190 + symbol - 144;
+      n = 9;
+    } else if (symbol < 280) {
+      code = symbol - 256;
+      n = 7;
+    } else {
+      code = 0xC0 + symbol - 280;
+      n = 8;
+    }
+    w->codes[symbol] = (u16)Thumbnail_Reverse(code, n);
+    w->lengths[symbol] = (u8)n;
+  }
+}
+
+static void ThumbnailBits_PutSymbol(thumbnail_bits *w, u32 symbol) {
+  ThumbnailBits_Put(w, w->codes[symbol], w->lengths[symbol]);
+}
+
+static const u16 g_length_base[29] = {3,  4,  5,  6,   7,   8,   9,   10,
+                                      11, 13, 15, 17,  19,  23,  27,  31,
+                                      35, 43, 51, 59,  67,  83,  99,  115,
+                                      131, 163, 195, 227, 258};
+static const u8 g_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const u16 g_dist_base[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const u8 g_dist_extra[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                    4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                    9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static void ThumbnailBits_PutMatch(thumbnail_bits *w, u32 length, u32 dist) {
+  i32 li = 28;
+  i32 di = 29;
+
+  while (g_length_base[li] > length)
+    li--;
+  while (g_dist_base[di] > dist)
+    di--;
+
+  ThumbnailBits_PutSymbol(w, 257 + (u32)li);
+  ThumbnailBits_Put(w, length - g_length_base[li], g_length_extra[li]);
+  ThumbnailBits_Put(w, Thumbnail_Reverse((u32)di, 5), 5);
+  ThumbnailBits_Put(w, dist - g_dist_base[di], g_dist_extra[di]);
+}
+
+static u32 Thumbnail_Hash3(const u8 *p) {
+  u32 v = (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16);
+  return (v * 2654435761u) >> (32 - THUMBNAIL_HASH_BITS);
+}
+
+/* zlib stream of 'data': one fixed-Huffman block */
+static b32 Thumbnail_Deflate(thumbnail_buffer *out, const u8 *data, usize len) {
+  static const u8 header[2] = {0x78, 0x01};
+  /* At most 9 bits per literal, plus header, trailer and slack */
+  usize worst = len + len / 8 + 64;
+  i32 *head = (i32 *)malloc(sizeof(i32) << THUMBNAIL_HASH_BITS);
+  i32 *prev = (i32 *)malloc(sizeof(i32) * THUMBNAIL_WINDOW);
+  thumbnail_bits w;
+  u32 adler_a = 1, adler_b = 0;
+
+  ThumbnailBuf_Put(out, header, sizeof(header));
+  if (!head || !prev || !ThumbnailBuf_Reserve(out, worst)) {
+    free(head);
+    free(prev);
+    return false;
+  }
+  memset(head, 0xFF, sizeof(i32) << THUMBNAIL_HASH_BITS);
+
+  ThumbnailBits_Init(&w, out->data + out->len);
+  ThumbnailBits_Put(&w, 1, 1); /* BFINAL */
+  ThumbnailBits_Put(&w, 1, 2); /* Fixed Huffman */
+
+  usize i = 0;
+  while (i < len) {
+    u32 best_len = 0;
+    u32 best_dist = 0;
+
+    if (i + 3 <= len) {
+      u32 h = Thumbnail_Hash3(data + i);
+      i32 candidate = head[h];
+      usize limit = Min(len - i, (usize)THUMBNAIL_MAX_MATCH);
+
+      for (i32 depth = 0; depth < THUMBNAIL_CHAIN_DEPTH && candidate >= 0 &&
+                          i - (usize)candidate <= THUMBNAIL_WINDOW;
+           depth++) {
+        const u8 *a = data + candidate;
+        const u8 *b = data + i;
+        usize n = 0;
+        while (n < limit && a[n] == b[n])
+          n++;
+        if (n > best_len) {
+          best_len = (u32)n;
+          best_dist = (u32)(i - (usize)candidate);
+          if (n == limit)
+            break;
+        }
+        i32 next = prev[candidate & (THUMBNAIL_WINDOW - 1)];
+        if (next >= candidate)
+          break;
+        candidate = next;
+      }
+      prev[i & (THUMBNAIL_WINDOW - 1)] = head[h];
+      head[h] = (i32)i;
+    }
+
+    if (best_len >= 3) {
+      ThumbnailBits_PutMatch(&w, best_len, best_dist);
+      for (usize k = i + 1; k < i + best_len && k + 3 <= len; k++) {
+        u32 h = Thumbnail_Hash3(data + k);
+        prev[k & (THUMBNAIL_WINDOW - 1)] = head[h];
+        head[h] = (i32)k;
+      }
+      i += best_len;
+    } else {
+      ThumbnailBits_PutSymbol(&w, data[i]);
+      i++;
+    }
+  }
+
+  ThumbnailBits_PutSymbol(&w, 256); /* End of block */
+  ThumbnailBits_Put(&w, 0, 7);      /* Flush to a byte boundary */
+  out->len = (usize)(w.out - out->data);
+  free(head);
+  free(prev);
+
+  for (usize k = 0; k < len; k++) {
+    adler_a = (adler_a + data[k]) % 65521;
+    adler_b = (adler_b + adler_a) % 65521;
+  }
+  ThumbnailBuf_PutU32BE(out, (adler_b << 16) | adler_a);
+  return !out->failed;
+}
+
+static u8 Thumbnail_Paeth(u8 a, u8 b, u8 c) {
+  i32 p = (i32)a + (i32)b - (i32)c;
+  i32 pa = p > a ? p - a : a - p;
+  i32 pb = p > b ? p - b : b - p;
+  i32 pc = p > c ? p - c : c - p;
+  if (pa <= pb && pa <= pc)
+    return a;
+  return pb <= pc ? b : c;
+}
+
+/* Filter each row with whichever of the five PNG filters leaves the
+ * smallest residuals */
+static b32 Thumbnail_FilterRows(const image *img, u8 *out) {
+  usize stride = (usize)img->width * 4;
+  u8 *trial = (u8 *)malloc(stride);
+
+  if (!trial)
+    return false;
+
+  for (i32 y = 0; y < img->height; y++) {
+    const u8 *row = img->pixels + (usize)y * stride;
+    const u8 *up = y > 0 ? row - stride : NULL;
+    u8 *dst = out + (usize)y * (stride + 1);
+    u32 best_cost = 0xFFFFFFFFu;
+
+    for (u8 filter = 0; filter < 5; filter++) {
+      u32 cost = 0;
+      /* One loop per filter keeps the inner loops branch free */
+      switch (filter) {
+      case 0:
+        memcpy(trial, row, stride);
+        break;
+      case 1:
+        for (usize x = 0; x < stride; x++)
+          trial[x] = (u8)(row[x] - (x >= 4 ? row[x - 4] : 0));
+        break;
+      case 2:
+        for (usize x = 0; x < stride; x++)
+          trial[x] = (u8)(row[x] - (up ? up[x] : 0));
+        break;
+      case 3:
+        for (usize x = 0; x < stride; x++) {
+          u32 a = x >= 4 ? row[x - 4] : 0;
+          u32 b = up ? up[x] : 0;
+          trial[x] = (u8)(row[x] - (u8)((a + b) / 2));
+        }
+        break;
+      default:
+        for (usize x = 0; x < stride; x++) {
+          u8 a = x >= 4 ? row[x - 4] : 0;
+          u8 b = up ? up[x] : 0;
+          u8 c = (up && x >= 4) ? up[x - 4] : 0;
+          trial[x] = (u8)(row[x] - Thumbnail_Paeth(a, b, c));
+        }
+        break;
+      }
+      for (usize x = 0; x < stride; x++)
+        cost += trial[x] < 128 ? trial[x] : 256u - trial[x];
+
+      if (cost < best_cost) {
+        best_cost = cost;
+        dst[0] = filter;
+        memcpy(dst + 1, trial, stride);
+      }
+    }
+  }
+
+  free(trial);
+  return true;
+}
+
+static b32 Thumbnail_EncodePng(const image *img, const char *uri,
+                               u64 modified_time, u64 file_size,
+                               thumbnail_buffer *out) {
+  static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  u32 crc_table[256];
+  u8 ihdr[13];
+  char number[32];
+  usize raw_len = (usize)img->height * ((usize)img->width * 4 + 1);
+  u8 *raw = (u8 *)malloc(raw_len);
+  thumbnail_buffer idat = {0};
+
+  if (!raw)
+    return false;
+
+  for (u32 n = 0; n < 256; n++) {
+    u32 c = n;
+    for (i32 k = 0; k < 8; k++)
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    crc_table[n] = c;
+  }
+
+  b32 ok = Thumbnail_FilterRows(img, raw) &&
+           Thumbnail_Deflate(&idat, raw, raw_len);
+  free(raw);
+  if (!ok) {
+    free(idat.data);
+    return false;
+  }
+
+  ihdr[0] = (u8)(img->width >> 24);
+  ihdr[1] = (u8)(img->width >> 16);
+  ihdr[2] = (u8)(img->width >> 8);
+  ihdr[3] = (u8)img->width;
+  ihdr[4] = (u8)(img->height >> 24);
+  ihdr[5] = (u8)(img->height >> 16);
+  ihdr[6] = (u8)(img->height >> 8);
+  ihdr[7] = (u8)img->height;
+  ihdr[8] = 8;  /* Bit depth */
+  ihdr[9] = 6;  /* RGBA */
+  ihdr[10] = 0; /* Deflate */
+  ihdr[11] = 0; /* Adaptive filtering */
+  ihdr[12] = 0; /* No interlace */
+
+  ThumbnailBuf_Put(out, signature, sizeof(signature));
+  Thumbnail_PutChunk(out, crc_table, "IHDR", ihdr, sizeof(ihdr));
+  Thumbnail_PutText(out, crc_table, "Thumb::URI", uri);
+  snprintf(number, sizeof(number), "%llu", (unsigned long long)modified_time);
+  Thumbnail_PutText(out, crc_table, "Thumb::MTime", number);
+  snprintf(number, sizeof(number), "%llu", (unsigned long long)file_size);
+  Thumbnail_PutText(out, crc_table, "Thumb::Size", number);
+  Thumbnail_PutText(out, crc_table, "Software", "Workbench");
+  Thumbnail_PutChunk(out, crc_table, "IDAT", idat.data, idat.len);
+  Thumbnail_PutChunk(out, crc_table, "IEND", NULL, 0);
+  free(idat.data);
+  return !out->failed;
+}
+
+/* ===== PNG Reading ===== */
+
+static u32 Thumbnail_ReadU32BE(const u8 *p) {
+  return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3];
+}
+
+/* A thumbnail is valid if it was made from this URI at this mtime */
+static b32 Thumbnail_IsValid(const u8 *data, usize size, const char *uri,
+                             u64 modified_time) {
+  static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  usize uri_len = strlen(uri);
+  b32 mtime_ok = false;
+  b32 uri_ok = false;
+  usize pos = 8;
+
+  if (size < 8 || memcmp(data, signature, 8) != 0)
+    return false;
+
+  while (pos + 12 <= size) {
+    usize len = Thumbnail_ReadU32BE(data + pos);
+    const u8 *type = data + pos + 4;
+    const char *text = (const char *)data + pos + 8;
+    if (len > size - pos - 12)
+      break;
+
+    if (memcmp(type, "tEXt", 4) == 0) {
+      const char *sep = (const char *)memchr(text, '\0', len);
+      if (sep) {
+        const char *value = sep + 1;
+        usize value_len = len - (usize)(value - text);
+        if (strcmp(text, "Thumb::MTime") == 0) {
+          char number[32];
+          usize n = Min(value_len, sizeof(number) - 1);
+          memcpy(number, value, n);
+          number[n] = '\0';
+          mtime_ok = strtoull(number, NULL, 10) == modified_time;
+        } else if (strcmp(text, "Thumb::URI") == 0) {
+          uri_ok = value_len == uri_len && memcmp(value, uri, uri_len) == 0;
+        }
+      }
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    pos += 12 + len;
+  }
+
+  return mtime_ok && uri_ok;
+}
+
+/* Contents of a valid thumbnail file (caller frees), or NULL */
+static u8 *Thumbnail_ReadValid(const char *path, u64 modified_time,
+                               thumbnail_size size, usize *out_len) {
+  char uri[THUMBNAIL_URI_MAX];
+  char thumb_path[FS_MAX_PATH];
+  u8 *data = NULL;
+  long len = 0;
+
+  if (!Thumbnail_GetPaths(path, size, uri, sizeof(uri), thumb_path,
+                          sizeof(thumb_path)))
+    return NULL;
+
+  FILE *file = fopen(thumb_path, "rb");
+  if (!file)
+    return NULL;
+  if (fseek(file, 0, SEEK_END) == 0 && (len = ftell(file)) > 0 &&
+      len <= (long)THUMBNAIL_MAX_FILE && fseek(file, 0, SEEK_SET) == 0) {
+    data = (u8 *)malloc((usize)len);
+    if (data && fread(data, 1, (usize)len, file) != (usize)len) {
+      free(data);
+      data = NULL;
+    }
+  }
+  fclose(file);
+
+  if (data && !Thumbnail_IsValid(data, (usize)len, uri, modified_time)) {
+    free(data);
+    data = NULL;
+  }
+  *out_len = (usize)len;
+  return data;
+}
+
+/* A valid thumbnail of at least 'size': other applications may only have
+ * made a larger one */
+static u8 *Thumbnail_ReadCovering(const char *path, u64 modified_time,
+                                  thumbnail_size size, usize *out_len) {
+  for (i32 i = size; i < THUMBNAIL_SIZE_COUNT; i++) {
+    u8 *data =
+        Thumbnail_ReadValid(path, modified_time, (thumbnail_size)i, out_len);
+    if (data)
+      return data;
+  }
+  return NULL;
+}
+
+/* ===== Public API ===== */
+
+i32 Thumbnail_Pixels(thumbnail_size size) { return 128 << size; }
+
+thumbnail_size Thumbnail_SizeCovering(i32 pixels) {
+  thumbnail_size size = THUMBNAIL_SIZE_NORMAL;
+  while (size + 1 < THUMBNAIL_SIZE_COUNT && Thumbnail_Pixels(size) < pixels)
+    size = (thumbnail_size)(size + 1);
+  return size;
+}
+
+image *Thumbnail_Load(const char *path, u64 modified_time,
+                      thumbnail_size size) {
+  usize len = 0;
+  u8 *data = Thumbnail_ReadCovering(path, modified_time, size, &len);
+  if (!data)
+    return NULL;
+
+  image *img = Image_LoadFromMemory(data, len);
+  free(data);
+  return img;
+}
+
+b32 Thumbnail_Save(const char *path, u64 modified_time, u64 file_size,
+                   thumbnail_size size, const image *img) {
+  char uri[THUMBNAIL_URI_MAX];
+  char thumb_path[FS_MAX_PATH];
+  char temp_path[FS_MAX_PATH + 32];
+  char root[FS_MAX_PATH];
+  char dir[FS_MAX_PATH];
+  i32 pixels = Thumbnail_Pixels(size);
+  image scaled = *img;
+  thumbnail_buffer png = {0};
+  b32 ok = false;
+
+  if (!img->pixels || !Thumbnail_RootDir(root, sizeof(root)) ||
+      !Thumbnail_GetPaths(path, size, uri, sizeof(uri), thumb_path,
+                          sizeof(thumb_path)))
+    return false;
+
+  /* Thumbnails of thumbnails are never made (spec) */
+  if (strncmp(path, root, strlen(root)) == 0)
+    return false;
+
+  if (img->width > pixels || img->height > pixels) {
+    usize bytes = (usize)img->width * (usize)img->height * 4;
+    scaled.pixels = (u8 *)malloc(bytes);
+    if (!scaled.pixels)
+      return false;
+    memcpy(scaled.pixels, img->pixels, bytes);
+    Image_Downscale(&scaled, pixels, pixels);
+  }
+
+  if (Thumbnail_EncodePng(&scaled, uri, modified_time, file_size, &png)) {
+    char cache[FS_MAX_PATH];
+    Platform_GetCachePath(cache, sizeof(cache));
+    Platform_CreateDirectory(cache);
+    /* Thumbnails show what private images look like: owner-only (spec) */
+    Platform_CreatePrivateDirectory(root);
+    FS_JoinPath(dir, sizeof(dir), root, g_thumbnail_dirs[size]);
+    Platform_CreatePrivateDirectory(dir);
+
+    /* Unique per writer: the preview and the generator may race */
+    snprintf(temp_path, sizeof(temp_path), "%s.%llx.tmp", thumb_path,
+             (unsigned long long)(usize)png.data);
+    if (Platform_WritePrivateFile(temp_path, png.data, png.len)) {
+      ok = Platform_Rename(temp_path, thumb_path);
+      if (!ok)
+        Platform_Delete(temp_path);
+    }
+  }
+
+  free(png.data);
+  if (scaled.pixels != img->pixels)
+    free(scaled.pixels);
+  return ok;
+}
+
+/* ===== Generator ===== */
+
+static void ThumbnailGen_Free(thumbnail_generator *gen) {
+  free(gen->queue);
+  if (gen->work_cond)
+    Platform_DestroyCondVar(gen->work_cond);
+  if (gen->mutex)
+    Platform_DestroyMutex(gen->mutex);
+  free(gen);
+}
+
+static b32 ThumbnailGen_Run(i64 max_dimension, const thumbnail_job *job) {
+  usize len = 0;
+  i32 width = 0, height = 0;
+  u8 *existing = Thumbnail_ReadCovering(job->path, job->modified_time,
+                                        job->thumb_size, &len);
+
+  if (existing) {
+    free(existing);
+    return true;
+  }
+
+  if (max_dimension > 0 &&
+      (!Image_GetSize(job->path, &width, &height) || width > max_dimension ||
+       height > max_dimension))
+    return false;
+
+  image *img = Image_Load(job->path);
+  if (!img)
+    return false;
+
+  b32 ok = Thumbnail_Save(job->path, job->modified_time, job->size,
+                          job->thumb_size, img);
+  Image_Free(img);
+  return ok;
+}
+
+static void *ThumbnailGen_WorkerThread(void *arg) {
+  thumbnail_generator *gen = (thumbnail_generator *)arg;
+
+  Platform_LockMutex(gen->mutex);
+  for (;;) {
+    while (!gen->released && gen->queue_next >= gen->queue_count) {
+      Platform_CondWait(gen->work_cond, gen->mutex);
+    }
+    if (gen->released)
+      break;
+
+    thumbnail_job job = gen->queue[gen->queue_next++];
+    i64 max_dimension = gen->max_dimension;
+    Platform_UnlockMutex(gen->mutex);
+
+    b32 ok = ThumbnailGen_Run(max_dimension, &job);
+
+    Platform_LockMutex(gen->mutex);
+    if (ok)
+      gen->generated++;
+    else
+      gen->failed++;
+  }
+  Platform_UnlockMutex(gen->mutex);
+
+  ThumbnailGen_Free(gen);
+  return NULL;
+}
+
+thumbnail_generator *ThumbnailGen_Create(i64 max_dimension) {
+  thumbnail_generator *gen =
+      (thumbnail_generator *)calloc(1, sizeof(thumbnail_generator));
+  if (!gen)
+    return NULL;
+
+  gen->max_dimension = max_dimension;
+  gen->queue = (thumbnail_job *)malloc(sizeof(thumbnail_job) *
+                                       THUMBNAIL_QUEUE_MAX);
+  gen->mutex = Platform_CreateMutex();
+  gen->work_cond = Platform_CreateCondVar();
+  if (gen->queue && gen->mutex && gen->work_cond) {
+    gen->thread = Platform_CreateThread(ThumbnailGen_WorkerThread, gen);
+  }
+
+  if (!gen->thread) {
+    ThumbnailGen_Free(gen);
+    return NULL;
+  }
+  return gen;
+}
+
+void ThumbnailGen_Release(thumbnail_generator *gen) {
+  if (!gen)
+    return;
+
+  Platform_DestroyThread(gen->thread);
+  Platform_LockMutex(gen->mutex);
+  gen->released = true;
+  Platform_CondSignal(gen->work_cond);
+  Platform_UnlockMutex(gen->mutex);
+}
+
+void ThumbnailGen_SetQueue(thumbnail_generator *gen, const thumbnail_job *jobs,
+                           i32 count) {
+  count = Clamp(count, 0, THUMBNAIL_QUEUE_MAX);
+
+  Platform_LockMutex(gen->mutex);
+  memcpy(gen->queue, jobs, sizeof(thumbnail_job) * (usize)count);
+  gen->queue_count = count;
+  gen->queue_next = 0;
+  if (count > 0)
+    Platform_CondSignal(gen->work_cond);
+  Platform_UnlockMutex(gen->mutex);
+}
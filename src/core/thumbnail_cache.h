@@ -0,0 +1,94 @@
+/*
+ * thumbnail_cache.h - Shared on-disk thumbnail cache (freedesktop spec)
+ *
+ * Thumbnails live in the user cache directory under thumbnails/<size>/ as
+ * PNGs named after the MD5 of the file URI, with the file's mtime stored in
+ * a Thumb::MTime text chunk. A thumbnail whose mtime no longer matches is
+ * stale and ignored. The same files are read and written by file managers
+ * and image viewers that follow the spec, so their thumbnails are reused.
+ *
+ * A generator thread fills the cache ahead of time for a queue of images
+ * (e.g. everything in a photo folder).
+ * C99, handmade hero style.
+ */
+
+#ifndef THUMBNAIL_CACHE_H
+#define THUMBNAIL_CACHE_H
+
+#include "image.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define THUMBNAIL_QUEUE_MAX 256 /* Generator jobs held at once */
+
+/* ===== Types ===== */
+
+typedef enum {
+  THUMBNAIL_SIZE_NORMAL,   /* 128 px */
+  THUMBNAIL_SIZE_LARGE,    /* 256 px */
+  THUMBNAIL_SIZE_X_LARGE,  /* 512 px */
+  THUMBNAIL_SIZE_XX_LARGE, /* 1024 px */
+  THUMBNAIL_SIZE_COUNT,
+} thumbnail_size;
+
+typedef struct {
+  char path[FS_MAX_PATH];
+  u64 modified_time;
+  u64 size;
+  thumbnail_size thumb_size;
+} thumbnail_job;
+
+typedef struct {
+  void *thread; /* Immutable after ThumbnailGen_Create */
+
+  /* Guards everything below */
+  void *mutex;
+  void *work_cond;
+  b32 released; /* Owner is gone, the worker frees the generator */
+  thumbnail_job *queue;
+  i32 queue_count;
+  i32 queue_next;
+  i64 max_dimension; /* Larger images are not decoded */
+
+  /* Counters */
+  u32 generated;
+  u32 failed;
+} thumbnail_generator;
+
+/* ===== Thumbnail Cache API ===== */
+
+/* Edge of the square box a size fits its thumbnails into */
+i32 Thumbnail_Pixels(thumbnail_size size);
+
+/* Smallest size whose box covers 'pixels' (at most xx-large) */
+thumbnail_size Thumbnail_SizeCovering(i32 pixels);
+
+/* Load a valid (mtime matching) thumbnail of an image, of 'size' or the
+ * next larger one found. NULL if there is none or it is stale. */
+image *Thumbnail_Load(const char *path, u64 modified_time,
+                      thumbnail_size size);
+
+/* Store a thumbnail of 'img' (any size, downscaled as needed) for the
+ * file. Written to a temporary name and renamed, so readers never see a
+ * partial file. */
+b32 Thumbnail_Save(const char *path, u64 modified_time, u64 file_size,
+                   thumbnail_size size, const image *img);
+
+/* ===== Generator API =====
+ * All calls must come from the owner (UI) thread.
+ */
+
+/* Start the generator thread. NULL on failure. */
+thumbnail_generator *ThumbnailGen_Create(i64 max_dimension);
+
+/* Stop and free the generator. A thumbnail in progress is finished first,
+ * by the worker, which frees the generator once done. */
+void ThumbnailGen_Release(thumbnail_generator *gen);
+
+/* Replace the pending jobs (dropping what was queued before). Images that
+ * already have a valid thumbnail are skipped by the worker. */
+void ThumbnailGen_SetQueue(thumbnail_generator *gen, const thumbnail_job *jobs,
+                           i32 count);
+
+#endif /* THUMBNAIL_CACHE_H */
@@ -0,0 +1,376 @@
+/*
+ * thumbnail_pool.c - Background thumbnail decoding implementation
+ *
+ * Slots are found through a small chained hash on the owner thread; the
+ * workers only ever look at slot states, under the mutex. A worker claims
+ * the queued slot with the lowest priority, so the tiles in view decode
+ * before the ones prefetched around it.
+ * C99, handmade hero style.
+ */
+
+#include "thumbnail_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_DestroyMutex(void *mutex);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+extern void *Platform_CreateCondVar(void);
+extern void Platform_DestroyCondVar(void *cond);
+extern void Platform_CondWait(void *cond, void *mutex);
+extern void Platform_CondSignal(void *cond);
+extern void Platform_CondBroadcast(void *cond);
+extern i32 Platform_GetProcessorCount(void);
+
+#define THUMBNAIL_POOL_BUCKETS 2048 /* Power of two */
+
+/* Owner-thread lookup, kept beside the pool so the header stays small */
+typedef struct {
+  i32 buckets[THUMBNAIL_POOL_BUCKETS];
+  i32 next[THUMBNAIL_POOL_SLOTS];
+} thumbnail_pool_index;
+
+typedef struct {
+  thumbnail_pool pool;
+  thumbnail_pool_index index;
+} thumbnail_pool_storage;
+
+static thumbnail_pool_index *ThumbnailPool_Index(thumbnail_pool *pool) {
+  return &((thumbnail_pool_storage *)pool)->index;
+}
+
+static u64 ThumbnailPool_Key(const char *path, u64 modified_time) {
+  u64 hash = 0xcbf29ce484222325ull; /* FNV-1a */
+  for (const u8 *p = (const u8 *)path; *p; p++) {
+    hash = (hash ^ *p) * 0x100000001b3ull;
+  }
+  return (hash ^ modified_time) * 0x100000001b3ull;
+}
+
+static usize ThumbnailPool_ImageBytes(const image *img) {
+  return img ? (usize)img->width * (usize)img->height * 4 : 0;
+}
+
+/* ===== Index (owner thread) ===== */
+
+static i32 ThumbnailPool_Find(thumbnail_pool *pool, u64 key, const char *path,
+                              u64 modified_time) {
+  thumbnail_pool_index *index = ThumbnailPool_Index(pool);
+  i32 i = index->buckets[key & (THUMBNAIL_POOL_BUCKETS - 1)];
+
+  while (i >= 0) {
+    const thumbnail_slot *slot = &pool->slots[i];
+    if (slot->key == key && slot->modified_time == modified_time &&
+        strcmp(slot->path, path) == 0)
+      return i;
+    i = index->next[i];
+  }
+  return -1;
+}
+
+static void ThumbnailPool_Link(thumbnail_pool *pool, i32 i) {
+  thumbnail_pool_index *index = ThumbnailPool_Index(pool);
+  i32 *bucket =
+      &index->buckets[pool->slots[i].key & (THUMBNAIL_POOL_BUCKETS - 1)];
+
+  index->next[i] = *bucket;
+  *bucket = i;
+}
+
+static void ThumbnailPool_Unlink(thumbnail_pool *pool, i32 i) {
+  thumbnail_pool_index *index = ThumbnailPool_Index(pool);
+  i32 *link =
+      &index->buckets[pool->slots[i].key & (THUMBNAIL_POOL_BUCKETS - 1)];
+
+  while (*link >= 0) {
+    if (*link == i) {
+      *link = index->next[i];
+      return;
+    }
+    link = &index->next[*link];
+  }
+}
+
+/* Empty a slot the workers are not using. Called with the mutex held. */
+static void ThumbnailPool_Clear(thumbnail_pool *pool, i32 i) {
+  thumbnail_slot *slot = &pool->slots[i];
+
+  if (slot->img) {
+    if (pool->config.release_image)
+      pool->config.release_image(pool->config.release_user_data, slot->img);
+    pool->resident_bytes -= ThumbnailPool_ImageBytes(slot->img);
+    Image_Free(slot->img);
+    slot->img = NULL;
+  }
+  ThumbnailPool_Unlink(pool, i);
+  slot->state = THUMBNAIL_SLOT_EMPTY;
+}
+
+/* An empty slot, or else the least recently used finished one that was
+ * not requested this frame. Called with the mutex held. */
+static i32 ThumbnailPool_Claim(thumbnail_pool *pool) {
+  i32 oldest = -1;
+
+  for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+    const thumbnail_slot *slot = &pool->slots[i];
+    if (slot->state == THUMBNAIL_SLOT_EMPTY)
+      return i;
+    if ((slot->state == THUMBNAIL_SLOT_READY ||
+         slot->state == THUMBNAIL_SLOT_FAILED) &&
+        slot->last_used < pool->clock &&
+        (oldest < 0 || slot->last_used < pool->slots[oldest].last_used))
+      oldest = i;
+  }
+
+  if (oldest >= 0) {
+    pool->evictions++;
+    ThumbnailPool_Clear(pool, oldest);
+  }
+  return oldest;
+}
+
+/* ===== Worker ===== */
+
+static image *ThumbnailPool_Decode(const thumbnail_pool_config *config,
+                                   const thumbnail_slot *job, b32 *out_cached) {
+  i32 pixels = Thumbnail_Pixels(config->size);
+  i32 width = 0, height = 0;
+
+  image *img = Thumbnail_Load(job->path, job->modified_time, config->size);
+  if (img) {
+    *out_cached = true;
+    Image_Downscale(img, pixels, pixels);
+    return img;
+  }
+
+  if (config->max_decode_bytes > 0 &&
+      job->size > (u64)config->max_decode_bytes)
+    return NULL;
+  if (config->max_dimension > 0 &&
+      (!Image_GetSize(job->path, &width, &height) ||
+       width > config->max_dimension || height > config->max_dimension))
+    return NULL;
+
+  img = Image_Load(job->path);
+  if (!img)
+    return NULL;
+
+  Image_Downscale(img, pixels, pixels);
+  Thumbnail_Save(job->path, job->modified_time, job->size, config->size, img);
+  return img;
+}
+
+static void ThumbnailPool_Free(thumbnail_pool *pool) {
+  if (pool->slots) {
+    for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+      Image_Free(pool->slots[i].img);
+    }
+  }
+  free(pool->slots);
+  if (pool->work_cond)
+    Platform_DestroyCondVar(pool->work_cond);
+  if (pool->mutex)
+    Platform_DestroyMutex(pool->mutex);
+  free(pool);
+}
+
+static void *ThumbnailPool_WorkerThread(void *arg) {
+  thumbnail_pool *pool = (thumbnail_pool *)arg;
+  b32 last;
+
+  Platform_LockMutex(pool->mutex);
+  for (;;) {
+    i32 best = -1;
+
+    while (!pool->released) {
+      for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+        const thumbnail_slot *slot = &pool->slots[i];
+        if (slot->state == THUMBNAIL_SLOT_QUEUED &&
+            (best < 0 || slot->priority < pool->slots[best].priority))
+          best = i;
+      }
+      if (best >= 0)
+        break;
+      Platform_CondWait(pool->work_cond, pool->mutex);
+    }
+    if (pool->released)
+      break;
+
+    thumbnail_slot job = pool->slots[best];
+    pool->slots[best].state = THUMBNAIL_SLOT_DECODING;
+    pool->in_flight++;
+    Platform_UnlockMutex(pool->mutex);
+
+    b32 cached = false;
+    image *img = ThumbnailPool_Decode(&pool->config, &job, &cached);
+
+    Platform_LockMutex(pool->mutex);
+    pool->in_flight--;
+    if (pool->released) {
+      Image_Free(img);
+      break;
+    }
+
+    thumbnail_slot *slot = &pool->slots[best];
+    slot->img = img;
+    slot->state = img ? THUMBNAIL_SLOT_READY : THUMBNAIL_SLOT_FAILED;
+    if (img) {
+      pool->resident_bytes += ThumbnailPool_ImageBytes(img);
+      pool->decoded++;
+      if (cached)
+        pool->cache_hits++;
+    } else {
+      pool->failed++;
+    }
+  }
+  last = --pool->live_threads == 0;
+  Platform_UnlockMutex(pool->mutex);
+
+  if (last)
+    ThumbnailPool_Free(pool);
+  return NULL;
+}
+
+/* ===== Thumbnail Pool API ===== */
+
+thumbnail_pool *ThumbnailPool_Create(const thumbnail_pool_config *config) {
+  thumbnail_pool_storage *storage =
+      (thumbnail_pool_storage *)calloc(1, sizeof(thumbnail_pool_storage));
+  thumbnail_pool *pool = storage ? &storage->pool : NULL;
+  i32 count;
+
+  if (!pool)
+    return NULL;
+
+  pool->config = *config;
+  count = config->thread_count > 0 ? config->thread_count
+                                   : Platform_GetProcessorCount() / 2;
+  count = Clamp(count, 1, THUMBNAIL_POOL_MAX_THREADS);
+
+  memset(storage->index.buckets, 0xFF, sizeof(storage->index.buckets));
+  pool->slots =
+      (thumbnail_slot *)calloc(THUMBNAIL_POOL_SLOTS, sizeof(thumbnail_slot));
+  pool->mutex = Platform_CreateMutex();
+  pool->work_cond = Platform_CreateCondVar();
+  if (!pool->slots || !pool->mutex || !pool->work_cond) {
+    ThumbnailPool_Free(pool);
+    return NULL;
+  }
+
+  Platform_LockMutex(pool->mutex);
+  for (i32 i = 0; i < count; i++) {
+    void *thread = Platform_CreateThread(ThumbnailPool_WorkerThread, pool);
+    if (!thread)
+      break;
+    pool->threads[pool->thread_count++] = thread;
+    pool->live_threads++;
+  }
+  Platform_UnlockMutex(pool->mutex);
+
+  if (pool->thread_count == 0) {
+    ThumbnailPool_Free(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void ThumbnailPool_Release(thumbnail_pool *pool) {
+  if (!pool)
+    return;
+
+  Platform_LockMutex(pool->mutex);
+  for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+    if (pool->slots[i].state == THUMBNAIL_SLOT_READY)
+      ThumbnailPool_Clear(pool, i);
+  }
+  for (i32 i = 0; i < pool->thread_count; i++) {
+    Platform_DestroyThread(pool->threads[i]);
+  }
+  pool->released = true;
+  Platform_CondBroadcast(pool->work_cond);
+  Platform_UnlockMutex(pool->mutex);
+}
+
+void ThumbnailPool_BeginFrame(thumbnail_pool *pool) {
+  Platform_LockMutex(pool->mutex);
+  pool->clock++;
+  Platform_UnlockMutex(pool->mutex);
+}
+
+image *ThumbnailPool_Request(thumbnail_pool *pool, const char *path,
+                             u64 modified_time, u64 size, i32 priority,
+                             b32 *out_failed) {
+  u64 key = ThumbnailPool_Key(path, modified_time);
+  image *img = NULL;
+
+  if (out_failed)
+    *out_failed = false;
+
+  Platform_LockMutex(pool->mutex);
+  i32 i = ThumbnailPool_Find(pool, key, path, modified_time);
+  if (i < 0) {
+    i = ThumbnailPool_Claim(pool);
+    if (i >= 0) {
+      thumbnail_slot *slot = &pool->slots[i];
+      slot->key = key;
+      strncpy(slot->path, path, FS_MAX_PATH - 1);
+      slot->path[FS_MAX_PATH - 1] = '\0';
+      slot->modified_time = modified_time;
+      slot->size = size;
+      slot->state = THUMBNAIL_SLOT_QUEUED;
+      ThumbnailPool_Link(pool, i);
+      pool->queued_new = true;
+    }
+  }
+
+  if (i >= 0) {
+    thumbnail_slot *slot = &pool->slots[i];
+    slot->priority = priority;
+    slot->last_used = pool->clock;
+    img = slot->state == THUMBNAIL_SLOT_READY ? slot->img : NULL;
+    if (out_failed)
+      *out_failed = slot->state == THUMBNAIL_SLOT_FAILED;
+  }
+  Platform_UnlockMutex(pool->mutex);
+  return img;
+}
+
+void ThumbnailPool_EndFrame(thumbnail_pool *pool) {
+  Platform_LockMutex(pool->mutex);
+
+  /* Scrolled out of range before a worker got to it */
+  for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+    if (pool->slots[i].state == THUMBNAIL_SLOT_QUEUED &&
+        pool->slots[i].last_used < pool->clock) {
+      pool->dropped++;
+      ThumbnailPool_Clear(pool, i);
+    }
+  }
+
+  /* Thumbnails requested this frame stay, even over the budget */
+  while (pool->resident_bytes > pool->config.max_bytes) {
+    i32 oldest = -1;
+    for (i32 i = 0; i < THUMBNAIL_POOL_SLOTS; i++) {
+      const thumbnail_slot *slot = &pool->slots[i];
+      if (slot->state == THUMBNAIL_SLOT_READY &&
+          slot->last_used < pool->clock &&
+          (oldest < 0 || slot->last_used < pool->slots[oldest].last_used))
+        oldest = i;
+    }
+    if (oldest < 0)
+      break;
+    pool->evictions++;
+    ThumbnailPool_Clear(pool, oldest);
+  }
+
+  if (pool->queued_new) {
+    pool->queued_new = false;
+    Platform_CondBroadcast(pool->work_cond);
+  }
+  Platform_UnlockMutex(pool->mutex);
+}
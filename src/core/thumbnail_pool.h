@@ -0,0 +1,110 @@
+/*
+ * thumbnail_pool.h - Background thumbnail decoding for grid views
+ *
+ * A fixed set of slots holds the thumbnails a view asked for. Each frame
+ * the owner requests the tiles around its viewport with a priority (their
+ * distance from it); worker threads decode the queued slots lowest
+ * priority first, going through the shared thumbnail cache. Requests that
+ * were not repeated in a frame are dropped before a worker picks them up,
+ * and decoded thumbnails beyond the memory budget are evicted least
+ * recently used first, so the owner never waits on a decode.
+ * C99, handmade hero style.
+ */
+
+#ifndef THUMBNAIL_POOL_H
+#define THUMBNAIL_POOL_H
+
+#include "fs.h"
+#include "image.h"
+#include "thumbnail_cache.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define THUMBNAIL_POOL_SLOTS 1024     /* Thumbnails tracked at once */
+#define THUMBNAIL_POOL_MAX_THREADS 8
+
+/* ===== Types ===== */
+
+typedef enum {
+  THUMBNAIL_SLOT_EMPTY,
+  THUMBNAIL_SLOT_QUEUED,
+  THUMBNAIL_SLOT_DECODING,
+  THUMBNAIL_SLOT_READY,
+  THUMBNAIL_SLOT_FAILED,
+} thumbnail_slot_state;
+
+typedef struct {
+  thumbnail_slot_state state;
+  u64 key; /* Hash of path and modified time */
+  char path[FS_MAX_PATH];
+  u64 modified_time;
+  u64 size;
+  i32 priority;  /* Distance from the viewport, lowest decoded first */
+  u64 last_used; /* Frame it was last requested in */
+  image *img;    /* READY only */
+} thumbnail_slot;
+
+/* Called on the owner thread for every decoded image before it is freed
+ * (e.g. to drop its GPU texture) */
+typedef void (*thumbnail_release_fn)(void *user_data, image *img);
+
+typedef struct {
+  thumbnail_size size; /* Freedesktop size decoded and cached */
+  i32 thread_count;    /* 0 = from the processor count */
+  u64 max_bytes;       /* Budget for decoded thumbnails */
+  i64 max_decode_bytes; /* Larger files are not decoded */
+  i64 max_dimension;    /* Nor images larger than this */
+  thumbnail_release_fn release_image;
+  void *release_user_data;
+} thumbnail_pool_config;
+
+typedef struct {
+  void *threads[THUMBNAIL_POOL_MAX_THREADS]; /* Immutable after create */
+  i32 thread_count;
+  thumbnail_pool_config config;
+
+  /* Guards everything below */
+  void *mutex;
+  void *work_cond;
+  b32 released; /* Owner is gone, the last worker frees the pool */
+  i32 live_threads;
+  thumbnail_slot *slots;
+  i32 in_flight; /* Slots being decoded (at most thread_count) */
+  u64 clock;     /* Frame counter */
+  u64 resident_bytes; /* Pixels of READY slots */
+  b32 queued_new;     /* Workers need waking at the end of the frame */
+
+  /* Counters for tuning */
+  u32 decoded;
+  u32 cache_hits; /* Thumbnails found in the on-disk cache */
+  u32 failed;
+  u32 evictions;
+  u32 dropped; /* Queued requests dropped unstarted */
+} thumbnail_pool;
+
+/* ===== Thumbnail Pool API =====
+ * All calls must come from the owner (UI) thread.
+ */
+
+/* Start the worker threads. NULL on failure. */
+thumbnail_pool *ThumbnailPool_Create(const thumbnail_pool_config *config);
+
+/* Stop and free the pool. Decodes in progress are finished by their
+ * workers; the last one to exit frees the pool. */
+void ThumbnailPool_Release(thumbnail_pool *pool);
+
+/* Start a frame of requests */
+void ThumbnailPool_BeginFrame(thumbnail_pool *pool);
+
+/* Ask for the thumbnail of an image. Returns it once decoded, NULL while
+ * it is queued or decoding, or if it failed (*out_failed set). */
+image *ThumbnailPool_Request(thumbnail_pool *pool, const char *path,
+                             u64 modified_time, u64 size, i32 priority,
+                             b32 *out_failed);
+
+/* End the frame: requests that were not repeated are dropped and decoded
+ * thumbnails over the budget evicted, then the workers are woken. */
+void ThumbnailPool_EndFrame(thumbnail_pool *pool);
+
+#endif /* THUMBNAIL_POOL_H */
@@ -0,0 +1,345 @@
+/*
+ * tree_filter.c - Background fuzzy name search implementation
+ *
+ * A single worker walks the subtree breadth-first so shallow (usually more
+ * relevant) matches arrive first. Each walk carries the generation it was
+ * started for; starting a new query bumps the generation and the worker
+ * drops the stale walk at the next directory or match.
+ * C99, handmade hero style.
+ */
+
+#include "tree_filter.h"
+#include "../platform/platform.h"
+#include "fuzzy_match.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+extern void *Platform_CreateCondVar(void);
+extern void Platform_CondWait(void *cond, void *mutex);
+extern void Platform_CondBroadcast(void *cond);
+
+/* ===== Types ===== */
+
+/* Worker-local state of one walk */
+typedef struct {
+  tree_filter *filter;
+  u32 generation;
+  char root[FS_MAX_PATH];
+  char query[TREE_FILTER_MAX_QUERY];
+  b32 show_hidden;
+  i32 strong_score;
+  b32 stop;
+
+  /* Directories still to visit (relative paths, FIFO) */
+  char **queue;
+  u32 queue_head;
+  u32 queue_count;
+  u32 queue_capacity;
+  const char *rel_dir; /* Directory being enumerated */
+} tree_filter_walk;
+
+/* ===== Internal Helpers ===== */
+
+/* Called with the mutex held */
+static b32 TreeFilter_IsStale(tree_filter *filter, u32 generation) {
+  return filter->shutdown_requested || filter->generation != generation;
+}
+
+static void TreeFilter_PushDirectory(tree_filter_walk *walk,
+                                     const char *rel_path) {
+  /* Reuse the consumed front of the queue before growing it */
+  if (walk->queue_count == walk->queue_capacity && walk->queue_head > 0) {
+    memmove(walk->queue, walk->queue + walk->queue_head,
+            sizeof(char *) * (walk->queue_count - walk->queue_head));
+    walk->queue_count -= walk->queue_head;
+    walk->queue_head = 0;
+  }
+  if (walk->queue_count == walk->queue_capacity) {
+    u32 capacity = walk->queue_capacity ? walk->queue_capacity * 2 : 256;
+    char **grown = (char **)realloc(walk->queue, sizeof(char *) * capacity);
+    if (!grown)
+      return; /* Out of memory: this branch is not walked */
+    walk->queue = grown;
+    walk->queue_capacity = capacity;
+  }
+
+  usize len = strlen(rel_path) + 1;
+  char *copy = (char *)malloc(len);
+  if (!copy)
+    return;
+  memcpy(copy, rel_path, len);
+  walk->queue[walk->queue_count++] = copy;
+}
+
+/* Record one match. Returns false when the walk is stale or full. */
+static b32 TreeFilter_AddResult(tree_filter_walk *walk, const char *rel_path,
+                                const tree_filter_result *result) {
+  tree_filter *filter = walk->filter;
+  b32 keep_going = true;
+  usize path_size = strlen(rel_path) + 1;
+
+  Platform_LockMutex(filter->mutex);
+  if (TreeFilter_IsStale(filter, walk->generation)) {
+    keep_going = false;
+  } else if (filter->result_count >= TREE_FILTER_MAX_RESULTS ||
+             filter->path_pool_used + path_size > TREE_FILTER_PATH_POOL_SIZE) {
+    filter->stopped_early = true;
+    keep_going = false;
+  } else {
+    tree_filter_result *out = &filter->results[filter->result_count++];
+    *out = *result;
+    out->path_offset = filter->path_pool_used;
+    memcpy(filter->path_pool + filter->path_pool_used, rel_path, path_size);
+    filter->path_pool_used += (u32)path_size;
+    if (result->score >= walk->strong_score)
+      filter->strong_count++;
+  }
+  Platform_UnlockMutex(filter->mutex);
+  return keep_going;
+}
+
+static b32 TreeFilter_VisitEntry(void *user_data, const char *name,
+                                 file_type type) {
+  tree_filter_walk *walk = (tree_filter_walk *)user_data;
+
+  if (name[0] == '.' && !walk->show_hidden)
+    return true;
+
+  char rel_path[FS_MAX_PATH];
+  if (walk->rel_dir[0]) {
+    FS_JoinPath(rel_path, sizeof(rel_path), walk->rel_dir, name);
+  } else {
+    snprintf(rel_path, sizeof(rel_path), "%s", name);
+  }
+
+  /* Symlinks are never followed, so cycles can't trap the walk */
+  if (type == WB_FILE_TYPE_DIRECTORY) {
+    TreeFilter_PushDirectory(walk, rel_path);
+  }
+
+  fuzzy_match_result match = FuzzyMatchScore(walk->query, name);
+  if (!match.matches)
+    return true;
+
+  tree_filter_result result = {0};
+  result.score = match.score;
+  result.is_directory = type == WB_FILE_TYPE_DIRECTORY;
+
+  /* Only matches pay for a stat (same fields as a directory listing) */
+  char full_path[FS_MAX_PATH];
+  FS_JoinPath(full_path, sizeof(full_path), walk->root, rel_path);
+  file_info info;
+  if (Platform_GetFileInfo(full_path, &info)) {
+    result.is_directory = info.type == WB_FILE_TYPE_DIRECTORY;
+    result.is_special = info.type == WB_FILE_TYPE_UNKNOWN;
+    result.size = info.size;
+    result.modified_time = info.modified_time;
+  }
+
+  if (!TreeFilter_AddResult(walk, rel_path, &result)) {
+    walk->stop = true;
+    return false;
+  }
+  return true;
+}
+
+static void TreeFilter_Walk(tree_filter_walk *walk) {
+  tree_filter *filter = walk->filter;
+  TreeFilter_PushDirectory(walk, "");
+
+  while (walk->queue_head < walk->queue_count && !walk->stop) {
+    char *rel_dir = walk->queue[walk->queue_head++];
+    char full_path[FS_MAX_PATH];
+    if (rel_dir[0]) {
+      FS_JoinPath(full_path, sizeof(full_path), walk->root, rel_dir);
+    } else {
+      snprintf(full_path, sizeof(full_path), "%s", walk->root);
+    }
+    walk->rel_dir = rel_dir;
+    Platform_EnumerateDirectory(full_path, TreeFilter_VisitEntry, walk);
+    free(rel_dir);
+
+    Platform_LockMutex(filter->mutex);
+    if (TreeFilter_IsStale(filter, walk->generation)) {
+      walk->stop = true;
+    } else {
+      filter->directories_walked++;
+      /* Ranked by score, so deeper levels would rarely show up anyway */
+      if (filter->strong_count >= TREE_FILTER_STRONG_TARGET &&
+          walk->queue_head < walk->queue_count) {
+        filter->stopped_early = true;
+        walk->stop = true;
+      }
+    }
+    Platform_UnlockMutex(filter->mutex);
+  }
+
+  while (walk->queue_head < walk->queue_count) {
+    free(walk->queue[walk->queue_head++]);
+  }
+  free(walk->queue);
+}
+
+static void *TreeFilter_WorkerThread(void *arg) {
+  tree_filter *filter = (tree_filter *)arg;
+  /* Large paths and queue bookkeeping live on the heap, not the stack */
+  tree_filter_walk *walk = (tree_filter_walk *)malloc(sizeof(*walk));
+
+  Platform_LockMutex(filter->mutex);
+  for (;;) {
+    while (!filter->shutdown_requested && !filter->pending) {
+      Platform_CondWait(filter->work_cond, filter->mutex);
+    }
+    if (filter->shutdown_requested || !walk)
+      break;
+
+    filter->pending = false;
+    memset(walk, 0, sizeof(*walk));
+    walk->filter = filter;
+    walk->generation = filter->generation;
+    memcpy(walk->root, filter->root, sizeof(walk->root));
+    memcpy(walk->query, filter->query, sizeof(walk->query));
+    walk->show_hidden = filter->show_hidden;
+    walk->strong_score = filter->strong_score;
+    Platform_UnlockMutex(filter->mutex);
+
+    TreeFilter_Walk(walk);
+
+    Platform_LockMutex(filter->mutex);
+    if (filter->generation == walk->generation) {
+      filter->running = false;
+    }
+  }
+  Platform_UnlockMutex(filter->mutex);
+  free(walk);
+  return NULL;
+}
+
+static b32 TreeFilter_StartWorker(tree_filter *filter) {
+  if (filter->thread)
+    return true;
+
+  filter->results = (tree_filter_result *)malloc(sizeof(tree_filter_result) *
+                                                 TREE_FILTER_MAX_RESULTS);
+  filter->path_pool = (char *)malloc(TREE_FILTER_PATH_POOL_SIZE);
+  filter->mutex = Platform_CreateMutex();
+  filter->work_cond = Platform_CreateCondVar();
+  if (!filter->results || !filter->path_pool || !filter->mutex ||
+      !filter->work_cond) {
+    return false;
+  }
+
+  filter->thread = Platform_CreateThread(TreeFilter_WorkerThread, filter);
+  return filter->thread != NULL;
+}
+
+/* Called with the mutex held */
+static void TreeFilter_ResetLocked(tree_filter *filter) {
+  filter->generation++;
+  filter->pending = false;
+  filter->running = false;
+  filter->stopped_early = false;
+  filter->result_count = 0;
+  filter->strong_count = 0;
+  filter->path_pool_used = 0;
+  filter->directories_walked = 0;
+}
+
+/* ===== Public API ===== */
+
+void TreeFilter_Init(tree_filter *filter) { memset(filter, 0, sizeof(*filter)); }
+
+void TreeFilter_Shutdown(tree_filter *filter) {
+  if (!filter->mutex || !filter->work_cond)
+    return;
+
+  /* The worker may still be enumerating, so the shared buffers are left
+   * allocated (same as content search) */
+  Platform_LockMutex(filter->mutex);
+  TreeFilter_ResetLocked(filter);
+  filter->shutdown_requested = true;
+  Platform_CondBroadcast(filter->work_cond);
+  Platform_UnlockMutex(filter->mutex);
+
+  if (filter->thread) {
+    Platform_DestroyThread(filter->thread);
+    filter->thread = NULL;
+  }
+}
+
+void TreeFilter_Start(tree_filter *filter, const char *root, const char *query,
+                      b32 show_hidden) {
+  if (!root || !query || query[0] == '\0') {
+    TreeFilter_Cancel(filter);
+    return;
+  }
+  if (filter->shutdown_requested || !TreeFilter_StartWorker(filter))
+    return;
+
+  /* Half the score of an exact name match: prefixes and long contiguous
+   * runs qualify, scattered subsequences don't */
+  i32 strong_score = FuzzyMatchScore(query, query).score / 2;
+
+  Platform_LockMutex(filter->mutex);
+  TreeFilter_ResetLocked(filter);
+  snprintf(filter->root, sizeof(filter->root), "%s", root);
+  snprintf(filter->query, sizeof(filter->query), "%s", query);
+  filter->show_hidden = show_hidden;
+  filter->strong_score = strong_score;
+  filter->pending = true;
+  filter->running = true;
+  Platform_CondBroadcast(filter->work_cond);
+  Platform_UnlockMutex(filter->mutex);
+}
+
+void TreeFilter_Cancel(tree_filter *filter) {
+  if (!filter->mutex)
+    return;
+  Platform_LockMutex(filter->mutex);
+  TreeFilter_ResetLocked(filter);
+  filter->query[0] = '\0';
+  Platform_UnlockMutex(filter->mutex);
+}
+
+tree_filter_status TreeFilter_GetStatus(tree_filter *filter) {
+  tree_filter_status status = {0};
+  if (!filter->mutex)
+    return status;
+
+  Platform_LockMutex(filter->mutex);
+  status.result_count = filter->result_count;
+  status.directories_walked = filter->directories_walked;
+  status.running = filter->running;
+  status.stopped_early = filter->stopped_early;
+  Platform_UnlockMutex(filter->mutex);
+  return status;
+}
+
+b32 TreeFilter_GetResult(tree_filter *filter, i32 index,
+                         tree_filter_result *out_result, char *out_path,
+                         usize out_path_size) {
+  if (!filter->mutex)
+    return false;
+
+  b32 found = false;
+  Platform_LockMutex(filter->mutex);
+  if (index >= 0 && index < filter->result_count) {
+    tree_filter_result *result = &filter->results[index];
+    if (out_result)
+      *out_result = *result;
+    if (out_path && out_path_size > 0)
+      snprintf(out_path, out_path_size, "%s",
+               filter->path_pool + result->path_offset);
+    found = true;
+  }
+  Platform_UnlockMutex(filter->mutex);
+  return found;
+}
@@ -0,0 +1,102 @@
+/*
+ * tree_filter.h - Background fuzzy name search over a directory subtree
+ *
+ * Walks a subtree breadth-first on a worker thread and scores every name
+ * against the query. Matches stream into a shared buffer that the explorer
+ * polls each frame; the walk stops early once enough strong matches (exact
+ * prefixes and the like) were found, since the list is ranked by score and
+ * deeper levels rarely beat them. Starting a new query cancels the previous
+ * walk.
+ * C99, handmade hero style.
+ */
+
+#ifndef TREE_FILTER_H
+#define TREE_FILTER_H
+
+#include "fs.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define TREE_FILTER_MAX_RESULTS (FS_MAX_ENTRIES - 1)
+#define TREE_FILTER_MAX_QUERY 128
+#define TREE_FILTER_PATH_POOL_SIZE Kilobytes(512)
+#define TREE_FILTER_STRONG_TARGET 64 /* Strong matches before stopping */
+
+/* ===== Types ===== */
+
+typedef struct {
+  u32 path_offset; /* Path relative to the root, offset into the path pool */
+  i32 score;       /* Fuzzy score of the file name */
+  b32 is_directory; /* Symlinked folders included */
+  b32 is_special;   /* FIFO, socket or device */
+  u64 size;
+  u64 modified_time;
+} tree_filter_result;
+
+typedef struct {
+  /* Guards everything below except the immutable thread handle */
+  void *mutex;
+  void *work_cond;
+  void *thread;
+  b32 shutdown_requested;
+
+  /* Current walk (a new generation cancels the previous one) */
+  u32 generation;
+  b32 pending; /* Generation not picked up by the worker yet */
+  char root[FS_MAX_PATH];
+  char query[TREE_FILTER_MAX_QUERY];
+  b32 show_hidden;
+  i32 strong_score; /* Scores at or above this count as strong */
+  b32 running;
+  b32 stopped_early;
+
+  /* Results in discovery order (shallow first). Entries below
+   * result_count never change within a generation. */
+  tree_filter_result *results;
+  i32 result_count;
+  i32 strong_count;
+  char *path_pool;
+  u32 path_pool_used;
+
+  /* Counters */
+  u64 directories_walked;
+} tree_filter;
+
+/* Snapshot of the walk progress for the UI */
+typedef struct {
+  i32 result_count;
+  u64 directories_walked;
+  b32 running;
+  b32 stopped_early; /* Enough strong matches, rest of the tree skipped */
+} tree_filter_status;
+
+/* ===== Tree Filter API =====
+ * All calls must come from a single (UI) thread.
+ */
+
+/* Initialize state. The worker thread is created on the first search. */
+void TreeFilter_Init(tree_filter *filter);
+
+/* Stop the worker. It exits after finishing its current directory. */
+void TreeFilter_Shutdown(tree_filter *filter);
+
+/* Start matching 'query' against every name below 'root'. Hidden entries
+ * are skipped (and not descended into) unless show_hidden is set; symlinked
+ * directories are listed but never followed. */
+void TreeFilter_Start(tree_filter *filter, const char *root, const char *query,
+                      b32 show_hidden);
+
+/* Cancel the running walk and drop its results */
+void TreeFilter_Cancel(tree_filter *filter);
+
+/* Current progress */
+tree_filter_status TreeFilter_GetStatus(tree_filter *filter);
+
+/* Access a result below status.result_count. out_path receives the path
+ * relative to the root. Returns false if out of range. */
+b32 TreeFilter_GetResult(tree_filter *filter, i32 index,
+                         tree_filter_result *out_result, char *out_path,
+                         usize out_path_size);
+
+#endif /* TREE_FILTER_H */
@@ -0,0 +1,1115 @@
+/*
+ * trigram_index.c - On-disk trigram index implementation
+ *
+ * File layout (native endianness, it is a local cache):
+ *   header | file table | path blob | postings | trigram table
+ * The file table is sorted by relative path, so a directory's files form a
+ * contiguous id range and lookups are binary searches. Posting lists are
+ * ascending file ids stored as LEB128 varint deltas.
+ * C99, handmade hero style.
+ */
+
+#include "trigram_index.h"
+#include "byte_scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread primitives (from platform layer) */
+extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
+extern void Platform_DestroyThread(void *thread);
+extern void *Platform_CreateMutex(void);
+extern void Platform_LockMutex(void *mutex);
+extern void Platform_UnlockMutex(void *mutex);
+
+/* ===== Configuration ===== */
+
+#define TRIGRAM_INDEX_MAGIC 0x49544257u /* "WBTI" */
+#define TRIGRAM_INDEX_VERSION 1
+#define TRIGRAM_INDEX_BINARY_PROBE Kilobytes(8) /* Same as content search */
+#define TRIGRAM_INDEX_REFRESH_MS (10 * 60 * 1000) /* Rebuild stale indexes */
+#define TRIGRAM_INDEX_ABORT_CHECK 64 /* Files between abort checks */
+#define TRIGRAM_INDEX_MAX_QUERY_TRIGRAMS 64 /* Enough to narrow any query */
+
+/* File flags */
+#define TRIGRAM_FILE_SKIPPED 0x1   /* Binary or too large, never a candidate */
+#define TRIGRAM_FILE_UNINDEXED 0x2 /* Over memory budget, always a candidate */
+
+/* ===== On-Disk Types ===== */
+
+typedef struct {
+  u32 magic;
+  u32 version;
+  u32 file_count;
+  u32 trigram_count;
+  u32 root_offset; /* Into the path blob */
+  u32 reserved;
+  u64 files_offset;
+  u64 paths_offset;
+  u64 postings_offset;
+  u64 trigrams_offset;
+  u64 total_size;
+} trigram_index_header;
+
+typedef struct {
+  u32 path_offset; /* Relative path, into the path blob */
+  u32 flags;
+  u64 size;
+  u64 modified_time;
+} trigram_index_file;
+
+typedef struct {
+  u32 trigram;
+  u32 count;       /* Files in the posting list */
+  u64 offset;      /* Into the postings section */
+} trigram_index_entry;
+
+/* ===== Build Types ===== */
+
+typedef struct {
+  char *rel_path;
+  u64 size;
+  u64 modified_time;
+  u32 flags;
+} trigram_build_file;
+
+typedef struct {
+  trigram_index *index;
+  const char *root;
+  const char *rel_dir; /* Directory being enumerated */
+
+  trigram_build_file *files;
+  u32 file_count;
+  u32 file_capacity;
+
+  char **dir_stack;
+  u32 dir_count;
+  u32 dir_capacity;
+
+  b32 out_of_memory;
+} trigram_build;
+
+/* ===== Internal Helpers ===== */
+
+static inline u8 TrigramIndex_Fold(u8 c) {
+  return (c >= 'A' && c <= 'Z') ? (u8)(c + 32) : c;
+}
+
+static inline u32 TrigramIndex_Pack(const u8 *p) {
+  return ((u32)TrigramIndex_Fold(p[0]) << 16) |
+         ((u32)TrigramIndex_Fold(p[1]) << 8) | (u32)TrigramIndex_Fold(p[2]);
+}
+
+static inline b32 TrigramIndex_IsSeparator(char c) {
+  return c == '/' || c == '\\';
+}
+
+/* Path of 'path' relative to 'root', or NULL if it is not below it */
+static const char *TrigramIndex_Relative(const char *root, const char *path) {
+  usize root_len = strlen(root);
+  while (root_len > 0 && TrigramIndex_IsSeparator(root[root_len - 1]))
+    root_len--;
+  if (strncmp(root, path, root_len) != 0)
+    return NULL;
+
+  const char *rest = path + root_len;
+  if (*rest != '\0' && !TrigramIndex_IsSeparator(*rest))
+    return NULL; /* "/foo/barbaz" is not below "/foo/bar" */
+  while (TrigramIndex_IsSeparator(*rest))
+    rest++;
+  return rest;
+}
+
+/* Cache file for an index rooted at 'root' */
+static b32 TrigramIndex_CachePath(const char *root, char *out, usize out_size) {
+  char cache[FS_MAX_PATH];
+  if (!Platform_GetCachePath(cache, sizeof(cache)))
+    return false;
+
+  char dir[FS_MAX_PATH];
+  FS_JoinPath(dir, sizeof(dir), cache, "workbench");
+  Platform_CreateDirectory(dir);
+  char index_dir[FS_MAX_PATH];
+  FS_JoinPath(index_dir, sizeof(index_dir), dir, "index");
+  Platform_CreateDirectory(index_dir);
+
+  /* FNV-1a of the root path */
+  u64 hash = 14695981039346656037ULL;
+  for (const char *c = root; *c; c++) {
+    hash ^= (u8)*c;
+    hash *= 1099511628211ULL;
+  }
+
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.idx", (unsigned long long)hash);
+  FS_JoinPath(out, out_size, index_dir, name);
+  return true;
+}
+
+/* Accessors into the mapped index (map must be valid) */
+static const trigram_index_header *TrigramIndex_Header(trigram_index *index) {
+  return (const trigram_index_header *)index->map.data;
+}
+
+static const trigram_index_file *TrigramIndex_Files(trigram_index *index) {
+  return (const trigram_index_file *)(index->map.data +
+                                      TrigramIndex_Header(index)->files_offset);
+}
+
+static const char *TrigramIndex_PathAt(trigram_index *index, u32 offset) {
+  return (const char *)(index->map.data +
+                        TrigramIndex_Header(index)->paths_offset + offset);
+}
+
+/* First file id whose relative path is >= 'rel' */
+static u32 TrigramIndex_LowerBound(trigram_index *index, const char *rel) {
+  const trigram_index_file *files = TrigramIndex_Files(index);
+  u32 lo = 0;
+  u32 hi = TrigramIndex_Header(index)->file_count;
+  while (lo < hi) {
+    u32 mid = lo + (hi - lo) / 2;
+    if (strcmp(TrigramIndex_PathAt(index, files[mid].path_offset), rel) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Id range [*out_lo, *out_hi) of the files below relative directory 'rel' */
+static void TrigramIndex_DirectoryRange(trigram_index *index, const char *rel,
+                                        u32 *out_lo, u32 *out_hi) {
+  if (rel[0] == '\0') {
+    *out_lo = 0;
+    *out_hi = TrigramIndex_Header(index)->file_count;
+    return;
+  }
+
+  /* "dir/" .. "dir0" ('0' sorts right after '/') */
+  char prefix[FS_MAX_PATH];
+  snprintf(prefix, sizeof(prefix), "%s/", rel);
+  *out_lo = TrigramIndex_LowerBound(index, prefix);
+  prefix[strlen(prefix) - 1] = '0';
+  *out_hi = TrigramIndex_LowerBound(index, prefix);
+}
+
+static b32 TrigramIndex_Validate(const platform_file_map *map,
+                                 const char *root) {
+  if (!map->data || map->size < sizeof(trigram_index_header))
+    return false;
+
+  const trigram_index_header *header = (const trigram_index_header *)map->data;
+  if (header->magic != TRIGRAM_INDEX_MAGIC ||
+      header->version != TRIGRAM_INDEX_VERSION ||
+      header->total_size != map->size)
+    return false;
+
+  u64 files_end =
+      header->files_offset + (u64)header->file_count * sizeof(trigram_index_file);
+  u64 trigrams_end = header->trigrams_offset +
+                     (u64)header->trigram_count * sizeof(trigram_index_entry);
+  if (files_end > header->paths_offset ||
+      header->paths_offset > header->postings_offset ||
+      header->postings_offset > header->trigrams_offset ||
+      trigrams_end > map->size || (header->files_offset & 7) ||
+      (header->trigrams_offset & 7))
+    return false;
+
+  u64 root_at = header->paths_offset + header->root_offset;
+  if (root_at >= header->postings_offset)
+    return false;
+  const char *stored_root = (const char *)(map->data + root_at);
+  usize max_len = (usize)(header->postings_offset - root_at);
+  return strnlen(stored_root, max_len) < max_len &&
+         strcmp(stored_root, root) == 0;
+}
+
+/* Decode up to 'count' ids of a posting list into 'out'.
+ * Returns the number decoded (fewer only if the data is truncated). */
+static u32 TrigramIndex_DecodePostings(trigram_index *index,
+                                       const trigram_index_entry *entry,
+                                       u32 *out) {
+  const trigram_index_header *header = TrigramIndex_Header(index);
+  const u8 *p = index->map.data + header->postings_offset + entry->offset;
+  const u8 *end = index->map.data + header->trigrams_offset;
+
+  u32 id = 0;
+  u32 decoded = 0;
+  while (decoded < entry->count && p < end) {
+    u32 delta = 0;
+    u32 shift = 0;
+    while (p < end && shift < 35) {
+      u8 byte = *p++;
+      delta |= (u32)(byte & 0x7F) << shift;
+      shift += 7;
+      if (!(byte & 0x80))
+        break;
+    }
+    id += delta;
+    out[decoded++] = id;
+  }
+  return decoded;
+}
+
+static const trigram_index_entry *TrigramIndex_FindEntry(trigram_index *index,
+                                                         u32 trigram) {
+  const trigram_index_header *header = TrigramIndex_Header(index);
+  const trigram_index_entry *entries =
+      (const trigram_index_entry *)(index->map.data + header->trigrams_offset);
+
+  u32 lo = 0;
+  u32 hi = header->trigram_count;
+  while (lo < hi) {
+    u32 mid = lo + (hi - lo) / 2;
+    if (entries[mid].trigram < trigram) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < header->trigram_count && entries[lo].trigram == trigram)
+             ? &entries[lo]
+             : NULL;
+}
+
+static int TrigramIndex_CompareEntryCount(const void *a, const void *b) {
+  const trigram_index_entry *ea = *(const trigram_index_entry *const *)a;
+  const trigram_index_entry *eb = *(const trigram_index_entry *const *)b;
+  return (ea->count > eb->count) - (ea->count < eb->count);
+}
+
+/* Called with the mutex held */
+static void TrigramIndex_Unload(trigram_index *index) {
+  Platform_UnmapFile(&index->map);
+  index->root[0] = '\0';
+  index->file_count = 0;
+  index->trigram_count = 0;
+  index->unindexed_count = 0;
+  index->loaded_from_disk = false;
+}
+
+/* Called with the mutex held */
+static b32 TrigramIndex_LoadLocked(trigram_index *index, const char *root,
+                                   const char *path) {
+  platform_file_map map;
+  if (!Platform_MapFile(path, &map))
+    return false;
+  if (!TrigramIndex_Validate(&map, root)) {
+    Platform_UnmapFile(&map);
+    return false;
+  }
+
+  TrigramIndex_Unload(index);
+  index->map = map;
+  snprintf(index->root, sizeof(index->root), "%s", root);
+  index->file_count = TrigramIndex_Header(index)->file_count;
+  index->trigram_count = TrigramIndex_Header(index)->trigram_count;
+
+  const trigram_index_file *files = TrigramIndex_Files(index);
+  for (u32 i = 0; i < index->file_count; i++) {
+    if (files[i].flags & TRIGRAM_FILE_UNINDEXED)
+      index->unindexed_count++;
+  }
+  return true;
+}
+
+/* ===== Index Build ===== */
+
+static b32 TrigramIndex_BuildAborted(trigram_index *index, const char *root) {
+  Platform_LockMutex(index->mutex);
+  b32 aborted = index->shutdown_requested ||
+                strcmp(index->build_root, root) != 0 ||
+                index->pending_root[0] != '\0';
+  Platform_UnlockMutex(index->mutex);
+  return aborted;
+}
+
+static char *TrigramIndex_StrDup(const char *s) {
+  usize len = strlen(s) + 1;
+  char *copy = (char *)malloc(len);
+  if (copy)
+    memcpy(copy, s, len);
+  return copy;
+}
+
+static b32 TrigramIndex_CollectEntry(void *user_data, const char *name,
+                                     file_type type) {
+  trigram_build *build = (trigram_build *)user_data;
+
+  /* Same walk rules as content search: no hidden entries, no symlinks */
+  if (name[0] == '.')
+    return true;
+  if (type != WB_FILE_TYPE_DIRECTORY && type != WB_FILE_TYPE_FILE)
+    return true;
+
+  char rel[FS_MAX_PATH];
+  if (build->rel_dir[0]) {
+    snprintf(rel, sizeof(rel), "%s/%s", build->rel_dir, name);
+  } else {
+    snprintf(rel, sizeof(rel), "%s", name);
+  }
+
+  if (type == WB_FILE_TYPE_DIRECTORY) {
+    if (build->dir_count == build->dir_capacity) {
+      u32 capacity = build->dir_capacity ? build->dir_capacity * 2 : 256;
+      char **grown =
+          (char **)realloc(build->dir_stack, sizeof(char *) * capacity);
+      if (!grown) {
+        build->out_of_memory = true;
+        return false;
+      }
+      build->dir_stack = grown;
+      build->dir_capacity = capacity;
+    }
+    char *copy = TrigramIndex_StrDup(rel);
+    if (!copy) {
+      build->out_of_memory = true;
+      return false;
+    }
+    build->dir_stack[build->dir_count++] = copy;
+    return true;
+  }
+
+  char full[FS_MAX_PATH];
+  FS_JoinPath(full, sizeof(full), build->root, rel);
+  file_info info;
+  if (!Platform_GetFileInfo(full, &info))
+    return true;
+
+  if (build->file_count == build->file_capacity) {
+    u32 capacity = build->file_capacity ? build->file_capacity * 2 : 4096;
+    trigram_build_file *grown = (trigram_build_file *)realloc(
+        build->files, sizeof(trigram_build_file) * capacity);
+    if (!grown) {
+      build->out_of_memory = true;
+      return false;
+    }
+    build->files = grown;
+    build->file_capacity = capacity;
+  }
+
+  trigram_build_file *file = &build->files[build->file_count];
+  file->rel_path = TrigramIndex_StrDup(rel);
+  if (!file->rel_path) {
+    build->out_of_memory = true;
+    return false;
+  }
+  file->size = info.size;
+  file->modified_time = info.modified_time;
+  file->flags = 0;
+  build->file_count++;
+  return true;
+}
+
+static int TrigramIndex_CompareBuildFiles(const void *a, const void *b) {
+  return strcmp(((const trigram_build_file *)a)->rel_path,
+                ((const trigram_build_file *)b)->rel_path);
+}
+
+/* Stable LSD radix sort of (trigram << 32 | file id) pairs by trigram.
+ * Pairs are produced in ascending id order, so the result is sorted by
+ * trigram then id. */
+static void TrigramIndex_SortPairs(u64 *pairs, u64 *temp, usize count) {
+  static u32 buckets[4096]; /* Only ever used by the single build thread */
+  u64 *src = pairs;
+  u64 *dst = temp;
+
+  for (u32 pass = 0; pass < 2; pass++) {
+    u32 shift = 32 + pass * 12;
+    memset(buckets, 0, sizeof(buckets));
+    for (usize i = 0; i < count; i++) {
+      buckets[(src[i] >> shift) & 0xFFF]++;
+    }
+    u32 sum = 0;
+    for (u32 b = 0; b < 4096; b++) {
+      u32 n = buckets[b];
+      buckets[b] = sum;
+      sum += n;
+    }
+    for (usize i = 0; i < count; i++) {
+      dst[buckets[(src[i] >> shift) & 0xFFF]++] = src[i];
+    }
+    u64 *swap = src;
+    src = dst;
+    dst = swap;
+  }
+  /* Two passes: the sorted data is back in 'pairs' */
+}
+
+static b32 TrigramIndex_WriteVarint(FILE *file, u32 value, u64 *written) {
+  u8 bytes[5];
+  u32 n = 0;
+  do {
+    u8 byte = value & 0x7F;
+    value >>= 7;
+    bytes[n++] = byte | (value ? 0x80 : 0);
+  } while (value);
+  *written += n;
+  return fwrite(bytes, 1, n, file) == n;
+}
+
+static b32 TrigramIndex_Pad(FILE *file, u64 *written) {
+  static const u8 zeros[8] = {0};
+  u32 pad = (u32)((8 - (*written & 7)) & 7);
+  *written += pad;
+  return pad == 0 || fwrite(zeros, 1, pad, file) == pad;
+}
+
+/* Extract trigrams of every file into pairs and write the index to 'path'.
+ * Returns false on abort, I/O error or when over the disk budget. */
+static b32 TrigramIndex_BuildToFile(trigram_index *index, const char *root,
+                                    const char *path, u64 max_memory_bytes,
+                                    u64 max_disk_bytes, u64 max_file_bytes) {
+  trigram_build build = {0};
+  build.index = index;
+  build.root = root;
+
+  b32 ok = false;
+  u8 *seen = NULL;
+  u64 *pairs = NULL;
+  u64 *temp = NULL;
+  trigram_index_entry *entries = NULL;
+  FILE *file = NULL;
+
+  /* Walk the tree */
+  char *top = TrigramIndex_StrDup("");
+  if (!top)
+    goto done;
+  build.dir_stack = (char **)malloc(sizeof(char *) * 256);
+  if (!build.dir_stack) {
+    free(top);
+    goto done;
+  }
+  build.dir_capacity = 256;
+  build.dir_stack[build.dir_count++] = top;
+
+  u32 dirs_walked = 0;
+  while (build.dir_count > 0 && !build.out_of_memory) {
+    char *rel_dir = build.dir_stack[--build.dir_count];
+    char full[FS_MAX_PATH];
+    if (rel_dir[0]) {
+      FS_JoinPath(full, sizeof(full), root, rel_dir);
+    } else {
+      snprintf(full, sizeof(full), "%s", root);
+    }
+    build.rel_dir = rel_dir;
+    Platform_EnumerateDirectory(full, TrigramIndex_CollectEntry, &build);
+    free(rel_dir);
+
+    if (++dirs_walked % TRIGRAM_INDEX_ABORT_CHECK == 0 &&
+        TrigramIndex_BuildAborted(index, root))
+      goto done;
+  }
+  if (build.out_of_memory)
+    goto done;
+
+  qsort(build.files, build.file_count, sizeof(trigram_build_file),
+        TrigramIndex_CompareBuildFiles);
+
+  /* Extract distinct trigrams per file */
+  usize pair_limit = (usize)(max_memory_bytes / (2 * sizeof(u64)));
+  usize pair_capacity = 0;
+  usize pair_count = 0;
+  b32 budget_exhausted = false;
+
+  seen = (u8 *)calloc(1, (1u << 24) / 8);
+  if (!seen)
+    goto done;
+
+  for (u32 id = 0; id < build.file_count; id++) {
+    trigram_build_file *bf = &build.files[id];
+
+    if (id % TRIGRAM_INDEX_ABORT_CHECK == 0 &&
+        TrigramIndex_BuildAborted(index, root))
+      goto done;
+
+    if (budget_exhausted) {
+      bf->flags |= TRIGRAM_FILE_UNINDEXED;
+      continue;
+    }
+    if (bf->size > max_file_bytes) {
+      bf->flags |= TRIGRAM_FILE_SKIPPED;
+      continue;
+    }
+
+    char full[FS_MAX_PATH];
+    FS_JoinPath(full, sizeof(full), root, bf->rel_path);
+    platform_file_map map;
+    if (!Platform_MapFile(full, &map)) {
+      bf->flags |= TRIGRAM_FILE_UNINDEXED; /* Let the search decide */
+      continue;
+    }
+
+    /* Trust the mapped size over the walk (file may have changed) */
+    bf->size = map.size;
+    if (map.size > max_file_bytes ||
+        ByteScan_HasNul(map.data, (usize)Min(map.size,
+                                             (u64)TRIGRAM_INDEX_BINARY_PROBE))) {
+      bf->flags |= TRIGRAM_FILE_SKIPPED;
+      Platform_UnmapFile(&map);
+      continue;
+    }
+
+    usize file_start = pair_count;
+    b32 overflow = false;
+    for (u64 i = 0; i + 2 < map.size; i++) {
+      u32 trigram = TrigramIndex_Pack(map.data + i);
+      u8 bit = (u8)(1u << (trigram & 7));
+      if (seen[trigram >> 3] & bit)
+        continue;
+      seen[trigram >> 3] |= bit;
+
+      if (pair_count == pair_capacity) {
+        usize capacity = pair_capacity ? pair_capacity * 2 : 1u << 20;
+        if (capacity > pair_limit)
+          capacity = pair_limit;
+        u64 *grown =
+            capacity > pair_capacity
+                ? (u64 *)realloc(pairs, sizeof(u64) * capacity)
+                : NULL;
+        if (!grown) {
+          overflow = true;
+          break;
+        }
+        pairs = grown;
+        pair_capacity = capacity;
+      }
+      pairs[pair_count++] = ((u64)trigram << 32) | id;
+    }
+    Platform_UnmapFile(&map);
+
+    /* Clear this file's bits for the next one */
+    for (usize i = file_start; i < pair_count; i++) {
+      u32 trigram = (u32)(pairs[i] >> 32);
+      seen[trigram >> 3] &= (u8)~(1u << (trigram & 7));
+    }
+    if (overflow) {
+      /* Drop the partial file; 'seen' is not used again */
+      pair_count = file_start;
+      bf->flags |= TRIGRAM_FILE_UNINDEXED;
+      budget_exhausted = true;
+    }
+  }
+
+  free(seen);
+  seen = NULL;
+
+  temp = (u64 *)malloc(sizeof(u64) * (pair_count ? pair_count : 1));
+  if (!temp)
+    goto done;
+  TrigramIndex_SortPairs(pairs, temp, pair_count);
+  free(temp);
+  temp = NULL;
+
+  /* Write the file */
+  file = fopen(path, "wb");
+  if (!file)
+    goto done;
+
+  trigram_index_header header = {0};
+  header.magic = TRIGRAM_INDEX_MAGIC;
+  header.version = TRIGRAM_INDEX_VERSION;
+  header.file_count = build.file_count;
+
+  u64 written = sizeof(header);
+  if (fwrite(&header, sizeof(header), 1, file) != 1)
+    goto done;
+
+  /* File table (path offsets follow the root in the blob) */
+  header.files_offset = written;
+  u32 path_offset = (u32)strlen(root) + 1;
+  for (u32 id = 0; id < build.file_count; id++) {
+    trigram_index_file tf = {0};
+    tf.path_offset = path_offset;
+    tf.flags = build.files[id].flags;
+    tf.size = build.files[id].size;
+    tf.modified_time = build.files[id].modified_time;
+    if (fwrite(&tf, sizeof(tf), 1, file) != 1)
+      goto done;
+    path_offset += (u32)strlen(build.files[id].rel_path) + 1;
+  }
+  written += (u64)build.file_count * sizeof(trigram_index_file);
+
+  header.paths_offset = written;
+  header.root_offset = 0;
+  if (fwrite(root, strlen(root) + 1, 1, file) != 1)
+    goto done;
+  for (u32 id = 0; id < build.file_count; id++) {
+    usize len = strlen(build.files[id].rel_path) + 1;
+    if (fwrite(build.files[id].rel_path, len, 1, file) != 1)
+      goto done;
+  }
+  written += path_offset;
+  if (!TrigramIndex_Pad(file, &written))
+    goto done;
+
+  /* Postings, collecting the trigram table as we go */
+  header.postings_offset = written;
+  u32 entry_capacity = 0;
+  u32 entry_count = 0;
+  for (usize i = 0; i < pair_count;) {
+    u32 trigram = (u32)(pairs[i] >> 32);
+    if (entry_count == entry_capacity) {
+      u32 capacity = entry_capacity ? entry_capacity * 2 : 65536;
+      trigram_index_entry *grown = (trigram_index_entry *)realloc(
+          entries, sizeof(trigram_index_entry) * capacity);
+      if (!grown)
+        goto done;
+      entries = grown;
+      entry_capacity = capacity;
+    }
+    trigram_index_entry *entry = &entries[entry_count++];
+    entry->trigram = trigram;
+    entry->offset = written - header.postings_offset;
+    entry->count = 0;
+
+    u32 previous = 0;
+    for (; i < pair_count && (u32)(pairs[i] >> 32) == trigram; i++) {
+      u32 id = (u32)pairs[i];
+      if (!TrigramIndex_WriteVarint(file, id - previous, &written))
+        goto done;
+      previous = id;
+      entry->count++;
+    }
+
+    if (written > max_disk_bytes)
+      goto done;
+  }
+  if (!TrigramIndex_Pad(file, &written))
+    goto done;
+
+  header.trigrams_offset = written;
+  header.trigram_count = entry_count;
+  if (entry_count > 0 &&
+      fwrite(entries, sizeof(trigram_index_entry), entry_count, file) !=
+          entry_count)
+    goto done;
+  written += (u64)entry_count * sizeof(trigram_index_entry);
+  header.total_size = written;
+  if (written > max_disk_bytes)
+    goto done;
+
+  /* Header last, so a torn write never validates */
+  if (fseek(file, 0, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(header), 1, file) != 1)
+    goto done;
+
+  ok = fflush(file) == 0;
+
+done:
+  if (file)
+    fclose(file);
+  free(entries);
+  free(temp);
+  free(pairs);
+  free(seen);
+  for (u32 i = 0; i < build.dir_count; i++)
+    free(build.dir_stack[i]);
+  free(build.dir_stack);
+  for (u32 i = 0; i < build.file_count; i++)
+    free(build.files[i].rel_path);
+  free(build.files);
+  return ok;
+}
+
+static void *TrigramIndex_BuildThread(void *arg) {
+  trigram_index *index = (trigram_index *)arg;
+
+  Platform_LockMutex(index->mutex);
+  for (;;) {
+    char root[FS_MAX_PATH];
+    snprintf(root, sizeof(root), "%s", index->build_root);
+    u64 max_memory_bytes = index->max_memory_bytes;
+    u64 max_disk_bytes = index->max_disk_bytes;
+    u64 max_file_bytes = index->max_file_bytes;
+    index->build_started_ms = Platform_GetTimeMs();
+    /* Changes recorded so far are picked up by this build's walk */
+    index->build_changed_count =
+        strcmp(index->changed_root, root) == 0 ? index->changed_count : 0;
+    Platform_UnlockMutex(index->mutex);
+
+    char path[FS_MAX_PATH];
+    char temp_path[FS_MAX_PATH + 8];
+    b32 built = false;
+    if (TrigramIndex_CachePath(root, path, sizeof(path))) {
+      snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+      built = TrigramIndex_BuildToFile(index, root, temp_path,
+                                       max_memory_bytes, max_disk_bytes,
+                                       max_file_bytes);
+      if (!built)
+        Platform_Delete(temp_path);
+    }
+
+    Platform_LockMutex(index->mutex);
+    if (built && !index->shutdown_requested &&
+        strcmp(index->build_root, root) == 0) {
+      /* Swap in the new index (Windows can't replace a mapped file) */
+      TrigramIndex_Unload(index);
+      Platform_Delete(path);
+      if (Platform_Rename(temp_path, path)) {
+        TrigramIndex_LoadLocked(index, root, path);
+      }
+
+      if (strcmp(index->changed_root, root) == 0) {
+        /* Keep only changes recorded while the build was running */
+        i32 seen = index->build_changed_count;
+        memmove(index->changed_dirs, index->changed_dirs + seen,
+                sizeof(trigram_index_changed_dir) *
+                    (usize)(index->changed_count - seen));
+        index->changed_count -= seen;
+      } else {
+        snprintf(index->changed_root, sizeof(index->changed_root), "%s", root);
+        index->changed_count = 0;
+      }
+      index->build_changed_count = 0;
+      index->changed_overflow = false;
+      index->last_build_ms = Platform_GetTimeMs() - index->build_started_ms;
+    } else if (built) {
+      Platform_Delete(temp_path);
+    }
+
+    if (!index->shutdown_requested && index->pending_root[0] != '\0') {
+      snprintf(index->build_root, sizeof(index->build_root), "%s",
+               index->pending_root);
+      index->pending_root[0] = '\0';
+      continue;
+    }
+
+    index->building = false;
+    index->build_root[0] = '\0';
+    break;
+  }
+  Platform_UnlockMutex(index->mutex);
+  return NULL;
+}
+
+/* Called with the mutex held */
+static void TrigramIndex_RequestBuild(trigram_index *index, const char *root) {
+  if (index->building) {
+    if (strcmp(index->build_root, root) != 0) {
+      /* Supersede the running build */
+      snprintf(index->pending_root, sizeof(index->pending_root), "%s", root);
+    }
+    return;
+  }
+
+  index->building = true;
+  index->pending_root[0] = '\0';
+  snprintf(index->build_root, sizeof(index->build_root), "%s", root);
+
+  void *thread = Platform_CreateThread(TrigramIndex_BuildThread, index);
+  if (!thread) {
+    index->building = false;
+    index->build_root[0] = '\0';
+    return;
+  }
+  Platform_DestroyThread(thread); /* Detach */
+}
+
+/* ===== Public API ===== */
+
+void TrigramIndex_Init(trigram_index *index) {
+  memset(index, 0, sizeof(*index));
+  index->max_memory_bytes = Megabytes(256);
+  index->max_disk_bytes = Megabytes(1024);
+  index->max_file_bytes = Megabytes(16);
+}
+
+void TrigramIndex_Shutdown(trigram_index *index) {
+  if (!index->mutex)
+    return;
+
+  /* A running build notices the flag and exits; its state stays allocated */
+  Platform_LockMutex(index->mutex);
+  index->shutdown_requested = true;
+  if (!index->building) {
+    TrigramIndex_Unload(index);
+  }
+  Platform_UnlockMutex(index->mutex);
+}
+
+void TrigramIndex_Configure(trigram_index *index, u64 max_memory_bytes,
+                            u64 max_disk_bytes, u64 max_file_bytes) {
+  if (!index->mutex) {
+    index->max_memory_bytes = max_memory_bytes;
+    index->max_disk_bytes = max_disk_bytes;
+    index->max_file_bytes = max_file_bytes;
+    return;
+  }
+  Platform_LockMutex(index->mutex);
+  index->max_memory_bytes = max_memory_bytes;
+  index->max_disk_bytes = max_disk_bytes;
+  index->max_file_bytes = max_file_bytes;
+  Platform_UnlockMutex(index->mutex);
+}
+
+void TrigramIndex_Ensure(trigram_index *index, const char *root) {
+  if (!index->mutex) {
+    index->mutex = Platform_CreateMutex();
+    index->changed_dirs = (trigram_index_changed_dir *)malloc(
+        sizeof(trigram_index_changed_dir) * TRIGRAM_INDEX_MAX_CHANGED_DIRS);
+    if (!index->mutex || !index->changed_dirs)
+      return;
+  }
+
+  Platform_LockMutex(index->mutex);
+  if (index->shutdown_requested) {
+    Platform_UnlockMutex(index->mutex);
+    return;
+  }
+
+  b32 covered =
+      index->map.data && TrigramIndex_Relative(index->root, root) != NULL;
+  b32 building_covered =
+      index->building && TrigramIndex_Relative(index->build_root, root);
+
+  if (!covered && !building_covered) {
+    char path[FS_MAX_PATH];
+    if (TrigramIndex_CachePath(root, path, sizeof(path)) &&
+        TrigramIndex_LoadLocked(index, root, path)) {
+      snprintf(index->changed_root, sizeof(index->changed_root), "%s", root);
+      index->changed_count = 0;
+      index->changed_overflow = false;
+      index->loaded_from_disk = true;
+    }
+    covered = index->map.data != NULL &&
+              TrigramIndex_Relative(index->root, root) != NULL;
+  }
+
+  if (!covered) {
+    if (!building_covered)
+      TrigramIndex_RequestBuild(index, root);
+  } else if (!index->building) {
+    /* An index from an earlier session missed every change since then, and
+     * the watcher only reports the folders that are open */
+    u64 now = Platform_GetTimeMs();
+    b32 stale = index->loaded_from_disk || index->changed_overflow ||
+                now - index->build_started_ms > TRIGRAM_INDEX_REFRESH_MS;
+    if (stale) {
+      index->loaded_from_disk = false;
+      TrigramIndex_RequestBuild(index, index->root);
+    }
+  }
+  Platform_UnlockMutex(index->mutex);
+}
+
+void TrigramIndex_MarkChanged(trigram_index *index, const char *dir) {
+  if (!index->mutex || !index->changed_dirs)
+    return;
+
+  Platform_LockMutex(index->mutex);
+
+  /* Changes are relative to the loaded index, or to the first build */
+  const char *base = index->map.data   ? index->root
+                     : index->building ? index->build_root
+                                       : NULL;
+  const char *rel = base ? TrigramIndex_Relative(base, dir) : NULL;
+  if (!rel || index->changed_overflow) {
+    Platform_UnlockMutex(index->mutex);
+    return;
+  }
+  if (strcmp(index->changed_root, base) != 0) {
+    snprintf(index->changed_root, sizeof(index->changed_root), "%s", base);
+    index->changed_count = 0;
+    index->build_changed_count = 0;
+  }
+
+  /* Already recorded? A repeat of an entry the running build has already
+   * walked moves to the end so the post-build trim keeps it. */
+  for (i32 i = 0; i < index->changed_count; i++) {
+    if (strcmp(index->changed_dirs[i].path, rel) != 0)
+      continue;
+    if (i < index->build_changed_count) {
+      trigram_index_changed_dir entry = index->changed_dirs[i];
+      memmove(&index->changed_dirs[i], &index->changed_dirs[i + 1],
+              sizeof(trigram_index_changed_dir) *
+                  (usize)(index->changed_count - i - 1));
+      index->changed_dirs[index->changed_count - 1] = entry;
+      index->build_changed_count--;
+    }
+    Platform_UnlockMutex(index->mutex);
+    return;
+  }
+
+  if (index->changed_count == TRIGRAM_INDEX_MAX_CHANGED_DIRS) {
+    /* Too much drift: fall back to scanning until a rebuild lands */
+    index->changed_overflow = true;
+    TrigramIndex_RequestBuild(index, base);
+  } else {
+    snprintf(index->changed_dirs[index->changed_count].path, FS_MAX_PATH, "%s",
+             rel);
+    index->changed_count++;
+  }
+  Platform_UnlockMutex(index->mutex);
+}
+
+b32 TrigramIndex_Query(trigram_index *index, const char *root,
+                       const char *query, trigram_index_visit_fn visit,
+                       void *user_data) {
+  usize query_len = strlen(query);
+  if (!index->mutex || query_len < 3)
+    return false;
+
+  Platform_LockMutex(index->mutex);
+  const char *rel_root =
+      index->map.data ? TrigramIndex_Relative(index->root, root) : NULL;
+  if (!rel_root || index->changed_overflow) {
+    Platform_UnlockMutex(index->mutex);
+    return false;
+  }
+
+  u32 lo, hi;
+  TrigramIndex_DirectoryRange(index, rel_root, &lo, &hi);
+  const trigram_index_file *files = TrigramIndex_Files(index);
+
+  /* Posting lists of the distinct query trigrams, shortest first */
+  const trigram_index_entry *lists[TRIGRAM_INDEX_MAX_QUERY_TRIGRAMS];
+  u32 list_count = 0;
+  b32 no_postings = false;
+  for (usize i = 0; i + 2 < query_len && list_count < ArrayCount(lists); i++) {
+    const trigram_index_entry *entry =
+        TrigramIndex_FindEntry(index, TrigramIndex_Pack((const u8 *)query + i));
+    if (!entry) {
+      no_postings = true;
+      break;
+    }
+    b32 duplicate = false;
+    for (u32 k = 0; k < list_count; k++) {
+      if (lists[k] == entry)
+        duplicate = true;
+    }
+    if (!duplicate)
+      lists[list_count++] = entry;
+  }
+
+  u32 *ids = NULL;
+  u32 *scratch = NULL;
+  u32 id_count = 0;
+  if (!no_postings && list_count > 0) {
+    qsort(lists, list_count, sizeof(lists[0]), TrigramIndex_CompareEntryCount);
+    ids = (u32 *)malloc(sizeof(u32) * lists[0]->count);
+    scratch = (u32 *)malloc(sizeof(u32) * (lists[list_count - 1]->count + 1));
+    if (ids && scratch) {
+      u32 decoded = TrigramIndex_DecodePostings(index, lists[0], ids);
+      for (u32 i = 0; i < decoded; i++) {
+        if (ids[i] >= lo && ids[i] < hi)
+          ids[id_count++] = ids[i];
+      }
+
+      /* Intersect with the longer lists */
+      for (u32 l = 1; l < list_count && id_count > 0; l++) {
+        u32 other_count = TrigramIndex_DecodePostings(index, lists[l], scratch);
+        u32 kept = 0;
+        u32 j = 0;
+        for (u32 i = 0; i < id_count; i++) {
+          while (j < other_count && scratch[j] < ids[i])
+            j++;
+          if (j < other_count && scratch[j] == ids[i])
+            ids[kept++] = ids[i];
+        }
+        id_count = kept;
+      }
+    } else {
+      /* Out of memory: let the caller scan */
+      free(ids);
+      free(scratch);
+      Platform_UnlockMutex(index->mutex);
+      return false;
+    }
+  }
+
+  char path[FS_MAX_PATH];
+  b32 keep_going = true;
+
+  /* Files that matched every trigram plus files the index could not hold.
+   * Both lists are ascending, so merge them to keep path order. */
+  u32 next = 0;
+  for (u32 id = lo; id < hi && keep_going; id++) {
+    b32 candidate = false;
+    if (next < id_count && ids[next] == id) {
+      candidate = true;
+      next++;
+    } else if (files[id].flags & TRIGRAM_FILE_UNINDEXED) {
+      candidate = true;
+    }
+    if (!candidate)
+      continue;
+    FS_JoinPath(path, sizeof(path), index->root,
+                TrigramIndex_PathAt(index, files[id].path_offset));
+    keep_going = visit(user_data, path, TRIGRAM_INDEX_CANDIDATE_FILE);
+  }
+  free(ids);
+  free(scratch);
+
+  /* Changed directories below the search root */
+  usize rel_root_len = strlen(rel_root);
+  i32 changed_count =
+      strcmp(index->changed_root, index->root) == 0 ? index->changed_count : 0;
+  for (i32 i = 0; i < changed_count && keep_going; i++) {
+    const char *dir = index->changed_dirs[i].path;
+    if (rel_root_len > 0 &&
+        (strncmp(dir, rel_root, rel_root_len) != 0 ||
+         (dir[rel_root_len] != '\0' && dir[rel_root_len] != '/')))
+      continue;
+
+    if (dir[0]) {
+      FS_JoinPath(path, sizeof(path), index->root, dir);
+    } else {
+      snprintf(path, sizeof(path), "%s", index->root);
+    }
+    keep_going = visit(user_data, path, TRIGRAM_INDEX_CANDIDATE_CHANGED_DIR);
+  }
+
+  Platform_UnlockMutex(index->mutex);
+  return true;
+}
+
+b32 TrigramIndex_IsFileCurrent(trigram_index *index, const char *path,
+                               u64 size, u64 modified_time) {
+  if (!index->mutex)
+    return false;
+
+  b32 current = false;
+  Platform_LockMutex(index->mutex);
+  const char *rel =
+      index->map.data ? TrigramIndex_Relative(index->root, path) : NULL;
+  if (rel && rel[0]) {
+    u32 id = TrigramIndex_LowerBound(index, rel);
+    const trigram_index_file *files = TrigramIndex_Files(index);
+    if (id < index->file_count &&
+        strcmp(TrigramIndex_PathAt(index, files[id].path_offset), rel) == 0) {
+      current = files[id].size == size &&
+                files[id].modified_time == modified_time;
+    }
+  }
+  Platform_UnlockMutex(index->mutex);
+  return current;
+}
+
+b32 TrigramIndex_HasDirectory(trigram_index *index, const char *path) {
+  if (!index->mutex)
+    return false;
+
+  b32 found = false;
+  Platform_LockMutex(index->mutex);
+  const char *rel =
+      index->map.data ? TrigramIndex_Relative(index->root, path) : NULL;
+  if (rel) {
+    u32 lo, hi;
+    TrigramIndex_DirectoryRange(index, rel, &lo, &hi);
+    found = lo < hi;
+  }
+  Platform_UnlockMutex(index->mutex);
+  return found;
+}
+
+b32 TrigramIndex_IsBuilding(trigram_index *index) {
+  if (!index->mutex)
+    return false;
+  Platform_LockMutex(index->mutex);
+  b32 building = index->building;
+  Platform_UnlockMutex(index->mutex);
+  return building;
+}
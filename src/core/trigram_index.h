@@ -0,0 +1,120 @@
+/*
+ * trigram_index.h - On-disk trigram index for content search
+ *
+ * Maps every (case-folded) 3-byte sequence to the sorted list of files that
+ * contain it. A literal query can only match files that contain all of its
+ * trigrams, so intersecting a few posting lists narrows a large tree to a
+ * handful of candidate files before content search verifies them.
+ *
+ * The index is built on a background thread, written to the user cache
+ * directory with delta/varint compressed posting lists and memory-mapped
+ * for queries. Directories reported as changed (watcher refreshes) are
+ * kept in a small overlay and re-checked on every query until the next
+ * rebuild.
+ * C99, handmade hero style.
+ */
+
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include "../platform/platform.h"
+#include "fs.h"
+#include "types.h"
+
+/* ===== Configuration ===== */
+
+#define TRIGRAM_INDEX_MAX_CHANGED_DIRS 64 /* Overlay size before a rebuild */
+
+/* ===== Types ===== */
+
+typedef enum {
+  TRIGRAM_INDEX_CANDIDATE_FILE = 0,  /* File that may contain the query */
+  TRIGRAM_INDEX_CANDIDATE_CHANGED_DIR, /* Changed directory, scan shallowly */
+} trigram_index_candidate_kind;
+
+/* Receives each candidate of a query. Return false to stop. */
+typedef b32 (*trigram_index_visit_fn)(void *user_data, const char *path,
+                                      trigram_index_candidate_kind kind);
+
+typedef struct {
+  char path[FS_MAX_PATH];
+} trigram_index_changed_dir;
+
+typedef struct {
+  /* Guards everything below */
+  void *mutex;
+  b32 shutdown_requested;
+
+  /* Budgets (from config) */
+  u64 max_memory_bytes; /* Posting pairs held while building */
+  u64 max_disk_bytes;   /* Largest index file that will be written */
+  u64 max_file_bytes;   /* Larger files are not indexed (nor searched) */
+
+  /* Loaded index */
+  platform_file_map map;
+  char root[FS_MAX_PATH];
+  b32 loaded_from_disk; /* Built by an earlier session, refresh pending */
+
+  /* Background build */
+  b32 building;
+  char build_root[FS_MAX_PATH];
+  char pending_root[FS_MAX_PATH]; /* Requested while a build was running */
+  u64 build_started_ms;
+  u64 last_build_ms; /* Duration of the last completed build */
+
+  /* Changed directories (relative to changed_root) since the loaded index
+   * was built. Entries below build_changed_count were seen by the running
+   * build. */
+  char changed_root[FS_MAX_PATH];
+  trigram_index_changed_dir *changed_dirs;
+  i32 changed_count;
+  i32 build_changed_count;
+  b32 changed_overflow; /* Too many changes - index unusable until rebuilt */
+
+  /* Stats of the loaded index */
+  u32 file_count;
+  u32 trigram_count;
+  u32 unindexed_count; /* Files past the memory budget, always scanned */
+} trigram_index;
+
+/* ===== Trigram Index API ===== */
+
+/* Initialize state. Nothing is loaded or built until TrigramIndex_Ensure. */
+void TrigramIndex_Init(trigram_index *index);
+
+/* Abort a running build and unmap the index */
+void TrigramIndex_Shutdown(trigram_index *index);
+
+/* Update budgets; they apply to the next build */
+void TrigramIndex_Configure(trigram_index *index, u64 max_memory_bytes,
+                            u64 max_disk_bytes, u64 max_file_bytes);
+
+/* Make sure an index covering 'root' is loaded or being built. Loads a
+ * cached index from disk if one exists (and refreshes it in the
+ * background), otherwise starts a background build. */
+void TrigramIndex_Ensure(trigram_index *index, const char *root);
+
+/* Record that the contents of 'dir' changed (non-recursive) */
+void TrigramIndex_MarkChanged(trigram_index *index, const char *dir);
+
+/* Visit the files below 'root' that may contain 'query' plus the changed
+ * directories that must be rescanned. Returns false (without visiting
+ * anything) when the index cannot answer: not loaded, 'root' not covered,
+ * query shorter than 3 bytes or too many pending changes. The visitor is
+ * called with the index lock held and must not call back into the index. */
+b32 TrigramIndex_Query(trigram_index *index, const char *root,
+                       const char *query, trigram_index_visit_fn visit,
+                       void *user_data);
+
+/* True if 'path' is indexed with this size and modification time, i.e. its
+ * postings are current and a shallow rescan can skip it */
+b32 TrigramIndex_IsFileCurrent(trigram_index *index, const char *path,
+                               u64 size, u64 modified_time);
+
+/* True if the index holds any file below directory 'path' */
+b32 TrigramIndex_HasDirectory(trigram_index *index, const char *path);
+
+/* True while a background build is running */
+b32 TrigramIndex_IsBuilding(trigram_index *index);
+
+#endif /* TRIGRAM_INDEX_H */
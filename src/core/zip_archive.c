@@ -0,0 +1,429 @@
+/*
+ * zip_archive.c - Read-only zip archive implementation
+ *
+ * C99, handmade hero style.
+ */
+
+#include "zip_archive.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Raw deflate decoder bundled with stb_image (compiled in image.c) */
+extern int stbi_zlib_decode_noheader_buffer(char *obuffer, int olen,
+                                            const char *ibuffer, int ilen);
+
+/* ===== Format ===== */
+
+#define ZIP_LOCAL_SIGNATURE 0x04034b50u
+#define ZIP_CENTRAL_SIGNATURE 0x02014b50u
+#define ZIP_END_SIGNATURE 0x06054b50u
+#define ZIP64_LOCATOR_SIGNATURE 0x07064b50u
+#define ZIP64_END_SIGNATURE 0x06064b50u
+
+#define ZIP_LOCAL_HEADER_SIZE 30
+#define ZIP_CENTRAL_HEADER_SIZE 46
+#define ZIP_END_SIZE 22
+#define ZIP64_LOCATOR_SIZE 20
+#define ZIP64_END_SIZE 56
+#define ZIP_MAX_COMMENT 65535
+
+#define ZIP_FLAG_ENCRYPTED 0x0001
+#define ZIP_EXTRA_ZIP64 0x0001
+
+static u16 ZipArchive_Read16(const u8 *p) { return (u16)(p[0] | (p[1] << 8)); }
+
+static u32 ZipArchive_Read32(const u8 *p) {
+  return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u64 ZipArchive_Read64(const u8 *p) {
+  return (u64)ZipArchive_Read32(p) | ((u64)ZipArchive_Read32(p + 4) << 32);
+}
+
+/* MS-DOS date and time (local, no zone) to Unix time */
+static u64 ZipArchive_DosTime(u16 date, u16 time) {
+  struct tm tm;
+
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = 80 + (date >> 9);
+  tm.tm_mon = ((date >> 5) & 0xF) - 1;
+  tm.tm_mday = date & 0x1F;
+  tm.tm_hour = time >> 11;
+  tm.tm_min = (time >> 5) & 0x3F;
+  tm.tm_sec = (time & 0x1F) * 2;
+  tm.tm_isdst = -1;
+  if (tm.tm_mon < 0 || tm.tm_mon > 11 || tm.tm_mday < 1) {
+    return 0;
+  }
+
+  time_t t = mktime(&tm);
+  return t == (time_t)-1 ? 0 : (u64)t;
+}
+
+/* ===== Paths ===== */
+
+b32 ZipArchive_IsArchiveName(const char *name) {
+  static const char *const extensions[] = {".zip", ".jar", ".apk", ".whl",
+                                           ".epub"};
+  usize len = strlen(name);
+
+  for (usize i = 0; i < ArrayCount(extensions); i++) {
+    usize ext_len = strlen(extensions[i]);
+    if (len > ext_len && strcasecmp(name + len - ext_len, extensions[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+b32 ZipArchive_SplitPath(const char *path, char *out_archive,
+                         usize archive_size, const char **out_member) {
+  usize len = strlen(path);
+
+  /* The first component that is an archive file (not a folder named so) */
+  for (usize end = 1; end <= len; end++) {
+    if (end < len && path[end] != '/') {
+      continue;
+    }
+    if (end >= archive_size) {
+      return false;
+    }
+
+    memcpy(out_archive, path, end);
+    out_archive[end] = '\0';
+    if (!ZipArchive_IsArchiveName(out_archive)) {
+      continue;
+    }
+
+    file_info info;
+    if (Platform_GetFileInfo(out_archive, &info) &&
+        info.type == WB_FILE_TYPE_FILE) {
+      *out_member = end < len ? path + end + 1 : path + end;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* ===== Central Directory ===== */
+
+/* Sizes and offset that did not fit 32 bits are in the zip64 extra field,
+ * in this order, only those that overflowed */
+static void ZipArchive_ReadZip64Extra(zip_member *member, const u8 *extra,
+                                      u16 extra_len, b32 size_overflow,
+                                      b32 compressed_overflow,
+                                      b32 offset_overflow) {
+  u16 at = 0;
+
+  while (at + 4 <= extra_len) {
+    u16 id = ZipArchive_Read16(extra + at);
+    u16 len = ZipArchive_Read16(extra + at + 2);
+    const u8 *field = extra + at + 4;
+    u16 used = 0;
+
+    if (at + 4 + len > extra_len) {
+      return;
+    }
+    if (id == ZIP_EXTRA_ZIP64) {
+      if (size_overflow && used + 8 <= len) {
+        member->size = ZipArchive_Read64(field + used);
+        used += 8;
+      }
+      if (compressed_overflow && used + 8 <= len) {
+        member->compressed_size = ZipArchive_Read64(field + used);
+        used += 8;
+      }
+      if (offset_overflow && used + 8 <= len) {
+        member->local_offset = ZipArchive_Read64(field + used);
+      }
+      return;
+    }
+    at = (u16)(at + 4 + len);
+  }
+}
+
+/* Locate the central directory from the end record (zip64 if needed) */
+static b32 ZipArchive_FindDirectory(const platform_file_map *map,
+                                    u64 *out_offset, u64 *out_size,
+                                    u64 *out_count) {
+  const u8 *data = map->data;
+  u64 size = map->size;
+  u64 end = 0;
+  b32 found = false;
+
+  if (!data || size < ZIP_END_SIZE) {
+    return false;
+  }
+
+  /* The end record is followed by a comment of up to 64 KiB */
+  u64 lowest = size > ZIP_END_SIZE + ZIP_MAX_COMMENT
+                   ? size - ZIP_END_SIZE - ZIP_MAX_COMMENT
+                   : 0;
+  for (u64 at = size - ZIP_END_SIZE + 1; at-- > lowest;) {
+    if (ZipArchive_Read32(data + at) == ZIP_END_SIGNATURE) {
+      end = at;
+      found = true;
+      break;
+    }
+  }
+  if (!found) {
+    return false;
+  }
+
+  *out_count = ZipArchive_Read16(data + end + 10);
+  *out_size = ZipArchive_Read32(data + end + 12);
+  *out_offset = ZipArchive_Read32(data + end + 16);
+
+  if ((*out_count == 0xFFFF || *out_offset == 0xFFFFFFFFu) &&
+      end >= ZIP64_LOCATOR_SIZE &&
+      ZipArchive_Read32(data + end - ZIP64_LOCATOR_SIZE) ==
+          ZIP64_LOCATOR_SIGNATURE) {
+    u64 end64 = ZipArchive_Read64(data + end - ZIP64_LOCATOR_SIZE + 8);
+    /* Subtraction form: end64 comes from the file and could wrap a sum */
+    if (size < ZIP64_END_SIZE || end64 > size - ZIP64_END_SIZE ||
+        ZipArchive_Read32(data + end64) != ZIP64_END_SIGNATURE) {
+      return false;
+    }
+    *out_count = ZipArchive_Read64(data + end64 + 32);
+    *out_size = ZipArchive_Read64(data + end64 + 40);
+    *out_offset = ZipArchive_Read64(data + end64 + 48);
+  }
+
+  return *out_offset <= size && *out_size <= size - *out_offset;
+}
+
+b32 ZipArchive_Open(zip_archive *zip, const char *path) {
+  u64 offset, directory_size, count;
+
+  memset(zip, 0, sizeof(*zip));
+  if (!Platform_MapFile(path, &zip->map)) {
+    return false;
+  }
+  if (!ZipArchive_FindDirectory(&zip->map, &offset, &directory_size, &count)) {
+    ZipArchive_Close(zip);
+    return false;
+  }
+
+  /* Every header takes at least 46 bytes, which bounds a bogus count */
+  count = Min(count, directory_size / ZIP_CENTRAL_HEADER_SIZE);
+  zip->members = (zip_member *)calloc((usize)Max(count, 1), sizeof(zip_member));
+  if (!zip->members) {
+    ZipArchive_Close(zip);
+    return false;
+  }
+
+  const u8 *at = zip->map.data + offset;
+  const u8 *end = at + directory_size;
+  while (zip->member_count < count &&
+         (usize)(end - at) >= ZIP_CENTRAL_HEADER_SIZE &&
+         ZipArchive_Read32(at) == ZIP_CENTRAL_SIGNATURE) {
+    zip_member *member = &zip->members[zip->member_count];
+    u16 name_len = ZipArchive_Read16(at + 28);
+    u16 extra_len = ZipArchive_Read16(at + 30);
+    u16 comment_len = ZipArchive_Read16(at + 32);
+    const u8 *name = at + ZIP_CENTRAL_HEADER_SIZE;
+
+    if ((usize)name_len + extra_len + comment_len > (usize)(end - name)) {
+      break;
+    }
+
+    member->flags = ZipArchive_Read16(at + 8);
+    member->method = ZipArchive_Read16(at + 10);
+    member->modified_time =
+        ZipArchive_DosTime(ZipArchive_Read16(at + 14), ZipArchive_Read16(at + 12));
+    member->compressed_size = ZipArchive_Read32(at + 20);
+    member->size = ZipArchive_Read32(at + 24);
+    member->local_offset = ZipArchive_Read32(at + 42);
+    ZipArchive_ReadZip64Extra(member, name + name_len, extra_len,
+                              member->size == 0xFFFFFFFFu,
+                              member->compressed_size == 0xFFFFFFFFu,
+                              member->local_offset == 0xFFFFFFFFu);
+
+    member->name = (const char *)name;
+    member->name_len = name_len;
+    if (name_len > 0 && name[name_len - 1] == '/') {
+      member->is_directory = true;
+      member->name_len--;
+    }
+    if (member->name_len > 0) {
+      zip->member_count++;
+    }
+
+    at = name + name_len + extra_len + comment_len;
+  }
+
+  return true;
+}
+
+void ZipArchive_Close(zip_archive *zip) {
+  free(zip->members);
+  if (zip->map.data) {
+    Platform_UnmapFile(&zip->map);
+  }
+  memset(zip, 0, sizeof(*zip));
+}
+
+i32 ZipArchive_Find(const zip_archive *zip, const char *name) {
+  usize len = strlen(name);
+
+  for (u32 i = 0; i < zip->member_count; i++) {
+    const zip_member *member = &zip->members[i];
+    if (member->name_len == len && memcmp(member->name, name, len) == 0) {
+      return (i32)i;
+    }
+  }
+  return -1;
+}
+
+/* ===== Listing ===== */
+
+b32 ZipArchive_IsDirectory(const zip_archive *zip, const char *name) {
+  usize len = strlen(name);
+
+  for (u32 i = 0; i < zip->member_count; i++) {
+    const zip_member *member = &zip->members[i];
+    if (memcmp(member->name, name, Min((usize)member->name_len, len)) != 0) {
+      continue;
+    }
+    if ((member->name_len == len && member->is_directory) ||
+        (member->name_len > len && member->name[len] == '/')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+typedef struct {
+  const char *name;
+  usize len;
+} zip_seen_name;
+
+static u64 ZipArchive_HashName(const char *name, usize len) {
+  u64 hash = 14695981039346656037ull; /* FNV-1a */
+  for (usize i = 0; i < len; i++) {
+    hash = (hash ^ (u8)name[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+void ZipArchive_ListDirectory(const zip_archive *zip, const char *dir,
+                              zip_list_fn callback, void *user_data) {
+  usize dir_len = strlen(dir);
+  usize table_size = 16;
+  zip_seen_name *seen;
+
+  while (table_size < (usize)zip->member_count * 2) {
+    table_size *= 2;
+  }
+  seen = (zip_seen_name *)calloc(table_size, sizeof(zip_seen_name));
+  if (!seen) {
+    return;
+  }
+
+  for (u32 i = 0; i < zip->member_count; i++) {
+    const zip_member *member = &zip->members[i];
+    const char *rest = member->name;
+    usize rest_len = member->name_len;
+
+    if (dir_len > 0) {
+      if (rest_len <= dir_len + 1 || memcmp(rest, dir, dir_len) != 0 ||
+          rest[dir_len] != '/') {
+        continue;
+      }
+      rest += dir_len + 1;
+      rest_len -= dir_len + 1;
+    }
+
+    /* Deeper members imply a folder here */
+    const char *slash = (const char *)memchr(rest, '/', rest_len);
+    usize name_len = slash ? (usize)(slash - rest) : rest_len;
+    b32 is_directory = slash || member->is_directory;
+    if (name_len == 0) {
+      continue;
+    }
+
+    usize slot = (usize)ZipArchive_HashName(rest, name_len) & (table_size - 1);
+    b32 duplicate = false;
+    while (seen[slot].name) {
+      if (seen[slot].len == name_len &&
+          memcmp(seen[slot].name, rest, name_len) == 0) {
+        duplicate = true;
+        break;
+      }
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (duplicate) {
+      continue;
+    }
+    seen[slot].name = rest;
+    seen[slot].len = name_len;
+
+    callback(user_data, rest, name_len, is_directory,
+             is_directory ? 0 : member->size, member->modified_time);
+  }
+
+  free(seen);
+}
+
+/* ===== Extraction ===== */
+
+u8 *ZipArchive_Extract(const zip_archive *zip, i32 index, u64 max_size,
+                       usize *out_size) {
+  const zip_member *member;
+  const u8 *header;
+  u8 *buffer;
+
+  if (index < 0 || (u32)index >= zip->member_count) {
+    return NULL;
+  }
+  member = &zip->members[index];
+  if (member->is_directory || (member->flags & ZIP_FLAG_ENCRYPTED) ||
+      member->size > max_size || member->size >= 0x7FFFFFFF ||
+      member->compressed_size >= 0x7FFFFFFF ||
+      (member->method != 0 && member->method != 8)) {
+    return NULL;
+  }
+
+  /* Name and extra field lengths can differ from the central directory */
+  if (zip->map.size < ZIP_LOCAL_HEADER_SIZE ||
+      member->local_offset > zip->map.size - ZIP_LOCAL_HEADER_SIZE) {
+    return NULL;
+  }
+  header = zip->map.data + member->local_offset;
+  if (ZipArchive_Read32(header) != ZIP_LOCAL_SIGNATURE) {
+    return NULL;
+  }
+  u64 data_offset = member->local_offset + ZIP_LOCAL_HEADER_SIZE +
+                    ZipArchive_Read16(header + 26) +
+                    ZipArchive_Read16(header + 28);
+  if (data_offset > zip->map.size ||
+      member->compressed_size > zip->map.size - data_offset) {
+    return NULL;
+  }
+
+  buffer = (u8 *)malloc((usize)member->size + 1);
+  if (!buffer) {
+    return NULL;
+  }
+
+  const u8 *data = zip->map.data + data_offset;
+  if (member->method == 0) {
+    if (member->compressed_size != member->size) {
+      free(buffer);
+      return NULL;
+    }
+    memcpy(buffer, data, (usize)member->size);
+  } else if (member->size > 0 &&
+             stbi_zlib_decode_noheader_buffer(
+                 (char *)buffer, (int)member->size, (const char *)data,
+                 (int)member->compressed_size) != (int)member->size) {
+    free(buffer);
+    return NULL;
+  }
+
+  buffer[member->size] = '\0';
+  *out_size = (usize)member->size;
+  return buffer;
+}
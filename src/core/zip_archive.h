@@ -0,0 +1,79 @@
+/*
+ * zip_archive.h - Read-only access to zip archives
+ *
+ * The archive stays memory-mapped: opening it only walks the central
+ * directory at its end, so listing even a large archive touches a few
+ * pages. A member is inflated straight from the mapping with the zlib
+ * decoder bundled in stb_image, into a buffer the size of that member;
+ * nothing is extracted to disk.
+ *
+ * Paths that run through an archive ("/tmp/a.zip/docs/readme.md") name its
+ * members, so the explorer can browse one like a read-only folder.
+ * C99, handmade hero style.
+ */
+
+#ifndef ZIP_ARCHIVE_H
+#define ZIP_ARCHIVE_H
+
+#include "../platform/platform.h"
+#include "types.h"
+
+/* ===== Types ===== */
+
+typedef struct {
+  const char *name; /* Into the mapping, not terminated */
+  u32 name_len;
+  u16 method; /* 0 stored, 8 deflated */
+  u16 flags;
+  u64 compressed_size;
+  u64 size;
+  u64 local_offset;  /* Of the local file header */
+  u64 modified_time; /* Unix time (zip times are local) */
+  b32 is_directory;
+} zip_member;
+
+typedef struct {
+  platform_file_map map;
+  zip_member *members;
+  u32 member_count;
+} zip_archive;
+
+/* Called for each direct child of a folder in the archive */
+typedef void (*zip_list_fn)(void *user_data, const char *name, usize name_len,
+                            b32 is_directory, u64 size, u64 modified_time);
+
+/* ===== Zip Archive API ===== */
+
+/* Whether a file name has a zip extension (.zip, .jar, ...) */
+b32 ZipArchive_IsArchiveName(const char *name);
+
+/* Split a path running through an archive, or naming one, into the
+ * archive file and the member path inside it ("" for the archive root).
+ * Returns false for ordinary paths. */
+b32 ZipArchive_SplitPath(const char *path, char *out_archive,
+                         usize archive_size, const char **out_member);
+
+/* Map the archive and read its central directory */
+b32 ZipArchive_Open(zip_archive *zip, const char *path);
+void ZipArchive_Close(zip_archive *zip);
+
+/* Index of the member named 'name' (folders without their trailing '/'),
+ * -1 if there is none */
+i32 ZipArchive_Find(const zip_archive *zip, const char *name);
+
+/* Whether 'name' is a folder: a member of its own or implied by the paths
+ * of deeper members */
+b32 ZipArchive_IsDirectory(const zip_archive *zip, const char *name);
+
+/* The direct children of folder 'dir' ("" for the root). Folders only
+ * implied by deeper member paths are listed too, once each. */
+void ZipArchive_ListDirectory(const zip_archive *zip, const char *dir,
+                              zip_list_fn callback, void *user_data);
+
+/* Inflate a member into a new NUL-terminated buffer (free() it). NULL if
+ * it is larger than max_size, encrypted, compressed with anything but
+ * deflate, or damaged. */
+u8 *ZipArchive_Extract(const zip_archive *zip, i32 index, u64 max_size,
+                       usize *out_size);
+
+#endif /* ZIP_ARCHIVE_H */
@@ -148,6 +148,7 @@ int main(int argc, char **argv) {
   panel *initial_panel = Layout_GetActivePanel(&layout);
   CommandPalette_Init(&palette,
                       initial_panel ? &initial_panel->explorer.fs : NULL);
+  palette.frecency = &layout.frecency;
 
   /* Initialize Commands Module */
   Commands_Init(&layout);
@@ -465,10 +466,15 @@ int main(int argc, char **argv) {
 
     frame_count++;
 
-    /* Small sleep to avoid busy-looping when no events */
-    Platform_SleepMs(16); /* ~60fps target */
+    /* Wait out the rest of the frame (~60fps target). Input and terminal
+     * output end the wait early so they show up without a frame of lag. */
+    u64 frame_elapsed = Platform_GetTimeMs() - current_time;
+    if (frame_elapsed < 16) {
+      Platform_WaitEventsTimeout(window, (u32)(16 - frame_elapsed));
+    }
   }
 
+  CommandPalette_Shutdown(&palette);
   Layout_Shutdown(&layout);
   UI_Shutdown(&ui);
   if (main_font)
@@ -411,3 +411,46 @@ void Platform_WaitEvents(platform_window *window) {
   (void)window;
   wl_display_dispatch(g_platform.display);
 }
+
+void Platform_WaitEventsTimeout(platform_window *window, u32 timeout_ms) {
+  while (wl_display_prepare_read(g_platform.display) != 0) {
+    wl_display_dispatch_pending(g_platform.display);
+  }
+  wl_display_flush(g_platform.display);
+
+  /* Dispatching may already have queued events */
+  if (window && window->event_read != window->event_write) {
+    wl_display_cancel_read(g_platform.display);
+    return;
+  }
+
+  struct pollfd pfds[2] = {
+      {.fd = wl_display_get_fd(g_platform.display), .events = POLLIN},
+      {.fd = g_platform.wake_fd, .events = POLLIN},
+  };
+
+  if (poll(pfds, 2, (int)timeout_ms) > 0 && (pfds[0].revents & POLLIN)) {
+    wl_display_read_events(g_platform.display);
+    wl_display_dispatch_pending(g_platform.display);
+  } else {
+    wl_display_cancel_read(g_platform.display);
+  }
+
+  if (pfds[1].revents & POLLIN) {
+    /* Reset the eventfd; wakes that arrived meanwhile are all handled by
+     * the frame about to run */
+    u64 count;
+    if (read(g_platform.wake_fd, &count, sizeof(count)) < 0) {
+      /* Nothing to reset */
+    }
+  }
+}
+
+void Platform_WakeEventLoop(void) {
+  if (!g_platform.initialized || g_platform.wake_fd < 0)
+    return;
+  u64 one = 1;
+  if (write(g_platform.wake_fd, &one, sizeof(one)) < 0) {
+    /* Counter saturated: a wake is pending anyway */
+  }
+}
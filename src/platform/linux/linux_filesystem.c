@@ -4,6 +4,9 @@
 
 #include "linux_internal.h"
 #include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/stat.h>
 
 /* ===== File System API ===== */
@@ -46,8 +49,10 @@ b32 Platform_ListDirectory(const char *path, directory_listing *listing,
         info->type = WB_FILE_TYPE_DIRECTORY;
       else if (S_ISLNK(st.st_mode))
         info->type = WB_FILE_TYPE_SYMLINK;
-      else
+      else if (S_ISREG(st.st_mode))
         info->type = WB_FILE_TYPE_FILE;
+      else
+        info->type = WB_FILE_TYPE_UNKNOWN; /* FIFOs, sockets, devices */
       info->size = st.st_size;
       info->modified_time = st.st_mtime;
     } else {
@@ -102,8 +107,10 @@ b32 Platform_GetFileInfo(const char *path, file_info *info) {
     info->type = WB_FILE_TYPE_DIRECTORY;
   else if (S_ISLNK(st.st_mode))
     info->type = WB_FILE_TYPE_SYMLINK;
-  else
+  else if (S_ISREG(st.st_mode))
     info->type = WB_FILE_TYPE_FILE;
+  else
+    info->type = WB_FILE_TYPE_UNKNOWN;
 
   info->size = st.st_size;
   info->modified_time = st.st_mtime;
@@ -134,6 +141,33 @@ b32 Platform_CreateDirectory(const char *path) {
   return mkdir(path, 0755) == 0;
 }
 
+b32 Platform_CreatePrivateDirectory(const char *path) {
+  return mkdir(path, 0700) == 0;
+}
+
+b32 Platform_WritePrivateFile(const char *path, const void *data, usize size) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+
+  const u8 *at = (const u8 *)data;
+  usize left = size;
+  while (left > 0) {
+    ssize_t written = write(fd, at, left);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      break;
+    at += written;
+    left -= (usize)written;
+  }
+
+  b32 ok = close(fd) == 0 && left == 0;
+  if (!ok)
+    unlink(path);
+  return ok;
+}
+
 b32 Platform_CreateFile(const char *path) {
   FILE *f = fopen(path, "w");
   if (f) {
@@ -245,3 +279,210 @@ const char *Platform_GetDownloadsPath(char *buffer, usize buffer_size) {
   }
   return buffer;
 }
+
+const char *Platform_GetCachePath(char *buffer, usize buffer_size) {
+  if (!buffer || buffer_size == 0)
+    return NULL;
+
+  const char *xdg_cache = getenv("XDG_CACHE_HOME");
+  if (xdg_cache && xdg_cache[0] == '/') {
+    snprintf(buffer, buffer_size, "%s", xdg_cache);
+    mkdir(buffer, 0755);
+    return buffer;
+  }
+
+  char home[FS_MAX_PATH];
+  const char *home_path = Platform_GetHomePath(home, sizeof(home));
+  if (!home_path)
+    return NULL;
+
+  if (home_path[strlen(home_path) - 1] == '/') {
+    snprintf(buffer, buffer_size, "%s.cache", home_path);
+  } else {
+    snprintf(buffer, buffer_size, "%s/.cache", home_path);
+  }
+  mkdir(buffer, 0755);
+  return buffer;
+}
+
+/* ===== Truncation Guard =====
+ * Touching a page of a mapping past the end of a file that shrank raises
+ * SIGBUS. The live mappings are kept here so the handler can put a zero
+ * page over the faulting one instead: the reader sees zeros until it
+ * notices the new size. Faults anywhere else go to the previous handler.
+ */
+
+#define LINUX_MAP_GUARD_SLOTS 256
+
+typedef struct {
+  uintptr_t start; /* 0 when the slot is free */
+  uintptr_t end;   /* 0 until the slot is filled */
+} linux_map_guard;
+
+static linux_map_guard g_map_guards[LINUX_MAP_GUARD_SLOTS];
+static struct sigaction g_map_guard_previous;
+static uintptr_t g_map_guard_page_size;
+static pthread_once_t g_map_guard_once = PTHREAD_ONCE_INIT;
+
+static void Linux_MapGuardHandler(int sig, siginfo_t *info, void *context) {
+  (void)sig;
+  (void)context;
+  uintptr_t addr = (uintptr_t)info->si_addr;
+
+  for (i32 i = 0; i < LINUX_MAP_GUARD_SLOTS; i++) {
+    uintptr_t start = __atomic_load_n(&g_map_guards[i].start, __ATOMIC_ACQUIRE);
+    uintptr_t end = __atomic_load_n(&g_map_guards[i].end, __ATOMIC_ACQUIRE);
+    if (addr >= start && addr < end) {
+      void *page = (void *)(addr & ~(g_map_guard_page_size - 1));
+      if (mmap(page, (size_t)g_map_guard_page_size, PROT_READ,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+               0) != MAP_FAILED)
+        return; /* The read is retried and sees zeros */
+      break;
+    }
+  }
+
+  /* Not ours: returning retries the access under the previous handler */
+  sigaction(SIGBUS, &g_map_guard_previous, NULL);
+}
+
+static void Linux_MapGuardInstall(void) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_sigaction = Linux_MapGuardHandler;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  g_map_guard_page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  sigaction(SIGBUS, &action, &g_map_guard_previous);
+}
+
+/* Unguarded (but still usable) if every slot is taken */
+static void Linux_MapGuardAdd(const u8 *data, u64 size) {
+  uintptr_t start = (uintptr_t)data;
+  pthread_once(&g_map_guard_once, Linux_MapGuardInstall);
+  for (i32 i = 0; i < LINUX_MAP_GUARD_SLOTS; i++) {
+    uintptr_t expected = 0;
+    if (__atomic_compare_exchange_n(&g_map_guards[i].start, &expected, start,
+                                    false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_RELAXED)) {
+      __atomic_store_n(&g_map_guards[i].end, start + (uintptr_t)size,
+                       __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+static void Linux_MapGuardRemove(const u8 *data) {
+  uintptr_t start = (uintptr_t)data;
+  for (i32 i = 0; i < LINUX_MAP_GUARD_SLOTS; i++) {
+    if (__atomic_load_n(&g_map_guards[i].start, __ATOMIC_ACQUIRE) == start &&
+        __atomic_load_n(&g_map_guards[i].end, __ATOMIC_ACQUIRE) != 0) {
+      __atomic_store_n(&g_map_guards[i].end, 0, __ATOMIC_RELEASE);
+      __atomic_store_n(&g_map_guards[i].start, 0, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+b32 Platform_MapFile(const char *path, platform_file_map *map) {
+  memset(map, 0, sizeof(*map));
+
+  /* Non-blocking so a FIFO can't hang the open; it fails the check below */
+  int fd = open(path, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return false;
+  }
+
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* The mapping keeps its own reference */
+  if (data == MAP_FAILED)
+    return false;
+
+  map->data = (const u8 *)data;
+  map->size = (u64)st.st_size;
+  Linux_MapGuardAdd(map->data, map->size);
+  return true;
+}
+
+void Platform_UnmapFile(platform_file_map *map) {
+  if (map->data) {
+    Linux_MapGuardRemove(map->data);
+    munmap((void *)map->data, (size_t)map->size);
+  }
+  memset(map, 0, sizeof(*map));
+}
+
+void Platform_ReleaseFileMapRange(const platform_file_map *map, u64 offset,
+                                  u64 size) {
+  if (!map->data || offset >= map->size)
+    return;
+
+  /* madvise wants a page-aligned start */
+  u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+  u64 start = offset - (offset % page_size);
+  u64 end = Min(offset + size, map->size);
+  madvise((void *)(map->data + start), (size_t)(end - start), MADV_DONTNEED);
+}
+
+b32 Platform_EnumerateDirectory(const char *path, platform_dir_enum_fn callback,
+                                void *user_data) {
+  DIR *dir = opendir(path);
+  if (!dir)
+    return false;
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    const char *name = entry->d_name;
+    if (name[0] == '.' &&
+        (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+      continue;
+
+    file_type type;
+    switch (entry->d_type) {
+    case DT_DIR:
+      type = WB_FILE_TYPE_DIRECTORY;
+      break;
+    case DT_LNK:
+      type = WB_FILE_TYPE_SYMLINK;
+      break;
+    case DT_REG:
+      type = WB_FILE_TYPE_FILE;
+      break;
+    case DT_UNKNOWN: {
+      /* Some file systems don't fill d_type */
+      struct stat st;
+      if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        type = WB_FILE_TYPE_UNKNOWN;
+      } else if (S_ISDIR(st.st_mode)) {
+        type = WB_FILE_TYPE_DIRECTORY;
+      } else if (S_ISLNK(st.st_mode)) {
+        type = WB_FILE_TYPE_SYMLINK;
+      } else if (S_ISREG(st.st_mode)) {
+        type = WB_FILE_TYPE_FILE;
+      } else {
+        type = WB_FILE_TYPE_UNKNOWN;
+      }
+      break;
+    }
+    default:
+      type = WB_FILE_TYPE_UNKNOWN; /* FIFOs, sockets, devices */
+      break;
+    }
+
+    if (!callback(user_data, name, type))
+      break;
+  }
+
+  closedir(dir);
+  return true;
+}
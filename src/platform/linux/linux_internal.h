@@ -51,6 +51,7 @@ typedef struct {
   u32 last_serial;
   u32 last_pointer_serial;
   b32 initialized;
+  int wake_fd; /* eventfd for Platform_WakeEventLoop */
   
   /* File clipboard state */
   clipboard_files file_clipboard;
@@ -3,6 +3,7 @@
  */
 
 #include "linux_internal.h"
+#include <sys/eventfd.h>
 
 linux_platform g_platform = {0};
 
@@ -292,6 +293,8 @@ b32 Platform_Init(void) {
   InitCursorTheme();
   g_platform.current_cursor = WB_CURSOR_DEFAULT;
 
+  g_platform.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
   /* Ensure app is installed to desktop (icon + .desktop file) */
   Platform_SelfInstall();
 
@@ -338,6 +341,8 @@ void Platform_Shutdown(void) {
     wl_registry_destroy(g_platform.registry);
   if (g_platform.display)
     wl_display_disconnect(g_platform.display);
+  if (g_platform.wake_fd >= 0)
+    close(g_platform.wake_fd);
 
   memset(&g_platform, 0, sizeof(g_platform));
 }
@@ -9,10 +9,12 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <pty.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -20,6 +22,7 @@
 struct PTY {
   pid_t pid;
   int master_fd;
+  int interrupt_fd; /* eventfd, signalled by PTY_Interrupt */
   u32 cols;
   u32 rows;
   b32 alive;
@@ -44,6 +47,14 @@ PTY *PTY_Create(const char *shell, const char *cwd) {
   pty->rows = 24;
   pty->alive = true;
 
+  /* The reader thread blocks until output or this wakes it; without it
+   * Terminal_Destroy could never stop the thread on an idle shell */
+  pty->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (pty->interrupt_fd < 0) {
+    free(pty);
+    return NULL;
+  }
+
   /* Set initial terminal size */
   struct winsize ws = {.ws_row = (unsigned short)pty->rows,
                        .ws_col = (unsigned short)pty->cols};
@@ -52,6 +63,7 @@ PTY *PTY_Create(const char *shell, const char *cwd) {
 
   if (pid < 0) {
     /* Fork failed */
+    close(pty->interrupt_fd);
     free(pty);
     return NULL;
   }
@@ -119,6 +131,9 @@ void PTY_Destroy(PTY *pty) {
   if (pty->master_fd >= 0) {
     close(pty->master_fd);
   }
+  if (pty->interrupt_fd >= 0) {
+    close(pty->interrupt_fd);
+  }
 
   free(pty);
 }
@@ -148,6 +163,37 @@ i32 PTY_Read(PTY *pty, char *buffer, u32 size) {
   return 0;
 }
 
+b32 PTY_WaitForOutput(PTY *pty) {
+  if (!pty || pty->master_fd < 0)
+    return false;
+
+  struct pollfd pfds[2] = {
+      {.fd = pty->master_fd, .events = POLLIN},
+      {.fd = pty->interrupt_fd, .events = POLLIN},
+  };
+
+  for (;;) {
+    if (poll(pfds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      return true; /* Let the read report the error */
+    }
+    /* The interrupt is never reset, so it wins over pending output */
+    if (pfds[1].revents & POLLIN)
+      return false;
+    return true;
+  }
+}
+
+void PTY_Interrupt(PTY *pty) {
+  if (!pty || pty->interrupt_fd < 0)
+    return;
+  u64 one = 1;
+  if (write(pty->interrupt_fd, &one, sizeof(one)) < 0) {
+    /* Already signalled */
+  }
+}
+
 i32 PTY_Write(PTY *pty, const char *data, u32 size) {
   if (!pty || !pty->alive || pty->master_fd < 0)
     return -1;
@@ -112,3 +112,15 @@ void Platform_CondSignal(void *cond) {
   if (!cond) return;
   pthread_cond_signal((pthread_cond_t *)cond);
 }
+
+void Platform_CondBroadcast(void *cond) {
+  if (!cond) return;
+  pthread_cond_broadcast((pthread_cond_t *)cond);
+}
+
+/* ===== System Info ===== */
+
+i32 Platform_GetProcessorCount(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (i32)count : 1;
+}
@@ -160,7 +160,7 @@ struct platform_event {
 /* ===== File System Types ===== */
 
 typedef enum {
-  WB_FILE_TYPE_UNKNOWN = 0,
+  WB_FILE_TYPE_UNKNOWN = 0, /* Also FIFOs, sockets and devices */
   WB_FILE_TYPE_FILE,
   WB_FILE_TYPE_DIRECTORY,
   WB_FILE_TYPE_SYMLINK,
@@ -179,6 +179,17 @@ typedef struct {
   usize capacity;
 } directory_listing;
 
+/* Read-only memory mapping of a whole file */
+typedef struct {
+  const u8 *data; /* NULL for empty files */
+  u64 size;
+} platform_file_map;
+
+/* Streaming directory enumeration callback.
+ * Return false to stop the enumeration early. */
+typedef b32 (*platform_dir_enum_fn)(void *user_data, const char *name,
+                                    file_type type);
+
 /* ===== Window API ===== */
 
 typedef struct {
@@ -203,6 +214,13 @@ b32 Platform_IsFullscreen(platform_window *window);
 b32 Platform_PollEvent(platform_window *window, platform_event *event);
 void Platform_WaitEvents(platform_window *window);
 
+/* Wait until a window event arrives, Platform_WakeEventLoop is called or
+ * timeout_ms passes, whichever is first */
+void Platform_WaitEventsTimeout(platform_window *window, u32 timeout_ms);
+
+/* End a Platform_WaitEventsTimeout early. Safe to call from any thread. */
+void Platform_WakeEventLoop(void);
+
 /* ===== File System API ===== */
 
 b32 Platform_ListDirectory(const char *path, directory_listing *listing,
@@ -216,12 +234,35 @@ b32 Platform_IsDirectory(const char *path);
 void Platform_OpenFile(const char *path);
 b32 Platform_CreateDirectory(const char *path);
 b32 Platform_CreateFile(const char *path);
+/* Owner-only (0700 / 0600 on POSIX) directory and file. The file must not
+ * exist yet; a partial write is removed. */
+b32 Platform_CreatePrivateDirectory(const char *path);
+b32 Platform_WritePrivateFile(const char *path, const void *data, usize size);
 b32 Platform_Delete(const char *path);
 b32 Platform_Rename(const char *old_path, const char *new_path);
 b32 Platform_Copy(const char *src, const char *dst);
 b32 Platform_GetRealPath(const char *path, char *out_path, usize out_size);
 const char *Platform_GetHomePath(char *buffer, usize buffer_size);
 const char *Platform_GetDownloadsPath(char *buffer, usize buffer_size);
+/* Per-user cache directory ($XDG_CACHE_HOME or ~/.cache, %LOCALAPPDATA%) */
+const char *Platform_GetCachePath(char *buffer, usize buffer_size);
+
+/* Map a regular file read-only. Returns false for directories, special files
+ * and errors. An empty file succeeds with data == NULL and size == 0. If the
+ * file is truncated while mapped, the lost part reads as zeros rather than
+ * faulting (Windows refuses to truncate mapped files). */
+b32 Platform_MapFile(const char *path, platform_file_map *map);
+void Platform_UnmapFile(platform_file_map *map);
+/* Drop the resident pages of a mapped range. They are read back from the
+ * file on the next access. */
+void Platform_ReleaseFileMapRange(const platform_file_map *map, u64 offset,
+                                  u64 size);
+
+/* Enumerate the entries of a directory without stat'ing each one (unlike
+ * Platform_ListDirectory). Skips "." and "..", does not follow symlinks.
+ * Returns false if the directory could not be opened. */
+b32 Platform_EnumerateDirectory(const char *path, platform_dir_enum_fn callback,
+                                void *user_data);
 
 /* ===== Clipboard API ===== */
 
@@ -562,4 +562,21 @@ void Platform_WaitEvents(platform_window *window) {
     return;
   WaitMessage();
 }
+
+void Platform_WaitEventsTimeout(platform_window *window, u32 timeout_ms) {
+  if (window && window->event_read != window->event_write)
+    return;
+  if (!g_platform.wake_event) {
+    MsgWaitForMultipleObjects(0, NULL, FALSE, timeout_ms, QS_ALLINPUT);
+    return;
+  }
+  MsgWaitForMultipleObjects(1, &g_platform.wake_event, FALSE, timeout_ms,
+                            QS_ALLINPUT);
+}
+
+void Platform_WakeEventLoop(void) {
+  if (g_platform.initialized && g_platform.wake_event) {
+    SetEvent(g_platform.wake_event);
+  }
+}
 #endif /* _WIN32 */
@@ -192,6 +192,40 @@ b32 Platform_CreateDirectory(const char *path) {
   return CreateDirectoryW(wide_path, NULL) != 0;
 }
 
+b32 Platform_CreatePrivateDirectory(const char *path) {
+  /* The per-user profile folders it is made in are already private */
+  return Platform_CreateDirectory(path);
+}
+
+b32 Platform_WritePrivateFile(const char *path, const void *data, usize size) {
+  wchar_t wide_path[FS_MAX_PATH] = {0};
+  if (Utf8ToWide(path, wide_path, FS_MAX_PATH) == 0)
+    return false;
+
+  HANDLE h = CreateFileW(wide_path, GENERIC_WRITE, 0, NULL, CREATE_NEW,
+                         FILE_ATTRIBUTE_NORMAL, NULL);
+  if (h == INVALID_HANDLE_VALUE)
+    return false;
+
+  const u8 *at = (const u8 *)data;
+  usize left = size;
+  while (left > 0) {
+    DWORD chunk = (DWORD)Min(left, (usize)Megabytes(64));
+    DWORD written = 0;
+    if (!WriteFile(h, at, chunk, &written, NULL) || written == 0)
+      break;
+    at += written;
+    left -= written;
+  }
+
+  CloseHandle(h);
+  if (left > 0) {
+    DeleteFileW(wide_path);
+    return false;
+  }
+  return true;
+}
+
 b32 Platform_CreateFile(const char *path) {
   wchar_t wide_path[FS_MAX_PATH] = {0};
   if (Utf8ToWide(path, wide_path, FS_MAX_PATH) == 0)
@@ -334,4 +368,113 @@ const char *Platform_GetDownloadsPath(char *buffer, usize buffer_size) {
   FS_NormalizePath(buffer);
   return buffer;
 }
+
+const char *Platform_GetCachePath(char *buffer, usize buffer_size) {
+  if (Windows_GetKnownFolderPath(&FOLDERID_LocalAppData, buffer, buffer_size))
+    return buffer;
+  return NULL;
+}
+
+b32 Platform_MapFile(const char *path, platform_file_map *map) {
+  memset(map, 0, sizeof(*map));
+
+  wchar_t wide_path[FS_MAX_PATH] = {0};
+  if (Utf8ToWide(path, wide_path, FS_MAX_PATH) == 0)
+    return false;
+
+  HANDLE file = CreateFileW(wide_path, GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return true;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping); /* The view keeps the mapping alive */
+  if (!data)
+    return false;
+
+  map->data = (const u8 *)data;
+  map->size = (u64)size.QuadPart;
+  return true;
+}
+
+void Platform_UnmapFile(platform_file_map *map) {
+  if (map->data) {
+    UnmapViewOfFile(map->data);
+  }
+  memset(map, 0, sizeof(*map));
+}
+
+void Platform_ReleaseFileMapRange(const platform_file_map *map, u64 offset,
+                                  u64 size) {
+  if (!map->data || offset >= map->size)
+    return;
+
+  /* Unlocking pages that were never locked trims them from the working
+   * set (the call reports an error, which is expected) */
+  u64 end = Min(offset + size, map->size);
+  VirtualUnlock((LPVOID)(map->data + offset), (SIZE_T)(end - offset));
+}
+
+b32 Platform_EnumerateDirectory(const char *path, platform_dir_enum_fn callback,
+                                void *user_data) {
+  wchar_t wide_path[FS_MAX_PATH] = {0};
+  wchar_t search_path[FS_MAX_PATH] = {0};
+
+  if (Utf8ToWide(path, wide_path, FS_MAX_PATH) == 0)
+    return false;
+
+  _snwprintf(search_path, FS_MAX_PATH - 1, L"%s\\*", wide_path);
+
+  /* Basic info skips the 8.3 short name lookup; large fetch batches entries */
+  WIN32_FIND_DATAW find_data;
+  HANDLE find_handle =
+      FindFirstFileExW(search_path, FindExInfoBasic, &find_data,
+                       FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+  if (find_handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  do {
+    const wchar_t *wname = find_data.cFileName;
+    if (wname[0] == L'.' &&
+        (wname[1] == L'\0' || (wname[1] == L'.' && wname[2] == L'\0')))
+      continue;
+
+    char name[256];
+    if (WideToUtf8(wname, name, sizeof(name)) == 0 || name[0] == '\0')
+      continue;
+
+    file_type type;
+    if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+      type = WB_FILE_TYPE_SYMLINK;
+    } else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      type = WB_FILE_TYPE_DIRECTORY;
+    } else {
+      type = WB_FILE_TYPE_FILE;
+    }
+
+    if (!callback(user_data, name, type))
+      break;
+  } while (FindNextFileW(find_handle, &find_data));
+
+  FindClose(find_handle);
+  return true;
+}
 #endif /* _WIN32 */
@@ -18,6 +18,7 @@
 
 #include "font.h"
 #include "renderer.h"
+#include "text.h"
 #include "types.h"
 
 #pragma comment(lib, "dwrite.lib")
@@ -33,7 +34,7 @@ DEFINE_GUID(IID_IDWriteFontFileStream, 0x6d48655c, 0xe508, 0x4903, 0x90, 0xa7,
 
 /* ===== Constants ===== */
 
-#define GLYPH_CACHE_SIZE 256
+#define GLYPH_CACHE_SIZE 1024
 #define MAX_FONT_PATH 512
 
 /* ===== Cached Glyph ===== */
@@ -690,7 +691,12 @@ i32 Font_MeasureWidth(font *f, const char *text) {
   const u8 *p = (const u8 *)text;
 
   while (*p) {
-    u32 codepoint = *p++;
+    u32 codepoint = *p;
+    if (codepoint < 0x80) {
+      p++;
+    } else {
+      p += Text_UTF8Decode((const char *)p, 4, &codepoint);
+    }
     cached_glyph *g = GetCachedGlyph(f, codepoint);
     if (g) {
       width += g->advance;
@@ -751,7 +757,12 @@ void Font_RenderText(font *f, u32 *pixels, i32 fb_width, i32 fb_height,
     clip_y1 = fb_height;
 
   while (*p) {
-    u32 codepoint = *p++;
+    u32 codepoint = *p;
+    if (codepoint < 0x80) {
+      p++;
+    } else {
+      p += Text_UTF8Decode((const char *)p, 4, &codepoint);
+    }
 
     cached_glyph *glyph = GetCachedGlyph(f, codepoint);
     if (!glyph)
@@ -28,6 +28,7 @@ typedef struct {
   HINSTANCE instance;
   b32 ole_initialized;
   b32 initialized;
+  HANDLE wake_event; /* Auto-reset, for Platform_WakeEventLoop */
 } windows_platform;
 
 extern windows_platform g_platform;
@@ -60,6 +60,8 @@ b32 Platform_Init(void) {
   }
   g_platform.ole_initialized = true;
 
+  g_platform.wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+
   g_platform.initialized = true;
   return true;
 }
@@ -71,6 +73,9 @@ void Platform_Shutdown(void) {
   if (g_platform.ole_initialized) {
     OleUninitialize();
   }
+  if (g_platform.wake_event) {
+    CloseHandle(g_platform.wake_event);
+  }
 
   memset(&g_platform, 0, sizeof(g_platform));
 }
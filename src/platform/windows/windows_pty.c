@@ -35,6 +35,7 @@ struct PTY {
   PROCESS_INFORMATION pi;
   PFN_ResizePseudoConsole fnResize;
   PFN_ClosePseudoConsole fnClose;
+  HANDLE hInterrupt; /* Manual-reset event, set by PTY_Interrupt */
 };
 
 /* Global function pointers and probe state */
@@ -113,6 +114,13 @@ PTY *PTY_Create(const char *shell, const char *cwd) {
   CloseHandle(hPipePTYInSide);
   CloseHandle(hPipePTYOutSide);
 
+  /* PTY_WaitForOutput waits on this, so a PTY never exists without it */
+  pty->hInterrupt = CreateEventW(NULL, TRUE, FALSE, NULL);
+  if (!pty->hInterrupt) {
+    PTY_Destroy(pty);
+    return NULL;
+  }
+
   /* Prepare Startup Info */
   STARTUPINFOEXW siEx;
   memset(&siEx, 0, sizeof(siEx));
@@ -176,6 +184,7 @@ PTY *PTY_Create(const char *shell, const char *cwd) {
 
   DeleteProcThreadAttributeList(siEx.lpAttributeList);
   free(siEx.lpAttributeList);
+
   return pty;
 }
 
@@ -194,6 +203,8 @@ void PTY_Destroy(PTY *pty) {
       CloseHandle(pty->hPipeIn);
     if (pty->hPipeOut)
       CloseHandle(pty->hPipeOut);
+    if (pty->hInterrupt)
+      CloseHandle(pty->hInterrupt);
     free(pty);
   }
 }
@@ -217,6 +228,34 @@ i32 PTY_Read(PTY *pty, char *buffer, u32 size) {
   return 0;
 }
 
+b32 PTY_WaitForOutput(PTY *pty) {
+  if (!pty || !pty->hPipeOut)
+    return false;
+
+  /* Anonymous pipes can't be waited on, so check for output every few
+   * milliseconds; the interrupt and the child exiting end the wait at once */
+  HANDLE handles[2] = {pty->hInterrupt, pty->pi.hProcess};
+  for (;;) {
+    DWORD bytesAvail = 0;
+    if (!PeekNamedPipe(pty->hPipeOut, NULL, 0, NULL, &bytesAvail, NULL) ||
+        bytesAvail > 0) {
+      return true;
+    }
+    DWORD result = WaitForMultipleObjects(pty->pi.hProcess ? 2 : 1, handles,
+                                          FALSE, 5);
+    if (result == WAIT_OBJECT_0)
+      return false;
+    if (result != WAIT_TIMEOUT)
+      return true;
+  }
+}
+
+void PTY_Interrupt(PTY *pty) {
+  if (pty && pty->hInterrupt) {
+    SetEvent(pty->hInterrupt);
+  }
+}
+
 i32 PTY_Write(PTY *pty, const char *data, u32 size) {
   if (!pty || !pty->hPipeIn)
     return 0;
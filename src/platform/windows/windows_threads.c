@@ -131,3 +131,17 @@ void Platform_CondSignal(void *cond) {
   windows_cond_var *cv = (windows_cond_var *)cond;
   WakeConditionVariable(&cv->cond);
 }
+
+void Platform_CondBroadcast(void *cond) {
+  if (!cond) return;
+  windows_cond_var *cv = (windows_cond_var *)cond;
+  WakeAllConditionVariable(&cv->cond);
+}
+
+/* ===== System Info ===== */
+
+i32 Platform_GetProcessorCount(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (i32)info.dwNumberOfProcessors : 1;
+}
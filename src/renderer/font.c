@@ -6,6 +6,7 @@
  */
 
 #include "font.h"
+#include "../core/text.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -17,7 +18,7 @@
 
 /* ===== Constants ===== */
 
-#define GLYPH_CACHE_SIZE 256
+#define GLYPH_CACHE_SIZE 1024
 
 /* ===== Cached Glyph ===== */
 
@@ -284,13 +285,15 @@ i32 Font_MeasureWidth(font *f, const char *text) {
   const u8 *p = (const u8 *)text;
 
   while (*p) {
-    /* Simple ASCII for now - TODO: UTF-8 */
-    u32 codepoint = *p++;
-
-    FT_UInt glyph_index = FT_Get_Char_Index(f->face, codepoint);
-    if (FT_Load_Glyph(f->face, glyph_index, FT_LOAD_DEFAULT) == 0) {
-      width += (i32)(f->face->glyph->advance.x >> 6);
+    u32 codepoint = *p;
+    if (codepoint < 0x80) {
+      p++;
+    } else {
+      p += Text_UTF8Decode((const char *)p, 4, &codepoint);
     }
+
+    cached_glyph *glyph = GetCachedGlyph(f, codepoint);
+    width += glyph ? glyph->advance : f->size_pixels / 2;
   }
 
   return width;
@@ -331,8 +334,12 @@ void Font_RenderText(font *f, u32 *pixels, i32 fb_width, i32 fb_height,
   u32 text_color = ((u32)cr << 16) | ((u32)cg << 8) | (u32)cb;
 
   while (*p) {
-    /* Simple ASCII for now - TODO: UTF-8 */
-    u32 codepoint = *p++;
+    u32 codepoint = *p;
+    if (codepoint < 0x80) {
+      p++;
+    } else {
+      p += Text_UTF8Decode((const char *)p, 4, &codepoint);
+    }
 
     cached_glyph *glyph = GetCachedGlyph(f, codepoint);
     if (!glyph || !glyph->bitmap) {
@@ -50,6 +50,8 @@ typedef void (*PFN_BackendDrawText)(render_context *ctx, v2i pos,
 struct image_s;
 typedef void (*PFN_BackendDrawImage)(render_context *ctx, rect r,
                                      struct image_s *img, color tint);
+typedef void (*PFN_BackendReleaseImage)(render_context *ctx,
+                                        struct image_s *img);
 typedef void (*PFN_BackendSetWindow)(render_context *ctx,
                                      struct platform_window *window);
 
@@ -66,6 +68,7 @@ struct renderer_backend {
   PFN_BackendSetClipRect set_clip_rect;
   PFN_BackendDrawText draw_text;
   PFN_BackendDrawImage draw_image;
+  PFN_BackendReleaseImage release_image; /* Optional */
   PFN_BackendSetWindow set_window;
 
   b32 presents_frame;
@@ -158,4 +161,8 @@ void Render_DrawTextDefault(render_context *ctx, v2i pos, const char *text,
 void Render_DrawImage(render_context *ctx, rect r, struct image_s *img,
                       color tint);
 
+/* Drop what the backend holds for an image (e.g. its texture) before the
+ * image is freed. Not needed for images drawn until shutdown. */
+void Render_ReleaseImage(render_context *ctx, struct image_s *img);
+
 #endif /* RENDERER_H */
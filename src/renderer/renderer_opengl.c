@@ -7,6 +7,7 @@
  */
 
 #include "renderer.h"
+#include "../core/text.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -41,6 +42,7 @@
 #define GL_MAX_VERTICES 65536
 #define GL_MAX_FONT_CACHES 16
 #define FONT_ATLAS_SIZE 1024
+#define GL_EXTRA_GLYPHS 1024 /* Glyphs past ASCII per font (hash slots) */
 
 /* ===== Vertex Structure ===== */
 
@@ -54,19 +56,30 @@ typedef struct {
 
 /* ===== Font Glyph Cache ===== */
 
+/* Glyph metrics in atlas */
+typedef struct {
+  b32 valid;
+  i32 x, y; /* Position in atlas */
+  i32 width, height;
+  i32 bearing_x, bearing_y;
+  i32 advance;
+} gl_glyph;
+
 typedef struct {
   u32 texture_id;
   i32 atlas_width;
   i32 atlas_height;
 
-  /* Glyph metrics in atlas */
-  struct {
-    b32 valid;
-    i32 x, y; /* Position in atlas */
-    i32 width, height;
-    i32 bearing_x, bearing_y;
-    i32 advance;
-  } glyphs[256]; /* ASCII only for now */
+  gl_glyph glyphs[128]; /* ASCII, packed when the font is first used */
+
+  /* Other codepoints, packed into the space left as they are first drawn.
+   * Open addressing by codepoint (0 = free slot); an invalid glyph is one
+   * the font lacks or that no longer fit. */
+  u32 extra_codepoints[GL_EXTRA_GLYPHS];
+  gl_glyph extra[GL_EXTRA_GLYPHS];
+  i32 extra_count;
+  i32 pack_x, pack_y;
+  i32 pack_row_height;
 
   font *font_ptr; /* Associated font */
   i32 line_height;
@@ -415,6 +428,9 @@ static gl_font_cache *GetFontCache(gl_backend_state *state, font *f) {
     if (gb.height > row_height)
       row_height = gb.height;
   }
+  cache->pack_x = pen_x;
+  cache->pack_y = pen_y;
+  cache->pack_row_height = row_height;
 
   /* Upload atlas to GPU */
   glGenTextures(1, &cache->texture_id);
@@ -433,6 +449,65 @@ static gl_font_cache *GetFontCache(gl_backend_state *state, font *f) {
   return cache;
 }
 
+/* Metrics of a glyph, packing it into the atlas on first use. The atlas
+ * texture must be bound. NULL draws as a space. */
+static gl_glyph *GL_GetGlyph(gl_font_cache *cache, font *f, u32 codepoint) {
+  if (codepoint < 128) {
+    return cache->glyphs[codepoint].valid ? &cache->glyphs[codepoint] : NULL;
+  }
+
+  u32 slot = (codepoint * 2654435761u) % GL_EXTRA_GLYPHS;
+  while (cache->extra_codepoints[slot] != 0) {
+    if (cache->extra_codepoints[slot] == codepoint) {
+      gl_glyph *found = &cache->extra[slot];
+      return found->valid ? found : NULL;
+    }
+    slot = (slot + 1) % GL_EXTRA_GLYPHS;
+  }
+
+  /* Keep probes short: a full table draws new codepoints as spaces */
+  if (cache->extra_count >= GL_EXTRA_GLYPHS * 3 / 4) {
+    return NULL;
+  }
+  cache->extra_codepoints[slot] = codepoint;
+  cache->extra_count++;
+
+  gl_glyph *glyph = &cache->extra[slot];
+  glyph_bitmap gb;
+  memset(glyph, 0, sizeof(*glyph));
+  if (!Font_GetGlyphBitmap(f, codepoint, &gb)) {
+    return NULL;
+  }
+
+  if (cache->pack_x + gb.width + 1 > cache->atlas_width) {
+    cache->pack_x = 1;
+    cache->pack_y += cache->pack_row_height + 1;
+    cache->pack_row_height = 0;
+  }
+  if (cache->pack_y + gb.height + 1 > cache->atlas_height) {
+    return NULL;
+  }
+
+  if (gb.bitmap && gb.width > 0 && gb.height > 0) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, cache->pack_x, cache->pack_y, gb.width,
+                    gb.height, GL_RED, GL_UNSIGNED_BYTE, gb.bitmap);
+  }
+
+  glyph->valid = true;
+  glyph->x = cache->pack_x;
+  glyph->y = cache->pack_y;
+  glyph->width = gb.width;
+  glyph->height = gb.height;
+  glyph->bearing_x = gb.bearing_x;
+  glyph->bearing_y = gb.bearing_y;
+  glyph->advance = gb.advance;
+
+  cache->pack_x += gb.width + 1;
+  cache->pack_row_height = Max(cache->pack_row_height, gb.height);
+  return glyph;
+}
+
 /* ===== Batch Rendering ===== */
 
 static void FlushBatch(gl_backend_state *state) {
@@ -715,21 +790,28 @@ static void GL_DrawText(render_context *ctx, v2i pos, const char *text, font *f,
 
   const u8 *p = (const u8 *)text;
   while (*p) {
-    u32 ch = *p++;
-    if (ch >= 256 || !cache->glyphs[ch].valid) {
+    u32 ch = *p;
+    if (ch < 0x80) {
+      p++;
+    } else {
+      p += Text_UTF8Decode((const char *)p, 4, &ch);
+    }
+
+    gl_glyph *glyph = GL_GetGlyph(cache, f, ch);
+    if (!glyph) {
       pen_x += cache->glyphs[' '].advance;
       continue;
     }
 
     EnsureBatchCapacity(state, 6);
 
-    i32 gx = cache->glyphs[ch].x;
-    i32 gy = cache->glyphs[ch].y;
-    i32 gw = cache->glyphs[ch].width;
-    i32 gh = cache->glyphs[ch].height;
-    i32 bearing_x = cache->glyphs[ch].bearing_x;
-    i32 bearing_y = cache->glyphs[ch].bearing_y;
-    i32 advance = cache->glyphs[ch].advance;
+    i32 gx = glyph->x;
+    i32 gy = glyph->y;
+    i32 gw = glyph->width;
+    i32 gh = glyph->height;
+    i32 bearing_x = glyph->bearing_x;
+    i32 bearing_y = glyph->bearing_y;
+    i32 advance = glyph->advance;
 
     f32 x0 = pen_x + bearing_x;
     f32 y0 = baseline_y - bearing_y;
@@ -1180,6 +1262,21 @@ static void GL_DrawImage(render_context *ctx, rect r, struct image_s *img_ptr,
   state->vertex_count += 6;
 }
 
+static void GL_ReleaseImage(render_context *ctx, struct image_s *img_ptr) {
+  gl_backend_state *state = (gl_backend_state *)ctx->backend->user_data;
+  image *img = (image *)img_ptr;
+
+  if (img->texture_id == 0)
+    return;
+
+  /* Draws already batched may still sample it */
+  FlushBatch(state);
+  if (state->current_texture == img->texture_id)
+    state->current_texture = 0; /* The name may be handed out again */
+  glDeleteTextures(1, &img->texture_id);
+  img->texture_id = 0;
+}
+
 static gl_backend_state g_gl_state = {0};
 
 static renderer_backend g_opengl_backend = {.name = "OpenGL",
@@ -1194,6 +1291,7 @@ static renderer_backend g_opengl_backend = {.name = "OpenGL",
                                             .set_clip_rect = GL_SetClipRect,
                                             .draw_text = GL_DrawText,
                                             .draw_image = GL_DrawImage,
+                                            .release_image = GL_ReleaseImage,
                                             .set_window = GL_SetWindow,
                                             .presents_frame = true,
                                             .user_data = &g_gl_state};
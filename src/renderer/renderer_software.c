@@ -396,3 +396,9 @@ void Render_DrawImage(render_context *ctx, rect r, struct image_s *img,
     ctx->backend->draw_image(ctx, r, img, tint);
   }
 }
+
+void Render_ReleaseImage(render_context *ctx, struct image_s *img) {
+  if (img && ctx->backend && ctx->backend->release_image) {
+    ctx->backend->release_image(ctx, img);
+  }
+}
@@ -6,6 +6,7 @@
  */
 
 #include "ansi_parser.h"
+#include "../core/text.h"
 #include <string.h>
 
 void ANSI_Init(ansi_parser *parser) {
@@ -33,12 +34,52 @@ static b32 is_csi_final(u8 c) {
   return c >= 0x40 && c <= 0x7E;
 }
 
+/* Bytes in the UTF-8 sequence 'lead' starts, 0 if it can't start one */
+static i32 utf8_sequence_length(u8 lead) {
+  if (lead >= 0xC2 && lead <= 0xDF)
+    return 2;
+  if (lead >= 0xE0 && lead <= 0xEF)
+    return 3;
+  if (lead >= 0xF0 && lead <= 0xF4)
+    return 4;
+  return 0;
+}
+
 ansi_result ANSI_Parse(ansi_parser *parser, u8 byte) {
   ansi_result result = {.action = WB_ANSI_ACTION_NONE};
 
   switch (parser->state) {
   case WB_ANSI_STATE_GROUND:
-    if (byte == 0x1B) {
+    if (parser->utf8_need > 0) {
+      if ((byte & 0xC0) == 0x80) {
+        /* Continuation byte */
+        parser->utf8_bytes[parser->utf8_len++] = byte;
+        if (parser->utf8_len == parser->utf8_need) {
+          /* Complete; overlong forms and surrogates decode as U+FFFD */
+          parser->utf8_need = 0;
+          result.action = WB_ANSI_ACTION_PRINT;
+          Text_UTF8Decode((const char *)parser->utf8_bytes,
+                          (usize)parser->utf8_len, &result.data.character);
+        }
+        break;
+      }
+      /* Cut short: this byte is handled on its own below */
+      parser->utf8_need = 0;
+      result.malformed = true;
+    }
+
+    if (byte >= 0x80) {
+      i32 length = utf8_sequence_length(byte);
+      if (length > 0) {
+        parser->utf8_bytes[0] = byte;
+        parser->utf8_len = 1;
+        parser->utf8_need = length;
+      } else {
+        /* Stray continuation or invalid byte */
+        result.action = WB_ANSI_ACTION_PRINT;
+        result.data.character = TEXT_REPLACEMENT_CHARACTER;
+      }
+    } else if (byte == 0x1B) {
       /* ESC - start escape sequence */
       parser->state = WB_ANSI_STATE_ESCAPE;
     } else if (is_control(byte)) {
@@ -1,7 +1,8 @@
 /*
  * ansi_parser.h - ANSI escape sequence parser for terminal emulation
  *
- * Parses VT100/ANSI terminal escape sequences.
+ * Parses VT100/ANSI terminal escape sequences. In the ground state text is
+ * decoded as UTF-8, a byte at a time, so sequences may be split anywhere.
  * C99, handmade hero style.
  */
 
@@ -68,13 +69,20 @@ typedef struct {
   /* OSC buffer */
   char osc_buffer[ANSI_MAX_OSC];
   i32 osc_len;
+
+  /* UTF-8 sequence being collected in the ground state */
+  u8 utf8_bytes[4];
+  i32 utf8_len;
+  i32 utf8_need; /* Length of the whole sequence, 0 between characters */
 } ansi_parser;
 
 /* Result of parsing one byte */
 typedef struct {
   ansi_action action;
+  b32 malformed; /* This byte cut a UTF-8 sequence short: print U+FFFD
+                    before acting on it */
   union {
-    u32 character; /* For PRINT action */
+    u32 character; /* For PRINT action (a codepoint) */
     u8 control;    /* For EXECUTE action */
     struct {
       char command;
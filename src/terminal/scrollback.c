@@ -0,0 +1,536 @@
+/*
+ * scrollback.c - Paged, compressed scrollback implementation
+ *
+ * A packed page holds SCROLLBACK_PAGE_LINES lines in three parts:
+ *   text   every line's text as Scrollback_EncodeText writes it, so a
+ *          search scans it in place
+ *   sizes  varint text bytes of each line
+ *   cells  per line: varint cell count, then (varint cell count, 4
+ *          attribute bytes) runs until the cells are covered
+ * A line of plain ASCII in one style takes its length plus about 7 bytes.
+ * C99, handmade hero style.
+ */
+
+#include "scrollback.h"
+#include "../core/text.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SCROLLBACK_SPACER_BYTE 0xFF
+#define SCROLLBACK_ATTR_BYTES 4
+#define SCROLLBACK_VARINT_BYTES 5 /* Most a u32 takes */
+
+/* ===== Internal Helpers ===== */
+
+static u32 Scrollback_AttrBits(cell_attr attr) {
+  u32 flags = (u32)attr.bold | ((u32)attr.dim << 1) |
+              ((u32)attr.italic << 2) | ((u32)attr.underline << 3) |
+              ((u32)attr.blink << 4) | ((u32)attr.reverse << 5) |
+              ((u32)attr.hidden << 6) | ((u32)attr.strikethrough << 7) |
+              ((u32)attr.wrapped << 8);
+  return (u32)attr.fg | ((u32)attr.bg << 8) | (flags << 16);
+}
+
+static cell_attr Scrollback_AttrFromBits(u32 bits) {
+  cell_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  u32 flags = bits >> 16;
+  attr.fg = (u8)(bits & 0xFF);
+  attr.bg = (u8)((bits >> 8) & 0xFF);
+  attr.bold = flags & 1;
+  attr.dim = (flags >> 1) & 1;
+  attr.italic = (flags >> 2) & 1;
+  attr.underline = (flags >> 3) & 1;
+  attr.blink = (flags >> 4) & 1;
+  attr.reverse = (flags >> 5) & 1;
+  attr.hidden = (flags >> 6) & 1;
+  attr.strikethrough = (flags >> 7) & 1;
+  attr.wrapped = (flags >> 8) & 1;
+  return attr;
+}
+
+/* Cells up to the last one that isn't a default blank. A wrapped row ends
+ * in the cell carrying its wrap flag, so it is never trimmed. */
+static u32 Scrollback_ContentLength(const terminal_cell *cells, u32 width) {
+  u32 blank_bits = TERM_DEFAULT_FG | (TERM_DEFAULT_BG << 8);
+  while (width > 0) {
+    const terminal_cell *cell = &cells[width - 1];
+    if (cell->codepoint != ' ' || Scrollback_AttrBits(cell->attr) != blank_bits)
+      break;
+    width--;
+  }
+  return width;
+}
+
+static u8 *Scrollback_PutVarint(u8 *at, u32 value) {
+  while (value >= 0x80) {
+    *at++ = (u8)(value | 0x80);
+    value >>= 7;
+  }
+  *at++ = (u8)value;
+  return at;
+}
+
+/* Read a varint at data[*pos], false if it runs past size */
+static b32 Scrollback_GetVarint(const u8 *data, u32 size, u32 *pos,
+                                u32 *out_value) {
+  u32 value = 0;
+  for (u32 shift = 0; shift < 35; shift += 7) {
+    if (*pos >= size)
+      return false;
+    u8 byte = data[(*pos)++];
+    value |= (u32)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *out_value = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void Scrollback_LinesReset(ScrollbackLines *lines) {
+  lines->line_count = 0;
+  lines->starts[0] = 0;
+}
+
+static void Scrollback_LinesFree(ScrollbackLines *lines) {
+  free(lines->cells);
+  lines->cells = NULL;
+  lines->cell_capacity = 0;
+  Scrollback_LinesReset(lines);
+}
+
+static b32 Scrollback_LinesReserve(ScrollbackLines *lines, u32 cells) {
+  if (cells <= lines->cell_capacity)
+    return true;
+  u32 capacity = lines->cell_capacity ? lines->cell_capacity : 4096;
+  while (capacity < cells)
+    capacity *= 2;
+  terminal_cell *grown =
+      realloc(lines->cells, (usize)capacity * sizeof(terminal_cell));
+  if (!grown)
+    return false;
+  lines->cells = grown;
+  lines->cell_capacity = capacity;
+  return true;
+}
+
+u32 Scrollback_EncodeText(const terminal_cell *cells, u32 width, u8 *out) {
+  u32 length = Scrollback_ContentLength(cells, width);
+  u8 *at = out;
+
+  for (u32 x = 0; x < length; x++) {
+    u32 codepoint = cells[x].codepoint;
+    if (codepoint < 0x80) {
+      *at++ = (u8)codepoint;
+    } else if (codepoint == TERM_WIDE_SPACER) {
+      *at++ = SCROLLBACK_SPACER_BYTE;
+    } else {
+      at += Text_UTF8Encode(codepoint, (char *)at);
+    }
+  }
+  if (length == 0 || !cells[length - 1].attr.wrapped) {
+    *at++ = '\n';
+  }
+  return (u32)(at - out);
+}
+
+static b32 Scrollback_Pack(const ScrollbackLines *lines, ScrollbackPage *out) {
+  u32 cell_count = lines->starts[lines->line_count];
+  usize bound = (usize)cell_count *
+                    (4 + SCROLLBACK_VARINT_BYTES + SCROLLBACK_ATTR_BYTES) +
+                (usize)lines->line_count * (1 + 3 * SCROLLBACK_VARINT_BYTES);
+  u8 *data = malloc(bound > 0 ? bound : 1);
+  if (!data)
+    return false;
+
+  u32 text_sizes[SCROLLBACK_PAGE_LINES];
+  u8 *at = data;
+  for (u32 i = 0; i < lines->line_count; i++) {
+    u32 length = lines->starts[i + 1] - lines->starts[i];
+    text_sizes[i] =
+        Scrollback_EncodeText(lines->cells + lines->starts[i], length, at);
+    at += text_sizes[i];
+  }
+  out->text_size = (u32)(at - data);
+
+  for (u32 i = 0; i < lines->line_count; i++) {
+    at = Scrollback_PutVarint(at, text_sizes[i]);
+  }
+
+  for (u32 i = 0; i < lines->line_count; i++) {
+    const terminal_cell *cells = lines->cells + lines->starts[i];
+    u32 length = lines->starts[i + 1] - lines->starts[i];
+    at = Scrollback_PutVarint(at, length);
+
+    u32 x = 0;
+    while (x < length) {
+      u32 bits = Scrollback_AttrBits(cells[x].attr);
+      u32 run = 1;
+      while (x + run < length &&
+             Scrollback_AttrBits(cells[x + run].attr) == bits) {
+        run++;
+      }
+      at = Scrollback_PutVarint(at, run);
+      for (i32 b = 0; b < SCROLLBACK_ATTR_BYTES; b++) {
+        *at++ = (u8)(bits >> (8 * b));
+      }
+      x += run;
+    }
+  }
+
+  out->size = (u32)(at - data);
+  u8 *shrunk = realloc(data, out->size > 0 ? out->size : 1);
+  out->data = shrunk ? shrunk : data;
+  return true;
+}
+
+/* Where each line's text starts in a packed page (starts[i + 1] is where it
+ * ends). Returns the offset of the cells part, 0 if the page is damaged. */
+static u32 Scrollback_PageTextStarts(const ScrollbackPage *page, u32 *starts) {
+  u32 pos = page->text_size;
+  starts[0] = 0;
+  for (u32 i = 0; i < SCROLLBACK_PAGE_LINES; i++) {
+    u32 size;
+    if (!Scrollback_GetVarint(page->data, page->size, &pos, &size) ||
+        size > page->text_size - starts[i])
+      return 0;
+    starts[i + 1] = starts[i] + size;
+  }
+  return pos;
+}
+
+static b32 Scrollback_Unpack(const ScrollbackPage *page, ScrollbackLines *out) {
+  u32 text_starts[SCROLLBACK_PAGE_LINES + 1];
+  const u8 *data = page->data;
+  u32 pos = Scrollback_PageTextStarts(page, text_starts);
+
+  Scrollback_LinesReset(out);
+  if (pos == 0)
+    return false;
+
+  for (u32 i = 0; i < SCROLLBACK_PAGE_LINES; i++) {
+    u32 length;
+    if (!Scrollback_GetVarint(data, page->size, &pos, &length))
+      return false;
+    u32 start = out->starts[out->line_count];
+    if (!Scrollback_LinesReserve(out, start + length))
+      return false;
+    terminal_cell *cells = out->cells + start;
+
+    u32 text = text_starts[i];
+    u32 text_end = text_starts[i + 1];
+    for (u32 x = 0; x < length; x++) {
+      if (text >= text_end)
+        return false;
+      if (data[text] == SCROLLBACK_SPACER_BYTE) {
+        cells[x].codepoint = TERM_WIDE_SPACER;
+        text++;
+      } else {
+        text += (u32)Text_UTF8Decode((const char *)data + text, text_end - text,
+                                     &cells[x].codepoint);
+      }
+    }
+
+    u32 x = 0;
+    while (x < length) {
+      u32 run;
+      if (!Scrollback_GetVarint(data, page->size, &pos, &run) || run == 0 ||
+          run > length - x || pos + SCROLLBACK_ATTR_BYTES > page->size)
+        return false;
+      u32 bits = 0;
+      for (i32 b = 0; b < SCROLLBACK_ATTR_BYTES; b++) {
+        bits |= (u32)data[pos++] << (8 * b);
+      }
+      cell_attr attr = Scrollback_AttrFromBits(bits);
+      for (u32 k = 0; k < run; k++) {
+        cells[x + k].attr = attr;
+      }
+      x += run;
+    }
+
+    out->starts[++out->line_count] = start + length;
+  }
+  return true;
+}
+
+static void Scrollback_Forget(Scrollback *sb, u64 page_id) {
+  for (i32 i = 0; i < SCROLLBACK_CACHE_PAGES; i++) {
+    if (sb->cache[i].page_id == page_id)
+      sb->cache[i].page_id = 0;
+  }
+}
+
+/* Full page i, 0 = oldest */
+static ScrollbackPage *Scrollback_Page(const Scrollback *sb, u32 index) {
+  return &sb->pages[(sb->page_head + index) & (sb->page_capacity - 1)];
+}
+
+/* Lines of the newest page, less those already dropped from its start */
+static u32 Scrollback_NewestLive(const Scrollback *sb) {
+  return sb->newest.line_count - (sb->page_count == 0 ? sb->first_line : 0);
+}
+
+/* Pack the full newest page onto the list of pages */
+static void Scrollback_Seal(Scrollback *sb) {
+  if (sb->page_count == sb->page_capacity) {
+    u32 capacity = sb->page_capacity ? sb->page_capacity * 2 : 64;
+    ScrollbackPage *grown =
+        realloc(sb->pages, (usize)capacity * sizeof(ScrollbackPage));
+    if (grown) {
+      /* Unwrap the ring: the slots before the head follow the old end */
+      if (sb->page_head > 0) {
+        memcpy(grown + sb->page_capacity, grown,
+               (usize)sb->page_head * sizeof(ScrollbackPage));
+      }
+      sb->pages = grown;
+      sb->page_capacity = capacity;
+    }
+  }
+
+  ScrollbackPage page;
+  if (sb->page_count < sb->page_capacity &&
+      Scrollback_Pack(&sb->newest, &page)) {
+    *Scrollback_Page(sb, sb->page_count++) = page;
+  } else {
+    /* Out of memory: lose these lines rather than stop scrolling */
+    sb->count -= Scrollback_NewestLive(sb);
+    if (sb->page_count == 0)
+      sb->first_line = 0;
+  }
+  Scrollback_LinesReset(&sb->newest);
+}
+
+static void Scrollback_DropOldest(Scrollback *sb) {
+  if (sb->count == 0)
+    return;
+  sb->count--;
+  sb->first_line++;
+  sb->first_id++;
+
+  if (sb->page_count > 0 && sb->first_line == SCROLLBACK_PAGE_LINES) {
+    free(Scrollback_Page(sb, 0)->data);
+    sb->page_head = (sb->page_head + 1) & (sb->page_capacity - 1);
+    sb->page_count--;
+    Scrollback_Forget(sb, sb->first_page_id);
+    sb->first_page_id++;
+    sb->first_line = 0;
+  } else if (sb->page_count == 0 && sb->count == 0) {
+    Scrollback_LinesReset(&sb->newest);
+    sb->first_line = 0;
+  }
+}
+
+/* ===== Public API ===== */
+
+Scrollback *Scrollback_Create(u32 max_lines) {
+  Scrollback *sb = malloc(sizeof(Scrollback));
+  if (!sb)
+    return NULL;
+  memset(sb, 0, sizeof(Scrollback));
+  sb->max_lines = Min(max_lines, (u32)SCROLLBACK_MAX_LINES);
+  sb->first_page_id = 1;
+  return sb;
+}
+
+void Scrollback_Destroy(Scrollback *sb) {
+  if (!sb)
+    return;
+  Scrollback_Clear(sb);
+  free(sb->pages);
+  free(sb->text);
+  Scrollback_LinesFree(&sb->newest);
+  for (i32 i = 0; i < SCROLLBACK_CACHE_PAGES; i++) {
+    Scrollback_LinesFree(&sb->cache[i].lines);
+  }
+  free(sb);
+}
+
+void Scrollback_Clear(Scrollback *sb) {
+  for (u32 i = 0; i < sb->page_count; i++) {
+    free(Scrollback_Page(sb, i)->data);
+  }
+  for (i32 i = 0; i < SCROLLBACK_CACHE_PAGES; i++) {
+    sb->cache[i].page_id = 0;
+  }
+  sb->first_page_id += sb->page_count;
+  sb->first_id += sb->count;
+  sb->page_head = 0;
+  sb->page_count = 0;
+  sb->first_line = 0;
+  sb->count = 0;
+  Scrollback_LinesReset(&sb->newest);
+}
+
+void Scrollback_SetMaxLines(Scrollback *sb, u32 max_lines) {
+  sb->max_lines = Min(max_lines, (u32)SCROLLBACK_MAX_LINES);
+  while (sb->count > sb->max_lines) {
+    Scrollback_DropOldest(sb);
+  }
+}
+
+void Scrollback_Push(Scrollback *sb, const terminal_cell *cells, u32 width) {
+  if (sb->max_lines == 0)
+    return;
+
+  if (sb->newest.line_count == SCROLLBACK_PAGE_LINES) {
+    Scrollback_Seal(sb);
+  }
+
+  ScrollbackLines *newest = &sb->newest;
+  u32 length = Scrollback_ContentLength(cells, width);
+  u32 start = newest->starts[newest->line_count];
+  if (!Scrollback_LinesReserve(newest, start + length))
+    return;
+
+  if (length > 0)
+    memcpy(newest->cells + start, cells, (usize)length * sizeof(terminal_cell));
+  newest->starts[++newest->line_count] = start + length;
+  sb->count++;
+
+  while (sb->count > sb->max_lines) {
+    Scrollback_DropOldest(sb);
+  }
+}
+
+void Scrollback_DropNewest(Scrollback *sb, u32 count) {
+  while (count > 0 && sb->count > 0) {
+    if (Scrollback_NewestLive(sb) == 0) {
+      /* Take the newest full page: freed whole if all its lines go,
+       * otherwise unpacked to drop from */
+      u32 index = sb->page_count - 1;
+      ScrollbackPage *page = Scrollback_Page(sb, index);
+      u32 page_live = SCROLLBACK_PAGE_LINES - (index == 0 ? sb->first_line : 0);
+      b32 unpacked = count < page_live && Scrollback_Unpack(page, &sb->newest);
+      Scrollback_Forget(sb, sb->first_page_id + index);
+      free(page->data);
+      sb->page_count--;
+      if (!unpacked) {
+        sb->count -= page_live;
+        count -= Min(count, page_live);
+        Scrollback_LinesReset(&sb->newest);
+        if (sb->page_count == 0)
+          sb->first_line = 0;
+        continue;
+      }
+    }
+
+    u32 drop = Min(count, Scrollback_NewestLive(sb));
+    sb->newest.line_count -= drop;
+    sb->count -= drop;
+    count -= drop;
+  }
+
+  if (sb->count == 0) {
+    Scrollback_LinesReset(&sb->newest);
+    sb->first_line = 0;
+  }
+}
+
+const terminal_cell *Scrollback_GetLine(Scrollback *sb, u32 index,
+                                        u32 *out_length) {
+  static terminal_cell empty;
+  *out_length = 0;
+  if (index >= sb->count)
+    return &empty;
+
+  u64 absolute = (u64)sb->first_line + index;
+  u32 page = (u32)(absolute / SCROLLBACK_PAGE_LINES);
+  u32 line = (u32)(absolute % SCROLLBACK_PAGE_LINES);
+
+  const ScrollbackLines *lines = &sb->newest;
+  if (page < sb->page_count) {
+    u64 page_id = sb->first_page_id + page;
+    ScrollbackCacheEntry *entry = NULL;
+    ScrollbackCacheEntry *oldest = &sb->cache[0];
+    for (i32 i = 0; i < SCROLLBACK_CACHE_PAGES; i++) {
+      if (sb->cache[i].page_id == page_id) {
+        entry = &sb->cache[i];
+        break;
+      }
+      if (sb->cache[i].last_used < oldest->last_used)
+        oldest = &sb->cache[i];
+    }
+
+    if (!entry) {
+      entry = oldest;
+      entry->page_id = 0;
+      if (!Scrollback_Unpack(Scrollback_Page(sb, page), &entry->lines))
+        return &empty;
+      entry->page_id = page_id;
+    }
+    entry->last_used = ++sb->cache_clock;
+    lines = &entry->lines;
+  }
+
+  if (line >= lines->line_count)
+    return &empty;
+  *out_length = lines->starts[line + 1] - lines->starts[line];
+  return lines->cells + lines->starts[line];
+}
+
+void Scrollback_GetText(Scrollback *sb, u32 index, ScrollbackText *out) {
+  out->text = NULL;
+  out->first = 0;
+  out->line_count = 0;
+  out->starts[0] = 0;
+  if (index >= sb->count)
+    return;
+
+  u32 page = (u32)(((u64)sb->first_line + index) / SCROLLBACK_PAGE_LINES);
+  u32 skip = page == 0 ? sb->first_line : 0; /* Dropped lines */
+  out->first = page * SCROLLBACK_PAGE_LINES + skip - sb->first_line;
+
+  if (page < sb->page_count) {
+    /* Read in place from the packed page */
+    const ScrollbackPage *packed = Scrollback_Page(sb, page);
+    if (Scrollback_PageTextStarts(packed, out->starts) == 0)
+      return;
+    u32 base = out->starts[skip];
+    out->text = packed->data + base;
+    out->line_count = SCROLLBACK_PAGE_LINES - skip;
+    for (u32 i = 0; i <= out->line_count; i++) {
+      out->starts[i] = out->starts[skip + i] - base;
+    }
+    return;
+  }
+
+  /* The newest page is cells: encode it */
+  const ScrollbackLines *lines = &sb->newest;
+  usize bound = 0;
+  for (u32 i = skip; i < lines->line_count; i++) {
+    bound += SCROLLBACK_TEXT_BOUND(lines->starts[i + 1] - lines->starts[i]);
+  }
+  if (bound > sb->text_capacity) {
+    u8 *grown = realloc(sb->text, bound);
+    if (!grown)
+      return;
+    sb->text = grown;
+    sb->text_capacity = bound;
+  }
+
+  u32 size = 0;
+  for (u32 i = skip; i < lines->line_count; i++) {
+    out->starts[out->line_count++] = size;
+    size += Scrollback_EncodeText(lines->cells + lines->starts[i],
+                                  lines->starts[i + 1] - lines->starts[i],
+                                  sb->text + size);
+  }
+  out->starts[out->line_count] = size;
+  out->text = sb->text;
+}
+
+usize Scrollback_MemoryUsed(const Scrollback *sb) {
+  usize bytes = sizeof(Scrollback) +
+                (usize)sb->page_capacity * sizeof(ScrollbackPage) +
+                (usize)sb->newest.cell_capacity * sizeof(terminal_cell) +
+                sb->text_capacity;
+  for (u32 i = 0; i < sb->page_count; i++) {
+    bytes += Scrollback_Page(sb, i)->size;
+  }
+  for (i32 i = 0; i < SCROLLBACK_CACHE_PAGES; i++) {
+    bytes += (usize)sb->cache[i].lines.cell_capacity * sizeof(terminal_cell);
+  }
+  return bytes;
+}
@@ -0,0 +1,128 @@
+/*
+ * scrollback.h - Paged, compressed scrollback storage for the terminal
+ *
+ * Lines that scroll off the top of the screen are stored trimmed to their
+ * content, in pages of SCROLLBACK_PAGE_LINES. The newest page is kept as
+ * cells so lines can be appended and popped cheaply; full pages are packed
+ * (UTF-8 text, so ASCII takes a byte per cell, and run-length attributes)
+ * and unpacked into a small cache only when a line on them is read. A
+ * page's text is kept in one block that search reads without unpacking.
+ * C99, handmade hero style.
+ */
+
+#ifndef SCROLLBACK_H
+#define SCROLLBACK_H
+
+#include "../core/types.h"
+#include "terminal.h"
+
+/* Configuration */
+#define SCROLLBACK_PAGE_LINES 256
+#define SCROLLBACK_CACHE_PAGES 4 /* Pages kept unpacked for reading */
+#define SCROLLBACK_MAX_LINES 100000000
+
+/* Lines of one page as cells: line i is cells[starts[i] .. starts[i+1]) */
+typedef struct {
+  terminal_cell *cells;
+  u32 cell_capacity;
+  u32 starts[SCROLLBACK_PAGE_LINES + 1];
+  u32 line_count;
+} ScrollbackLines;
+
+typedef struct {
+  u8 *data; /* Packed lines, see scrollback.c */
+  u32 size;
+  u32 text_size; /* Their text is data[0 .. text_size) */
+} ScrollbackPage;
+
+typedef struct {
+  u64 page_id; /* Of the packed page held, 0 when unused */
+  u64 last_used;
+  ScrollbackLines lines;
+} ScrollbackCacheEntry;
+
+/* Text of consecutive lines as Scrollback_EncodeText writes it: line
+ * first + i is text[starts[i] .. starts[i + 1]) */
+typedef struct {
+  const u8 *text;
+  u32 starts[SCROLLBACK_PAGE_LINES + 1];
+  u32 first;
+  u32 line_count;
+} ScrollbackText;
+
+/* Most bytes Scrollback_EncodeText writes for a line of 'width' cells */
+#define SCROLLBACK_TEXT_BOUND(width) ((usize)(width) * 4 + 1)
+
+typedef struct Scrollback Scrollback;
+
+struct Scrollback {
+  u32 max_lines;
+  u32 count; /* Lines stored */
+
+  /* Id of line 0. Ids only change as the oldest lines are dropped, so
+   * first_id + index names a line while newer ones are pushed. */
+  u64 first_id;
+
+  /* Full pages, oldest first, in a ring starting at slot page_head (so
+   * dropping the oldest moves nothing; the capacity is a power of two).
+   * Page i has id first_page_id + i (ids start at 1), which doesn't change
+   * as older pages are dropped. */
+  ScrollbackPage *pages;
+  u32 page_head;
+  u32 page_count;
+  u32 page_capacity;
+  u64 first_page_id;
+
+  /* Lines already dropped from the start of the oldest page (or of the
+   * newest, while it is the only one) */
+  u32 first_line;
+
+  ScrollbackLines newest; /* Page being filled */
+
+  ScrollbackCacheEntry cache[SCROLLBACK_CACHE_PAGES];
+  u64 cache_clock;
+
+  u8 *text; /* The newest page's text, for Scrollback_GetText */
+  usize text_capacity;
+};
+
+/* Create empty scrollback keeping at most max_lines (clamped to
+ * SCROLLBACK_MAX_LINES) */
+Scrollback *Scrollback_Create(u32 max_lines);
+
+void Scrollback_Destroy(Scrollback *sb);
+
+/* Drop every line */
+void Scrollback_Clear(Scrollback *sb);
+
+/* Change the line limit, dropping the oldest lines past it */
+void Scrollback_SetMaxLines(Scrollback *sb, u32 max_lines);
+
+/* Append a line of 'width' cells, trimmed of trailing default blanks. The
+ * oldest line is dropped once max_lines are stored. */
+void Scrollback_Push(Scrollback *sb, const terminal_cell *cells, u32 width);
+
+/* Drop the newest 'count' lines (all of them if there are fewer) */
+void Scrollback_DropNewest(Scrollback *sb, u32 count);
+
+/* Cells of line 'index' (0 = oldest) and how many there are: every cell
+ * past *out_length is a default blank. Valid until the next call on sb. */
+const terminal_cell *Scrollback_GetLine(Scrollback *sb, u32 index,
+                                        u32 *out_length);
+
+/* Write a line's text: its cells (trimmed as Scrollback_Push trims them)
+ * as UTF-8, a 0xFF byte (never valid UTF-8) for each TERM_WIDE_SPACER,
+ * then '\n' unless the line wraps onto the next, so a wrapped line reads
+ * as one. out must hold SCROLLBACK_TEXT_BOUND(width) bytes. Returns the
+ * bytes written. */
+u32 Scrollback_EncodeText(const terminal_cell *cells, u32 width, u8 *out);
+
+/* Text of the lines on the page holding line 'index', from the first one
+ * stored: read in place from a packed page, encoded for the newest. Empty
+ * (text NULL) if the page is damaged. Valid until the next call on sb. */
+void Scrollback_GetText(Scrollback *sb, u32 index, ScrollbackText *out);
+
+/* Bytes held, packed and unpacked (for tuning) */
+usize Scrollback_MemoryUsed(const Scrollback *sb);
+
+#endif /* SCROLLBACK_H */
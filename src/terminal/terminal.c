@@ -7,12 +7,16 @@
  */
 
 #include "terminal.h"
+#include "scrollback.h"
+#include "../core/byte_scan.h"
+#include "../core/text.h"
 #include "../platform/platform.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-#define READ_BUFFER_SIZE (64 * 1024) /* 64KB ring buffer */
+#define READ_BUFFER_SIZE (4 * 1024 * 1024) /* 4MB ring buffer */
+#define READ_CHUNK_SIZE (64 * 1024)        /* Parsed per tail update */
 
 /* ===== Helper Functions ===== */
 
@@ -32,6 +36,7 @@ static void reset_attr(cell_attr *attr) {
 static void clear_cell(terminal_cell *cell) {
   cell->codepoint = ' ';
   reset_attr(&cell->attr);
+  cell->attr.wrapped = 0;
 }
 
 static void clear_line(Terminal *term, u32 y) {
@@ -48,24 +53,34 @@ static void clear_screen_cells(Terminal *term) {
   }
 }
 
+static const terminal_cell blank_cell = {
+    ' ', {TERM_DEFAULT_FG, TERM_DEFAULT_BG, 0, 0, 0, 0, 0, 0, 0, 0, 0}};
+
+/* Cells of virtual line y (0 = oldest scrollback line) and how many are
+ * stored: scrollback lines are trimmed, and every cell past *out_len is a
+ * default blank. NULL past the last screen row. */
+static const terminal_cell *get_row(Terminal *term, u32 y, u32 *out_len) {
+  if (y < term->scrollback_count) {
+    return Scrollback_GetLine(term->scrollback, y, out_len);
+  }
+  u32 screen_y = y - term->scrollback_count;
+  if (screen_y >= term->rows) {
+    *out_len = 0;
+    return NULL;
+  }
+  *out_len = term->cols;
+  return &term->screen[screen_y * term->cols];
+}
+
 /* ===== Scroll Operations ===== */
 
 static void push_line_to_scrollback(Terminal *term, u32 line) {
   if (!term->scrollback)
     return;
 
-  u32 dest_line =
-      (term->scrollback_start + term->scrollback_count) % term->scrollback_size;
-
-  memcpy(&term->scrollback[dest_line * term->cols],
-         &term->screen[line * term->cols], term->cols * sizeof(terminal_cell));
-
-  if (term->scrollback_count < term->scrollback_size) {
-    term->scrollback_count++;
-  } else {
-    term->scrollback_start =
-        (term->scrollback_start + 1) % term->scrollback_size;
-  }
+  Scrollback_Push(term->scrollback, &term->screen[line * term->cols],
+                  term->cols);
+  term->scrollback_count = term->scrollback->count;
 }
 
 static void scroll_up(Terminal *term, u32 top, u32 bottom, u32 count) {
@@ -117,36 +132,65 @@ static void scroll_down(Terminal *term, u32 top, u32 bottom, u32 count) {
 
 /* ===== Read Thread ===== */
 
+/* The ring's head and tail are each written by one thread and read by the
+ * other: a release store publishes the bytes (or the free space) before
+ * the counter that covers them, an acquire load sees both. */
+static u32 ring_load(const u32 *counter) {
+  return __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+}
+
+static void ring_store(u32 *counter, u32 value) {
+  __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+}
+
 static void *pty_read_thread(void *arg) {
   Terminal *term = (Terminal *)arg;
-  char buffer[4096];
+  u32 mask = term->read_buffer_size - 1;
 
-  while (term->thread_running && PTY_IsAlive(term->pty)) {
-    i32 bytes = PTY_Read(term->pty, buffer, sizeof(buffer));
+  while (term->thread_running) {
+    u32 head = term->read_head;
 
-    if (bytes > 0) {
-      pthread_mutex_lock(&term->buffer_mutex);
-
-      /* Write to ring buffer */
-      for (i32 i = 0; i < bytes; i++) {
-        u32 next_head = (term->read_head + 1) % term->read_buffer_size;
-        if (next_head != term->read_tail) {
-          term->read_buffer[term->read_head] = buffer[i];
-          term->read_head = next_head;
-        }
-        /* If buffer full, drop oldest data (overwrite) */
-      }
+    if (head - ring_load(&term->read_tail) == term->read_buffer_size) {
+      /* Ring full: leave the output in the PTY, whose buffer fills and
+       * blocks the child until the UI catches up. Nothing is dropped. */
+      Platform_SleepMs(1);
+      continue;
+    }
+
+    /* Sleep until there is output; false once Terminal_Destroy (or a
+     * respawn) interrupts the wait */
+    if (!PTY_WaitForOutput(term->pty))
+      break;
+
+    /* The UI may have caught up while we slept */
+    u32 used = head - ring_load(&term->read_tail);
+    u32 free_bytes = term->read_buffer_size - used;
 
-      pthread_mutex_unlock(&term->buffer_mutex);
+    /* Read straight into the free span up to the end of the buffer */
+    u32 offset = head & mask;
+    u32 span = term->read_buffer_size - offset;
+    if (span > free_bytes)
+      span = free_bytes;
+
+    i32 bytes = PTY_Read(term->pty, term->read_buffer + offset, span);
+
+    if (bytes > 0) {
+      ring_store(&term->read_head, head + (u32)bytes);
+      /* Wake the UI for the first output after it caught up (an echoed
+       * key, say); while it is behind it drains the ring every frame */
+      if (used == 0)
+        Platform_WakeEventLoop();
     } else if (bytes < 0) {
       /* Error, exit thread */
       break;
-    } else {
-      /* No data, sleep briefly */
-      Platform_SleepMs(5);
+    } else if (!PTY_IsAlive(term->pty)) {
+      /* End of output: the child exited */
+      break;
     }
   }
 
+  /* Let the UI notice the exit */
+  Platform_WakeEventLoop();
   return NULL;
 }
 
@@ -371,8 +415,9 @@ static void handle_csi(Terminal *term, ansi_result *result) {
       /* Clear scrollback too for both 2 (ED) and 3 (Clear History) */
       /* This is a user-preference choice to match "Ctrl+L cleans buffer"
        * request */
+      if (term->scrollback)
+        Scrollback_Clear(term->scrollback);
       term->scrollback_count = 0;
-      term->scrollback_start = 0;
       term->scroll_offset = 0;
     }
     break;
@@ -529,36 +574,111 @@ static void handle_control(Terminal *term, u8 c) {
   term->dirty = true;
 }
 
+/* Move to the start of the next line once the cursor has passed the last
+ * column, scrolling at the bottom of the scroll region */
+static void wrap_line(Terminal *term) {
+  /* Mark the last character of the previous line as wrapped */
+  u32 prev_y = term->cursor_y;
+  u32 prev_x = term->cols - 1;
+  terminal_cell *last_cell = &term->screen[prev_y * term->cols + prev_x];
+  last_cell->attr.wrapped = 1;
+
+  term->cursor_x = 0;
+  term->cursor_y++;
+  if (term->cursor_y >= term->scroll_bottom) {
+    term->cursor_y = term->scroll_bottom - 1;
+    scroll_up(term, term->scroll_top, term->scroll_bottom, 1);
+  }
+}
+
+/* Before cells [x0, x1) of a row are overwritten, blank the other half of
+ * any wide character cut by either edge */
+static void split_wide(Terminal *term, terminal_cell *row, u32 x0, u32 x1) {
+  if (x0 > 0 && row[x0].codepoint == TERM_WIDE_SPACER)
+    row[x0 - 1].codepoint = ' ';
+  if (x1 < term->cols && row[x1].codepoint == TERM_WIDE_SPACER)
+    row[x1].codepoint = ' ';
+}
+
 static void put_char(Terminal *term, u32 codepoint) {
-  if (term->cursor_x >= term->cols) {
-    /* Line wrap */
-    /* Mark the last character of the previous line as wrapped */
-    u32 prev_y = term->cursor_y;
-    u32 prev_x = term->cols - 1;
-    terminal_cell *last_cell = &term->screen[prev_y * term->cols + prev_x];
-    last_cell->attr.wrapped = 1;
+  u32 width = 1;
+  if (codepoint >= 0x80) {
+    /* Combining marks are dropped: a cell holds a single codepoint */
+    i32 columns = Text_CodepointColumns(codepoint);
+    if (columns == 0)
+      return;
+    if (columns == 2 && term->cols >= 2)
+      width = 2;
+  }
 
-    term->cursor_x = 0;
-    term->cursor_y++;
-    if (term->cursor_y >= term->scroll_bottom) {
-      term->cursor_y = term->scroll_bottom - 1;
-      scroll_up(term, term->scroll_top, term->scroll_bottom, 1);
+  if (term->cursor_x + width > term->cols) {
+    /* A wide character doesn't fit in the last column: leave it blank */
+    if (term->cursor_x < term->cols) {
+      terminal_cell *row = &term->screen[term->cursor_y * term->cols];
+      split_wide(term, row, term->cursor_x, term->cols);
+      row[term->cursor_x].codepoint = ' ';
+      term->cursor_x = term->cols;
     }
+    wrap_line(term);
   }
 
-  terminal_cell *cell =
-      &term->screen[term->cursor_y * term->cols + term->cursor_x];
+  terminal_cell *row = &term->screen[term->cursor_y * term->cols];
+  split_wide(term, row, term->cursor_x, term->cursor_x + width);
+
+  terminal_cell *cell = &row[term->cursor_x];
   cell->codepoint = codepoint;
   cell->attr = term->current_attr;
   cell->attr.wrapped = 0; /* Clear wrap flag for new char */
+  if (width == 2) {
+    cell[1] = cell[0];
+    cell[1].codepoint = TERM_WIDE_SPACER;
+  }
+
+  term->cursor_x += width;
+  term->dirty = true;
+}
+
+/* Same as put_char for each byte of a printable ASCII run, a row segment
+ * at a time */
+static void put_run(Terminal *term, const u8 *text, usize len) {
+  terminal_cell blank;
+  blank.codepoint = ' ';
+  blank.attr = term->current_attr;
+  blank.attr.wrapped = 0;
+
+  while (len > 0) {
+    if (term->cursor_x >= term->cols) {
+      wrap_line(term);
+    }
+
+    u32 count = term->cols - term->cursor_x;
+    if (count > len)
+      count = (u32)len;
+
+    terminal_cell *row = &term->screen[term->cursor_y * term->cols];
+    split_wide(term, row, term->cursor_x, term->cursor_x + count);
+
+    terminal_cell *cell = &row[term->cursor_x];
+    for (u32 i = 0; i < count; i++) {
+      cell[i] = blank;
+      cell[i].codepoint = text[i];
+    }
+
+    term->cursor_x += count;
+    text += count;
+    len -= count;
+  }
 
-  term->cursor_x++;
   term->dirty = true;
 }
 
 static void process_byte(Terminal *term, u8 byte) {
   ansi_result result = ANSI_Parse(&term->parser, byte);
 
+  if (result.malformed) {
+    put_char(term, TEXT_REPLACEMENT_CHARACTER);
+  }
+
   switch (result.action) {
   case WB_ANSI_ACTION_PRINT:
     put_char(term, result.data.character);
@@ -606,6 +726,35 @@ static void process_byte(Terminal *term, u8 byte) {
   }
 }
 
+/* Feed a chunk of PTY output through the parser. In the ground state the
+ * printable ASCII runs that make up most output skip the parser and are
+ * written a row segment at a time. */
+static void process_bytes(Terminal *term, const u8 *data, usize len) {
+  usize i = 0;
+  while (i < len) {
+    if (term->parser.state == WB_ANSI_STATE_GROUND &&
+        term->parser.utf8_need == 0) {
+      usize run = ByteScan_PrintableRun(data + i, len - i);
+      if (run > 0) {
+        put_run(term, data + i, run);
+        i += run;
+        continue;
+      }
+
+      /* A whole UTF-8 sequence in the chunk: decode it here. One split
+       * across chunks is collected by the parser instead. */
+      if (data[i] >= 0x80 && len - i >= 4) {
+        u32 codepoint;
+        i += (usize)Text_UTF8Decode((const char *)data + i, len - i,
+                                    &codepoint);
+        put_char(term, codepoint);
+        continue;
+      }
+    }
+    process_byte(term, data[i++]);
+  }
+}
+
 /* ===== Public API ===== */
 
 Terminal *Terminal_Create(u32 cols, u32 rows) {
@@ -635,28 +784,19 @@ Terminal *Terminal_Create(u32 cols, u32 rows) {
   }
   clear_screen_cells(term);
 
-  /* Allocate scrollback */
-  term->scrollback_size = TERMINAL_SCROLLBACK_LINES;
-  term->scrollback =
-      malloc(term->scrollback_size * cols * sizeof(terminal_cell));
-  if (!term->scrollback) {
-    /* Continue without scrollback */
-    term->scrollback_size = 0;
-  }
+  /* Allocate scrollback (continue without it on failure) */
+  term->scrollback = Scrollback_Create(TERMINAL_SCROLLBACK_LINES);
 
   /* Allocate read buffer */
   term->read_buffer_size = READ_BUFFER_SIZE;
   term->read_buffer = malloc(term->read_buffer_size);
   if (!term->read_buffer) {
-    free(term->scrollback);
+    Scrollback_Destroy(term->scrollback);
     free(term->screen);
     free(term);
     return NULL;
   }
 
-  /* Initialize mutex */
-  pthread_mutex_init(&term->buffer_mutex, NULL);
-
   /* Initialize parser */
   ANSI_Init(&term->parser);
 
@@ -675,6 +815,7 @@ void Terminal_Destroy(Terminal *term) {
   /* Stop read thread */
   if (term->thread_running) {
     term->thread_running = false;
+    PTY_Interrupt(term->pty);
     pthread_join(term->read_thread, NULL);
   }
 
@@ -683,10 +824,8 @@ void Terminal_Destroy(Terminal *term) {
     PTY_Destroy(term->pty);
   }
 
-  pthread_mutex_destroy(&term->buffer_mutex);
-
   free(term->read_buffer);
-  free(term->scrollback);
+  Scrollback_Destroy(term->scrollback);
   free(term->screen);
   free(term);
 }
@@ -699,6 +838,7 @@ b32 Terminal_Spawn(Terminal *term, const char *shell, const char *cwd) {
   if (term->pty) {
     if (term->thread_running) {
       term->thread_running = false;
+      PTY_Interrupt(term->pty);
       pthread_join(term->read_thread, NULL);
     }
     PTY_Destroy(term->pty);
@@ -738,23 +878,35 @@ void Terminal_Update(Terminal *term) {
   if (!term)
     return;
 
-  /* Process pending data from read thread */
-  pthread_mutex_lock(&term->buffer_mutex);
+  /* Process pending data from read thread. The reader never writes between
+   * read_tail and read_head, so those bytes are parsed in place and only
+   * then handed back. At most one ring's worth is taken per update, so a
+   * flood of output cannot hold up the frame indefinitely. */
+  u32 mask = term->read_buffer_size - 1;
+  u32 tail = term->read_tail;
+  u32 budget = term->read_buffer_size;
+
+  while (budget > 0) {
+    u32 pending = ring_load(&term->read_head) - tail;
+    if (pending == 0)
+      break;
 
-  while (term->read_tail != term->read_head) {
-    u8 byte = term->read_buffer[term->read_tail];
-    term->read_tail = (term->read_tail + 1) % term->read_buffer_size;
+    u32 offset = tail & mask;
+    u32 span = term->read_buffer_size - offset;
+    if (span > pending)
+      span = pending;
+    if (span > READ_CHUNK_SIZE)
+      span = READ_CHUNK_SIZE;
+    if (span > budget)
+      span = budget;
 
-    /* DEBUG: Log removed */
+    process_bytes(term, (const u8 *)term->read_buffer + offset, span);
 
-    /* Release lock briefly to allow reader thread to continue */
-    pthread_mutex_unlock(&term->buffer_mutex);
-    process_byte(term, byte);
-    pthread_mutex_lock(&term->buffer_mutex);
+    tail += span;
+    budget -= span;
+    ring_store(&term->read_tail, tail);
   }
 
-  pthread_mutex_unlock(&term->buffer_mutex);
-
   /* Do NOT reset scroll to bottom on update - allows reading history while
    * output arrives */
   if (term->dirty && term->scroll_offset > 0) {
@@ -801,7 +953,22 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
     screen_rows_used = term->cursor_y + 1;
   }
 
-  u32 total_old_lines = term->scrollback_count + screen_rows_used;
+  /* Reflow the newest history, back to the start of a logical line, and
+   * the screen. Older history keeps the width it scrolled off at (wider
+   * rows are clipped when drawn), so resizing doesn't unpack all of it. */
+  u32 reflow_sb = Min(term->scrollback_count, (u32)TERMINAL_REFLOW_LINES);
+  while (reflow_sb < term->scrollback_count &&
+         reflow_sb < 2 * TERMINAL_REFLOW_LINES) {
+    u32 len;
+    const terminal_cell *row =
+        get_row(term, term->scrollback_count - reflow_sb - 1, &len);
+    if (len == 0 || !row[len - 1].attr.wrapped)
+      break;
+    reflow_sb++;
+  }
+  u32 kept_sb = term->scrollback_count - reflow_sb;
+
+  u32 total_old_lines = reflow_sb + screen_rows_used;
   u32 estimated_capacity =
       (total_old_lines * term->cols) / cols + total_old_lines + 100;
 
@@ -822,10 +989,11 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
   u32 new_cursor_y = 0; /* Index in 'lines' initially */
   b32 cursor_found = false;
 
-  b32 sel_start_found = false;
-  b32 sel_end_found = false;
-  u32 new_sel_start_x = 0, new_sel_start_y = 0;
-  u32 new_sel_end_x = 0, new_sel_end_y = 0;
+  /* Selection ends in the history that isn't reflowed keep their place */
+  b32 sel_start_found = term->sel_start.y < kept_sb;
+  b32 sel_end_found = term->sel_end.y < kept_sb;
+  u32 new_sel_start_x = term->sel_start.x, new_sel_start_y = term->sel_start.y;
+  u32 new_sel_end_x = term->sel_end.x, new_sel_end_y = term->sel_end.y;
 
   /* Buffer for current logical line (unwrapped) */
   u32 logical_cap = 4096;
@@ -846,39 +1014,34 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
     /* Collect consecutive wrapped lines into `logical_line` */
     while (i < total_old_lines) {
       /* Get source row */
-      terminal_cell *src_row;
+      u32 virtual_y = kept_sb + i;
+      u32 row_len;
+      const terminal_cell *src_row = get_row(term, virtual_y, &row_len);
       b32 row_is_cursor = false;
       b32 row_is_sel_start = false;
       b32 row_is_sel_end = false;
 
-      if (i < term->scrollback_count) {
-        u32 idx = (term->scrollback_start + i) % term->scrollback_size;
-        src_row = &term->scrollback[idx * term->cols];
-      } else {
-        u32 screen_y = i - term->scrollback_count;
-        src_row = &term->screen[screen_y * term->cols];
-        if (screen_y == term->cursor_y)
-          row_is_cursor = true;
-      }
+      if (virtual_y >= term->scrollback_count &&
+          virtual_y - term->scrollback_count == term->cursor_y)
+        row_is_cursor = true;
 
       if (term->has_selection) {
-        if (i == term->sel_start.y)
+        if (virtual_y == term->sel_start.y)
           row_is_sel_start = true;
-        if (i == term->sel_end.y)
+        if (virtual_y == term->sel_end.y)
           row_is_sel_end = true;
       }
 
       /* Check wrap on last cell */
-      terminal_cell *last_cell = &src_row[term->cols - 1];
-      b32 is_wrapped = last_cell->attr.wrapped;
+      b32 is_wrapped = row_len > 0 && src_row[row_len - 1].attr.wrapped;
 
       /* Determine copy length */
-      u32 copy_len = term->cols;
+      u32 copy_len = row_len;
 
       if (!is_wrapped) {
         /* Trim empty space from non-wrapped lines */
         while (copy_len > 0) {
-          terminal_cell *c = &src_row[copy_len - 1];
+          const terminal_cell *c = &src_row[copy_len - 1];
           /* Treat NULL or empty space with default BG as empty */
           if (c->codepoint != 0 && c->codepoint != ' ')
             break;
@@ -888,15 +1051,6 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
         }
       }
 
-      /* Expand logical buffer if needed */
-      if (logical_len + copy_len > logical_cap) {
-        logical_cap = (logical_len + copy_len > logical_cap * 2)
-                          ? (logical_len + copy_len + 1024)
-                          : (logical_cap * 2);
-        logical_line =
-            realloc(logical_line, logical_cap * sizeof(terminal_cell));
-      }
-
       /* Coordinate Checks (ensure copy covers coordinate if it was in the
        * whitespace) */
       if (row_is_cursor) {
@@ -918,9 +1072,18 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
         sel_end_offset = logical_len + term->sel_end.x;
       }
 
-      /* Copy to logical */
+      /* Expand logical buffer if needed */
+      if (logical_len + copy_len > logical_cap) {
+        logical_cap = (logical_len + copy_len > logical_cap * 2)
+                          ? (logical_len + copy_len + 1024)
+                          : (logical_cap * 2);
+        logical_line =
+            realloc(logical_line, logical_cap * sizeof(terminal_cell));
+      }
+
+      /* Copy to logical (past a trimmed row's length, blanks) */
       for (u32 k = 0; k < copy_len; k++) {
-        logical_line[logical_len + k] = src_row[k];
+        logical_line[logical_len + k] = k < row_len ? src_row[k] : blank_cell;
         logical_line[logical_len + k].attr.wrapped = 0; /* Clear wrap flag */
       }
       logical_len += copy_len;
@@ -943,6 +1106,11 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
       u32 chunk_len = cols;
       if (processed + chunk_len > logical_len) {
         chunk_len = logical_len - processed;
+      } else if (chunk_len > 1 && processed + chunk_len < logical_len &&
+                 logical_line[processed + chunk_len].codepoint ==
+                     TERM_WIDE_SPACER) {
+        /* Don't split a wide character: move it to the next row */
+        chunk_len--;
       }
 
       /* Allocate New Line */
@@ -961,7 +1129,7 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
       }
 
       /* Set Wrap Flag */
-      if (chunk_len == cols && processed + chunk_len < logical_len) {
+      if (processed + chunk_len < logical_len) {
         new_row[cols - 1].attr.wrapped = 1;
       }
 
@@ -978,7 +1146,7 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
         if (sel_start_offset >= processed &&
             sel_start_offset < processed + chunk_len) {
           new_sel_start_x = sel_start_offset - processed;
-          new_sel_start_y = line_count;
+          new_sel_start_y = kept_sb + line_count;
           sel_start_found = true;
         }
       }
@@ -986,7 +1154,7 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
         if (sel_end_offset >= processed &&
             sel_end_offset < processed + chunk_len) {
           new_sel_end_x = sel_end_offset - processed;
-          new_sel_end_y = line_count;
+          new_sel_end_y = kept_sb + line_count;
           sel_end_found = true;
         }
       }
@@ -1021,38 +1189,16 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
   }
 
   /* === SCROLLBACK === */
-  /* If we have more history than max size, trim top */
-  u32 sb_lines_to_keep = final_sb_count;
-  u32 sb_source_start = 0;
-
-  if (sb_lines_to_keep > term->scrollback_size && term->scrollback_size > 0) {
-    sb_source_start = sb_lines_to_keep - term->scrollback_size;
-    sb_lines_to_keep = term->scrollback_size;
-  }
-
-  /* Reallocate Scrollback Buffer */
-  if (term->scrollback)
-    free(term->scrollback);
-  term->scrollback = NULL;
-
-  if (term->scrollback_size > 0) {
-    term->scrollback =
-        malloc(term->scrollback_size * cols * sizeof(terminal_cell));
-    /* Copy lines into ring buffer (linear fill is fine since we just reset
-     * start=0) */
-    u32 dst_idx = 0;
-    for (u32 k = 0; k < sb_lines_to_keep; k++) {
-      terminal_cell *src = lines[sb_source_start + k].cells;
-      terminal_cell *dst = &term->scrollback[dst_idx * cols];
-      memcpy(dst, src, cols * sizeof(terminal_cell));
-      dst_idx++;
+  /* Replace the reflowed history with the rows that no longer fit on the
+   * screen. Pushing trims them, and drops the oldest lines past the limit. */
+  if (term->scrollback) {
+    Scrollback_DropNewest(term->scrollback, reflow_sb);
+    for (u32 k = 0; k < final_sb_count; k++) {
+      Scrollback_Push(term->scrollback, lines[k].cells, cols);
     }
-    term->scrollback_count = sb_lines_to_keep;
-    term->scrollback_start = 0;
-  } else {
-    term->scrollback_count = 0;
-    term->scrollback_start = 0;
+    term->scrollback_count = term->scrollback->count;
   }
+  u32 dropped = kept_sb + final_sb_count - term->scrollback_count;
 
   /* === SCREEN === */
   /* New Screen Buffer */
@@ -1100,12 +1246,14 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
 
   /* Update selection positions (absolute virtual indices) */
   if (term->has_selection) {
-    /* If either end was lost (not found in current flow), clear selection */
-    if (sel_start_found && sel_end_found) {
+    /* If either end was lost (not found in current flow, or dropped from
+     * history), clear selection */
+    if (sel_start_found && sel_end_found && new_sel_start_y >= dropped &&
+        new_sel_end_y >= dropped) {
       term->sel_start.x = new_sel_start_x;
-      term->sel_start.y = new_sel_start_y;
+      term->sel_start.y = new_sel_start_y - dropped;
       term->sel_end.x = new_sel_end_x;
-      term->sel_end.y = new_sel_end_y;
+      term->sel_end.y = new_sel_end_y - dropped;
     } else {
       term->has_selection = false;
     }
@@ -1137,6 +1285,32 @@ void Terminal_Resize(Terminal *term, u32 cols, u32 rows) {
   term->dirty = true;
 }
 
+void Terminal_SetScrollbackLines(Terminal *term, u32 lines) {
+  if (!term || !term->scrollback)
+    return;
+
+  u32 old_count = term->scrollback_count;
+  Scrollback_SetMaxLines(term->scrollback, lines);
+  term->scrollback_count = term->scrollback->count;
+
+  u32 dropped = old_count - term->scrollback_count;
+  if (dropped == 0)
+    return;
+
+  if (term->has_selection) {
+    if (term->sel_start.y >= dropped && term->sel_end.y >= dropped) {
+      term->sel_start.y -= dropped;
+      term->sel_end.y -= dropped;
+    } else {
+      term->has_selection = false;
+      term->is_selecting = false;
+    }
+  }
+  if (term->scroll_offset > (i32)term->scrollback_count)
+    term->scroll_offset = (i32)term->scrollback_count;
+  term->dirty = true;
+}
+
 void Terminal_Write(Terminal *term, const char *data, u32 size) {
   if (!term || !term->pty || !data || size == 0)
     return;
@@ -1217,6 +1391,19 @@ void Terminal_Scroll(Terminal *term, i32 lines) {
   term->dirty = true;
 }
 
+void Terminal_ScrollToLine(Terminal *term, u32 line) {
+  if (!term)
+    return;
+
+  i32 top = (i32)term->scrollback_count - term->scroll_offset;
+  if ((i32)line >= top && (i32)line < top + (i32)term->rows)
+    return;
+
+  term->scroll_offset = 0;
+  Terminal_Scroll(term, (i32)term->scrollback_count - (i32)line +
+                            (i32)term->rows / 2);
+}
+
 const terminal_cell *Terminal_GetCell(Terminal *term, u32 x, u32 y) {
   if (!term || x >= term->cols || y >= term->rows)
     return NULL;
@@ -1233,20 +1420,11 @@ const terminal_cell *Terminal_GetCell(Terminal *term, u32 x, u32 y) {
     return NULL;
   }
 
-  if (virtual_line < (i32)term->scrollback_count) {
-    /* Line is in scrollback */
-    u32 actual_line =
-        (term->scrollback_start + virtual_line) % term->scrollback_size;
-    return &term->scrollback[actual_line * term->cols + x];
-  } else {
-    /* Line is in screen */
-    u32 screen_y = (u32)(virtual_line - (i32)term->scrollback_count);
-    if (screen_y < term->rows) {
-      return &term->screen[screen_y * term->cols + x];
-    }
-  }
-
-  return NULL;
+  u32 len;
+  const terminal_cell *row = get_row(term, (u32)virtual_line, &len);
+  if (!row)
+    return NULL;
+  return x < len ? &row[x] : &blank_cell;
 }
 
 b32 Terminal_IsCursorAt(Terminal *term, u32 x, u32 y) {
@@ -1356,6 +1534,9 @@ const char *Terminal_GetCurrentLine(Terminal *term) {
     terminal_cell *cell = &term->screen[y * term->cols + x];
     u32 cp = cell->codepoint;
 
+    if (cp == TERM_WIDE_SPACER)
+      continue;
+
     if (cp == 0 || (cp == ' ' && len == 0)) {
       /* Skip leading spaces and nulls (only if at start of input) */
       if (len == 0)
@@ -1363,15 +1544,9 @@ const char *Terminal_GetCurrentLine(Terminal *term) {
       /* Otherwise fallthrough to add space */
     }
 
-    /* Add character to buffer (simple conversion) */
-    if (len < sizeof(term->current_line) - 1) {
-      if (cp < 128) {
-        term->current_line[len++] = (char)cp;
-      } else {
-        /* Replace non-ASCII with ? for now to keep length correct/safe */
-        /* TODO: Real UTF-8 would be better but requires more logic */
-        term->current_line[len++] = '?';
-      }
+    /* Add character to buffer as UTF-8 */
+    if (len + 4 < sizeof(term->current_line)) {
+      len += (u32)Text_UTF8Encode(cp, term->current_line + len);
     }
   }
 
@@ -1520,44 +1695,22 @@ char *Terminal_GetSelectionText(Terminal *term) {
       x_end = term->cols - 1;
 
     /* Get line data */
-    const terminal_cell *row_data = NULL;
-    if (y < term->scrollback_count) {
-      u32 idx = (term->scrollback_start + y) % term->scrollback_size;
-      row_data = &term->scrollback[idx * term->cols];
-    } else {
-      u32 screen_y = y - term->scrollback_count;
-      if (screen_y < term->rows) {
-        row_data = &term->screen[screen_y * term->cols];
-      }
-    }
-
+    u32 row_len;
+    const terminal_cell *row_data = get_row(term, y, &row_len);
     if (!row_data)
       continue;
 
-    b32 line_wrapped = row_data[term->cols - 1].attr.wrapped;
+    b32 line_wrapped = row_len > 0 && row_data[row_len - 1].attr.wrapped;
 
     /* Extract text from cells */
     for (u32 x = x_start; x <= x_end; x++) {
-      u32 cp = row_data[x].codepoint;
+      u32 cp = x < row_len ? row_data[x].codepoint : ' ';
+      if (cp == TERM_WIDE_SPACER)
+        continue;
       if (cp == 0)
         cp = ' ';
 
-      /* Simple UTF-8 encoding */
-      if (cp < 0x80) {
-        buffer[len++] = (char)cp;
-      } else if (cp < 0x800) {
-        buffer[len++] = (char)(0xC0 | (cp >> 6));
-        buffer[len++] = (char)(0x80 | (cp & 0x3F));
-      } else if (cp < 0x10000) {
-        buffer[len++] = (char)(0xE0 | (cp >> 12));
-        buffer[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
-        buffer[len++] = (char)(0x80 | (cp & 0x3F));
-      } else {
-        buffer[len++] = (char)(0xF0 | (cp >> 18));
-        buffer[len++] = (char)(0x80 | ((cp >> 12) & 0x3F));
-        buffer[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
-        buffer[len++] = (char)(0x80 | (cp & 0x3F));
-      }
+      len += (usize)Text_UTF8Encode(cp, buffer + len);
     }
 
     /* Add newline if not end of selection AND not wrapped line */
@@ -44,8 +44,13 @@ typedef struct {
   cell_attr attr; /* Visual attributes */
 } terminal_cell;
 
+/* Codepoint of the cell right of a wide (two-column) character. It draws
+ * nothing and is skipped when text is extracted. */
+#define TERM_WIDE_SPACER 0xFFFFFFFFu
+
 /* Terminal scroll buffer configuration */
-#define TERMINAL_SCROLLBACK_LINES 1000
+#define TERMINAL_SCROLLBACK_LINES 10000 /* Until set from config */
+#define TERMINAL_REFLOW_LINES 1000      /* Newest history rewrapped on resize */
 
 typedef struct Terminal Terminal;
 
@@ -55,11 +60,10 @@ struct Terminal {
   u32 cols;
   u32 rows;
 
-  /* Scrollback buffer (ring buffer of lines) */
-  terminal_cell *scrollback;
-  u32 scrollback_size;  /* Number of lines in scrollback */
-  u32 scrollback_start; /* Start index in ring buffer */
-  u32 scrollback_count; /* Number of valid lines */
+  /* Scrollback (paged and packed, see scrollback.h). Lines keep the width
+   * they scrolled off at, trimmed of trailing blanks. */
+  struct Scrollback *scrollback;
+  u32 scrollback_count; /* Number of valid lines (mirrors scrollback->count) */
 
   /* Scroll offset (0 = at bottom, showing live output) */
   i32 scroll_offset;
@@ -86,10 +90,12 @@ struct Terminal {
 
   /* Read thread for PTY (per user feedback) */
   pthread_t read_thread;
-  pthread_mutex_t buffer_mutex;
   b32 thread_running;
 
-  /* Ring buffer for incoming data from read thread */
+  /* Single-producer/single-consumer ring for incoming data: the read thread
+   * only advances read_head, Terminal_Update only read_tail, so neither
+   * takes a lock. Both count bytes (wrapping at 2^32) rather than index the
+   * buffer, whose size is a power of two. */
   char *read_buffer;
   u32 read_buffer_size;
   u32 read_head;
@@ -133,6 +139,9 @@ void Terminal_Update(Terminal *term);
 /* Resize terminal to new dimensions */
 void Terminal_Resize(Terminal *term, u32 cols, u32 rows);
 
+/* Set how many lines of scrollback to keep, dropping the oldest past it */
+void Terminal_SetScrollbackLines(Terminal *term, u32 lines);
+
 /* Write keyboard input to terminal */
 void Terminal_Write(Terminal *term, const char *data, u32 size);
 
@@ -142,7 +151,12 @@ void Terminal_SendKey(Terminal *term, u32 keycode, u32 modifiers);
 /* Scroll by given number of lines (positive = up, negative = down) */
 void Terminal_Scroll(Terminal *term, i32 lines);
 
-/* Get cell at given position (handles scroll offset) */
+/* Scroll so virtual line 'line' (0 = oldest scrollback line) is in view,
+ * centering it if it wasn't */
+void Terminal_ScrollToLine(Terminal *term, u32 line);
+
+/* Get cell at given position (handles scroll offset). Valid until the
+ * next call for another row. */
 const terminal_cell *Terminal_GetCell(Terminal *term, u32 x, u32 y);
 
 /* Check if cursor should be visible at given position */
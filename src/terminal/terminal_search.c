@@ -0,0 +1,405 @@
+/*
+ * terminal_search.c - Incremental terminal search implementation
+ *
+ * Text is searched a block at a time: a scrollback page (up to
+ * SCROLLBACK_PAGE_LINES lines, from Scrollback_GetText) or as many screen
+ * rows. A match may run across wrapped rows but not across blocks.
+ * C99, handmade hero style.
+ */
+
+#include "terminal_search.h"
+#include "../core/byte_scan.h"
+#include "../core/text.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TERMINAL_SEARCH_LINE_END 0xFFFFFFFFu /* pos_byte past a line's text */
+
+/* ===== Internal Helpers ===== */
+
+static u64 TerminalSearch_FirstId(Terminal *term) {
+  return term->scrollback ? term->scrollback->first_id : 0;
+}
+
+static u32 TerminalSearch_LineCount(Terminal *term) {
+  return term->scrollback_count + term->rows;
+}
+
+/* Cells of virtual line 'line' and how many there are */
+static const terminal_cell *TerminalSearch_Row(Terminal *term, u32 line,
+                                               u32 *out_length) {
+  if (line < term->scrollback_count) {
+    return Scrollback_GetLine(term->scrollback, line, out_length);
+  }
+  *out_length = term->cols;
+  return &term->screen[(line - term->scrollback_count) * term->cols];
+}
+
+static b32 TerminalSearch_RowWraps(Terminal *term, u32 line) {
+  u32 length;
+  const terminal_cell *cells = TerminalSearch_Row(term, line, &length);
+  return length > 0 && cells[length - 1].attr.wrapped;
+}
+
+static b32 TerminalSearch_Reserve(TerminalSearch *search, usize bytes) {
+  if (bytes <= search->text_capacity)
+    return true;
+  usize capacity = Max(search->text_capacity * 2, bytes);
+  u8 *grown = realloc(search->text, capacity);
+  if (!grown)
+    return false;
+  search->text = grown;
+  search->text_capacity = capacity;
+  return true;
+}
+
+/* The block of text holding virtual line 'line' */
+static void TerminalSearch_GetBlock(TerminalSearch *search, Terminal *term,
+                                    u32 line, ScrollbackText *out) {
+  if (line < term->scrollback_count) {
+    Scrollback_GetText(term->scrollback, line, out);
+    return;
+  }
+
+  u32 screen_y = line - term->scrollback_count;
+  u32 first_y = screen_y - screen_y % SCROLLBACK_PAGE_LINES;
+  u32 count = Min(term->rows - first_y, (u32)SCROLLBACK_PAGE_LINES);
+
+  out->text = NULL;
+  out->first = term->scrollback_count + first_y;
+  out->line_count = 0;
+  out->starts[0] = 0;
+  if (!TerminalSearch_Reserve(search, count * SCROLLBACK_TEXT_BOUND(term->cols)))
+    return;
+
+  u32 size = 0;
+  for (u32 i = 0; i < count; i++) {
+    out->starts[i] = size;
+    size += Scrollback_EncodeText(&term->screen[(first_y + i) * term->cols],
+                                  term->cols, search->text + size);
+  }
+  out->starts[count] = size;
+  out->line_count = count;
+  out->text = search->text;
+}
+
+/* Offset of the first (or last) match starting in text[lo, hi), -1 if
+ * there is none */
+static isize TerminalSearch_FindIn(TerminalSearch *search, const u8 *text,
+                                   usize size, usize lo, usize hi, b32 last) {
+  if (lo >= hi)
+    return -1;
+
+  usize end = Min(hi - 1 + search->pattern_len, size);
+  isize found = -1;
+  usize at = lo;
+  while (at < hi) {
+    isize offset = ByteScan_FindLiteral(text + at, end - at, search->pattern,
+                                        search->pattern_len,
+                                        search->ignore_case);
+    if (offset < 0)
+      break;
+    found = (isize)at + offset;
+    if (!last)
+      break;
+    at = (usize)found + 1;
+  }
+  return found;
+}
+
+/* Byte offset of a position within a block line, clamped to its text */
+static usize TerminalSearch_BlockOffset(const ScrollbackText *block, u32 index,
+                                        u32 byte) {
+  u32 length = block->starts[index + 1] - block->starts[index];
+  return block->starts[index] + Min(byte, length);
+}
+
+/* The query as line text: each character UTF-8 encoded, wide ones followed
+ * by the spacer byte their second cell encodes as, zero-width ones dropped
+ * as the terminal drops them */
+static void TerminalSearch_EncodePattern(TerminalSearch *search) {
+  const char *query = search->query;
+  usize length = strlen(query);
+  usize at = 0;
+
+  search->pattern_len = 0;
+  search->ignore_case = true;
+  while (at < length) {
+    u32 codepoint;
+    at += (usize)Text_UTF8Decode(query + at, length - at, &codepoint);
+
+    i32 columns = 1;
+    if (codepoint >= 0x80) {
+      columns = Text_CodepointColumns(codepoint);
+    } else if (codepoint >= 'A' && codepoint <= 'Z') {
+      search->ignore_case = false;
+    }
+    if (columns == 0)
+      continue;
+
+    u8 *out = search->pattern + search->pattern_len;
+    search->pattern_len += (usize)Text_UTF8Encode(codepoint, (char *)out);
+    if (columns == 2) {
+      search->pattern[search->pattern_len++] = 0xFF;
+    }
+  }
+}
+
+/* Where a search starts without a current match: after the last visible
+ * row going older, at the first one going newer */
+static void TerminalSearch_FromView(TerminalSearch *search, Terminal *term) {
+  u64 top = TerminalSearch_FirstId(term) + term->scrollback_count -
+            (u64)term->scroll_offset;
+  if (search->older) {
+    search->pos_id = top + term->rows - 1;
+    search->pos_byte = TERMINAL_SEARCH_LINE_END;
+  } else {
+    search->pos_id = top;
+    search->pos_byte = 0;
+  }
+}
+
+static void TerminalSearch_Begin(TerminalSearch *search, Terminal *term) {
+  search->start_id = search->pos_id;
+  search->start_byte = search->pos_byte;
+  search->running = true;
+  search->wrapped = false;
+  search->failed = false;
+  search->has_match = false;
+  TerminalSearch_Update(search, term);
+}
+
+/* ===== Public API ===== */
+
+void TerminalSearch_Reset(TerminalSearch *search) {
+  free(search->marks);
+  free(search->row_starts);
+  free(search->text);
+  memset(search, 0, sizeof(TerminalSearch));
+}
+
+void TerminalSearch_SetQuery(TerminalSearch *search, Terminal *term,
+                             const char *query) {
+  strncpy(search->query, query, sizeof(search->query) - 1);
+  search->query[sizeof(search->query) - 1] = '\0';
+  TerminalSearch_EncodePattern(search);
+
+  if (search->pattern_len == 0) {
+    search->running = false;
+    search->failed = false;
+    search->has_match = false;
+    return;
+  }
+
+  /* From the current match, inclusive: it stays if it still matches */
+  search->older = true;
+  if (search->has_match) {
+    search->pos_id = search->match_id;
+    search->pos_byte = search->match_byte + 1;
+  } else {
+    TerminalSearch_FromView(search, term);
+  }
+  TerminalSearch_Begin(search, term);
+}
+
+void TerminalSearch_Next(TerminalSearch *search, Terminal *term, b32 older) {
+  if (search->pattern_len == 0)
+    return;
+
+  search->older = older;
+  if (search->has_match) {
+    search->pos_id = search->match_id;
+    search->pos_byte = older ? search->match_byte : search->match_byte + 1;
+  } else {
+    TerminalSearch_FromView(search, term);
+  }
+  TerminalSearch_Begin(search, term);
+}
+
+b32 TerminalSearch_Update(TerminalSearch *search, Terminal *term) {
+  if (!search->running)
+    return false;
+
+  u64 first_id = TerminalSearch_FirstId(term);
+  u32 total = TerminalSearch_LineCount(term);
+  usize scanned = 0;
+  ScrollbackText block;
+
+  while (scanned < TERMINAL_SEARCH_CHUNK) {
+    /* Lines may have been dropped or added since the last update */
+    u32 line = 0;
+    u32 byte = 0;
+    if (search->pos_id >= first_id + total) {
+      line = total - 1;
+      byte = TERMINAL_SEARCH_LINE_END;
+    } else if (search->pos_id >= first_id) {
+      line = (u32)(search->pos_id - first_id);
+      byte = search->pos_byte;
+    }
+
+    TerminalSearch_GetBlock(search, term, line, &block);
+    u32 block_end = block.first + block.line_count;
+    if (block_end <= line) {
+      block_end = line + 1; /* No text (damaged page): step over the line */
+    }
+    usize size = block.starts[block.line_count];
+
+    /* Back where the search began: only what is left of this block */
+    b32 at_start = search->wrapped && search->start_id >= first_id &&
+                   search->start_id >= first_id + block.first &&
+                   search->start_id < first_id + block_end;
+
+    if (block.text) {
+      usize pos = TerminalSearch_BlockOffset(&block, line - block.first, byte);
+      usize start = 0;
+      if (at_start) {
+        start = TerminalSearch_BlockOffset(
+            &block, (u32)(search->start_id - first_id) - block.first,
+            search->start_byte);
+      }
+
+      usize lo = search->older ? (at_start ? start : 0) : pos;
+      usize hi = search->older ? pos : (at_start ? start : size);
+      isize found =
+          TerminalSearch_FindIn(search, block.text, size, lo, hi, search->older);
+      scanned += hi > lo ? hi - lo : 0;
+
+      if (found >= 0) {
+        u32 index = 0;
+        while (block.starts[index + 1] <= (usize)found) {
+          index++;
+        }
+        search->running = false;
+        search->has_match = true;
+        search->match_id = first_id + block.first + index;
+        search->match_byte = (u32)((usize)found - block.starts[index]);
+        Terminal_ScrollToLine(term, block.first + index);
+        return false;
+      }
+    }
+
+    if (at_start) {
+      search->running = false;
+      search->failed = true;
+      return false;
+    }
+
+    /* On to the next block, around the end once */
+    b32 at_end = search->older ? block.first == 0 : block_end >= total;
+    if (at_end) {
+      if (search->wrapped) {
+        search->running = false;
+        search->failed = true;
+        return false;
+      }
+      search->wrapped = true;
+    }
+
+    if (search->older) {
+      search->pos_id = first_id + (at_end ? total : block.first) - 1;
+      search->pos_byte = TERMINAL_SEARCH_LINE_END;
+    } else {
+      search->pos_id = first_id + (at_end ? 0 : block_end);
+      search->pos_byte = 0;
+    }
+  }
+  return true;
+}
+
+const u8 *TerminalSearch_MarkViewport(TerminalSearch *search, Terminal *term) {
+  if (search->pattern_len == 0)
+    return NULL;
+
+  u32 cols = term->cols;
+  u32 rows = term->rows;
+  if (cols * rows > search->marks_capacity) {
+    u8 *grown = realloc(search->marks, cols * rows);
+    if (!grown)
+      return NULL;
+    search->marks = grown;
+    search->marks_capacity = cols * rows;
+  }
+  memset(search->marks, TERMINAL_SEARCH_MARK_NONE, cols * rows);
+
+  /* The visible rows, widened to whole logical lines (within reason) */
+  u32 total = TerminalSearch_LineCount(term);
+  u32 top = term->scrollback_count - (u32)term->scroll_offset;
+  u32 bottom = Min(top + rows, total) - 1;
+  u32 first = top;
+  u32 last = bottom;
+  while (first > 0 && top - first < TERMINAL_SEARCH_CONTEXT_ROWS &&
+         TerminalSearch_RowWraps(term, first - 1)) {
+    first--;
+  }
+  while (last + 1 < total && last - bottom < TERMINAL_SEARCH_CONTEXT_ROWS &&
+         TerminalSearch_RowWraps(term, last)) {
+    last++;
+  }
+
+  u32 count = last - first + 1;
+  if (count + 1 > search->row_capacity) {
+    u32 *grown = realloc(search->row_starts, (count + 1) * sizeof(u32));
+    if (!grown)
+      return search->marks;
+    search->row_starts = grown;
+    search->row_capacity = count + 1;
+  }
+
+  u32 size = 0;
+  for (u32 i = 0; i < count; i++) {
+    u32 length;
+    const terminal_cell *cells = TerminalSearch_Row(term, first + i, &length);
+    if (!TerminalSearch_Reserve(search, size + SCROLLBACK_TEXT_BOUND(length)))
+      return search->marks;
+    search->row_starts[i] = size;
+    size += Scrollback_EncodeText(cells, length, search->text + size);
+  }
+  search->row_starts[count] = size;
+
+  const u8 *text = search->text;
+  u64 first_id = TerminalSearch_FirstId(term);
+  u32 row = 0;
+  usize at = 0;
+  for (;;) {
+    isize offset = ByteScan_FindLiteral(text + at, size - at, search->pattern,
+                                        search->pattern_len,
+                                        search->ignore_case);
+    if (offset < 0)
+      break;
+    u32 match = (u32)(at + (usize)offset);
+    at = match + 1;
+
+    while (search->row_starts[row + 1] <= match) {
+      row++;
+    }
+    b32 current = search->has_match &&
+                  search->match_id == first_id + first + row &&
+                  search->match_byte == match - search->row_starts[row];
+    u8 mark = current ? TERMINAL_SEARCH_MARK_CURRENT : TERMINAL_SEARCH_MARK_MATCH;
+
+    /* Cells start at every byte but UTF-8 continuations */
+    u32 cell = 0;
+    for (u32 b = search->row_starts[row]; b < match; b++) {
+      cell += (text[b] & 0xC0) != 0x80;
+    }
+
+    u32 cell_row = row;
+    for (u32 b = match; b < match + search->pattern_len; b++) {
+      while (search->row_starts[cell_row + 1] <= b) {
+        cell_row++;
+        cell = 0;
+      }
+      if (text[b] == '\n' || (text[b] & 0xC0) == 0x80)
+        continue;
+
+      u32 y = first + cell_row;
+      if (y >= top && y <= bottom && cell < cols) {
+        u8 *slot = &search->marks[(y - top) * cols + cell];
+        *slot = Max(*slot, mark);
+      }
+      cell++;
+    }
+  }
+  return search->marks;
+}
@@ -0,0 +1,88 @@
+/*
+ * terminal_search.h - Incremental search over terminal scrollback and screen
+ *
+ * The query is matched against line text as Scrollback_EncodeText writes
+ * it, with the vectorized literal finder: packed scrollback pages are
+ * scanned in place, a page at a time, and only the screen and the newest
+ * page are encoded first. Each update scans a bounded amount of text so
+ * the UI stays responsive on very long scrollbacks.
+ * C99, handmade hero style.
+ */
+
+#ifndef TERMINAL_SEARCH_H
+#define TERMINAL_SEARCH_H
+
+#include "../core/types.h"
+#include "scrollback.h"
+#include "terminal.h"
+
+/* Configuration */
+#define TERMINAL_SEARCH_MAX_QUERY 256
+#define TERMINAL_SEARCH_CHUNK Megabytes(8) /* Text scanned per update */
+#define TERMINAL_SEARCH_CONTEXT_ROWS 64 /* Wrapped rows looked past the view */
+
+/* Viewport cell marks */
+#define TERMINAL_SEARCH_MARK_NONE 0
+#define TERMINAL_SEARCH_MARK_MATCH 1
+#define TERMINAL_SEARCH_MARK_CURRENT 2
+
+/* Lines are named by id (Scrollback first_id + virtual line) so a search
+ * keeps its place while output scrolls. A position is a line id and a byte
+ * offset into that line's text. */
+typedef struct {
+  char query[TERMINAL_SEARCH_MAX_QUERY]; /* As typed, UTF-8 */
+  /* In line text form. At most 3 bytes per query byte: an invalid byte
+   * becomes U+FFFD, a wide character gains a spacer byte. */
+  u8 pattern[TERMINAL_SEARCH_MAX_QUERY * 3];
+  usize pattern_len;
+  b32 ignore_case; /* The query has no uppercase letters */
+
+  /* Scan in progress: older looks for the last match starting before pos,
+   * newer for the first one starting at or after it, wrapping around at
+   * either end until it comes back to start */
+  b32 running;
+  b32 older;
+  b32 wrapped;
+  b32 failed;
+  u64 start_id;
+  u32 start_byte;
+  u64 pos_id;
+  u32 pos_byte;
+
+  b32 has_match;
+  u64 match_id;
+  u32 match_byte;
+
+  /* TERMINAL_SEARCH_MARK_* per viewport cell, from
+   * TerminalSearch_MarkViewport */
+  u8 *marks;
+  u32 marks_capacity;
+
+  /* Encoded screen rows and viewport text, and where each viewport row's
+   * text starts */
+  u8 *text;
+  usize text_capacity;
+  u32 *row_starts;
+  u32 row_capacity;
+} TerminalSearch;
+
+/* Free buffers and forget the query */
+void TerminalSearch_Reset(TerminalSearch *search);
+
+/* Search for a new query (UTF-8), from the current match if there is one
+ * (so typing more narrows it in place) or from the bottom of the view */
+void TerminalSearch_SetQuery(TerminalSearch *search, Terminal *term,
+                             const char *query);
+
+/* Move to the next match toward older (or newer) output */
+void TerminalSearch_Next(TerminalSearch *search, Terminal *term, b32 older);
+
+/* Scan up to TERMINAL_SEARCH_CHUNK bytes of text. When a match is found the
+ * terminal scrolls to it. Returns true while the scan is still running. */
+b32 TerminalSearch_Update(TerminalSearch *search, Terminal *term);
+
+/* Mark the matches in the terminal's viewport: search->marks[y * cols + x]
+ * for each visible cell, NULL when there is no query */
+const u8 *TerminalSearch_MarkViewport(TerminalSearch *search, Terminal *term);
+
+#endif /* TERMINAL_SEARCH_H */
@@ -25,6 +25,14 @@ void PTY_Destroy(PTY *pty);
 /* Read from PTY (non-blocking, returns bytes read or 0 if no data) */
 i32 PTY_Read(PTY *pty, char *buffer, u32 size);
 
+/* Block until output is ready to read (or the child has hung up). Returns
+ * false once PTY_Interrupt has been called. */
+b32 PTY_WaitForOutput(PTY *pty);
+
+/* Wake a thread blocked in PTY_WaitForOutput for good, e.g. to stop it
+ * before PTY_Destroy. Safe to call from any thread. */
+void PTY_Interrupt(PTY *pty);
+
 /* Write to PTY (keyboard input from user) */
 i32 PTY_Write(PTY *pty, const char *data, u32 size);
 
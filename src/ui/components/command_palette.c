@@ -6,19 +6,228 @@
  */
 
 #include "command_palette.h"
+#include "../../config/config.h"
+#include "../../core/content_search.h"
+#include "../../core/fuzzy_filter.h"
 #include "../../core/fuzzy_match.h"
 #include "../../core/input.h"
 #include "../../core/text.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* ===== Internal Helpers ===== */
 
-/* Compare palette items by match score (descending) for qsort */
-static int ComparePaletteItemsByScore(const void *a, const void *b) {
-  const palette_item *item_a = (const palette_item *)a;
-  const palette_item *item_b = (const palette_item *)b;
-  return item_b->match_score - item_a->match_score; /* Higher score first */
+/* Score callback for file mode (source is the explorer's entries).
+ * Frequently and recently visited paths get a ranking bonus. */
+static fuzzy_match_result ScoreFileEntry(void *user_data, i32 index,
+                                         const char *query) {
+  command_palette_state *state = (command_palette_state *)user_data;
+  fs_entry *entry = &state->fs->entries[index];
+  fuzzy_match_result result = FuzzyMatchScore(query, entry->name);
+  if (result.matches && state->frecency) {
+    result.score += Frecency_Boost(state->frecency, entry->path);
+  }
+  return result;
+}
+
+/* Count a visit of 'path' for frecency ranking */
+static void RecordVisit(command_palette_state *state, const char *path) {
+  if (state->frecency) {
+    Frecency_Visit(state->frecency, path);
+  }
+}
+
+/* Fill a palette item from a file system entry */
+static void FillItemFromEntry(palette_item *item, fs_entry *entry, i32 score) {
+  memset(item, 0, sizeof(*item));
+  snprintf(item->label, sizeof(item->label), "%s", entry->name);
+  item->icon = entry->icon;
+  item->is_file = true;
+  item->user_data = entry;
+  item->match_score = score;
+}
+
+/* Append content search hits that arrived since the last frame */
+static void AppendSearchHits(command_palette_state *state) {
+  content_search_status status = ContentSearch_GetStatus(&state->search);
+
+  while (state->search_hits_shown < status.hit_count &&
+         state->item_count < PALETTE_MAX_ITEMS) {
+    i32 hit_index = state->search_hits_shown++;
+    content_search_hit hit;
+    char path[FS_MAX_PATH];
+    if (!ContentSearch_GetHit(&state->search, hit_index, &hit, path,
+                              sizeof(path)))
+      break;
+
+    /* Show paths relative to the searched folder */
+    const char *display = path;
+    usize root_len = strlen(state->search.root);
+    if (strncmp(path, state->search.root, root_len) == 0) {
+      display = path + root_len;
+      while (*display == '/' || *display == '\\')
+        display++;
+    }
+
+    palette_item *item = &state->items[state->item_count++];
+    memset(item, 0, sizeof(*item));
+    snprintf(item->label, sizeof(item->label), "%.120s:%u: %.120s", display,
+             hit.line, hit.snippet);
+    item->icon = FS_GetIconType(path, false);
+    item->is_search_hit = true;
+    item->hit_index = hit_index;
+    item->match_score = 0;
+  }
+}
+
+/* Restart the content search for the current '/' query */
+static void StartContentSearch(command_palette_state *state) {
+  state->item_count = 0;
+  state->search_hits_shown = 0;
+  state->search_active = true;
+
+  u64 max_file_bytes =
+      (u64)Max(Config_GetI64("search.max_file_bytes", 16777216), 0);
+
+  /* Optional trigram index narrows the files to scan */
+  if (Config_GetBool("search.index.enabled", false)) {
+    TrigramIndex_Configure(
+        &state->search_index,
+        (u64)Max(Config_GetI64("search.index.max_memory_bytes", 268435456), 0),
+        (u64)Max(Config_GetI64("search.index.max_disk_bytes", 1073741824), 0),
+        max_file_bytes);
+    TrigramIndex_Ensure(&state->search_index, state->fs->current_path);
+    ContentSearch_SetIndex(&state->search, &state->search_index);
+  } else {
+    ContentSearch_SetIndex(&state->search, NULL);
+  }
+
+  ContentSearch_Start(&state->search, state->fs->current_path,
+                      state->input_buffer + 1, max_file_bytes);
+}
+
+static void StopContentSearch(command_palette_state *state) {
+  if (!state->search_active)
+    return;
+  ContentSearch_Cancel(&state->search);
+  state->search_active = false;
+  state->search_hits_shown = 0;
+}
+
+/* Single item for a ':<line>' or ':0x<offset>' query */
+static void PopulateGoToLineItem(command_palette_state *state) {
+  palette_item *item = &state->items[0];
+  const char *digits = state->input_buffer + 1;
+  b32 is_offset = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X');
+  char *end = NULL;
+  unsigned long long value =
+      strtoull(is_offset ? digits + 2 : digits, &end, is_offset ? 16 : 10);
+
+  if (!state->goto_position)
+    return;
+
+  memset(item, 0, sizeof(*item));
+  item->icon = WB_FILE_ICON_UNKNOWN;
+  item->is_goto_line = true;
+  snprintf(item->category, sizeof(item->category), "Preview");
+  state->goto_is_offset = is_offset;
+  state->goto_target = (u64)value;
+  state->goto_valid = end != (is_offset ? digits + 2 : digits) &&
+                      *end == '\0' && (is_offset || value > 0);
+  if (!state->goto_valid) {
+    snprintf(item->label, sizeof(item->label),
+             "Type a line number or 0x offset to jump the preview to");
+  } else if (is_offset) {
+    snprintf(item->label, sizeof(item->label), "Go to offset 0x%llx in preview",
+             value);
+  } else {
+    snprintf(item->label, sizeof(item->label), "Go to line %llu in preview",
+             value);
+  }
+  state->item_count = 1;
+}
+
+static i32 HexDigitValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* Parse "7f 45 4c 46" style hex bytes. Returns the byte count, 0 if the
+ * text is not an even run of hex digits. */
+static usize ParseHexBytes(const char *text, u8 *out, usize out_size) {
+  usize count = 0;
+  i32 high = -1;
+
+  for (; *text; text++) {
+    i32 digit = HexDigitValue(*text);
+    if (*text == ' ') {
+      if (high >= 0)
+        return 0; /* Split byte */
+      continue;
+    }
+    if (digit < 0)
+      return 0;
+    if (high < 0) {
+      high = digit;
+    } else {
+      if (count == out_size)
+        return 0;
+      out[count++] = (u8)((high << 4) | digit);
+      high = -1;
+    }
+  }
+  return high < 0 ? count : 0;
+}
+
+/* Single item for a '#<pattern>' query: hex bytes, or text (quoted to
+ * force a literal, e.g. #"cafe") */
+static void PopulatePreviewFindItem(command_palette_state *state) {
+  palette_item *item = &state->items[0];
+  const char *pattern = state->input_buffer + 1;
+  usize length = 0;
+  b32 is_hex = false;
+
+  if (!state->find_bytes)
+    return;
+
+  if (pattern[0] == '"') {
+    pattern++;
+    length = strlen(pattern);
+    if (length > 0 && pattern[length - 1] == '"')
+      length--;
+  } else {
+    length = ParseHexBytes(pattern, state->find_pattern,
+                           sizeof(state->find_pattern));
+    is_hex = length > 0;
+    if (!is_hex)
+      length = strlen(pattern);
+  }
+  length = Min(length, sizeof(state->find_pattern));
+  if (!is_hex)
+    memcpy(state->find_pattern, pattern, length);
+  state->find_pattern_len = length;
+
+  memset(item, 0, sizeof(*item));
+  item->icon = WB_FILE_ICON_UNKNOWN;
+  item->is_preview_find = true;
+  snprintf(item->category, sizeof(item->category), "Preview");
+  if (length == 0) {
+    snprintf(item->label, sizeof(item->label),
+             "Type hex bytes or \"text\" to find in the preview");
+  } else if (is_hex) {
+    snprintf(item->label, sizeof(item->label), "Find bytes %s in preview",
+             pattern);
+  } else {
+    snprintf(item->label, sizeof(item->label), "Find \"%.*s\" in preview",
+             (int)length, pattern);
+  }
+  state->item_count = 1;
 }
 
 /* Populate items list for file mode */
@@ -28,37 +237,46 @@ static void PopulateFileItems(command_palette_state *state) {
     return;
 
   const char *query = state->input_buffer;
-  b32 has_query = query[0] != '\0';
-
-  for (u32 i = 0;
-       i < state->fs->entry_count && state->item_count < PALETTE_MAX_ITEMS;
-       i++) {
-    fs_entry *entry = &state->fs->entries[i];
-
-    /* Filter by query with scoring */
-    i32 score = 0;
-    if (has_query) {
-      fuzzy_match_result result = FuzzyMatchScore(query, entry->name);
-      if (!result.matches)
-        continue;
-      score = result.score;
-    }
 
-    palette_item *item = &state->items[state->item_count];
-    memset(item, 0, sizeof(*item));
-    snprintf(item->label, sizeof(item->label), "%s", entry->name);
-    item->icon = entry->icon;
-    item->is_file = true;
-    item->user_data = entry;
-    item->match_score = score;
+  if (query[0] == '/') {
+    StartContentSearch(state);
+    return;
+  }
+  StopContentSearch(state);
 
-    state->item_count++;
+  if (query[0] == ':') {
+    PopulateGoToLineItem(state);
+    return;
   }
 
-  /* Sort by score if we have a query */
-  if (has_query && state->item_count > 1) {
-    qsort(state->items, (size_t)state->item_count, sizeof(palette_item),
-          ComparePaletteItemsByScore);
+  if (query[0] == '#') {
+    PopulatePreviewFindItem(state);
+    return;
+  }
+
+  if (query[0] == '\0') {
+    for (u32 i = 0;
+         i < state->fs->entry_count && state->item_count < PALETTE_MAX_ITEMS;
+         i++) {
+      FillItemFromEntry(&state->items[state->item_count++],
+                        &state->fs->entries[i], 0);
+    }
+    return;
+  }
+
+  /* Typing a character only rescores the previous matches */
+  i32 match_count = 0;
+  const fuzzy_candidate *matches = FuzzyFilter_Apply(
+      &state->file_filter, query, (i32)state->fs->entry_count,
+      state->fs->generation, ScoreFileEntry, state, &match_count);
+
+  /* Only the items that fit in the list need to be sorted */
+  fuzzy_candidate ranked[FS_MAX_ENTRIES];
+  i32 sorted = FuzzyFilter_SelectTop(matches, match_count, PALETTE_MAX_ITEMS,
+                                     ranked);
+  for (i32 i = 0; i < sorted; i++) {
+    FillItemFromEntry(&state->items[state->item_count++],
+                      &state->fs->entries[ranked[i].index], ranked[i].score);
   }
 }
 
@@ -78,6 +296,21 @@ static void FillItemFromCommand(palette_item *item, palette_command *cmd,
   item->command_index = cmd_idx;
 }
 
+/* Score callback for command mode: match name OR tags, take highest score */
+static fuzzy_match_result ScoreCommand(void *user_data, i32 index,
+                                       const char *query) {
+  command_palette_state *state = (command_palette_state *)user_data;
+  palette_command *cmd = &state->commands[index];
+
+  fuzzy_match_result name_result = FuzzyMatchScore(query, cmd->name);
+  fuzzy_match_result tags_result = FuzzyMatchScore(query, cmd->tags);
+  if (tags_result.matches &&
+      (!name_result.matches || tags_result.score > name_result.score)) {
+    return tags_result;
+  }
+  return name_result;
+}
+
 /* Populate items list for command mode */
 static void PopulateCommandItems(command_palette_state *state) {
   state->item_count = 0;
@@ -91,8 +324,8 @@ static void PopulateCommandItems(command_palette_state *state) {
 
   b32 empty_query = (query[0] == '\0');
 
-  /* Step 1: Add recently used commands first if query is empty */
   if (empty_query) {
+    /* Step 1: Add recently used commands first */
     for (i32 r = 0; r < state->recent_count; r++) {
       i32 cmd_idx = state->recent_commands[r];
       if (cmd_idx < 0 || cmd_idx >= state->command_count)
@@ -106,14 +339,10 @@ static void PopulateCommandItems(command_palette_state *state) {
       if (state->item_count >= PALETTE_MAX_ITEMS)
         return;
     }
-  }
 
-  /* Step 2: Add matching commands */
-  for (i32 i = 0; i < state->command_count; i++) {
-    palette_command *cmd = &state->commands[i];
-
-    /* If query is empty, skip commands already added in recent list */
-    if (empty_query) {
+    /* Step 2: Add the remaining commands in registration order */
+    for (i32 i = 0; i < state->command_count; i++) {
+      /* Skip commands already added in recent list */
       b32 already_added = false;
       for (i32 r = 0; r < state->recent_count; r++) {
         if (state->recent_commands[r] == i) {
@@ -123,39 +352,34 @@ static void PopulateCommandItems(command_palette_state *state) {
       }
       if (already_added)
         continue;
-    }
-
-    /* Filter by query with scoring */
-    i32 score = 0;
-    if (empty_query) {
-      score = 0; /* No query = no special score */
-    } else {
-      /* Match name OR tags, take highest score */
-      fuzzy_match_result name_result = FuzzyMatchScore(query, cmd->name);
-      fuzzy_match_result tags_result = FuzzyMatchScore(query, cmd->tags);
-      if (name_result.matches) {
-        score = name_result.score;
-      }
-      if (tags_result.matches && tags_result.score > score) {
-        score = tags_result.score;
-      }
-      if (!name_result.matches && !tags_result.matches) {
-        continue; /* No match */
-      }
-    }
 
-    FillItemFromCommand(&state->items[state->item_count], cmd, i, NULL);
-    state->items[state->item_count].match_score = score;
+      FillItemFromCommand(&state->items[state->item_count],
+                          &state->commands[i], i, NULL);
+      state->items[state->item_count].match_score = 0;
 
-    state->item_count++;
-    if (state->item_count >= PALETTE_MAX_ITEMS)
-      break;
+      state->item_count++;
+      if (state->item_count >= PALETTE_MAX_ITEMS)
+        break;
+    }
+    return;
   }
 
-  /* Sort by score if we have a query */
-  if (!empty_query && state->item_count > 1) {
-    qsort(state->items, (size_t)state->item_count, sizeof(palette_item),
-          ComparePaletteItemsByScore);
+  /* Matching commands, best first. Commands are only ever appended, so the
+   * count identifies the source list. */
+  i32 match_count = 0;
+  const fuzzy_candidate *matches =
+      FuzzyFilter_Apply(&state->command_filter, query, state->command_count, 0,
+                        ScoreCommand, state, &match_count);
+
+  fuzzy_candidate ranked[PALETTE_MAX_COMMANDS];
+  i32 sorted = FuzzyFilter_SelectTop(matches, match_count, PALETTE_MAX_ITEMS,
+                                     ranked);
+  for (i32 i = 0; i < sorted; i++) {
+    i32 cmd_idx = ranked[i].index;
+    FillItemFromCommand(&state->items[state->item_count],
+                        &state->commands[cmd_idx], cmd_idx, NULL);
+    state->items[state->item_count].match_score = ranked[i].score;
+    state->item_count++;
   }
 }
 
@@ -166,13 +390,31 @@ static void CommandPalette_ExecuteSelectedItem(command_palette_state *state) {
 
   palette_item *item = &state->items[state->selected_index];
 
-  if (item->is_file) {
+  if (item->is_goto_line) {
+    if (state->goto_valid)
+      state->goto_position(state->preview_user_data, state->goto_target,
+                           state->goto_is_offset);
+  } else if (item->is_preview_find) {
+    if (state->find_pattern_len > 0)
+      state->find_bytes(state->preview_user_data, state->find_pattern,
+                        state->find_pattern_len);
+  } else if (item->is_search_hit) {
+    char path[FS_MAX_PATH];
+    if (ContentSearch_GetHit(&state->search, item->hit_index, NULL, path,
+                             sizeof(path))) {
+      RecordVisit(state, path);
+      Platform_OpenFile(path);
+    }
+  } else if (item->is_file) {
     /* Navigate to file or directory */
     fs_entry *entry = (fs_entry *)item->user_data;
     if (entry) {
       if (entry->is_directory) {
-        FS_LoadDirectory(state->fs, entry->path);
+        if (FS_LoadDirectory(state->fs, entry->path)) {
+          RecordVisit(state, state->fs->current_path);
+        }
       } else {
+        RecordVisit(state, entry->path);
         Platform_OpenFile(entry->path);
       }
     }
@@ -220,6 +462,18 @@ void CommandPalette_Init(command_palette_state *state, fs_state *fs) {
   memset(state, 0, sizeof(*state));
   state->fs = fs;
   state->mode = WB_PALETTE_MODE_CLOSED;
+
+  ContentSearch_Init(&state->search);
+  TrigramIndex_Init(&state->search_index);
+
+  /* Incremental match caches (file storage lives next to the entries) */
+  fuzzy_candidate *file_storage =
+      fs ? ArenaPushArray(fs->arena, fuzzy_candidate,
+                          FS_MAX_ENTRIES * FUZZY_FILTER_MAX_DEPTH)
+         : NULL;
+  FuzzyFilter_Init(&state->file_filter, file_storage, FS_MAX_ENTRIES);
+  FuzzyFilter_Init(&state->command_filter, state->command_filter_storage,
+                   PALETTE_MAX_COMMANDS);
   state->item_height = 28;
   state->selected_index = 0;
 
@@ -237,6 +491,12 @@ void CommandPalette_Init(command_palette_state *state, fs_state *fs) {
   state->scroll.scroll_v.speed = 1500.0f;
 }
 
+void CommandPalette_Shutdown(command_palette_state *state) {
+  ContentSearch_Shutdown(&state->search);
+  TrigramIndex_Shutdown(&state->search_index);
+  state->search_active = false;
+}
+
 void CommandPalette_RegisterCommand(command_palette_state *state,
                                     const char *name, const char *shortcut,
                                     const char *category, const char *tags,
@@ -295,6 +555,7 @@ void CommandPalette_Open(command_palette_state *state, palette_mode mode) {
 }
 
 void CommandPalette_Close(command_palette_state *state) {
+  StopContentSearch(state);
   state->mode = WB_PALETTE_MODE_CLOSED;
   state->fade_anim.target = 0.0f;
   Input_PopFocus();
@@ -308,6 +569,12 @@ b32 CommandPalette_Update(command_palette_state *state, ui_context *ui) {
   /* Always update fade animation (for fade-out when closing) */
   SmoothValue_Update(&state->fade_anim, ui->dt);
 
+  /* Keep the search index's change overlay in sync with the watcher */
+  if (state->fs && state->fs->change_count != state->search_seen_changes) {
+    state->search_seen_changes = state->fs->change_count;
+    TrigramIndex_MarkChanged(&state->search_index, state->fs->current_path);
+  }
+
   if (!CommandPalette_IsOpen(state))
     return false;
 
@@ -316,6 +583,11 @@ b32 CommandPalette_Update(command_palette_state *state, ui_context *ui) {
 
   ui_input *input = &ui->input;
 
+  /* Stream in content search results */
+  if (state->search_active) {
+    AppendSearchHits(state);
+  }
+
   /* Handle escape to close */
   if (input->key_pressed[WB_KEY_ESCAPE]) {
     CommandPalette_Close(state);
@@ -474,8 +746,9 @@ void CommandPalette_Render(command_palette_state *state, ui_context *ui,
     /* Placeholder */
     color placeholder = th->text_muted;
     placeholder.a = (u8)(placeholder.a * fade);
-    const char *hint = state->mode == WB_PALETTE_MODE_FILE ? "Search files..."
-                                                        : "Type a command...";
+    const char *hint = state->mode == WB_PALETTE_MODE_FILE
+                           ? "Search files... (/ contents, : line or 0x offset, # find)"
+                           : "Type a command...";
     Render_DrawText(renderer, text_pos, hint, f, placeholder);
   }
 
@@ -503,6 +776,28 @@ void CommandPalette_Render(command_palette_state *state, ui_context *ui,
     }
   }
 
+  /* Content search progress on the right of the input */
+  if (state->search_active) {
+    content_search_status status = ContentSearch_GetStatus(&state->search);
+    char status_text[128];
+    snprintf(status_text, sizeof(status_text), "%d in %llu files, %llu ms%s%s",
+             status.hit_count, (unsigned long long)status.files_matched,
+             (unsigned long long)status.elapsed_ms,
+             status.used_index ? " indexed"
+             : TrigramIndex_IsBuilding(&state->search_index) ? " (indexing)"
+                                                             : "",
+             status.running     ? " (searching...)"
+             : status.truncated ? " (limit reached)"
+                                : "");
+    v2i status_size = UI_MeasureText(status_text, f);
+    color status_color = th->text_muted;
+    status_color.a = (u8)(status_color.a * fade);
+    Render_DrawText(renderer,
+                    (v2i){input_rect.x + input_rect.w - status_size.x - padding,
+                          text_pos.y},
+                    status_text, f, status_color);
+  }
+
   UI_EndLayout();
 
   /* ===== Separator Line ===== */
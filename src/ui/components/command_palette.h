@@ -3,13 +3,19 @@
  *
  * VSCode-style command palette for quick access to files and commands.
  * Ctrl+P: File search, Ctrl+Shift+P: Command mode (prefix >)
+ * Typing '/' in file mode searches file contents below the current folder,
+ * ':' followed by a number jumps the preview to that line (0x for a byte
+ * offset) and '#' followed by hex bytes or text finds them in the preview.
  * C99, handmade hero style.
  */
 
 #ifndef COMMAND_PALETTE_H
 #define COMMAND_PALETTE_H
 
+#include "../../core/content_search.h"
+#include "../../core/frecency.h"
 #include "../../core/fs.h"
+#include "../../core/fuzzy_filter.h"
 #include "../ui.h"
 
 /* ===== Configuration ===== */
@@ -19,6 +25,7 @@
 #define PALETTE_MAX_COMMANDS 64
 #define PALETTE_MAX_SHORTCUT 32
 #define PALETTE_MAX_RECENT_COMMANDS 2
+#define PALETTE_MAX_FIND_PATTERN 128
 
 /* ===== Types ===== */
 
@@ -41,6 +48,10 @@ typedef struct {
   command_callback callback;
   void *user_data;
   b32 is_file;
+  b32 is_search_hit; /* Content search result */
+  b32 is_goto_line;  /* ':<line>' or ':0x<offset>' entry, jumps to goto_target */
+  b32 is_preview_find; /* '#<bytes>' entry, searches for find_pattern */
+  i32 hit_index;     /* Index into the content search hits */
   i32 command_index; /* Index into registered commands array */
   i32 match_score;   /* Fuzzy match score for sorting (higher = better) */
 } palette_item;
@@ -88,6 +99,33 @@ typedef struct {
   /* File system reference (for file search) */
   fs_state *fs;
 
+  /* Visit history (set by the owner), boosts frequently used files */
+  frecency_db *frecency;
+
+  /* Preview hooks, set by the owner: line or offset jump (':' prefix in
+   * file mode) and byte search ('#' prefix) */
+  void (*goto_position)(void *user_data, u64 value, b32 is_offset);
+  void (*find_bytes)(void *user_data, const u8 *pattern, usize length);
+  void *preview_user_data;
+  b32 goto_valid;
+  b32 goto_is_offset;
+  u64 goto_target;
+  u8 find_pattern[PALETTE_MAX_FIND_PATTERN];
+  usize find_pattern_len;
+
+  /* Cached match sets per query (incremental refinement) */
+  fuzzy_filter file_filter;
+  fuzzy_filter command_filter;
+  fuzzy_candidate
+      command_filter_storage[PALETTE_MAX_COMMANDS * FUZZY_FILTER_MAX_DEPTH];
+
+  /* Content search ('/' prefix in file mode) */
+  content_search_state search;
+  b32 search_active;
+  i32 search_hits_shown; /* Hits already turned into items */
+  trigram_index search_index;
+  u32 search_seen_changes; /* fs->change_count reported to the index */
+
   /* Cached dimensions */
   i32 item_height;
   rect panel_bounds;
@@ -98,6 +136,9 @@ typedef struct {
 /* Initialize palette state */
 void CommandPalette_Init(command_palette_state *state, fs_state *fs);
 
+/* Stop background work (content search workers, index builds) */
+void CommandPalette_Shutdown(command_palette_state *state);
+
 /* Register a command */
 void CommandPalette_RegisterCommand(command_palette_state *state,
                                     const char *name, const char *shortcut,
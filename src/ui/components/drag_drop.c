@@ -98,8 +98,11 @@ void DragDrop_BeginPotential(drag_drop_state *state, fs_state *fs,
       drag_item *item = &state->items[state->item_count];
       strncpy(item->path, entry->path, FS_MAX_PATH - 1);
       item->path[FS_MAX_PATH - 1] = '\0';
-      strncpy(item->name, entry->name, FS_MAX_NAME - 1);
-      item->name[FS_MAX_NAME - 1] = '\0';
+      /* The file's own name: recursive filter results show a path */
+      const char *name = FS_GetFilename(entry->path);
+      usize name_len = Min(strlen(name), sizeof(item->name) - 1);
+      memcpy(item->name, name, name_len);
+      item->name[name_len] = '\0';
       item->icon = entry->icon;
       item->is_directory = entry->is_directory;
       item->size = entry->size;
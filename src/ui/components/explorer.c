@@ -6,10 +6,12 @@
 
 #include "explorer.h"
 #include "../../config/config.h"
+#include "../../core/fuzzy_filter.h"
 #include "../../core/fuzzy_match.h"
 #include "../../core/input.h"
 #include "../../core/text.h"
 #include "../../core/theme.h"
+#include "../../core/zip_archive.h"
 #include "../layout.h"
 #include "breadcrumb.h"
 #include "context_menu.h"
@@ -31,122 +33,256 @@
 #define EXPLORER_SCROLLBAR_WIDTH 6
 #define EXPLORER_SCROLLBAR_GUTTER 12
 #define EXPLORER_SCROLLBAR_OFFSET 8
+#define EXPLORER_FILTER_TOP_K 128 /* Filter matches fully sorted by score */
+#define EXPLORER_TILE_PADDING 6     /* Around the thumbnail (see file_item.c) */
+#define EXPLORER_TILE_GAP 4
 
 /* ===== Visibility Helpers ===== */
 
+/* Hidden files are those starting with '.' (".." is always shown) */
+static b32 Explorer_PassesHiddenFilter(explorer_state *state,
+                                       fs_entry *entry) {
+  if (strcmp(entry->name, "..") == 0)
+    return true;
+  return state->show_hidden || entry->name[0] != '.';
+}
+
+/* Get the part of the quick filter query used to match file names.
+ * Returns NULL when nothing should be filtered out:
+ * - Filter inactive or empty
+ * - Just "~" (navigating to home, show all files)
+ * - Just "/" (navigating to root, show all files)
+ * - Path ending with separator (user is still typing path)
+ */
+static const char *Explorer_GetMatchQuery(explorer_state *state) {
+  if (!QuickFilter_IsActive(&state->filter))
+    return NULL;
+
+  const char *query = QuickFilter_GetQuery(&state->filter);
+  if (query[0] == '\0' || (query[0] == '~' && query[1] == '\0') ||
+      (query[0] == '/' && query[1] == '\0')) {
+    return NULL;
+  }
+
+  /* Use only the part after the last separator for matching filenames */
+  const char *last_sep = FS_FindLastSeparator(query);
+  const char *match_query = last_sep ? last_sep + 1 : query;
+  return match_query[0] != '\0' ? match_query : NULL;
+}
+
 /* Check if an entry at the given index should be visible */
 static b32 Explorer_IsEntryVisible(explorer_state *state, i32 index) {
   fs_entry *entry = FS_GetEntry(&state->fs, index);
   if (!entry)
     return false;
 
+  if (!Explorer_PassesHiddenFilter(state, entry))
+    return false;
+
   /* ".." is always visible */
   if (strcmp(entry->name, "..") == 0)
     return true;
 
-  /* Hidden files are those starting with '.' */
-  if (!state->show_hidden && entry->name[0] == '.') {
+  /* Apply quick filter if active */
+  const char *match_query = Explorer_GetMatchQuery(state);
+  if (match_query && !FuzzyMatch(match_query, entry->name))
     return false;
-  }
 
-  /* Apply quick filter if active */
-  if (QuickFilter_IsActive(&state->filter)) {
-    const char *query = QuickFilter_GetQuery(&state->filter);
+  return true;
+}
 
-    /* Skip filtering for pure navigation prefixes:
-     * - Just "~" (navigating to home, show all files)
-     * - Just "/" (navigating to root, show all files)
-     * - Path ending with separator (user is still typing path)
-     */
-    if (query[0] == '\0' ||
-        (query[0] == '~' && query[1] == '\0') ||
-        (query[0] == '/' && query[1] == '\0')) {
-      /* Pure navigation prefix - show all (except hidden per above) */
-    } else {
-      /* Use only the part after the last separator for matching filenames */
-      const char *last_sep = FS_FindLastSeparator(query);
-      const char *match_query = last_sep ? last_sep + 1 : query;
+/* Ranking bonus for frequently and recently visited paths */
+static i32 Explorer_FrecencyBoost(explorer_state *state, const char *path) {
+  return state->layout ? Frecency_Boost(&state->layout->frecency, path) : 0;
+}
 
-      /* If query ends with separator, user is still typing path - show all */
-      if (match_query[0] != '\0' && !FuzzyMatch(match_query, entry->name)) {
-        return false;
-      }
-    }
+/* Score callback for the quick filter cache. Hidden entries never match, so
+ * toggling hidden files must reload the directory (bumping its generation). */
+static fuzzy_match_result Explorer_ScoreEntry(void *user_data, i32 index,
+                                              const char *query) {
+  explorer_state *state = (explorer_state *)user_data;
+  fs_entry *entry = &state->fs.entries[index];
+
+  if (!Explorer_PassesHiddenFilter(state, entry)) {
+    fuzzy_match_result no_match = {false, 0};
+    return no_match;
+  }
+  fuzzy_match_result result = FuzzyMatchScore(query, entry->name);
+  if (result.matches) {
+    result.score += Explorer_FrecencyBoost(state, entry->path);
   }
+  return result;
+}
 
-  return true;
+/* ===== Recursive Filter ===== */
+
+/* Drop whatever fs.entries hold before tree results are copied in */
+static void Explorer_ClearTreeEntries(explorer_state *state) {
+  state->fs.entry_count = 0;
+  state->fs.generation++;
+  state->fs.selected_index = -1;
+  FS_ClearSelection(&state->fs);
+  state->tree_copied = 0;
+  state->tree_generation = state->fs.generation;
 }
 
-/* Entry with match score for sorting */
-typedef struct {
-  i32 index;      /* Index into fs.entries */
-  i32 score;      /* Fuzzy match score (higher = better) */
-} scored_entry;
+/* Append the results found since the last call to fs.entries. A folder
+ * reload (watcher, resort) replaced them, so those start over from the
+ * first result. Returns true if the entries changed. */
+static b32 Explorer_CopyTreeResults(explorer_state *state) {
+  fs_state *fs = &state->fs;
+  b32 changed = false;
+  if (fs->generation != state->tree_generation) {
+    Explorer_ClearTreeEntries(state);
+    changed = true;
+  }
+
+  i32 copied_before = state->tree_copied;
+  tree_filter_status status = TreeFilter_GetStatus(&state->tree);
+  while (state->tree_copied < status.result_count &&
+         fs->entry_count < fs->entry_capacity) {
+    tree_filter_result result;
+    char rel_path[FS_MAX_PATH];
+    if (!TreeFilter_GetResult(&state->tree, state->tree_copied, &result,
+                              rel_path, sizeof(rel_path)))
+      break;
+
+    /* Shown relative to the folder the walk started in */
+    fs_entry *entry = &fs->entries[fs->entry_count];
+    strncpy(entry->name, rel_path, FS_MAX_NAME - 1);
+    entry->name[FS_MAX_NAME - 1] = '\0';
+    FS_JoinPath(entry->path, FS_MAX_PATH, state->tree_root, rel_path);
+    entry->is_directory = result.is_directory;
+    entry->is_special = result.is_special;
+    entry->size = result.size;
+    entry->modified_time = result.modified_time;
+    entry->icon =
+        FS_GetIconType(FS_GetFilename(rel_path), result.is_directory);
+    state->tree_scores[fs->entry_count] =
+        result.score + Explorer_FrecencyBoost(state, entry->path);
+
+    fs->entry_count++;
+    state->tree_copied++;
+  }
+
+  if (state->tree_copied > copied_before) {
+    fs->generation++;
+    state->tree_generation = fs->generation;
+    changed = true;
+  }
+  return changed;
+}
+
+/* Rank the tree results by score, best first */
+static void Explorer_UpdateTreeVisibleEntries(explorer_state *state) {
+  Explorer_CopyTreeResults(state);
+
+  fuzzy_candidate matches[FS_MAX_ENTRIES];
+  i32 match_count = (i32)state->fs.entry_count;
+  for (i32 i = 0; i < match_count; i++) {
+    matches[i].index = i;
+    matches[i].score = state->tree_scores[i];
+  }
+
+  /* Fully sort only the best matches, the rest keep discovery order */
+  fuzzy_candidate ranked[FS_MAX_ENTRIES];
+  FuzzyFilter_SelectTop(matches, match_count, EXPLORER_FILTER_TOP_K, ranked);
 
-/* Compare scored entries by score (descending) for qsort */
-static int CompareScoredEntries(const void *a, const void *b) {
-  const scored_entry *se_a = (const scored_entry *)a;
-  const scored_entry *se_b = (const scored_entry *)b;
-  return se_b->score - se_a->score; /* Higher score first */
+  state->visible_count = 0;
+  for (i32 i = 0; i < match_count; i++) {
+    state->visible_entries[state->visible_count++] = ranked[i].index;
+  }
 }
 
 /* Update the cached list of visible entries */
 static void Explorer_UpdateVisibleEntries(explorer_state *state) {
   state->visible_count = 0;
-  
-  /* Check if quick filter is active */
-  b32 filter_active = QuickFilter_IsActive(&state->filter);
-  const char *query = QuickFilter_GetQuery(&state->filter);
-  b32 has_query = filter_active && query[0] != '\0';
-  
-  /* Use stack-allocated array for scored entries when filtering */
-  scored_entry scored_entries[FS_MAX_ENTRIES];
-  
-  for (u32 i = 0; i < state->fs.entry_count; i++) {
-    /* Get match score if filter is active */
-    i32 score = 0;
-    if (has_query) {
-      fs_entry *entry = &state->fs.entries[i];
-      
-      /* Skip filtering for pure navigation prefixes */
-      if (query[0] == '\0' ||
-          (query[0] == '~' && query[1] == '\0') ||
-          (query[0] == '/' && query[1] == '\0')) {
-        /* Pure navigation prefix - show all */
-      } else {
-        /* Use only the part after the last separator for matching filenames */
-        const char *last_sep = FS_FindLastSeparator(query);
-        const char *match_query = last_sep ? last_sep + 1 : query;
-        
-        /* If query ends with separator, user is still typing path - show all */
-        if (match_query[0] != '\0') {
-          fuzzy_match_result result = FuzzyMatchScore(match_query, entry->name);
-          if (!result.matches)
-            continue;
-          score = result.score;
-        }
+
+  if (state->tree_active) {
+    Explorer_UpdateTreeVisibleEntries(state);
+    return;
+  }
+
+  const char *match_query = Explorer_GetMatchQuery(state);
+  if (!match_query) {
+    /* No query - directory order */
+    for (u32 i = 0; i < state->fs.entry_count; i++) {
+      if (Explorer_PassesHiddenFilter(state, &state->fs.entries[i])) {
+        state->visible_entries[state->visible_count++] = (i32)i;
       }
     }
-    
-    if (Explorer_IsEntryVisible(state, (i32)i)) {
-      if (state->visible_count < FS_MAX_ENTRIES) {
-        scored_entries[state->visible_count].index = (i32)i;
-        scored_entries[state->visible_count].score = score;
-        state->visible_count++;
-      }
+    return;
+  }
+
+  /* Typing a character only rescores the previous matches */
+  i32 match_count = 0;
+  const fuzzy_candidate *matches = FuzzyFilter_Apply(
+      &state->filter_cache, match_query, (i32)state->fs.entry_count,
+      state->fs.generation, Explorer_ScoreEntry, state, &match_count);
+
+  /* Fully sort only the best matches, the rest keep directory order */
+  fuzzy_candidate ranked[FS_MAX_ENTRIES];
+  FuzzyFilter_SelectTop(matches, match_count, EXPLORER_FILTER_TOP_K, ranked);
+
+  for (i32 i = 0; i < match_count; i++) {
+    state->visible_entries[state->visible_count++] = ranked[i].index;
+  }
+}
+
+/* Start, follow or stop the recursive walk for the current filter query.
+ * Call once per frame after the folder traversal of the quick filter. */
+static void Explorer_UpdateTreeFilter(explorer_state *state) {
+  if (!state->recursive_filter)
+    return;
+
+  const char *match_query = Explorer_GetMatchQuery(state);
+  if (!match_query) {
+    if (state->tree_active) {
+      /* Put the folder listing back */
+      TreeFilter_Cancel(&state->tree);
+      state->tree_active = false;
+      QuickFilter_SetStatus(&state->filter, "");
+      FS_LoadDirectory(&state->fs, state->fs.current_path);
+      Explorer_UpdateVisibleEntries(state);
     }
+    return;
   }
-  
-  /* Sort by score if filter is active with a query */
-  if (has_query && state->visible_count > 1) {
-    qsort(scored_entries, (size_t)state->visible_count, sizeof(scored_entry),
-          CompareScoredEntries);
+
+  if (!state->tree_active || strcmp(state->tree_query, match_query) != 0 ||
+      !FS_PathsEqual(state->tree_root, state->fs.current_path) ||
+      state->tree_show_hidden != state->show_hidden) {
+    snprintf(state->tree_root, sizeof(state->tree_root), "%s",
+             state->fs.current_path);
+    snprintf(state->tree_query, sizeof(state->tree_query), "%s", match_query);
+    state->tree_show_hidden = state->show_hidden;
+    TreeFilter_Start(&state->tree, state->tree_root, state->tree_query,
+                     state->tree_show_hidden);
+    state->tree_active = true;
+    Explorer_ClearTreeEntries(state);
+  }
+
+  /* Keep the best match selected as better ones stream in, unless the user
+   * moved the selection */
+  b32 follow_best = state->visible_count == 0 ||
+                    state->fs.selected_index == state->visible_entries[0];
+  if (Explorer_CopyTreeResults(state)) {
+    Explorer_UpdateVisibleEntries(state);
+    if (follow_best && state->visible_count > 0) {
+      Explorer_SetSelection(state, state->visible_entries[0]);
+    }
   }
-  
-  /* Copy sorted indices to visible_entries */
-  for (i32 i = 0; i < state->visible_count; i++) {
-    state->visible_entries[i] = scored_entries[i].index;
+
+  tree_filter_status status = TreeFilter_GetStatus(&state->tree);
+  char text[64];
+  if (status.running) {
+    snprintf(text, sizeof(text), "%d matches, searching...",
+             status.result_count);
+  } else if (status.stopped_early) {
+    snprintf(text, sizeof(text), "%d best matches", status.result_count);
+  } else {
+    snprintf(text, sizeof(text), "%d matches", status.result_count);
   }
+  QuickFilter_SetStatus(&state->filter, text);
 }
 
 /* Find the next visible entry index in the given direction */
@@ -248,6 +384,45 @@ static i32 Explorer_ActualToVisibleIndex(explorer_state *state,
   return -1;
 }
 
+/* ===== List and Grid Geometry ===== */
+
+static i32 Explorer_Columns(explorer_state *state) {
+  return state->grid_view ? Max(state->grid_columns, 1) : 1;
+}
+
+static i32 Explorer_RowHeight(explorer_state *state) {
+  return state->grid_view ? state->grid_tile_height : state->item_height;
+}
+
+/* Tile size for a line height, kept for hit testing between renders */
+static void Explorer_UpdateTileGeometry(explorer_state *state, i32 line_height,
+                                        i32 list_width) {
+  state->grid_tile_width = state->grid_tile_size + 2 * EXPLORER_TILE_PADDING +
+                           EXPLORER_TILE_GAP;
+  state->grid_tile_height = state->grid_tile_size +
+                            3 * EXPLORER_TILE_PADDING + line_height +
+                            EXPLORER_TILE_GAP;
+  state->grid_columns =
+      Max((list_width - EXPLORER_SCROLLBAR_GUTTER) / state->grid_tile_width, 1);
+}
+
+/* Visible index of the row or tile under a point (may be past the end) */
+static i32 Explorer_VisibleIndexAt(explorer_state *state, v2i pos) {
+  i32 y = pos.y - state->list_bounds.y + (i32)state->scroll.offset.y;
+  i32 column = 0;
+
+  if (y < 0) {
+    return -1;
+  }
+  if (state->grid_view) {
+    column = (pos.x - state->list_bounds.x) / state->grid_tile_width;
+    if (column < 0 || column >= Explorer_Columns(state)) {
+      return -1;
+    }
+  }
+  return (y / Explorer_RowHeight(state)) * Explorer_Columns(state) + column;
+}
+
 void Explorer_SetSelection(explorer_state *state, i32 index) {
   FS_SetSelection(&state->fs, index);
   SmoothValue_SetTarget(&state->selection_anim, (f32)state->fs.selected_index);
@@ -273,6 +448,10 @@ void Explorer_Init(explorer_state *state, memory_arena *arena) {
   state->show_hidden = Config_GetBool("explorer.show_hidden", false);
   state->show_size_column = true;
   state->show_date_column = false;
+  state->grid_view = Config_GetBool("explorer.grid_view", false);
+  state->grid_tile_size =
+      (i32)Clamp(Config_GetI64("explorer.grid.tile_size", 128), 32, 512);
+  Explorer_UpdateTileGeometry(state, EXPLORER_ITEM_HEIGHT - 12, 0);
 
   /* Load sort settings */
   const char *sort_type_str = Config_GetString("explorer.sort_type", "name");
@@ -299,8 +478,14 @@ void Explorer_Init(explorer_state *state, memory_arena *arena) {
   /* Initialize breadcrumb */
   Breadcrumb_Init(&state->breadcrumb);
 
-  /* Initialize quick filter */
+  /* Initialize quick filter and its incremental match cache */
   QuickFilter_Init(&state->filter);
+  fuzzy_candidate *filter_storage = ArenaPushArray(
+      arena, fuzzy_candidate, FS_MAX_ENTRIES * FUZZY_FILTER_MAX_DEPTH);
+  FuzzyFilter_Init(&state->filter_cache, filter_storage, FS_MAX_ENTRIES);
+  state->recursive_filter = Config_GetBool("explorer.recursive_filter", false);
+  state->browse_archives = Config_GetBool("explorer.browse_archives", true);
+  TreeFilter_Init(&state->tree);
 
   /* Initialize file system watcher */
   FSWatcher_Init(&state->watcher);
@@ -325,16 +510,31 @@ void Explorer_Init(explorer_state *state, memory_arena *arena) {
 
 void Explorer_Shutdown(explorer_state *state) {
   FSWatcher_Shutdown(&state->watcher);
+  TreeFilter_Shutdown(&state->tree);
+  ThumbnailPool_Release(state->thumbnails);
+  state->thumbnails = NULL;
 }
 
 /* ===== Navigation ===== */
 
+/* Open a file with the system handler and count the visit */
+static void Explorer_OpenFile(explorer_state *state, const char *path) {
+  if (state->layout) {
+    Frecency_Visit(&state->layout->frecency, path);
+  }
+  Platform_OpenFile(path);
+}
+
 b32 Explorer_NavigateTo(explorer_state *state, const char *path,
                         b32 keep_filter) {
   if (FS_PathsEqual(state->fs.current_path, path))
     return true;
 
   if (FS_LoadDirectory(&state->fs, path)) {
+    if (state->layout) {
+      Frecency_Visit(&state->layout->frecency, state->fs.current_path);
+    }
+
     if (keep_filter) {
       /* Update filter text to match the new location relative to search start
        * Need to use the normalized current_path (which resolves .. and .)
@@ -371,8 +571,12 @@ b32 Explorer_NavigateTo(explorer_state *state, const char *path,
       QuickFilter_Clear(&state->filter);
     }
 
-    /* Update file watcher to watch new directory */
-    FSWatcher_WatchDirectory(&state->watcher, path);
+    /* Update file watcher to watch new directory (archives are read once) */
+    if (state->fs.in_archive) {
+      FSWatcher_StopWatching(&state->watcher);
+    } else {
+      FSWatcher_WatchDirectory(&state->watcher, path);
+    }
 
     /* Push to history */
     Explorer_ResetScroll(state);
@@ -446,6 +650,13 @@ void Explorer_ToggleHidden(explorer_state *state) {
   }
 }
 
+void Explorer_ToggleGridView(explorer_state *state) {
+  state->grid_view = !state->grid_view;
+  Config_SetBool("explorer.grid_view", state->grid_view);
+  Config_Save();
+  state->scroll_to_selection = true;
+}
+
 /* ===== Dialog Helpers ===== */
 
 static void Explorer_SetupInputDialog(explorer_state *state, explorer_mode mode,
@@ -469,12 +680,27 @@ static void Explorer_GetInputPath(explorer_state *state, char *out_path,
   FS_JoinPath(out_path, out_size, state->fs.current_path, state->input_buffer);
 }
 
+/* 'name' next to an entry. Recursive filter results live below the current
+ * folder and their names are display paths (possibly truncated), so file
+ * operations go by the entry's full path instead. */
+static void Explorer_GetSiblingPath(const fs_entry *entry, const char *name,
+                                    char *out_path, usize out_size) {
+  char dir[FS_MAX_PATH];
+  snprintf(dir, sizeof(dir), "%s", entry->path);
+  char *separator = (char *)FS_FindLastSeparator(dir);
+  if (separator) {
+    separator[separator == dir ? 1 : 0] = '\0';
+  }
+  FS_JoinPath(out_path, out_size, dir, name);
+}
+
 /* ===== File Operations ===== */
 
 void Explorer_StartRename(explorer_state *state) {
   fs_entry *entry = FS_GetSelectedEntry(&state->fs);
   if (entry && strcmp(entry->name, "..") != 0) {
-    Explorer_SetupInputDialog(state, WB_EXPLORER_MODE_RENAME, entry->name);
+    Explorer_SetupInputDialog(state, WB_EXPLORER_MODE_RENAME,
+                              FS_GetFilename(entry->path));
   }
 }
 
@@ -679,16 +905,17 @@ void Explorer_FocusFilter(explorer_state *state) {
 void Explorer_Duplicate(explorer_state *state) {
   fs_entry *entry = FS_GetSelectedEntry(&state->fs);
   if (entry && strcmp(entry->name, "..") != 0) {
-    const char *ext = FS_GetExtension(entry->name);
-    i32 name_len = (i32)strlen(entry->name);
+    const char *name = FS_GetFilename(entry->path);
+    const char *ext = FS_GetExtension(name);
+    i32 name_len = (i32)strlen(name);
     i32 ext_len = (i32)strlen(ext);
     i32 base_len = name_len - ext_len;
 
     char dest[FS_MAX_PATH];
     char copy_name[FS_MAX_NAME];
-    snprintf(copy_name, sizeof(copy_name), "%.*s_copy%s", base_len, entry->name,
+    snprintf(copy_name, sizeof(copy_name), "%.*s_copy%s", base_len, name,
              ext);
-    FS_JoinPath(dest, sizeof(dest), state->fs.current_path, copy_name);
+    Explorer_GetSiblingPath(entry, copy_name, dest, sizeof(dest));
 
     if (FS_Copy(entry->path, dest)) {
       Explorer_Refresh(state);
@@ -696,18 +923,28 @@ void Explorer_Duplicate(explorer_state *state) {
   }
 }
 
+/* Enter a folder or archive, open anything else */
+static void Explorer_ActivateEntry(explorer_state *state, fs_entry *entry) {
+  b32 browse = entry->is_directory || (state->browse_archives &&
+                                       ZipArchive_IsArchiveName(entry->name));
+  if (browse) {
+    char target_path[FS_MAX_PATH];
+    strncpy(target_path, entry->path, FS_MAX_PATH - 1);
+    target_path[FS_MAX_PATH - 1] = '\0';
+    if (Explorer_NavigateTo(state, target_path,
+                            QuickFilter_IsActive(&state->filter)) ||
+        entry->is_directory) {
+      return;
+    }
+  }
+  /* Not a readable archive after all: hand it to the system */
+  Explorer_OpenFile(state, entry->path);
+}
+
 void Explorer_OpenSelected(explorer_state *state) {
   fs_entry *entry = FS_GetSelectedEntry(&state->fs);
   if (entry) {
-    if (entry->is_directory) {
-      char target_path[FS_MAX_PATH];
-      strncpy(target_path, entry->path, FS_MAX_PATH - 1);
-      target_path[FS_MAX_PATH - 1] = '\0';
-      Explorer_NavigateTo(state, target_path,
-                          QuickFilter_IsActive(&state->filter));
-    } else {
-      Platform_OpenFile(entry->path);
-    }
+    Explorer_ActivateEntry(state, entry);
   }
 }
 
@@ -736,33 +973,48 @@ static void Explorer_HandleNavigationInput(explorer_state *state,
                                            ui_context *ui, b32 filter_active) {
   ui_input *input = &ui->input;
 
+  /* Up and down move a whole row of tiles in the grid */
+  i32 columns = Explorer_Columns(state);
+
   /* Vim-style navigation - disabled when filter is active (j/k are printable)
    */
   if (!filter_active && Input_KeyRepeat(WB_KEY_J)) {
-    Explorer_MoveVisibleSelection(state, 1);
+    Explorer_MoveVisibleSelection(state, columns);
   }
 
   if (!filter_active && Input_KeyRepeat(WB_KEY_K)) {
-    Explorer_MoveVisibleSelection(state, -1);
+    Explorer_MoveVisibleSelection(state, -columns);
   }
 
   /* Arrow key navigation - always works */
   if (Input_KeyRepeat(WB_KEY_DOWN) && !(input->modifiers & MOD_CTRL)) {
-    Explorer_MoveVisibleSelection(state, 1);
+    Explorer_MoveVisibleSelection(state, columns);
   }
 
   if (Input_KeyRepeat(WB_KEY_UP) && !(input->modifiers & MOD_CTRL)) {
-    Explorer_MoveVisibleSelection(state, -1);
+    Explorer_MoveVisibleSelection(state, -columns);
+  }
+
+  /* Left and right walk the tiles (the filter owns them while active) */
+  if (state->grid_view && !filter_active && !(input->modifiers & MOD_ALT)) {
+    if (Input_KeyRepeat(WB_KEY_RIGHT)) {
+      Explorer_MoveVisibleSelection(state, 1);
+    }
+    if (Input_KeyRepeat(WB_KEY_LEFT)) {
+      Explorer_MoveVisibleSelection(state, -1);
+    }
   }
 
   /* Page navigation */
   if (Input_KeyRepeat(WB_KEY_PAGE_DOWN)) {
-    i32 visible = (i32)(state->scroll.view_size.y / state->item_height);
+    i32 visible =
+        (i32)(state->scroll.view_size.y / Explorer_RowHeight(state)) * columns;
     Explorer_MoveVisibleSelection(state, visible);
   }
 
   if (Input_KeyRepeat(WB_KEY_PAGE_UP)) {
-    i32 visible = (i32)(state->scroll.view_size.y / state->item_height);
+    i32 visible =
+        (i32)(state->scroll.view_size.y / Explorer_RowHeight(state)) * columns;
     Explorer_MoveVisibleSelection(state, -visible);
   }
 
@@ -867,7 +1119,8 @@ static void Explorer_OnConfirm(explorer_state *state) {
     fs_entry *entry = FS_GetSelectedEntry(&state->fs);
     if (entry && state->input_buffer[0] != '\0') {
       char new_path[FS_MAX_PATH];
-      Explorer_GetInputPath(state, new_path, sizeof(new_path));
+      Explorer_GetSiblingPath(entry, state->input_buffer, new_path,
+                              sizeof(new_path));
       if (FS_Rename(entry->path, new_path)) {
         Explorer_Refresh(state);
       } else if (state->layout) {
@@ -955,6 +1208,7 @@ static void HandleDialogInput(explorer_state *state, ui_context *ui) {
 void Explorer_PollWatcher(explorer_state *state) {
   /* Poll file watcher for external changes */
   if (FSWatcher_Poll(&state->watcher)) {
+    state->fs.change_count++;
     Explorer_Refresh(state);
   }
   
@@ -1030,9 +1284,8 @@ void Explorer_Update(explorer_state *state, ui_context *ui,
           ContextMenu_IsMouseOver(state->context_menu, input->mouse_pos);
 
       if (input->mouse_pressed[WB_MOUSE_LEFT] && !mouse_over_menu) {
-        i32 click_y = input->mouse_pos.y - state->list_bounds.y +
-                      (i32)state->scroll.offset.y;
-        i32 clicked_visible_index = click_y / state->item_height;
+        i32 clicked_visible_index =
+            Explorer_VisibleIndexAt(state, input->mouse_pos);
 
         /* Convert visible index to actual entry index */
         i32 actual_index =
@@ -1047,15 +1300,7 @@ void Explorer_Update(explorer_state *state, ui_context *ui,
             Explorer_SetSelection(state, actual_index);
             fs_entry *entry = FS_GetSelectedEntry(&state->fs);
             if (entry) {
-              if (entry->is_directory) {
-                char target_path[FS_MAX_PATH];
-                strncpy(target_path, entry->path, FS_MAX_PATH - 1);
-                target_path[FS_MAX_PATH - 1] = '\0';
-                Explorer_NavigateTo(state, target_path,
-                                    QuickFilter_IsActive(&state->filter));
-              } else {
-                Platform_OpenFile(entry->path);
-              }
+              Explorer_ActivateEntry(state, entry);
             }
             state->last_click_time = 0;
           } else {
@@ -1115,9 +1360,8 @@ void Explorer_Update(explorer_state *state, ui_context *ui,
 
       /* Handle right-click for context menu */
       if (input->mouse_pressed[WB_MOUSE_RIGHT] && state->context_menu) {
-        i32 click_y = input->mouse_pos.y - state->list_bounds.y +
-                      (i32)state->scroll.offset.y;
-        i32 clicked_visible_index = click_y / state->item_height;
+        i32 clicked_visible_index =
+            Explorer_VisibleIndexAt(state, input->mouse_pos);
 
         /* Convert visible index to actual entry index */
         i32 actual_index =
@@ -1241,6 +1485,9 @@ void Explorer_Update(explorer_state *state, ui_context *ui,
       /* Filter just ended - stay in current directory (do not revert) */
     }
 
+    /* Recursive mode swaps the listing for subtree matches */
+    Explorer_UpdateTreeFilter(state);
+
     /* If filter state or content changed, reset selection */
     const char *current_filter = QuickFilter_GetQuery(&state->filter);
     if (filter_was_active != filter_is_active ||
@@ -1341,6 +1588,76 @@ static void RenderDialog(explorer_state *state, ui_context *ui, rect bounds) {
   }
 }
 
+/* ===== Grid Thumbnails ===== */
+
+/* Members of an archive are not files the decoders can open */
+static b32 Explorer_HasThumbnail(const explorer_state *state,
+                                 const fs_entry *entry) {
+  return !state->fs.in_archive && !entry->is_directory &&
+         entry->icon == WB_FILE_ICON_IMAGE;
+}
+
+static void Explorer_ReleaseThumbnail(void *user_data, image *img) {
+  Render_ReleaseImage((render_context *)user_data, img);
+}
+
+static image *Explorer_GetThumbnail(explorer_state *state, fs_entry *entry) {
+  if (!state->thumbnails || !Explorer_HasThumbnail(state, entry)) {
+    return NULL;
+  }
+  /* Already requested this frame: this only reads the slot */
+  return ThumbnailPool_Request(state->thumbnails, entry->path,
+                               entry->modified_time, entry->size, 0, NULL);
+}
+
+/* Ask for the thumbnails of the rows in view, then of as many rows again
+ * above and below, nearest first. Everything else queued is dropped. */
+static void Explorer_RequestThumbnails(explorer_state *state, ui_context *ui,
+                                       i32 start_row, i32 end_row) {
+  i32 columns = Explorer_Columns(state);
+  i32 view_rows = Max(end_row - start_row, 1);
+  /* Leave room in the pool for the rows in view to change */
+  i32 max_rows = Max(THUMBNAIL_POOL_SLOTS / 2 / columns, view_rows);
+  i32 margin = Clamp(max_rows - view_rows, 0, view_rows) / 2;
+
+  if (!state->thumbnails) {
+    thumbnail_pool_config config = {0};
+    config.size = Thumbnail_SizeCovering(state->grid_tile_size);
+    config.thread_count = (i32)Config_GetI64("explorer.grid.decode_threads", 0);
+    config.max_bytes =
+        (u64)Max(Config_GetI64("explorer.grid.max_bytes", 67108864), 0);
+    config.max_decode_bytes =
+        Config_GetI64("preview.image.max_decode_bytes", 33554432);
+    config.max_dimension = Config_GetI64("preview.image.max_dimension", 8192);
+    config.release_image = Explorer_ReleaseThumbnail;
+    config.release_user_data = ui->renderer;
+    state->thumbnails = ThumbnailPool_Create(&config);
+    if (!state->thumbnails) {
+      return;
+    }
+  }
+
+  ThumbnailPool_BeginFrame(state->thumbnails);
+  for (i32 row = start_row - margin; row < end_row + margin; row++) {
+    i32 distance = row < start_row  ? start_row - row
+                   : row >= end_row ? row - end_row + 1
+                                    : 0;
+    for (i32 column = 0; column < columns; column++) {
+      i32 visible = row * columns + column;
+      if (visible < 0 || visible >= state->visible_count) {
+        continue;
+      }
+      fs_entry *entry = FS_GetEntry(&state->fs, state->visible_entries[visible]);
+      if (entry && Explorer_HasThumbnail(state, entry)) {
+        ThumbnailPool_Request(state->thumbnails, entry->path,
+                              entry->modified_time, entry->size, distance,
+                              NULL);
+      }
+    }
+  }
+  ThumbnailPool_EndFrame(state->thumbnails);
+}
+
 void Explorer_Render(explorer_state *state, ui_context *ui, rect bounds,
                      b32 has_focus, drag_drop_state *drag, u32 panel_idx) {
   render_context *ctx = ui->renderer;
@@ -1410,9 +1727,18 @@ void Explorer_Render(explorer_state *state, ui_context *ui, rect bounds,
   /* Store bounds for mouse input handling */
   state->list_bounds = list_area;
 
+  /* The grid lays rows of tiles out like the list lays out rows */
+  if (state->grid_view) {
+    Explorer_UpdateTileGeometry(state, Font_GetLineHeight(ui->font),
+                                list_area.w);
+  }
+  i32 columns = Explorer_Columns(state);
+  i32 row_height = Explorer_RowHeight(state);
+
   /* Count visible items first for proper calculations */
   i32 visible_item_count = Explorer_CountVisible(state);
-  f32 content_height = (f32)(visible_item_count * state->item_height);
+  i32 row_count = (visible_item_count + columns - 1) / columns;
+  f32 content_height = (f32)(row_count * row_height);
 
   /* Add extra padding (3 items) when scrollbar is needed so user can scroll
    * past the end to access empty space for right-clicking */
@@ -1437,8 +1763,8 @@ void Explorer_Render(explorer_state *state, ui_context *ui, rect bounds,
       visible_sel_index = i;
     }
 
-    f32 sel_y = (f32)(visible_sel_index * state->item_height);
-    ScrollContainer_ScrollToY(&state->scroll, sel_y, (f32)state->item_height);
+    f32 sel_y = (f32)((visible_sel_index / columns) * row_height);
+    ScrollContainer_ScrollToY(&state->scroll, sel_y, (f32)row_height);
     state->scroll_to_selection = false;
   }
 
@@ -1453,28 +1779,41 @@ void Explorer_Render(explorer_state *state, ui_context *ui, rect bounds,
 
   /* Draw visible items - iterate only through items in the viewport using
    * cached indices */
-  i32 start_visible = (i32)(state->scroll.offset.y / state->item_height);
-  i32 end_visible = start_visible + list_area.h / state->item_height + 2;
+  i32 start_row = (i32)(state->scroll.offset.y / row_height);
+  i32 end_row = start_row + list_area.h / row_height + 2;
+  i32 start_visible = start_row * columns;
+  i32 end_visible = end_row * columns;
 
   if (start_visible < 0)
     start_visible = 0;
   if (end_visible > state->visible_count)
     end_visible = state->visible_count;
 
+  if (state->grid_view) {
+    Explorer_RequestThumbnails(state, ui, start_row, end_row);
+  }
+
   for (i32 i = start_visible; i < end_visible; i++) {
     i32 actual_index = state->visible_entries[i];
     fs_entry *entry = FS_GetEntry(&state->fs, actual_index);
     if (!entry)
       continue;
 
-    i32 item_y =
-        list_area.y + (i * state->item_height) - (i32)state->scroll.offset.y;
-    i32 actual_width = list_area.w;
-    if (state->scroll.content_size.y > state->scroll.view_size.y) {
-      actual_width -=
-          EXPLORER_SCROLLBAR_GUTTER; /* Reserve space for scrollbar */
+    i32 item_y = list_area.y + ((i / columns) * row_height) -
+                 (i32)state->scroll.offset.y;
+    rect item_bounds;
+    if (state->grid_view) {
+      item_bounds = (rect){list_area.x + (i % columns) * state->grid_tile_width,
+                           item_y, state->grid_tile_width - EXPLORER_TILE_GAP,
+                           row_height - EXPLORER_TILE_GAP};
+    } else {
+      i32 actual_width = list_area.w;
+      if (state->scroll.content_size.y > state->scroll.view_size.y) {
+        actual_width -=
+            EXPLORER_SCROLLBAR_GUTTER; /* Reserve space for scrollbar */
+      }
+      item_bounds = (rect){list_area.x, item_y, actual_width, row_height};
     }
-    rect item_bounds = {list_area.x, item_y, actual_width, state->item_height};
 
     /* Check if this folder is a drop target */
     if (DragDrop_IsDragging(drag) && entry->is_directory) {
@@ -1492,11 +1831,17 @@ void Explorer_Render(explorer_state *state, ui_context *ui, rect bounds,
     b32 is_selected = FS_IsSelected(&state->fs, actual_index);
     b32 is_hovered = !modal_active && (ui->active == UI_ID_NONE) &&
                      UI_PointInRect(ui->input.mouse_pos, item_bounds);
-    file_item_config item_config = {.icon_size = EXPLORER_ICON_SIZE,
-                                    .icon_padding = EXPLORER_ICON_PADDING,
-                                    .show_size = state->show_size_column};
-    FileItem_Render(ui, entry, item_bounds, is_selected, is_hovered,
-                    &item_config);
+    if (state->grid_view) {
+      FileItem_RenderTile(ui, entry, item_bounds,
+                          Explorer_GetThumbnail(state, entry), is_selected,
+                          is_hovered);
+    } else {
+      file_item_config item_config = {.icon_size = EXPLORER_ICON_SIZE,
+                                      .icon_padding = EXPLORER_ICON_PADDING,
+                                      .show_size = state->show_size_column};
+      FileItem_Render(ui, entry, item_bounds, is_selected, is_hovered,
+                      &item_config);
+    }
   }
 
   /* Check panel itself as drop target (empty area) */
@@ -10,7 +10,10 @@
 
 #include "../../core/fs.h"
 #include "../../core/fs_watcher.h"
+#include "../../core/fuzzy_filter.h"
 #include "../../core/text.h"
+#include "../../core/thumbnail_pool.h"
+#include "../../core/tree_filter.h"
 #include "../ui.h"
 #include "quick_filter.h"
 #include "breadcrumb.h"
@@ -50,6 +53,15 @@ typedef struct explorer_state_s {
   b32 show_size_column;
   b32 show_date_column;
 
+  /* Grid view (explorer.grid_view): entries as tiles, images with their
+   * thumbnails. Tile geometry is that of the last render. */
+  b32 grid_view;
+  i32 grid_tile_size; /* Thumbnail edge (explorer.grid.tile_size) */
+  i32 grid_tile_width;
+  i32 grid_tile_height;
+  i32 grid_columns;
+  thumbnail_pool *thumbnails; /* Created when the grid is first shown */
+
   /* Mode and dialogs */
   explorer_mode mode;
   char input_buffer[256];
@@ -79,12 +91,28 @@ typedef struct explorer_state_s {
 
   /* Quick filter state */
   quick_filter_state filter;
+  fuzzy_filter filter_cache; /* Cached match sets per filter query */
 
   /* Search Traversal State */
   char search_start_path[FS_MAX_PATH];
   b32 filter_was_active;
   char last_filter_buffer[QUICK_FILTER_MAX_INPUT];
 
+  /* Enter zip archives like read-only folders (explorer.browse_archives) */
+  b32 browse_archives;
+
+  /* Recursive quick filter (explorer.recursive_filter). While active,
+   * fs.entries hold the subtree matches instead of the folder listing. */
+  b32 recursive_filter;
+  tree_filter tree;
+  b32 tree_active;
+  char tree_root[FS_MAX_PATH];
+  char tree_query[QUICK_FILTER_MAX_INPUT];
+  b32 tree_show_hidden;
+  i32 tree_copied;     /* Results copied into fs.entries */
+  u32 tree_generation; /* fs.generation after the last copy */
+  i32 tree_scores[FS_MAX_ENTRIES];
+
   /* Context menu (managed by layout/main.c) */
   struct context_menu_state_s *context_menu;
 
@@ -140,6 +168,9 @@ fs_entry *Explorer_GetSelected(explorer_state *state);
 /* Toggle hidden files visibility */
 void Explorer_ToggleHidden(explorer_state *state);
 
+/* Switch between the list and the thumbnail grid (persisted) */
+void Explorer_ToggleGridView(explorer_state *state);
+
 typedef struct {
   i32 success_count;
   i32 failure_count;
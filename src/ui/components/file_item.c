@@ -5,6 +5,7 @@
  */
 
 #include "file_item.h"
+#include "../../core/image.h"
 #include "icons.h"
 #include "theme.h"
 
@@ -59,3 +60,81 @@ void FileItem_Render(ui_context *ui, fs_entry *entry, rect bounds,
                     is_selected ? th->background : th->text_muted);
   }
 }
+
+#define FILE_TILE_PADDING 6
+
+/* Copy 'name' into 'out', cut with "..." to fit max_width */
+static void FileItem_FitName(font *f, const char *name, i32 max_width,
+                             char *out, usize out_size) {
+  usize len = strlen(name);
+
+  if (len >= out_size)
+    len = out_size - 1;
+  memcpy(out, name, len);
+  out[len] = '\0';
+  if (Font_MeasureWidth(f, out) <= max_width)
+    return;
+
+  while (len > 0) {
+    /* Back up a whole UTF-8 sequence */
+    do {
+      len--;
+    } while (len > 0 && ((u8)name[len] & 0xC0) == 0x80);
+    if (len + 4 > out_size)
+      continue;
+    memcpy(out, name, len);
+    memcpy(out + len, "...", 4);
+    if (Font_MeasureWidth(f, out) <= max_width)
+      return;
+  }
+  memcpy(out, "...", 4);
+}
+
+void FileItem_RenderTile(ui_context *ui, fs_entry *entry, rect bounds,
+                         struct image_s *thumbnail, b32 is_selected,
+                         b32 is_hovered) {
+  render_context *ctx = ui->renderer;
+  const theme *th = ui->theme;
+  i32 line_height = Font_GetLineHeight(ui->font);
+  char label[FS_MAX_NAME];
+
+  if (is_selected) {
+    Render_DrawRectRounded(ctx, bounds, 4.0f, th->accent);
+  } else if (is_hovered) {
+    Render_DrawRectRounded(ctx, bounds, 4.0f, th->panel);
+  }
+
+  rect art = {bounds.x + FILE_TILE_PADDING, bounds.y + FILE_TILE_PADDING,
+              bounds.w - 2 * FILE_TILE_PADDING,
+              bounds.h - 3 * FILE_TILE_PADDING - line_height};
+  image *img = (image *)thumbnail;
+
+  if (img && img->width > 0 && img->height > 0 && art.w > 0 && art.h > 0) {
+    /* Fit without upscaling */
+    f32 scale = Min((f32)art.w / (f32)img->width,
+                    (f32)art.h / (f32)img->height);
+    if (scale > 1.0f)
+      scale = 1.0f;
+    i32 w = Max((i32)((f32)img->width * scale), 1);
+    i32 h = Max((i32)((f32)img->height * scale), 1);
+    rect r = {art.x + (art.w - w) / 2, art.y + (art.h - h) / 2, w, h};
+    Render_DrawImage(ctx, r, thumbnail, COLOR_RGBA(255, 255, 255, 255));
+  } else {
+    i32 size = Clamp(Min(art.w, art.h) / 2, 16, 64);
+    rect icon_bounds = {art.x + (art.w - size) / 2, art.y + (art.h - size) / 2,
+                        size, size};
+    Icon_Draw(ctx, icon_bounds, entry->icon,
+              is_selected ? th->background : Icon_GetTypeColor(entry->icon, th));
+  }
+
+  b32 is_hidden = entry->name[0] == '.' && strcmp(entry->name, "..") != 0;
+  color text_color = is_selected ? th->background
+                     : is_hidden ? th->text_muted
+                                 : th->text;
+  i32 label_width = bounds.w - 2 * FILE_TILE_PADDING;
+  FileItem_FitName(ui->font, entry->name, label_width, label, sizeof(label));
+  i32 text_width = Font_MeasureWidth(ui->font, label);
+  v2i text_pos = {bounds.x + (bounds.w - text_width) / 2,
+                  bounds.y + bounds.h - FILE_TILE_PADDING - line_height};
+  Render_DrawText(ctx, text_pos, label, ui->font, text_color);
+}
@@ -35,4 +35,13 @@ void FileItem_Render(ui_context *ui, fs_entry *entry, rect bounds,
                      b32 is_selected, b32 is_hovered,
                      const file_item_config *config);
 
+/* Render a file item as a grid tile: the thumbnail (or the type icon while
+ * there is none) above the name, shortened to fit.
+ *
+ * @param thumbnail Decoded thumbnail, or NULL to draw the icon.
+ */
+void FileItem_RenderTile(ui_context *ui, fs_entry *entry, rect bounds,
+                         struct image_s *thumbnail, b32 is_selected,
+                         b32 is_hovered);
+
 #endif /* FILE_ITEM_H */
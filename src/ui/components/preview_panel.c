@@ -6,6 +6,9 @@
 
 #include "preview_panel.h"
 #include "../../config/config.h"
+#include "../../core/byte_scan.h"
+#include "../../core/text.h"
+#include "../../core/zip_archive.h"
 #include "../../platform/platform.h"
 #include "../../renderer/font.h"
 #include "explorer.h"
@@ -20,8 +23,19 @@
 #define PREVIEW_SPLITTER_WIDTH 4
 #define PREVIEW_PANEL_PADDING 12
 #define PREVIEW_LINE_BUFFER 1024
+#define PREVIEW_ROW_BYTES (PREVIEW_LINE_BUFFER * 4) /* UTF-8 of a full row */
 #define PREVIEW_MIN_RATIO 0.05f
 #define PREVIEW_MAX_RATIO 0.95f
+#define PREVIEW_MAPPED_BACKSCAN Kilobytes(64) /* Longest line walked back */
+#define PREVIEW_SEARCH_CHUNK Megabytes(16)    /* Bytes searched per frame */
+#define PREVIEW_THUMBNAIL_MIN_IMAGES 8 /* Folders worth generating ahead */
+#define PREVIEW_READ_CHUNK Kilobytes(64) /* Text read between cancel checks */
+#define PREVIEW_SYNTAX_MAX_LINE Kilobytes(16) /* Longer lines stay plain */
+#define PREVIEW_SYNTAX_SPANS 512 /* Token runs per highlighted line */
+#define PREVIEW_ARCHIVE_CHECK 4096 /* Members listed between cancel checks */
+#define PREVIEW_DIRECTORY_LIST 256 /* Children named in a folder summary */
+#define PREVIEW_DIRECTORY_CHECK 128 /* Children counted between clock reads */
+#define PREVIEW_DIRECTORY_PROGRESS_MS 150 /* Between partial summaries */
 
 extern void *Platform_CreateThread(void *(*func)(void *), void *arg);
 extern void *Platform_CreateMutex(void);
@@ -30,6 +44,7 @@ extern void Platform_UnlockMutex(void *mutex);
 extern void *Platform_CreateCondVar(void);
 extern void Platform_CondWait(void *cond, void *mutex);
 extern void Platform_CondSignal(void *cond);
+extern void Platform_CondBroadcast(void *cond);
 
 static void PreviewCopyString(char *dst, usize dst_size, const char *src) {
   usize len = 0;
@@ -58,10 +73,22 @@ static void PreviewContent_Clear(preview_content *content) {
   if (!content)
     return;
 
-  if (content->text) {
+  if (content->lines) {
+    LineIndex_Release(content->lines);
+  } else if (content->map.data) {
+    Platform_UnmapFile(&content->map);
+  } else if (content->text) {
     free(content->text);
   }
 
+  if (content->row_starts) {
+    free(content->row_starts);
+  }
+  for (i32 i = 0; i < PREVIEW_WRAP_CACHE; i++) {
+    free(content->wraps[i].row_starts);
+  }
+  SyntaxLines_Free(&content->syntax);
+
   if (content->img) {
     Image_Free(content->img);
   }
@@ -117,10 +144,139 @@ static b32 PreviewContentIsCacheable(const preview_content *content) {
     return false;
   }
 
-  return content->type == WB_PREVIEW_CONTENT_TEXT ||
-         content->type == WB_PREVIEW_CONTENT_IMAGE ||
-         content->type == WB_PREVIEW_CONTENT_DIRECTORY ||
-         content->type == WB_PREVIEW_CONTENT_METADATA;
+  /* A partial folder summary is replaced by the next one */
+  return !content->partial &&
+         (content->type == WB_PREVIEW_CONTENT_TEXT ||
+          content->type == WB_PREVIEW_CONTENT_HEX ||
+          content->type == WB_PREVIEW_CONTENT_IMAGE ||
+          content->type == WB_PREVIEW_CONTENT_DIRECTORY ||
+          content->type == WB_PREVIEW_CONTENT_METADATA);
+}
+
+static b32 PreviewContentSameFile(const preview_content *a,
+                                  const preview_content *b) {
+  return a->path[0] && strcmp(a->path, b->path) == 0 && a->size == b->size &&
+         a->modified_time == b->modified_time;
+}
+
+static b32 PreviewContentMatches(const preview_content *content,
+                                 const fs_entry *entry) {
+  if (!content || !entry || !content->path[0]) {
+    return false;
+  }
+
+  return strcmp(content->path, entry->path) == 0 && content->size == entry->size &&
+         content->modified_time == entry->modified_time;
+}
+
+/* ===== Preview Cache ===== */
+
+/* Memory a cached preview holds on to. Mapped files only count their
+ * bookkeeping: their pages belong to the page cache. */
+static u64 PreviewContentBytes(const preview_content *content) {
+  u64 bytes = sizeof(*content) + (u64)content->row_capacity * sizeof(u32) +
+              (u64)content->syntax.capacity * (sizeof(u64) + sizeof(syntax_state));
+
+  for (i32 i = 0; i < PREVIEW_WRAP_CACHE; i++) {
+    bytes += (u64)content->wraps[i].row_capacity * sizeof(u32);
+  }
+  if (content->text && !content->lines && !content->map.data) {
+    bytes += content->text_len;
+  }
+  if (content->img) {
+    bytes += (u64)content->img->width * (u64)content->img->height * 4;
+  }
+  return bytes;
+}
+
+/* Free slot 'index', moving the last entry into it */
+static void PreviewCache_Remove(preview_cache *cache, i32 index) {
+  i32 last = cache->count - 1;
+
+  PreviewContent_Clear(&cache->entries[index]);
+  cache->bytes -= cache->entry_bytes[index];
+  if (index != last) {
+    cache->entries[index] = cache->entries[last];
+    cache->last_used[index] = cache->last_used[last];
+    cache->entry_bytes[index] = cache->entry_bytes[last];
+    memset(&cache->entries[last], 0, sizeof(cache->entries[last]));
+  }
+  cache->count--;
+}
+
+static void PreviewCache_EvictOldest(preview_cache *cache) {
+  i32 oldest = 0;
+
+  for (i32 i = 1; i < cache->count; i++) {
+    if (cache->last_used[i] < cache->last_used[oldest]) {
+      oldest = i;
+    }
+  }
+  PreviewCache_Remove(cache, oldest);
+  cache->evictions++;
+}
+
+/* Evict until 'incoming' more bytes and one more entry fit */
+static void PreviewCache_MakeRoom(preview_cache *cache, u64 incoming) {
+  while (cache->count > 0 && (cache->count == PREVIEW_CACHE_SLOTS ||
+                              cache->bytes + incoming > cache->max_bytes)) {
+    PreviewCache_EvictOldest(cache);
+  }
+}
+
+/* Take ownership of 'content' (left empty) */
+static void PreviewCache_Put(preview_cache *cache, preview_content *content) {
+  u64 bytes = PreviewContentBytes(content);
+
+  if (!PreviewContentIsCacheable(content) || !content->path[0] ||
+      bytes > cache->max_bytes) {
+    PreviewContent_Clear(content);
+    return;
+  }
+
+  /* An older version of the same file is never shown again */
+  for (i32 i = cache->count - 1; i >= 0; i--) {
+    if (strcmp(cache->entries[i].path, content->path) == 0) {
+      PreviewCache_Remove(cache, i);
+    }
+  }
+
+  PreviewCache_MakeRoom(cache, bytes);
+  PreviewContent_Move(&cache->entries[cache->count], content);
+  cache->last_used[cache->count] = ++cache->clock;
+  cache->entry_bytes[cache->count] = bytes;
+  cache->bytes += bytes;
+  cache->count++;
+}
+
+static i32 PreviewCache_Find(const preview_cache *cache, const fs_entry *entry) {
+  for (i32 i = 0; i < cache->count; i++) {
+    if (PreviewContentMatches(&cache->entries[i], entry)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Move the cached preview of 'entry' to 'out'. Returns false on a miss. */
+static b32 PreviewCache_Take(preview_cache *cache, const fs_entry *entry,
+                             preview_content *out) {
+  i32 index = PreviewCache_Find(cache, entry);
+
+  if (index < 0) {
+    cache->misses++;
+    return false;
+  }
+  PreviewContent_Move(out, &cache->entries[index]);
+  PreviewCache_Remove(cache, index);
+  cache->hits++;
+  return true;
+}
+
+static void PreviewCache_Clear(preview_cache *cache) {
+  while (cache->count > 0) {
+    PreviewCache_Remove(cache, cache->count - 1);
+  }
 }
 
 static void PreviewPanel_PreserveCurrent(preview_state *state) {
@@ -128,9 +284,7 @@ static void PreviewPanel_PreserveCurrent(preview_state *state) {
     return;
   }
 
-  if (PreviewContentIsCacheable(&state->current)) {
-    PreviewContent_Move(&state->previous, &state->current);
-  }
+  PreviewCache_Put(&state->cache, &state->current);
 }
 
 static b32 PreviewEntryEquals(preview_state *state, i32 selection_count,
@@ -219,8 +373,108 @@ static b32 PreviewBufferLooksBinary(const u8 *data, usize size) {
   return sample > 0 && (control_count * 5) > sample;
 }
 
+/* Binary content is shown as a hex dump straight from the mapping */
+static void PreviewSetHex(preview_content *result, platform_file_map map) {
+  result->type = WB_PREVIEW_CONTENT_HEX;
+  result->map = map;
+  result->text = (char *)map.data;
+  result->text_len = (usize)map.size;
+}
+
+static void PreviewLoadHex(const preview_request *req,
+                           preview_content *result) {
+  platform_file_map map;
+  if (!Platform_MapFile(req->path, &map)) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Failed to read file");
+    return;
+  }
+
+  if (!map.data) {
+    result->type = WB_PREVIEW_CONTENT_METADATA;
+    PreviewCopyString(result->detail, sizeof(result->detail), "Empty file");
+    return;
+  }
+
+  PreviewSetHex(result, map);
+}
+
+/* Files over the text budget are mapped instead of copied; their line index
+ * is built on demand. Returns false to fall back to a truncated read. */
+static b32 PreviewLoadMapped(const preview_request *req,
+                             preview_content *result) {
+  platform_file_map map;
+  if (!Platform_MapFile(req->path, &map) || !map.data) {
+    return false;
+  }
+
+  if (PreviewBufferLooksBinary(map.data, (usize)Min(map.size, 512))) {
+    PreviewSetHex(result, map);
+    return true;
+  }
+
+  line_index *lines = LineIndex_Create(map);
+  if (!lines) {
+    Platform_UnmapFile(&map);
+    return false;
+  }
+
+  result->type = WB_PREVIEW_CONTENT_TEXT;
+  result->lines = lines;
+  result->text = (char *)lines->map.data;
+  result->text_len = (usize)lines->map.size;
+  return true;
+}
+
+/* Asked by the loaders between chunks of work: has the UI moved on from
+ * what this worker is loading? (NULL worker: a synchronous load) */
+static b32 PreviewWorker_IsCancelled(void *user_data) {
+  preview_worker *worker = (preview_worker *)user_data;
+  b32 cancelled;
+
+  if (!worker) {
+    return false;
+  }
+  Platform_LockMutex(worker->owner->mutex);
+  cancelled = worker->cancelled || worker->owner->shutdown_requested;
+  Platform_UnlockMutex(worker->owner->mutex);
+  return cancelled;
+}
+
+/* Hand a finished load (or a progress update of one) over to the UI.
+ * Called with the mutex held. */
+static void PreviewWorker_Publish(preview_worker *worker,
+                                  preview_content *result) {
+  preview_state *state = worker->owner;
+
+  if (worker->cancelled || state->shutdown_requested) {
+    PreviewContent_Clear(result);
+  } else if (worker->is_prefetch) {
+    state->prefetch_results[state->prefetch_result_count++] = *result;
+  } else {
+    /* May have been bumped by a newer request for the same file */
+    result->generation = worker->request.generation;
+    if (state->worker_has_result &&
+        state->worker_result.generation > result->generation) {
+      PreviewContent_Clear(result);
+      return;
+    }
+    if (state->worker_has_result) {
+      PreviewContent_Clear(&state->worker_result);
+    }
+    state->worker_result = *result;
+    state->worker_has_result = true;
+  }
+}
+
 static void PreviewLoadText(preview_state *state, const preview_request *req,
-                            preview_content *result) {
+                            preview_content *result, preview_worker *worker) {
+  if (req->size > (u64)Max(state->text_max_bytes, 1024) &&
+      PreviewLoadMapped(req, result)) {
+    return;
+  }
+
   FILE *file = fopen(req->path, "rb");
   if (!file) {
     result->type = WB_PREVIEW_CONTENT_ERROR;
@@ -238,14 +492,21 @@ static void PreviewLoadText(preview_state *state, const preview_request *req,
     return;
   }
 
-  usize read_bytes = fread(buffer, 1, max_bytes, file);
+  usize read_bytes = 0;
+  while (read_bytes < max_bytes) {
+    usize want = Min(max_bytes - read_bytes, (usize)PREVIEW_READ_CHUNK);
+    usize got = fread(buffer + read_bytes, 1, want, file);
+    read_bytes += got;
+    if (got < want || PreviewWorker_IsCancelled(worker)) {
+      break;
+    }
+  }
   fclose(file);
   buffer[read_bytes] = '\0';
 
   if (PreviewBufferLooksBinary((const u8 *)buffer, read_bytes)) {
     free(buffer);
-    result->type = WB_PREVIEW_CONTENT_METADATA;
-    PreviewCopyString(result->detail, sizeof(result->detail), "Binary file");
+    PreviewLoadHex(req, result);
     return;
   }
 
@@ -254,8 +515,19 @@ static void PreviewLoadText(preview_state *state, const preview_request *req,
   result->text_len = read_bytes;
 }
 
+/* Freedesktop size for an image request: the smallest that covers the box */
+static thumbnail_size PreviewThumbnailSize(const preview_request *req) {
+  return Thumbnail_SizeCovering(
+      Max(req->image_fit_width, req->image_fit_height));
+}
+
+/* A fresh decode hands back a copy of its thumbnail in 'out_thumbnail' for
+ * the caller to store once the preview is shown */
 static void PreviewLoadImage(preview_state *state, const preview_request *req,
-                             preview_content *result) {
+                             preview_content *result, image **out_thumbnail,
+                             preview_worker *worker) {
+  thumbnail_size thumb_size = PreviewThumbnailSize(req);
+
   if (state->image_max_decode_bytes > 0 &&
       req->size > (u64)state->image_max_decode_bytes) {
     result->type = WB_PREVIEW_CONTENT_METADATA;
@@ -264,158 +536,800 @@ static void PreviewLoadImage(preview_state *state, const preview_request *req,
     return;
   }
 
-  result->img = Image_Load(req->path);
-  if (!result->img) {
-    result->type = WB_PREVIEW_CONTENT_ERROR;
+  /* Checked from the header, before the full-size decode */
+  if (state->image_max_dimension > 0 &&
+      Image_GetSize(req->path, &result->image_width, &result->image_height) &&
+      (result->image_width > state->image_max_dimension ||
+       result->image_height > state->image_max_dimension)) {
+    result->type = WB_PREVIEW_CONTENT_METADATA;
     PreviewCopyString(result->detail, sizeof(result->detail),
-                      "Failed to decode image");
+                      "Image dimensions exceed preview limit");
     return;
   }
 
-  if (state->image_max_dimension > 0 &&
-      (result->img->width > state->image_max_dimension ||
-       result->img->height > state->image_max_dimension)) {
-    Image_Free(result->img);
-    result->img = NULL;
-    result->type = WB_PREVIEW_CONTENT_METADATA;
+  /* The shared cache holds a thumbnail at least as large as it would be
+   * downscaled to, unless the box is larger than the largest size */
+  if (state->thumbnail_cache &&
+      Thumbnail_Pixels(thumb_size) >=
+          Max(req->image_fit_width, req->image_fit_height)) {
+    result->img = Thumbnail_Load(req->path, req->modified_time, thumb_size);
+    if (result->img) {
+      if (!Image_GetSize(req->path, &result->image_width,
+                         &result->image_height)) {
+        result->image_width = result->img->width;
+        result->image_height = result->img->height;
+      }
+      Image_Downscale(result->img, req->image_fit_width,
+                      req->image_fit_height);
+      result->type = WB_PREVIEW_CONTENT_IMAGE;
+      return;
+    }
+  }
+
+  result->img = Image_LoadCancellable(
+      req->path, worker ? PreviewWorker_IsCancelled : NULL, worker);
+  if (!result->img) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
     PreviewCopyString(result->detail, sizeof(result->detail),
-                      "Image dimensions exceed preview limit");
+                      "Failed to decode image");
     return;
   }
 
+  /* Only the thumbnail is kept: drawing and caching it is far cheaper */
+  result->image_width = result->img->width;
+  result->image_height = result->img->height;
+  Image_Downscale(result->img, req->image_fit_width, req->image_fit_height);
   result->type = WB_PREVIEW_CONTENT_IMAGE;
-}
-
-static void PreviewBuildResult(preview_state *state, const preview_request *req,
-                               preview_content *result) {
-  memset(result, 0, sizeof(*result));
-  PreviewContent_CopyMeta(result, req);
 
-  switch (req->load_kind) {
-  case WB_PREVIEW_LOAD_TEXT:
-    PreviewLoadText(state, req, result);
-    break;
-  case WB_PREVIEW_LOAD_IMAGE:
-    PreviewLoadImage(state, req, result);
-    break;
-  case WB_PREVIEW_LOAD_NONE:
-  default:
-    result->type = req->is_directory ? WB_PREVIEW_CONTENT_DIRECTORY
-                                     : WB_PREVIEW_CONTENT_METADATA;
-    break;
+  if (state->thumbnail_cache && out_thumbnail &&
+      !PreviewWorker_IsCancelled(worker)) {
+    *out_thumbnail = Image_Copy(result->img);
+    if (*out_thumbnail) {
+      i32 pixels = Thumbnail_Pixels(thumb_size);
+      Image_Downscale(*out_thumbnail, pixels, pixels);
+    }
   }
 }
 
-static void *PreviewPanel_WorkerThread(void *arg) {
-  preview_state *state = (preview_state *)arg;
+/* ===== Directory Summary =====
+ * A folder previews as counts over its children (files, folders, size,
+ * newest file, kinds) and a listing of the first PREVIEW_DIRECTORY_LIST of
+ * them. The children are enumerated without a stat per entry where the
+ * file system gives their type, and files are stat'ed one by one for size
+ * and time. Large folders show partial summaries as counting goes on; past
+ * preview.directory.time_budget_ms the summary stops where it got to. The
+ * finished summary is cached like any preview, so it is kept until the
+ * folder's modified time changes.
+ */
 
-  for (;;) {
-    preview_request request = {0};
+typedef struct {
+  char name[FS_MAX_NAME];
+  u64 size;
+  b32 is_directory;
+} preview_directory_child;
+
+typedef struct {
+  const preview_request *req;
+  preview_worker *worker;
+  u64 deadline_ms;
+  u64 next_progress_ms;
+  b32 timed_out;
+
+  u64 item_count;
+  u64 file_count;
+  u64 folder_count;
+  u64 total_size; /* Of the files, not what is inside subfolders */
+  u64 newest_time;
+  char newest_name[FS_MAX_NAME];
+  u64 kind_counts[WB_FILE_ICON_COUNT];
+
+  preview_directory_child *children; /* PREVIEW_DIRECTORY_LIST of them */
+  u32 child_count;
+} preview_directory_scan;
+
+static int PreviewDirectoryChildCompare(const void *a, const void *b) {
+  const preview_directory_child *left = (const preview_directory_child *)a;
+  const preview_directory_child *right = (const preview_directory_child *)b;
+
+  if (left->is_directory != right->is_directory) {
+    return left->is_directory ? -1 : 1;
+  }
+  return strcasecmp(left->name, right->name);
+}
 
-    Platform_LockMutex(state->mutex);
-    while (!state->shutdown_requested && !state->worker_has_request) {
-      Platform_CondWait(state->cond_var, state->mutex);
-    }
+/* Append formatted text, growing the buffer (false when out of memory) */
+static b32 PreviewDirectoryAppend(char **text, usize *len, usize *capacity,
+                                  const char *line) {
+  usize line_len = strlen(line);
 
-    if (state->shutdown_requested) {
-      Platform_UnlockMutex(state->mutex);
-      break;
+  if (*len + line_len + 1 > *capacity) {
+    usize grown = Max(*capacity * 2, *len + line_len + 1);
+    char *bigger = (char *)realloc(*text, grown);
+    if (!bigger) {
+      return false;
     }
+    *text = bigger;
+    *capacity = grown;
+  }
+  memcpy(*text + *len, line, line_len + 1);
+  *len += line_len;
+  return true;
+}
 
-    request = state->worker_request;
-    state->worker_has_request = false;
-    Platform_UnlockMutex(state->mutex);
+/* The summary so far as a preview of its own */
+static void PreviewDirectoryFormat(preview_directory_scan *scan, b32 partial,
+                                   preview_content *result) {
+  static const struct {
+    file_icon_type icon;
+    const char *label;
+  } kinds[] = {
+      {WB_FILE_ICON_IMAGE, "images"},         {WB_FILE_ICON_CODE_C, "C"},
+      {WB_FILE_ICON_CODE_H, "headers"},       {WB_FILE_ICON_CODE_PY, "Python"},
+      {WB_FILE_ICON_CODE_JS, "JavaScript"},   {WB_FILE_ICON_CODE_OTHER, "code"},
+      {WB_FILE_ICON_DOCUMENT, "documents"},   {WB_FILE_ICON_MARKDOWN, "Markdown"},
+      {WB_FILE_ICON_CONFIG, "config"},        {WB_FILE_ICON_ARCHIVE, "archives"},
+      {WB_FILE_ICON_AUDIO, "audio"},          {WB_FILE_ICON_VIDEO, "video"},
+      {WB_FILE_ICON_EXECUTABLE, "executables"},
+      {WB_FILE_ICON_SYMLINK, "links"},        {WB_FILE_ICON_FILE, "other"},
+  };
+  char line[FS_MAX_NAME + 128];
+  char size_text[32];
+  char time_text[64];
+  usize capacity = Kilobytes(4);
+  usize len = 0;
+  char *text = (char *)malloc(capacity);
+  b32 ok = text != NULL;
 
-    preview_content result;
-    PreviewBuildResult(state, &request, &result);
+  memset(result, 0, sizeof(*result));
+  PreviewContent_CopyMeta(result, scan->req);
+  result->type = WB_PREVIEW_CONTENT_DIRECTORY;
+  result->partial = partial;
+  if (partial) {
+    snprintf(result->detail, sizeof(result->detail),
+             "Counting... %llu items so far",
+             (unsigned long long)scan->item_count);
+  } else if (scan->timed_out) {
+    snprintf(result->detail, sizeof(result->detail),
+             "Stopped counting after %llu items",
+             (unsigned long long)scan->item_count);
+  }
+  if (!ok) {
+    return;
+  }
+  text[0] = '\0';
 
-    Platform_LockMutex(state->mutex);
-    if (state->worker_has_result) {
-      PreviewContent_Clear(&state->worker_result);
+  snprintf(line, sizeof(line), "Items: %llu (%llu files, %llu folders)\n",
+           (unsigned long long)scan->item_count,
+           (unsigned long long)scan->file_count,
+           (unsigned long long)scan->folder_count);
+  ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, line);
+  FS_FormatSize(scan->total_size, size_text, sizeof(size_text));
+  snprintf(line, sizeof(line), "Total size: %s (subfolders not counted)\n",
+           size_text);
+  ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, line);
+  if (scan->newest_name[0]) {
+    FS_FormatTime(scan->newest_time, time_text, sizeof(time_text));
+    snprintf(line, sizeof(line), "Newest: %s (%s)\n", scan->newest_name,
+             time_text);
+    ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, line);
+  }
+
+  {
+    i32 at = snprintf(line, sizeof(line), "Kinds:");
+    i32 listed = 0;
+    for (usize i = 0; i < ArrayCount(kinds) && at < (i32)sizeof(line); i++) {
+      u64 count = scan->kind_counts[kinds[i].icon];
+      if (count > 0) {
+        at += snprintf(line + at, sizeof(line) - (usize)at, "%s %llu %s",
+                       listed++ ? "," : "", (unsigned long long)count,
+                       kinds[i].label);
+      }
+    }
+    if (listed > 0) {
+      ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, line) &&
+           PreviewDirectoryAppend(&text, &len, &capacity, "\n");
     }
-    state->worker_result = result;
-    state->worker_has_result = true;
-    Platform_UnlockMutex(state->mutex);
   }
 
-  return NULL;
+  if (scan->child_count > 0) {
+    ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, "\n");
+    qsort(scan->children, scan->child_count, sizeof(scan->children[0]),
+          PreviewDirectoryChildCompare);
+  }
+  for (u32 i = 0; i < scan->child_count && ok; i++) {
+    const preview_directory_child *child = &scan->children[i];
+    FS_FormatSize(child->size, size_text, sizeof(size_text));
+    snprintf(line, sizeof(line), "%10s  %s%s\n",
+             child->is_directory ? "-" : size_text, child->name,
+             child->is_directory ? "/" : "");
+    ok = PreviewDirectoryAppend(&text, &len, &capacity, line);
+  }
+  if (scan->item_count > scan->child_count) {
+    snprintf(line, sizeof(line), "%10s  ... and %llu more\n", "",
+             (unsigned long long)(scan->item_count - scan->child_count));
+    ok = ok && PreviewDirectoryAppend(&text, &len, &capacity, line);
+  }
+
+  if (!ok) {
+    free(text);
+    return;
+  }
+  result->text = text;
+  result->text_len = len;
 }
 
-void PreviewPanel_Init(preview_state *state) {
-  memset(state, 0, sizeof(*state));
-  state->splitter_id = UI_GenID("PreviewPanelSplitter");
-  state->observed_selection_count = -1;
-  ScrollContainer_Init(&state->scroll);
-  PreviewPanel_RefreshConfig(state);
+static b32 PreviewDirectoryVisit(void *user_data, const char *name,
+                                 file_type type) {
+  preview_directory_scan *scan = (preview_directory_scan *)user_data;
+  b32 is_directory = type == WB_FILE_TYPE_DIRECTORY;
+  file_icon_type icon = type == WB_FILE_TYPE_SYMLINK
+                            ? WB_FILE_ICON_SYMLINK
+                            : FS_GetIconType(name, is_directory);
+  u64 size = 0;
+
+  scan->item_count++;
+  scan->kind_counts[icon]++;
+  if (is_directory) {
+    scan->folder_count++;
+  } else if (type != WB_FILE_TYPE_UNKNOWN) {
+    char path[FS_MAX_PATH];
+    file_info info;
+
+    scan->file_count++;
+    FS_JoinPath(path, sizeof(path), scan->req->path, name);
+    if (Platform_GetFileInfo(path, &info)) {
+      size = info.size;
+      scan->total_size += info.size;
+      if (info.modified_time > scan->newest_time) {
+        scan->newest_time = info.modified_time;
+        PreviewCopyString(scan->newest_name, sizeof(scan->newest_name), name);
+      }
+    }
+  }
 
-  state->mutex = Platform_CreateMutex();
-  state->cond_var = Platform_CreateCondVar();
-  if (state->mutex && state->cond_var) {
-    state->thread = Platform_CreateThread(PreviewPanel_WorkerThread, state);
+  if (scan->child_count < PREVIEW_DIRECTORY_LIST) {
+    preview_directory_child *child = &scan->children[scan->child_count++];
+    PreviewCopyString(child->name, sizeof(child->name), name);
+    child->size = size;
+    child->is_directory = is_directory;
   }
-}
 
-void PreviewPanel_Shutdown(preview_state *state) {
-  if (state->mutex && state->cond_var) {
-    Platform_LockMutex(state->mutex);
-    state->shutdown_requested = true;
-    if (state->worker_has_result) {
-      PreviewContent_Clear(&state->worker_result);
-      state->worker_has_result = false;
+  if (scan->item_count % PREVIEW_DIRECTORY_CHECK == 0) {
+    u64 now = Platform_GetTimeMs();
+
+    if (PreviewWorker_IsCancelled(scan->worker)) {
+      return false;
+    }
+    if (now >= scan->deadline_ms) {
+      scan->timed_out = true;
+      return false;
+    }
+    /* Show what is counted so far; only the selection's own load can */
+    if (scan->worker && !scan->worker->is_prefetch &&
+        now >= scan->next_progress_ms) {
+      preview_content progress;
+      PreviewDirectoryFormat(scan, true, &progress);
+      Platform_LockMutex(scan->worker->owner->mutex);
+      PreviewWorker_Publish(scan->worker, &progress);
+      Platform_UnlockMutex(scan->worker->owner->mutex);
+      scan->next_progress_ms = now + PREVIEW_DIRECTORY_PROGRESS_MS;
     }
-    Platform_CondSignal(state->cond_var);
-    Platform_UnlockMutex(state->mutex);
   }
-  PreviewContent_Clear(&state->current);
-  PreviewContent_Clear(&state->previous);
+  return true;
 }
 
-void PreviewPanel_RefreshConfig(preview_state *state) {
-  state->enabled = Config_GetBool("preview.enabled", false);
-  state->width_ratio =
-      (f32)Config_GetF64("preview.width_ratio", 0.40);
-  if (state->width_ratio < PREVIEW_MIN_RATIO) {
-    state->width_ratio = PREVIEW_MIN_RATIO;
+static void PreviewLoadDirectory(preview_state *state,
+                                 const preview_request *req,
+                                 preview_content *result,
+                                 preview_worker *worker) {
+  preview_directory_scan scan;
+  u64 now = Platform_GetTimeMs();
+
+  memset(&scan, 0, sizeof(scan));
+  scan.req = req;
+  scan.worker = worker;
+  scan.deadline_ms = now + (u64)Max(state->directory_budget_ms, 1);
+  scan.next_progress_ms = now + PREVIEW_DIRECTORY_PROGRESS_MS;
+  scan.children = (preview_directory_child *)malloc(
+      sizeof(preview_directory_child) * PREVIEW_DIRECTORY_LIST);
+  if (!scan.children) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail), "Out of memory");
+    return;
   }
-  if (state->width_ratio > PREVIEW_MAX_RATIO) {
-    state->width_ratio = PREVIEW_MAX_RATIO;
+
+  if (!Platform_EnumerateDirectory(req->path, PreviewDirectoryVisit, &scan)) {
+    free(scan.children);
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Failed to read folder");
+    return;
   }
 
-  state->text_max_bytes = Config_GetI64("preview.text.max_bytes", 262144);
-  state->image_max_decode_bytes =
-      Config_GetI64("preview.image.max_decode_bytes", 33554432);
-  state->image_max_dimension =
-      Config_GetI64("preview.image.max_dimension", 4096);
-  state->selection_debounce_ms =
-      Config_GetI64("preview.selection_debounce_ms", 60);
+  PreviewDirectoryFormat(&scan, false, result);
+  free(scan.children);
 }
 
-b32 PreviewPanel_IsVisible(preview_state *state, b32 preview_allowed) {
-  return state->enabled && preview_allowed;
-}
+/* ===== Archives =====
+ * A zip archive previews as its member listing, and a member inside one as
+ * the file would: it is inflated into memory (up to
+ * preview.archive.max_member_bytes), never written to disk.
+ */
 
-void PreviewPanel_ComputeBounds(preview_state *state, rect bounds,
-                                rect *out_list_bounds,
-                                rect *out_splitter_bounds,
-                                rect *out_preview_bounds) {
-  rect list_bounds = bounds;
-  rect splitter_bounds = {bounds.x + bounds.w, bounds.y, 0, bounds.h};
-  rect preview_bounds = {bounds.x + bounds.w, bounds.y, 0, bounds.h};
+/* One line per member of the folder at 'dir' ("" for the whole archive) */
+static void PreviewListArchive(preview_state *state, const zip_archive *zip,
+                               const char *dir, preview_content *result,
+                               preview_worker *worker) {
+  usize max_bytes = (usize)Max(state->text_max_bytes, 1024);
+  usize dir_len = strlen(dir);
+  usize capacity = Min(max_bytes, (usize)Kilobytes(16));
+  usize len = 0;
+  u32 listed = 0;
+  char *text = (char *)malloc(capacity + 1);
 
-  i32 usable_width = bounds.w - PREVIEW_SPLITTER_WIDTH;
-  if (usable_width > 0) {
-    i32 min_preview = Min(PREVIEW_MIN_WIDTH, Max(usable_width - 1, 0));
-    i32 min_list = Min(PREVIEW_MIN_LIST_WIDTH, Max(usable_width - min_preview, 0));
-    i32 max_preview = usable_width - min_list;
-    i32 preview_width = (i32)((f32)usable_width * state->width_ratio);
+  if (!text) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail), "Out of memory");
+    return;
+  }
 
-    if (max_preview < min_preview) {
-      preview_width = Max(usable_width / 3, 0);
-    } else {
-      preview_width = Clamp(preview_width, min_preview, max_preview);
+  for (u32 i = 0; i < zip->member_count; i++) {
+    const zip_member *member = &zip->members[i];
+    char size_text[32];
+    char time_text[64];
+    char line[FS_MAX_PATH + 128];
+
+    if ((i + 1) % PREVIEW_ARCHIVE_CHECK == 0 &&
+        PreviewWorker_IsCancelled(worker)) {
+      break;
+    }
+    if (dir_len > 0 && (member->name_len <= dir_len ||
+                        memcmp(member->name, dir, dir_len) != 0 ||
+                        member->name[dir_len] != '/')) {
+      continue;
     }
 
-    if (preview_width > 0 && preview_width < usable_width) {
+    FS_FormatSize(member->size, size_text, sizeof(size_text));
+    FS_FormatTime(member->modified_time, time_text, sizeof(time_text));
+    i32 line_len = snprintf(line, sizeof(line), "%10s  %s  %.*s%s\n",
+                            member->is_directory ? "-" : size_text, time_text,
+                            (int)Min(member->name_len, (u32)FS_MAX_PATH),
+                            member->name, member->is_directory ? "/" : "");
+    if (line_len <= 0) {
+      continue;
+    }
+    line_len = Min(line_len, (i32)sizeof(line) - 1);
+
+    if (len + (usize)line_len > max_bytes) {
+      break; /* Like a truncated read: the text budget holds */
+    }
+    if (len + (usize)line_len > capacity) {
+      usize grown = Min(Max(capacity * 2, len + (usize)line_len), max_bytes);
+      char *bigger = (char *)realloc(text, grown + 1);
+      if (!bigger) {
+        break;
+      }
+      text = bigger;
+      capacity = grown;
+    }
+    memcpy(text + len, line, (usize)line_len);
+    len += (usize)line_len;
+    listed++;
+  }
+  text[len] = '\0';
+
+  if (listed == 0) {
+    free(text);
+    result->type = WB_PREVIEW_CONTENT_METADATA;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      zip->member_count ? "Empty folder" : "Empty archive");
+    return;
+  }
+
+  result->type = WB_PREVIEW_CONTENT_TEXT;
+  result->text = text;
+  result->text_len = len;
+}
+
+/* Inflate a member and preview it as an image, text or hex */
+static void PreviewLoadArchiveMember(preview_state *state,
+                                     const preview_request *req,
+                                     const zip_archive *zip, i32 index,
+                                     preview_content *result) {
+  u64 max_size = (u64)Max(state->archive_max_member_bytes, 0);
+  usize size = 0;
+  u8 *data;
+
+  if (req->load_kind == WB_PREVIEW_LOAD_IMAGE &&
+      state->image_max_decode_bytes > 0) {
+    max_size = Min(max_size, (u64)state->image_max_decode_bytes);
+  }
+  if (zip->members[index].size > max_size) {
+    result->type = WB_PREVIEW_CONTENT_METADATA;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Archive member too large to preview");
+    return;
+  }
+
+  data = ZipArchive_Extract(zip, index, max_size, &size);
+  if (!data) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Failed to extract archive member");
+    return;
+  }
+
+  if (req->load_kind == WB_PREVIEW_LOAD_IMAGE) {
+    result->img = Image_LoadFromMemory(data, size);
+    free(data);
+    if (!result->img) {
+      result->type = WB_PREVIEW_CONTENT_ERROR;
+      PreviewCopyString(result->detail, sizeof(result->detail),
+                        "Failed to decode image");
+      return;
+    }
+    result->image_width = result->img->width;
+    result->image_height = result->img->height;
+    if (state->image_max_dimension > 0 &&
+        (result->image_width > state->image_max_dimension ||
+         result->image_height > state->image_max_dimension)) {
+      Image_Free(result->img);
+      result->img = NULL;
+      result->type = WB_PREVIEW_CONTENT_METADATA;
+      PreviewCopyString(result->detail, sizeof(result->detail),
+                        "Image dimensions exceed preview limit");
+      return;
+    }
+    Image_Downscale(result->img, req->image_fit_width, req->image_fit_height);
+    result->type = WB_PREVIEW_CONTENT_IMAGE;
+    return;
+  }
+
+  if (size == 0) {
+    free(data);
+    result->type = WB_PREVIEW_CONTENT_METADATA;
+    PreviewCopyString(result->detail, sizeof(result->detail), "Empty file");
+    return;
+  }
+
+  /* The buffer is owned (no mapping), so clearing frees it either way */
+  result->text = (char *)data;
+  result->text_len = size;
+  if (req->load_kind == WB_PREVIEW_LOAD_HEX ||
+      PreviewBufferLooksBinary(data, size)) {
+    result->type = WB_PREVIEW_CONTENT_HEX;
+    return;
+  }
+
+  /* Text keeps to the in-memory budget, like a truncated read */
+  result->text_len = Min(size, (usize)Max(state->text_max_bytes, 1024));
+  result->text[result->text_len] = '\0';
+  result->type = WB_PREVIEW_CONTENT_TEXT;
+}
+
+static void PreviewLoadArchive(preview_state *state, const preview_request *req,
+                               const char *archive_path, const char *member,
+                               preview_content *result,
+                               preview_worker *worker) {
+  zip_archive zip;
+  char name[FS_MAX_PATH];
+
+  result->in_archive = true;
+  if (!ZipArchive_Open(&zip, archive_path)) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Failed to read archive");
+    return;
+  }
+
+  PreviewCopyString(name, sizeof(name), member);
+  FS_NormalizePath(name);
+  i32 index = name[0] ? ZipArchive_Find(&zip, name) : -1;
+
+  if (!name[0] || req->is_directory || ZipArchive_IsDirectory(&zip, name)) {
+    PreviewListArchive(state, &zip, name, result, worker);
+  } else if (index < 0) {
+    result->type = WB_PREVIEW_CONTENT_ERROR;
+    PreviewCopyString(result->detail, sizeof(result->detail),
+                      "Archive member not found");
+  } else {
+    PreviewLoadArchiveMember(state, req, &zip, index, result);
+  }
+  ZipArchive_Close(&zip);
+
+  if (result->type == WB_PREVIEW_CONTENT_TEXT) {
+    SyntaxLines_Init(&result->syntax,
+                     name[0] && !req->is_directory
+                         ? Syntax_DetectLanguage(req->name, result->text,
+                                                 Min(result->text_len, 256))
+                         : SYNTAX_LANGUAGE_NONE);
+  }
+}
+
+static void PreviewBuildResult(preview_state *state, const preview_request *req,
+                               preview_content *result, image **out_thumbnail,
+                               preview_worker *worker) {
+  char archive[FS_MAX_PATH];
+  const char *member;
+
+  memset(result, 0, sizeof(*result));
+  PreviewContent_CopyMeta(result, req);
+
+  if (ZipArchive_SplitPath(req->path, archive, sizeof(archive), &member)) {
+    PreviewLoadArchive(state, req, archive, member, result, worker);
+    return;
+  }
+
+  switch (req->load_kind) {
+  case WB_PREVIEW_LOAD_TEXT:
+    PreviewLoadText(state, req, result, worker);
+    if (result->type == WB_PREVIEW_CONTENT_TEXT) {
+      SyntaxLines_Init(&result->syntax,
+                       Syntax_DetectLanguage(req->name, result->text,
+                                             Min(result->text_len, 256)));
+    }
+    break;
+  case WB_PREVIEW_LOAD_IMAGE:
+    PreviewLoadImage(state, req, result, out_thumbnail, worker);
+    break;
+  case WB_PREVIEW_LOAD_HEX:
+    PreviewLoadHex(req, result);
+    break;
+  case WB_PREVIEW_LOAD_DIRECTORY:
+    PreviewLoadDirectory(state, req, result, worker);
+    break;
+  case WB_PREVIEW_LOAD_NONE:
+  default:
+    result->type = req->is_directory ? WB_PREVIEW_CONTENT_DIRECTORY
+                                     : WB_PREVIEW_CONTENT_METADATA;
+    break;
+  }
+}
+
+/* Next queued neighbour an idle worker may take: text before images, and
+ * an image only while another worker stays idle for the selection. -1 if
+ * there is none. Called with the mutex held. */
+static i32 PreviewPanel_PickPrefetch(preview_state *state) {
+  i32 idle = 0;
+  i32 image_index = -1;
+
+  if (state->prefetch_in_flight + state->prefetch_result_count >=
+      PREVIEW_PREFETCH_MAX) {
+    return -1;
+  }
+
+  for (i32 i = 0; i < state->worker_count; i++) {
+    idle += state->workers[i].busy ? 0 : 1;
+  }
+  for (i32 i = state->prefetch_next; i < state->prefetch_count; i++) {
+    if (state->prefetch_queue[i].load_kind != WB_PREVIEW_LOAD_IMAGE) {
+      return i;
+    }
+    if (image_index < 0) {
+      image_index = i;
+    }
+  }
+  return (idle > 1 || state->worker_count == 1) ? image_index : -1;
+}
+
+static void *PreviewPanel_WorkerThread(void *arg) {
+  preview_worker *worker = (preview_worker *)arg;
+  preview_state *state = worker->owner;
+
+  Platform_LockMutex(state->mutex);
+  for (;;) {
+    i32 prefetch = -1;
+
+    while (!state->shutdown_requested && !state->worker_has_request &&
+           (prefetch = PreviewPanel_PickPrefetch(state)) < 0) {
+      Platform_CondWait(state->cond_var, state->mutex);
+    }
+
+    if (state->shutdown_requested) {
+      break;
+    }
+
+    /* The selection always goes before speculation */
+    if (state->worker_has_request) {
+      worker->request = state->worker_request;
+      worker->is_prefetch = false;
+      state->worker_has_request = false;
+    } else {
+      preview_request *queue = state->prefetch_queue;
+      preview_request picked = queue[prefetch];
+      queue[prefetch] = queue[state->prefetch_next];
+      queue[state->prefetch_next++] = picked;
+      worker->request = picked;
+      worker->is_prefetch = true;
+      state->prefetch_in_flight++;
+    }
+    worker->busy = true;
+    worker->cancelled = false;
+    preview_request request = worker->request;
+    Platform_UnlockMutex(state->mutex);
+
+    preview_content result;
+    image *thumbnail = NULL;
+    PreviewBuildResult(state, &request, &result, &thumbnail, worker);
+
+    Platform_LockMutex(state->mutex);
+    b32 cancelled = worker->cancelled;
+    if (worker->is_prefetch) {
+      state->prefetch_in_flight--;
+    }
+    PreviewWorker_Publish(worker, &result);
+    worker->busy = false;
+    Platform_CondBroadcast(state->cond_var); /* Frees up image prefetches */
+    Platform_UnlockMutex(state->mutex);
+
+    /* Encoding takes a while, so it waits until the preview is out */
+    if (thumbnail) {
+      if (!cancelled) {
+        Thumbnail_Save(request.path, request.modified_time, request.size,
+                       PreviewThumbnailSize(&request), thumbnail);
+      }
+      Image_Free(thumbnail);
+    }
+    Platform_LockMutex(state->mutex);
+  }
+  Platform_UnlockMutex(state->mutex);
+
+  return NULL;
+}
+
+void PreviewPanel_Init(preview_state *state) {
+  memset(state, 0, sizeof(*state));
+  state->splitter_id = UI_GenID("PreviewPanelSplitter");
+  state->observed_selection_count = -1;
+  state->observed_index = -1;
+  state->travel = 1;
+  ScrollContainer_Init(&state->scroll);
+  PreviewPanel_RefreshConfig(state);
+
+  state->worker_threads = Config_GetI64("preview.workers", 2);
+  state->mutex = Platform_CreateMutex();
+  state->cond_var = Platform_CreateCondVar();
+  if (state->mutex && state->cond_var) {
+    i32 count = (i32)Clamp(state->worker_threads, 1, PREVIEW_WORKER_MAX);
+    for (i32 i = 0; i < count; i++) {
+      preview_worker *worker = &state->workers[state->worker_count];
+      worker->owner = state;
+      worker->thread = Platform_CreateThread(PreviewPanel_WorkerThread, worker);
+      if (!worker->thread) {
+        break;
+      }
+      state->worker_count++;
+    }
+  }
+
+  state->follow_watcher_ready = FSWatcher_Init(&state->follow_watcher);
+  if (state->thumbnail_cache) {
+    state->thumbnails = ThumbnailGen_Create(state->image_max_dimension);
+  }
+}
+
+void PreviewPanel_Shutdown(preview_state *state) {
+  if (state->mutex && state->cond_var) {
+    Platform_LockMutex(state->mutex);
+    state->shutdown_requested = true;
+    if (state->worker_has_result) {
+      PreviewContent_Clear(&state->worker_result);
+      state->worker_has_result = false;
+    }
+    for (i32 i = 0; i < state->prefetch_result_count; i++) {
+      PreviewContent_Clear(&state->prefetch_results[i]);
+    }
+    state->prefetch_result_count = 0;
+    Platform_CondBroadcast(state->cond_var);
+    Platform_UnlockMutex(state->mutex);
+  }
+  PreviewContent_Clear(&state->current);
+  PreviewCache_Clear(&state->cache);
+  ThumbnailGen_Release(state->thumbnails);
+  state->thumbnails = NULL;
+
+  if (state->follow_watcher_ready) {
+    FSWatcher_Shutdown(&state->follow_watcher);
+    state->follow_watcher_ready = false;
+  }
+}
+
+void PreviewPanel_RefreshConfig(preview_state *state) {
+  state->enabled = Config_GetBool("preview.enabled", false);
+  state->width_ratio =
+      (f32)Config_GetF64("preview.width_ratio", 0.40);
+  if (state->width_ratio < PREVIEW_MIN_RATIO) {
+    state->width_ratio = PREVIEW_MIN_RATIO;
+  }
+  if (state->width_ratio > PREVIEW_MAX_RATIO) {
+    state->width_ratio = PREVIEW_MAX_RATIO;
+  }
+
+  state->text_max_bytes = Config_GetI64("preview.text.max_bytes", 262144);
+  state->image_max_decode_bytes =
+      Config_GetI64("preview.image.max_decode_bytes", 33554432);
+  state->image_max_dimension =
+      Config_GetI64("preview.image.max_dimension", 8192);
+  state->image_thumbnail_size =
+      Config_GetI64("preview.image.thumbnail_size", 1024);
+  state->thumbnail_cache =
+      Config_GetBool("preview.image.thumbnail_cache", true);
+  state->selection_debounce_ms =
+      Config_GetI64("preview.selection_debounce_ms", 60);
+  state->follow = Config_GetBool("preview.follow", true);
+  state->prefetch_ahead = Config_GetI64("preview.prefetch_count", 2);
+  state->syntax_highlight = Config_GetBool("preview.syntax_highlight", true);
+  state->directory_budget_ms =
+      Config_GetI64("preview.directory.time_budget_ms", 2000);
+  state->archive_max_member_bytes =
+      Config_GetI64("preview.archive.max_member_bytes", 67108864);
+  state->cache.max_bytes =
+      (u64)Max(Config_GetI64("preview.cache.max_bytes", 67108864), 0);
+  PreviewCache_MakeRoom(&state->cache, 0);
+}
+
+void PreviewPanel_ToggleFollow(preview_state *state) {
+  state->follow = !state->follow;
+  Config_SetBool("preview.follow", state->follow);
+  Config_Save();
+}
+
+void PreviewPanel_Jump(preview_state *state, preview_jump jump, u64 value) {
+  state->pending_jump = jump;
+  state->pending_jump_value = value;
+}
+
+void PreviewPanel_Find(preview_state *state, const u8 *pattern, usize length) {
+  const preview_content *content = &state->current;
+  b32 same_pattern = length == state->search_pattern_len &&
+                     memcmp(pattern, state->search_pattern, length) == 0;
+
+  if (length == 0 || length > sizeof(state->search_pattern) ||
+      (content->type != WB_PREVIEW_CONTENT_TEXT &&
+       content->type != WB_PREVIEW_CONTENT_HEX)) {
+    return;
+  }
+
+  memcpy(state->search_pattern, pattern, length);
+  state->search_pattern_len = length;
+  state->search_generation = content->generation;
+  state->search_running = true;
+  state->search_wrapped = false;
+  state->search_failed = false;
+  /* Searching again for the same bytes moves on to the next match */
+  state->search_start = (state->has_match && same_pattern)
+                            ? state->match_offset + 1
+                            : content->view_offset;
+  state->search_pos = state->search_start;
+  state->has_match = false;
+}
+
+b32 PreviewPanel_IsVisible(preview_state *state, b32 preview_allowed) {
+  return state->enabled && preview_allowed;
+}
+
+void PreviewPanel_ComputeBounds(preview_state *state, rect bounds,
+                                rect *out_list_bounds,
+                                rect *out_splitter_bounds,
+                                rect *out_preview_bounds) {
+  rect list_bounds = bounds;
+  rect splitter_bounds = {bounds.x + bounds.w, bounds.y, 0, bounds.h};
+  rect preview_bounds = {bounds.x + bounds.w, bounds.y, 0, bounds.h};
+
+  i32 usable_width = bounds.w - PREVIEW_SPLITTER_WIDTH;
+  if (usable_width > 0) {
+    i32 min_preview = Min(PREVIEW_MIN_WIDTH, Max(usable_width - 1, 0));
+    i32 min_list = Min(PREVIEW_MIN_LIST_WIDTH, Max(usable_width - min_preview, 0));
+    i32 max_preview = usable_width - min_list;
+    i32 preview_width = (i32)((f32)usable_width * state->width_ratio);
+
+    if (max_preview < min_preview) {
+      preview_width = Max(usable_width / 3, 0);
+    } else {
+      preview_width = Clamp(preview_width, min_preview, max_preview);
+    }
+
+    if (preview_width > 0 && preview_width < usable_width) {
       list_bounds.w = bounds.w - PREVIEW_SPLITTER_WIDTH - preview_width;
       splitter_bounds =
           (rect){list_bounds.x + list_bounds.w, bounds.y, PREVIEW_SPLITTER_WIDTH,
@@ -436,231 +1350,1482 @@ void PreviewPanel_ComputeBounds(preview_state *state, rect bounds,
   }
 }
 
-static void PreviewPanel_DispatchRequest(preview_state *state,
-                                         const preview_request *request) {
-  if (!state->mutex || !state->cond_var || !state->thread) {
-    preview_content result;
-    PreviewBuildResult(state, request, &result);
-    if (PreviewContentIsCacheable(&state->current)) {
-      PreviewContent_Move(&state->previous, &state->current);
+static b32 PreviewRequestSameFile(const preview_request *a,
+                                  const preview_request *b) {
+  return strcmp(a->path, b->path) == 0 && a->size == b->size &&
+         a->modified_time == b->modified_time && a->load_kind == b->load_kind;
+}
+
+static void PreviewPanel_DispatchRequest(preview_state *state,
+                                         const preview_request *request) {
+  b32 adopted = false;
+
+  if (!state->mutex || !state->cond_var || state->worker_count == 0) {
+    preview_content result;
+    PreviewBuildResult(state, request, &result, NULL, NULL);
+    PreviewPanel_PreserveCurrent(state);
+    PreviewContent_Move(&state->current, &result);
+    return;
+  }
+
+  Platform_LockMutex(state->mutex);
+  /* A worker already loading the file (say, a prefetch of it) just takes
+   * the new generation; loads for older selections stop */
+  for (i32 i = 0; i < state->worker_count; i++) {
+    preview_worker *worker = &state->workers[i];
+    if (!worker->busy || worker->cancelled) {
+      continue;
+    }
+    if (!adopted && PreviewRequestSameFile(&worker->request, request)) {
+      if (worker->is_prefetch) {
+        worker->is_prefetch = false;
+        state->prefetch_in_flight--;
+      }
+      worker->request.generation = request->generation;
+      adopted = true;
+    } else if (!worker->is_prefetch) {
+      worker->cancelled = true;
+    }
+  }
+
+  state->worker_request = *request;
+  state->worker_has_request = !adopted;
+  Platform_CondBroadcast(state->cond_var);
+  Platform_UnlockMutex(state->mutex);
+}
+
+/* Stop loads for selections the UI has moved on from, except one of the
+ * file still being waited for (the debounced request adopts it) */
+static void PreviewPanel_CancelStale(preview_state *state) {
+  const preview_content *current = &state->current;
+
+  if (!state->mutex || state->worker_count == 0) {
+    return;
+  }
+
+  Platform_LockMutex(state->mutex);
+  for (i32 i = 0; i < state->worker_count; i++) {
+    preview_worker *worker = &state->workers[i];
+    const preview_request *req = &worker->request;
+    if (!worker->busy || worker->is_prefetch ||
+        req->generation == state->current_generation) {
+      continue;
+    }
+    if (current->type == WB_PREVIEW_CONTENT_LOADING &&
+        strcmp(req->path, current->path) == 0 &&
+        req->size == current->size &&
+        req->modified_time == current->modified_time) {
+      continue;
+    }
+    worker->cancelled = true;
+  }
+  Platform_UnlockMutex(state->mutex);
+}
+
+static void PreviewPanel_ConsumeWorkerResult(preview_state *state) {
+  preview_content result = {0};
+  b32 has_result = false;
+
+  if (!state->mutex) {
+    return;
+  }
+
+  Platform_LockMutex(state->mutex);
+  if (state->worker_has_result) {
+    result = state->worker_result;
+    memset(&state->worker_result, 0, sizeof(state->worker_result));
+    state->worker_has_result = false;
+    has_result = true;
+  }
+  Platform_UnlockMutex(state->mutex);
+
+  if (!has_result) {
+    return;
+  }
+
+  if (result.generation != state->current_generation) {
+    PreviewContent_Clear(&result);
+    return;
+  }
+
+  /* A newer summary of the same folder keeps the scroll position */
+  b32 update = state->current.partial &&
+               state->current.generation == result.generation;
+  PreviewPanel_PreserveCurrent(state);
+  PreviewContent_Move(&state->current, &result);
+  if (!update) {
+    ScrollContainer_Init(&state->scroll);
+  }
+}
+
+/* A speculative load finished: show it if the selection has caught up with
+ * it, cache it otherwise */
+static void PreviewPanel_ConsumePrefetchResults(preview_state *state) {
+  preview_content results[PREVIEW_PREFETCH_MAX];
+  i32 count = 0;
+
+  if (!state->mutex) {
+    return;
+  }
+
+  Platform_LockMutex(state->mutex);
+  if (state->prefetch_result_count > 0) {
+    count = state->prefetch_result_count;
+    memcpy(results, state->prefetch_results, sizeof(results[0]) * (usize)count);
+    state->prefetch_result_count = 0;
+    Platform_CondBroadcast(state->cond_var); /* Room for the next ones */
+  }
+  Platform_UnlockMutex(state->mutex);
+
+  for (i32 i = 0; i < count; i++) {
+    preview_content *result = &results[i];
+    if (state->current.type == WB_PREVIEW_CONTENT_LOADING &&
+        PreviewContentSameFile(&state->current, result)) {
+      /* Also drops the request for it; a load of it in flight is stale
+       * now and gets cancelled */
+      state->has_pending_request = false;
+      state->current_generation++;
+      result->generation = state->current_generation;
+      PreviewContent_Move(&state->current, result);
+      ScrollContainer_Init(&state->scroll);
+      continue;
+    }
+
+    PreviewCache_Put(&state->cache, result);
+  }
+}
+
+/* Images are decoded into thumbnails no larger than the preview area, or
+ * preview.image.thumbnail_size so panel resizes rarely need a reload */
+static void PreviewSetImageFit(const preview_state *state,
+                               preview_request *req) {
+  i32 minimum = (i32)Clamp(state->image_thumbnail_size, 16, 16384);
+
+  req->image_fit_width = Max(state->image_bounds.w, minimum);
+  req->image_fit_height = Max(state->image_bounds.h, minimum);
+}
+
+static preview_load_kind PreviewGetLoadKind(const fs_entry *entry) {
+  if (!entry) {
+    return WB_PREVIEW_LOAD_NONE;
+  }
+  if (entry->is_directory) {
+    return WB_PREVIEW_LOAD_DIRECTORY;
+  }
+  if (entry->is_special) {
+    /* Opening a FIFO would block the worker until something writes to it */
+    return WB_PREVIEW_LOAD_NONE;
+  }
+  if (ZipArchive_IsArchiveName(entry->name)) {
+    return WB_PREVIEW_LOAD_ARCHIVE;
+  }
+  if (entry->icon == WB_FILE_ICON_IMAGE) {
+    return WB_PREVIEW_LOAD_IMAGE;
+  }
+  if (PreviewPathLooksText(entry)) {
+    return WB_PREVIEW_LOAD_TEXT;
+  }
+
+  switch (entry->icon) {
+  case WB_FILE_ICON_ARCHIVE:
+  case WB_FILE_ICON_EXECUTABLE:
+  case WB_FILE_ICON_AUDIO:
+  case WB_FILE_ICON_VIDEO:
+    return WB_PREVIEW_LOAD_HEX;
+  default:
+    /* Unknown kinds are sniffed: the text load falls back to hex when the
+     * first bytes look binary */
+    return WB_PREVIEW_LOAD_TEXT;
+  }
+}
+
+static void PreviewPanel_BeginLoading(preview_state *state, const fs_entry *entry,
+                                      preview_load_kind load_kind,
+                                      const char *detail) {
+  state->current_generation++;
+  PreviewPanel_PreserveCurrent(state);
+  PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_LOADING, entry,
+                           state->current_generation, detail);
+  state->current.load_kind = load_kind;
+  state->has_pending_request = true;
+  memset(&state->pending_request, 0, sizeof(state->pending_request));
+  state->pending_request.generation = state->current_generation;
+  state->pending_request.load_kind = load_kind;
+  PreviewCopyString(state->pending_request.path,
+                    sizeof(state->pending_request.path), entry->path);
+  PreviewCopyString(state->pending_request.name,
+                    sizeof(state->pending_request.name), entry->name);
+  state->pending_request.icon = entry->icon;
+  state->pending_request.is_directory = entry->is_directory;
+  state->pending_request.size = entry->size;
+  state->pending_request.modified_time = entry->modified_time;
+  PreviewSetImageFit(state, &state->pending_request);
+  state->pending_due_time_ms =
+      Platform_GetTimeMs() + (u64)Max(state->selection_debounce_ms, 0);
+  ScrollContainer_Init(&state->scroll);
+}
+
+static b32 PreviewPrefetchWanted(preview_state *state, const fs_entry *entry) {
+  return entry && !entry->is_directory &&
+         PreviewGetLoadKind(entry) != WB_PREVIEW_LOAD_NONE &&
+         !PreviewContentMatches(&state->current, entry) &&
+         PreviewCache_Find(&state->cache, entry) < 0;
+}
+
+/* Queue the neighbours of a single selection for the worker: the next ones
+ * in the direction of travel, then the one behind. Replaces (cancels) what
+ * was queued for the previous selection. */
+static void PreviewPanel_SchedulePrefetch(preview_state *state, fs_state *fs,
+                                          i32 selection_count) {
+  preview_request queue[PREVIEW_PREFETCH_MAX];
+  i32 count = 0;
+  i32 index = fs ? fs->selected_index : -1;
+  i32 ahead = (i32)Clamp(state->prefetch_ahead, 0, PREVIEW_PREFETCH_MAX - 1);
+
+  if (!state->mutex || state->worker_count == 0) {
+    return;
+  }
+
+  if (index >= 0 && state->observed_index >= 0 && index != state->observed_index) {
+    state->travel = index > state->observed_index ? 1 : -1;
+  }
+  state->observed_index = index;
+
+  if (selection_count == 1 && index >= 0 && ahead > 0) {
+    for (i32 i = 1; i <= ahead + 1; i++) {
+      /* ahead entries forward, then one backward */
+      i32 neighbour = i <= ahead ? index + state->travel * i
+                                 : index - state->travel;
+      fs_entry *entry = FS_GetEntry(fs, neighbour);
+      if (!PreviewPrefetchWanted(state, entry)) {
+        continue;
+      }
+
+      preview_request *req = &queue[count++];
+      memset(req, 0, sizeof(*req));
+      req->load_kind = PreviewGetLoadKind(entry);
+      PreviewCopyString(req->path, sizeof(req->path), entry->path);
+      PreviewCopyString(req->name, sizeof(req->name), entry->name);
+      req->icon = entry->icon;
+      req->size = entry->size;
+      req->modified_time = entry->modified_time;
+      PreviewSetImageFit(state, req);
+    }
+  }
+
+  Platform_LockMutex(state->mutex);
+  memcpy(state->prefetch_queue, queue, sizeof(queue[0]) * (usize)count);
+  state->prefetch_count = count;
+  state->prefetch_next = 0;
+
+  /* Speculation no longer wanted stops, unless it is for the selection
+   * itself (the request for it adopts the load) */
+  for (i32 i = 0; i < state->worker_count; i++) {
+    preview_worker *worker = &state->workers[i];
+    b32 wanted = worker->request.size == state->observed_size &&
+                 worker->request.modified_time ==
+                     state->observed_modified_time &&
+                 strcmp(worker->request.path, state->observed_path) == 0;
+    for (i32 j = 0; j < count && !wanted; j++) {
+      wanted = PreviewRequestSameFile(&worker->request, &queue[j]);
+    }
+    if (worker->busy && worker->is_prefetch && !wanted) {
+      worker->cancelled = true;
+    }
+  }
+
+  if (count > 0) {
+    Platform_CondBroadcast(state->cond_var);
+  }
+  Platform_UnlockMutex(state->mutex);
+}
+
+/* Queue thumbnails for every image of a newly listed folder that holds
+ * enough of them, at the size the preview uses */
+static void PreviewPanel_QueueThumbnails(preview_state *state, fs_state *fs) {
+  thumbnail_job *jobs;
+  preview_request fit = {0};
+  i32 count = 0;
+
+  if (!state->thumbnails || !fs ||
+      (fs->generation == state->thumbnail_dir_generation &&
+       strcmp(fs->current_path, state->thumbnail_dir) == 0)) {
+    return;
+  }
+  PreviewCopyString(state->thumbnail_dir, sizeof(state->thumbnail_dir),
+                    fs->current_path);
+  state->thumbnail_dir_generation = fs->generation;
+
+  jobs = (thumbnail_job *)malloc(sizeof(thumbnail_job) * THUMBNAIL_QUEUE_MAX);
+  if (!jobs) {
+    return;
+  }
+
+  PreviewSetImageFit(state, &fit);
+  for (u32 i = 0; i < fs->entry_count && count < THUMBNAIL_QUEUE_MAX; i++) {
+    const fs_entry *entry = &fs->entries[i];
+    /* Members of an archive have no file of their own to thumbnail */
+    if (fs->in_archive || entry->is_directory ||
+        entry->icon != WB_FILE_ICON_IMAGE ||
+        (state->image_max_decode_bytes > 0 &&
+         entry->size > (u64)state->image_max_decode_bytes)) {
+      continue;
+    }
+
+    thumbnail_job *job = &jobs[count++];
+    PreviewCopyString(job->path, sizeof(job->path), entry->path);
+    job->modified_time = entry->modified_time;
+    job->size = entry->size;
+    job->thumb_size = PreviewThumbnailSize(&fit);
+  }
+
+  /* An empty queue cancels the previous folder's jobs */
+  ThumbnailGen_SetQueue(state->thumbnails, jobs,
+                        count >= PREVIEW_THUMBNAIL_MIN_IMAGES ? count : 0);
+  free(jobs);
+}
+
+static void PreviewPanel_ApplySelection(preview_state *state,
+                                        struct explorer_state_s *explorer) {
+  i32 selection_count = 0;
+  fs_entry *entry = NULL;
+
+  if (explorer) {
+    selection_count = FS_GetSelectionCount(&explorer->fs);
+    entry = FS_GetSelectedEntry(&explorer->fs);
+  }
+
+  if (PreviewEntryEquals(state, selection_count, entry)) {
+    return;
+  }
+
+  PreviewRememberSelection(state, selection_count, entry);
+  state->has_pending_request = false;
+  PreviewPanel_SchedulePrefetch(state, explorer ? &explorer->fs : NULL,
+                                selection_count);
+
+  /* A followed file picks up its own changes (PreviewPanel_UpdateFollow) */
+  if (state->follow && selection_count == 1 && entry && !entry->is_directory &&
+      state->current.type == WB_PREVIEW_CONTENT_TEXT &&
+      !state->current.in_archive &&
+      strcmp(state->current.path, entry->path) == 0) {
+    return;
+  }
+
+  if (selection_count <= 0 || !entry) {
+    state->current_generation++;
+    PreviewPanel_PreserveCurrent(state);
+    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_EMPTY, NULL,
+                             state->current_generation, "No selection");
+    ScrollContainer_Init(&state->scroll);
+    return;
+  }
+
+  if (selection_count > 1) {
+    state->current_generation++;
+    PreviewPanel_PreserveCurrent(state);
+    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_MULTI_SELECTION,
+                             entry, state->current_generation,
+                             "Multiple items selected");
+    ScrollContainer_Init(&state->scroll);
+    return;
+  }
+
+  if (PreviewContentMatches(&state->current, entry) &&
+      (state->current.type == WB_PREVIEW_CONTENT_TEXT ||
+       state->current.type == WB_PREVIEW_CONTENT_HEX ||
+       state->current.type == WB_PREVIEW_CONTENT_IMAGE ||
+       state->current.type == WB_PREVIEW_CONTENT_DIRECTORY ||
+       state->current.type == WB_PREVIEW_CONTENT_METADATA)) {
+    return;
+  }
+
+  {
+    preview_content cached = {0};
+    if (PreviewCache_Take(&state->cache, entry, &cached)) {
+      /* New generation so a load still in flight can't replace it */
+      state->current_generation++;
+      cached.generation = state->current_generation;
+      PreviewPanel_PreserveCurrent(state);
+      PreviewContent_Move(&state->current, &cached);
+      ScrollContainer_Init(&state->scroll);
+      return;
+    }
+  }
+
+  switch (PreviewGetLoadKind(entry)) {
+  case WB_PREVIEW_LOAD_TEXT:
+    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_TEXT,
+                              "Loading text preview...");
+    break;
+  case WB_PREVIEW_LOAD_IMAGE:
+    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_IMAGE,
+                              "Loading image preview...");
+    break;
+  case WB_PREVIEW_LOAD_HEX:
+    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_HEX,
+                              "Loading hex preview...");
+    break;
+  case WB_PREVIEW_LOAD_ARCHIVE:
+    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_ARCHIVE,
+                              "Loading archive...");
+    break;
+  case WB_PREVIEW_LOAD_DIRECTORY:
+    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_DIRECTORY,
+                              "Summarizing folder...");
+    break;
+  case WB_PREVIEW_LOAD_NONE:
+  default:
+    state->current_generation++;
+    PreviewPanel_PreserveCurrent(state);
+    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_METADATA, entry,
+                             state->current_generation, "Preview not available");
+    ScrollContainer_Init(&state->scroll);
+    break;
+  }
+}
+
+static void PreviewPanel_UpdateSplitter(preview_state *state, ui_context *ui) {
+  if (state->last_splitter_bounds.w <= 0 || state->host_bounds.w <= 0) {
+    return;
+  }
+
+  b32 hover = UI_PointInRect(ui->input.mouse_pos, state->last_splitter_bounds);
+  if (!state->dragging_splitter && ui->active == UI_ID_NONE && hover &&
+      ui->input.mouse_pressed[WB_MOUSE_LEFT]) {
+    ui->active = state->splitter_id;
+    state->dragging_splitter = true;
+    state->drag_start_x = (f32)ui->input.mouse_pos.x;
+    state->drag_start_ratio = state->width_ratio;
+  }
+
+  if (ui->active != state->splitter_id) {
+    return;
+  }
+
+  if (ui->input.mouse_down[WB_MOUSE_LEFT]) {
+    i32 usable_width = state->host_bounds.w - PREVIEW_SPLITTER_WIDTH;
+    i32 min_preview = Min(PREVIEW_MIN_WIDTH, Max(usable_width - 1, 0));
+    i32 min_list = Min(PREVIEW_MIN_LIST_WIDTH,
+                       Max(usable_width - min_preview, 0));
+    i32 max_preview = Max(usable_width - min_list, min_preview);
+    i32 right_edge = state->host_bounds.x + state->host_bounds.w;
+    i32 preview_width =
+        right_edge - (ui->input.mouse_pos.x + (PREVIEW_SPLITTER_WIDTH / 2));
+
+    if (usable_width > 0) {
+      preview_width = Clamp(preview_width, min_preview, max_preview);
+      state->width_ratio =
+          (f32)preview_width / (f32)Max(usable_width, 1);
+      state->width_ratio =
+          Clamp(state->width_ratio, PREVIEW_MIN_RATIO, PREVIEW_MAX_RATIO);
+    }
+  } else {
+    ui->active = UI_ID_NONE;
+    state->dragging_splitter = false;
+    Config_SetF64("preview.width_ratio", state->width_ratio);
+    Config_Save();
+  }
+}
+
+static i32 PreviewTextColumns(font *font_to_use, i32 width) {
+  i32 cell_width = Max(Font_MeasureWidth(font_to_use, "M"), 1);
+  return Clamp(width / cell_width, 1, PREVIEW_LINE_BUFFER - 1);
+}
+
+/* End of the row starting at 'at' of a line ending at line_end: as many
+ * codepoints as fit 'columns' cells (at least one), with the zero-width
+ * ones that follow. ASCII takes one byte per cell and skips decoding. */
+static usize PreviewRowEnd(const char *text, usize at, usize line_end,
+                           i32 columns) {
+  usize end = at;
+  i32 used = 0;
+
+  while (end < line_end && end - at + 4 <= PREVIEW_ROW_BYTES) {
+    u32 codepoint = (u8)text[end];
+    i32 length = 1;
+    i32 width = 1;
+
+    if (codepoint >= 0x80) {
+      length = Text_UTF8Decode(text + end, line_end - end, &codepoint);
+      width = Text_CodepointColumns(codepoint);
+    }
+    if (used + width > columns && used > 0) {
+      break;
+    }
+    used += width;
+    end += (usize)length;
+  }
+  return end;
+}
+
+/* Append the rows of text[at..] to the row index */
+static b32 PreviewIndexRows(preview_content *content, usize at) {
+  const char *text = content->text;
+  usize text_len = content->text_len;
+  i32 columns = content->row_columns;
+
+  while (at < text_len) {
+    const char *newline = (const char *)memchr(text + at, '\n', text_len - at);
+    usize line_end = newline ? (usize)(newline - text) : text_len;
+    usize row = at;
+
+    do {
+      if (content->row_count == content->row_capacity) {
+        u32 capacity = content->row_capacity ? content->row_capacity * 2 : 1024;
+        u32 *grown =
+            (u32 *)realloc(content->row_starts, sizeof(u32) * capacity);
+        if (!grown) {
+          content->row_columns = 0; /* Rebuilt on the next render */
+          return false;
+        }
+        content->row_starts = grown;
+        content->row_capacity = capacity;
+      }
+      content->row_starts[content->row_count++] = (u32)row;
+      row = PreviewRowEnd(text, row, line_end, columns);
+    } while (row < line_end);
+
+    at = line_end + 1;
+  }
+
+  return true;
+}
+
+/* Record where every wrapped row starts. Built once per load and wrap
+ * width so drawing only has to touch the rows in the viewport. */
+static b32 PreviewBuildRowIndex(preview_content *content, i32 columns) {
+  content->row_count = 0;
+  content->row_columns = columns;
+  return PreviewIndexRows(content, 0);
+}
+
+/* Make the row index for 'columns' the current one: one kept from an
+ * earlier width if there is, else a new one. The index it replaces is
+ * kept in its place, so going back to a width (toggling the panel,
+ * restoring the window) doesn't wrap the text again. */
+static b32 PreviewUseRowIndex(preview_content *content, i32 columns) {
+  preview_wrap replaced = {content->row_starts, content->row_count,
+                           content->row_capacity, content->row_columns};
+  preview_wrap chosen = {0};
+  i32 slot = PREVIEW_WRAP_CACHE - 1;
+
+  for (i32 i = 0; i < PREVIEW_WRAP_CACHE; i++) {
+    if (content->wraps[i].row_starts && content->wraps[i].columns == columns) {
+      chosen = content->wraps[i];
+      slot = i;
+      break;
+    }
+  }
+
+  if (replaced.columns > 0) {
+    if (!chosen.row_starts) {
+      free(content->wraps[slot].row_starts);
+    }
+    memmove(&content->wraps[1], &content->wraps[0],
+            sizeof(content->wraps[0]) * (usize)slot);
+    content->wraps[0] = replaced;
+  } else {
+    /* Never built or failed: its memory goes to the new index */
+    if (chosen.row_starts) {
+      memmove(&content->wraps[slot], &content->wraps[slot + 1],
+              sizeof(content->wraps[0]) *
+                  (usize)(PREVIEW_WRAP_CACHE - 1 - slot));
+      memset(&content->wraps[PREVIEW_WRAP_CACHE - 1], 0,
+             sizeof(content->wraps[0]));
+      free(replaced.row_starts);
+    } else {
+      chosen.row_starts = replaced.row_starts;
+      chosen.row_capacity = replaced.row_capacity;
+    }
+  }
+
+  content->row_starts = chosen.row_starts;
+  content->row_count = chosen.row_count;
+  content->row_capacity = chosen.row_capacity;
+  if (chosen.columns == columns) {
+    content->row_columns = columns;
+    return true;
+  }
+  return PreviewBuildRowIndex(content, columns);
+}
+
+/* Extend the row index over text appended after old_len */
+static b32 PreviewExtendRowIndex(preview_content *content, usize old_len) {
+  usize at = old_len;
+
+  /* Indexes kept for other widths don't cover the new text */
+  for (i32 i = 0; i < PREVIEW_WRAP_CACHE; i++) {
+    free(content->wraps[i].row_starts);
+  }
+  memset(content->wraps, 0, sizeof(content->wraps));
+
+  if (content->row_columns <= 0) {
+    return true; /* Built on the next render */
+  }
+
+  /* An unterminated last line continues: re-wrap it from its last row */
+  if (content->row_count > 0 && old_len > 0 &&
+      content->text[old_len - 1] != '\n') {
+    at = content->row_starts[--content->row_count];
+  }
+  return PreviewIndexRows(content, at);
+}
+
+/* Draw one wrapped row: at most max_len bytes, cut at the newline */
+static void PreviewDrawRow(ui_context *ui, font *font_to_use, v2i pos,
+                           const char *row, usize max_len) {
+  char buffer[PREVIEW_ROW_BYTES + 1];
+  const char *newline = (const char *)memchr(row, '\n', max_len);
+  usize len = Min(newline ? (usize)(newline - row) : max_len,
+                  (usize)PREVIEW_ROW_BYTES);
+
+  if (len == 0) {
+    return;
+  }
+
+  memcpy(buffer, row, len);
+  buffer[len] = '\0';
+  Render_DrawText(ui->renderer, pos, buffer, font_to_use, ui->theme->text);
+}
+
+/* ===== Syntax Highlighting =====
+ * Rows are drawn from the spans of the line they belong to. A frame lexes
+ * only the lines it shows: the first one's state comes from the line state
+ * cache, the following ones carry it over.
+ */
+
+/* Start of the line containing 'at'. Looks back at most
+ * PREVIEW_MAPPED_BACKSCAN bytes; longer lines are split there. */
+static u64 PreviewLineStart(const preview_content *content, u64 at) {
+  u64 limit = at > PREVIEW_MAPPED_BACKSCAN ? at - PREVIEW_MAPPED_BACKSCAN : 0;
+
+  while (at > limit) {
+    if (content->text[at - 1] == '\n') {
+      return at;
+    }
+    at--;
+  }
+  return limit;
+}
+
+/* The line the rows being drawn belong to */
+typedef struct {
+  b32 valid;
+  b32 plain; /* Too long to highlight */
+  u64 line_start;
+  u64 line_end; /* Its newline, or the end of the text */
+  syntax_state next_state;
+  syntax_span spans[PREVIEW_SYNTAX_SPANS];
+  i32 span_count;
+} preview_syntax_line;
+
+static color PreviewSyntaxColor(const theme *th, syntax_token token) {
+  switch (token) {
+  case SYNTAX_TOKEN_KEYWORD:
+    return th->syntax_keyword;
+  case SYNTAX_TOKEN_TYPE:
+    return th->syntax_type;
+  case SYNTAX_TOKEN_STRING:
+    return th->syntax_string;
+  case SYNTAX_TOKEN_NUMBER:
+    return th->syntax_number;
+  case SYNTAX_TOKEN_COMMENT:
+    return th->syntax_comment;
+  case SYNTAX_TOKEN_META:
+    return th->syntax_meta;
+  case SYNTAX_TOKEN_KEY:
+    return th->syntax_key;
+  default:
+    return th->text;
+  }
+}
+
+/* Lex the line containing the row at 'row_start', unless it is the one
+ * already lexed */
+static void PreviewSyntax_Seek(preview_syntax_line *line,
+                               preview_content *content, u64 row_start) {
+  const char *text = content->text;
+  u64 text_len = content->text_len;
+  syntax_state state;
+
+  if (line->valid && row_start >= line->line_start &&
+      row_start <= line->line_end) {
+    return;
+  }
+
+  u64 start = PreviewLineStart(content, row_start);
+  if (line->valid && !line->plain && start == line->line_end + 1) {
+    state = line->next_state;
+    SyntaxLines_Record(&content->syntax, start, state);
+  } else {
+    state = SyntaxLines_StateAt(&content->syntax, text, (usize)text_len, start);
+  }
+
+  u64 scan = Min(text_len - start, (u64)PREVIEW_SYNTAX_MAX_LINE + 1);
+  const char *newline = (const char *)memchr(text + start, '\n', (usize)scan);
+  line->valid = true;
+  line->line_start = start;
+  line->line_end = newline ? (u64)(newline - text) : start + scan;
+  line->plain = line->line_end - start > PREVIEW_SYNTAX_MAX_LINE;
+  line->span_count = 0;
+  if (!line->plain) {
+    line->next_state = Syntax_TokenizeLine(
+        content->syntax.language, state, text + start,
+        (usize)(line->line_end - start), line->spans, PREVIEW_SYNTAX_SPANS,
+        &line->span_count);
+  }
+}
+
+/* Draw the row at 'row_start' (at most max_len bytes, cut at the newline)
+ * in the colours of its line, one draw per token run */
+static void PreviewDrawSyntaxRow(ui_context *ui, font *font_to_use, v2i pos,
+                                 preview_content *content, u64 row_start,
+                                 usize max_len, preview_syntax_line *line) {
+  char buffer[PREVIEW_ROW_BYTES + 1];
+  const char *text = content->text;
+
+  PreviewSyntax_Seek(line, content, row_start);
+  if (line->plain) {
+    PreviewDrawRow(ui, font_to_use, pos, text + row_start, max_len);
+    return;
+  }
+
+  u64 row_end = Min(row_start + Min(max_len, (usize)PREVIEW_ROW_BYTES),
+                    line->line_end);
+  for (i32 i = 0; i < line->span_count; i++) {
+    const syntax_span *span = &line->spans[i];
+    u64 start = Max(line->line_start + span->start, row_start);
+    u64 end = Min(line->line_start + span->start + span->length, row_end);
+    if (end <= start) {
+      if (line->line_start + span->start >= row_end) {
+        break;
+      }
+      continue;
+    }
+
+    usize len = (usize)(end - start);
+    memcpy(buffer, text + start, len);
+    buffer[len] = '\0';
+    Render_DrawText(ui->renderer, pos, buffer, font_to_use,
+                    PreviewSyntaxColor(ui->theme, span->token));
+    pos.x += Font_MeasureWidth(font_to_use, buffer);
+  }
+}
+
+static b32 PreviewHighlights(const preview_state *state,
+                             const preview_content *content) {
+  return state->syntax_highlight &&
+         content->syntax.language != SYNTAX_LANGUAGE_NONE;
+}
+
+/* Draw the wrapped rows intersecting the viewport */
+static void PreviewDrawTextRows(preview_state *state, ui_context *ui,
+                                rect bounds, font *font_to_use,
+                                f32 scroll_y) {
+  preview_content *content = &state->current;
+  preview_syntax_line line;
+  b32 highlight = PreviewHighlights(state, content);
+  i32 line_height = Max(Font_GetLineHeight(font_to_use), 1);
+  i32 first_row = Max((i32)scroll_y / line_height, 0);
+  i32 last_row = Min(((i32)scroll_y + bounds.h) / line_height + 1,
+                     (i32)content->row_count - 1);
+
+  line.valid = false;
+  for (i32 row = first_row; row <= last_row; row++) {
+    usize start = content->row_starts[row];
+    usize end = (u32)row + 1 < content->row_count
+                    ? content->row_starts[row + 1]
+                    : content->text_len;
+    usize len = end - start;
+    v2i pos = {bounds.x, bounds.y + row * line_height - (i32)scroll_y};
+    if (highlight) {
+      PreviewDrawSyntaxRow(ui, font_to_use, pos, content, start, len, &line);
+    } else {
+      PreviewDrawRow(ui, font_to_use, pos, content->text + start, len);
+    }
+  }
+}
+
+static void PreviewScrollTo(preview_state *state, f32 y) {
+  f32 target = Clamp(y, 0.0f, ScrollContainer_GetMaxScroll(&state->scroll));
+  state->scroll.target_offset.y = target;
+  SmoothValue_SetTarget(&state->scroll.scroll_v, target);
+}
+
+/* ===== Mapped Text and Hex =====
+ * Large files have no row index: the view is a byte offset and rows are
+ * found by walking from it, so a frame only touches the visible window.
+ * The hex view works the same way with fixed PREVIEW_HEX_ROW_BYTES rows.
+ */
+
+static b32 PreviewIsMapped(const preview_content *content) {
+  return (content->type == WB_PREVIEW_CONTENT_TEXT && content->lines) ||
+         content->type == WB_PREVIEW_CONTENT_HEX;
+}
+
+static u64 PreviewMappedNextRow(const preview_content *content, u64 at,
+                                i32 columns) {
+  u64 size = content->text_len;
+  if (at >= size) {
+    return size;
+  }
+  if (content->type == WB_PREVIEW_CONTENT_HEX) {
+    return Min(at + PREVIEW_HEX_ROW_BYTES, size);
+  }
+
+  u64 window = Min((u64)PREVIEW_ROW_BYTES, size - at);
+  const char *newline =
+      (const char *)memchr(content->text + at, '\n', (usize)window);
+  u64 line_end = newline ? (u64)(newline - content->text) : at + window;
+
+  /* A row that fills the width exactly still ends its line */
+  at = PreviewRowEnd(content->text, (usize)at, (usize)line_end, columns);
+  if (at < size && content->text[at] == '\n') {
+    at++;
+  }
+  return at;
+}
+
+static u64 PreviewMappedPrevRow(const preview_content *content, u64 at,
+                                i32 columns) {
+  if (at == 0) {
+    return 0;
+  }
+  if (content->type == WB_PREVIEW_CONTENT_HEX) {
+    return ((at - 1) / PREVIEW_HEX_ROW_BYTES) * PREVIEW_HEX_ROW_BYTES;
+  }
+
+  u64 segment_end = content->text[at - 1] == '\n' ? at - 1 : at;
+  u64 row = PreviewLineStart(content, segment_end);
+  for (;;) {
+    u64 next = PreviewRowEnd(content->text, (usize)row, (usize)segment_end,
+                             columns);
+    if (next >= segment_end || next == row) {
+      return row;
+    }
+    row = next;
+  }
+}
+
+/* Start of the row containing 'at', for offsets from outside the view */
+static u64 PreviewMappedRowStart(const preview_content *content, u64 at) {
+  at = Min(at, (u64)content->text_len);
+  if (content->type == WB_PREVIEW_CONTENT_HEX) {
+    return (at / PREVIEW_HEX_ROW_BYTES) * PREVIEW_HEX_ROW_BYTES;
+  }
+
+  u64 row = PreviewLineStart(content, at);
+  for (;;) {
+    u64 next = PreviewMappedNextRow(content, row, content->row_columns);
+    if (next > at || next == row) {
+      return row;
+    }
+    row = next;
+  }
+}
+
+/* Top row offset that puts the end of the file at the bottom of the view */
+static u64 PreviewMappedEndOffset(const preview_state *state) {
+  const preview_content *content = &state->current;
+  u64 at = content->text_len;
+
+  for (i32 i = 0; i < Max(state->mapped_rows, 1) && at > 0; i++) {
+    at = PreviewMappedPrevRow(content, at, content->row_columns);
+  }
+  return at;
+}
+
+static void PreviewMappedScrollRows(preview_state *state, i32 rows, u64 end) {
+  preview_content *content = &state->current;
+
+  for (; rows > 0 && content->view_offset < end; rows--) {
+    content->view_offset =
+        PreviewMappedNextRow(content, content->view_offset, content->row_columns);
+  }
+  for (; rows < 0 && content->view_offset > 0; rows++) {
+    content->view_offset =
+        PreviewMappedPrevRow(content, content->view_offset, content->row_columns);
+  }
+}
+
+static rect PreviewMappedScrollbar(const preview_state *state, u64 end) {
+  const preview_content *content = &state->current;
+  rect bounds = state->content_bounds;
+  f64 visible = (f64)state->mapped_rows * (f64)content->row_columns /
+                (f64)Max(content->text_len, 1);
+  i32 bar_height =
+      Max((i32)((f64)bounds.h * Min(visible, 1.0)), SCROLL_MIN_BAR_HEIGHT);
+  f64 ratio = end > 0 ? Min((f64)content->view_offset / (f64)end, 1.0) : 0.0;
+  i32 bar_y = bounds.y + (i32)((f64)(bounds.h - bar_height) * ratio);
+
+  return (rect){bounds.x + bounds.w - SCROLL_SCROLLBAR_OFFSET, bar_y,
+                SCROLL_SCROLLBAR_WIDTH, bar_height};
+}
+
+/* Wheel and scrollbar input for mapped text and hex. The pixel scroll
+ * container stays at zero content size so it doesn't react as well. */
+static void PreviewPanel_UpdateMappedScroll(preview_state *state,
+                                            ui_context *ui) {
+  preview_content *content = &state->current;
+  rect bounds = state->content_bounds;
+  ui_id drag_id = UI_GenID("PreviewMappedScrollbar");
+
+  if (!PreviewIsMapped(content) || content->row_columns <= 0 ||
+      state->mapped_rows <= 0) {
+    if (state->mapped_dragging) {
+      state->mapped_dragging = false;
+      ui->active = UI_ID_NONE;
+    }
+    return;
+  }
+
+  u64 end = PreviewMappedEndOffset(state);
+
+  if (state->mapped_dragging) {
+    if (ui->input.mouse_down[WB_MOUSE_LEFT]) {
+      rect bar = PreviewMappedScrollbar(state, end);
+      f64 track = (f64)(bounds.h - bar.h);
+      ui->active = drag_id;
+      if (track > 0) {
+        f64 delta = ((f64)ui->input.mouse_pos.y - state->mapped_drag_start_mouse) /
+                    track * (f64)end;
+        f64 target = (f64)state->mapped_drag_start_offset + delta;
+        target = Clamp(target, 0.0, (f64)end);
+        content->view_offset = (u64)target >= end
+                                   ? end
+                                   : PreviewMappedRowStart(content, (u64)target);
+      }
+    } else {
+      state->mapped_dragging = false;
+      ui->active = UI_ID_NONE;
+    }
+    return;
+  }
+
+  if (!UI_PointInRect(ui->input.mouse_pos, bounds)) {
+    return;
+  }
+
+  if (ui->input.scroll_delta != 0) {
+    f32 pixels = -ui->input.scroll_delta * SCROLL_WHEEL_MULTIPLIER;
+    i32 rows = (i32)(pixels / (f32)Max(state->mapped_line_height, 1));
+    if (rows == 0) {
+      rows = pixels > 0 ? 1 : -1;
+    }
+    PreviewMappedScrollRows(state, rows, end);
+  }
+
+  if (ui->input.mouse_pressed[WB_MOUSE_LEFT] && ui->active == UI_ID_NONE) {
+    rect bar = PreviewMappedScrollbar(state, end);
+    bar.w += 4; /* Hit area padding */
+    if (UI_PointInRect(ui->input.mouse_pos, bar)) {
+      state->mapped_dragging = true;
+      state->mapped_drag_start_mouse = (f32)ui->input.mouse_pos.y;
+      state->mapped_drag_start_offset = content->view_offset;
+      ui->active = drag_id;
+    }
+  }
+}
+
+/* Current line (or indexing progress) for the meta area */
+static void PreviewMappedUpdateDetail(preview_state *state) {
+  preview_content *content = &state->current;
+  b32 complete = false;
+  u64 indexed = LineIndex_GetProgress(content->lines, &complete);
+  i32 percent = (i32)((f64)indexed * 100.0 / (f64)Max(content->text_len, 1));
+  u64 line = 0;
+
+  if (state->pending_jump == WB_PREVIEW_JUMP_LINE) {
+    snprintf(content->detail, sizeof(content->detail),
+             "Indexing to line %llu... %d%%",
+             (unsigned long long)state->pending_jump_value, percent);
+  } else if (LineIndex_LineAt(content->lines, content->view_offset, &line)) {
+    snprintf(content->detail, sizeof(content->detail), "Line %llu",
+             (unsigned long long)(line + 1));
+  } else {
+    snprintf(content->detail, sizeof(content->detail), "Indexing lines... %d%%",
+             percent);
+  }
+}
+
+static void PreviewDrawMappedScrollbar(preview_state *state, ui_context *ui) {
+  rect bar = PreviewMappedScrollbar(state, PreviewMappedEndOffset(state));
+  color bar_color = ui->theme->text_muted;
+  if (state->mapped_dragging) {
+    bar_color.a = 220;
+  } else if (UI_PointInRect(ui->input.mouse_pos, bar)) {
+    bar_color.a = 160;
+  } else {
+    bar_color.a = 100;
+  }
+  Render_DrawRectRounded(ui->renderer, bar, 3.0f, bar_color);
+}
+
+static void PreviewRenderMappedText(preview_state *state, ui_context *ui,
+                                    rect text_bounds, font *text_font,
+                                    i32 columns) {
+  preview_content *content = &state->current;
+  preview_syntax_line line;
+  b32 highlight = PreviewHighlights(state, content);
+  i32 line_height = Max(Font_GetLineHeight(text_font), 1);
+  u64 at = content->view_offset;
+
+  line.valid = false;
+  content->row_columns = columns;
+  state->mapped_rows = Max(text_bounds.h / line_height, 1);
+  state->mapped_line_height = line_height;
+  ScrollContainer_SetContentSize(&state->scroll, 0.0f);
+
+  /* The index only has to keep up with where the user has scrolled */
+  LineIndex_RequestOffset(content->lines, content->view_offset);
+
+  Render_SetClipRect(ui->renderer, text_bounds);
+  for (i32 y = text_bounds.y;
+       y < text_bounds.y + text_bounds.h && at < content->text_len;
+       y += line_height) {
+    u64 next = PreviewMappedNextRow(content, at, columns);
+    usize len = (usize)(next - at);
+    if (highlight) {
+      PreviewDrawSyntaxRow(ui, text_font, (v2i){text_bounds.x, y}, content, at,
+                           len, &line);
+    } else {
+      PreviewDrawRow(ui, text_font, (v2i){text_bounds.x, y},
+                     content->text + at, len);
     }
-    PreviewContent_Clear(&state->current);
-    PreviewContent_Move(&state->current, &result);
-    return;
+    at = next;
   }
+  Render_ResetClipRect(ui->renderer);
 
-  Platform_LockMutex(state->mutex);
-  state->worker_request = *request;
-  state->worker_has_request = true;
-  Platform_CondSignal(state->cond_var);
-  Platform_UnlockMutex(state->mutex);
+  if (content->view_offset > 0 || at < content->text_len) {
+    PreviewDrawMappedScrollbar(state, ui);
+  }
 }
 
-static void PreviewPanel_ConsumeWorkerResult(preview_state *state) {
-  preview_content result = {0};
-  b32 has_result = false;
+/* Format one hex row: offset, 16 bytes split in two groups, then ASCII */
+static usize PreviewFormatHexRow(char *buffer, const u8 *data, u64 at,
+                                 usize count, i32 offset_digits) {
+  static const char digits[] = "0123456789abcdef";
+  usize len = (usize)snprintf(buffer, PREVIEW_LINE_BUFFER, "%0*llx  ",
+                              offset_digits, (unsigned long long)at);
+
+  for (usize i = 0; i < PREVIEW_HEX_ROW_BYTES; i++) {
+    if (i < count) {
+      buffer[len++] = digits[data[i] >> 4];
+      buffer[len++] = digits[data[i] & 0xF];
+    } else {
+      buffer[len++] = ' ';
+      buffer[len++] = ' ';
+    }
+    buffer[len++] = ' ';
+    if (i == PREVIEW_HEX_ROW_BYTES / 2 - 1) {
+      buffer[len++] = ' ';
+    }
+  }
 
-  if (!state->mutex) {
-    return;
+  buffer[len++] = ' ';
+  buffer[len++] = '|';
+  for (usize i = 0; i < count; i++) {
+    buffer[len++] = (data[i] >= 0x20 && data[i] < 0x7F) ? (char)data[i] : '.';
   }
+  buffer[len++] = '|';
+  buffer[len] = '\0';
+  return len;
+}
 
-  Platform_LockMutex(state->mutex);
-  if (state->worker_has_result) {
-    result = state->worker_result;
-    memset(&state->worker_result, 0, sizeof(state->worker_result));
-    state->worker_has_result = false;
-    has_result = true;
+/* Column of byte 'index' of a row in the hex and ASCII parts */
+static i32 PreviewHexByteColumn(i32 offset_digits, usize index) {
+  return offset_digits + 2 + (i32)index * 3 +
+         (index >= PREVIEW_HEX_ROW_BYTES / 2 ? 1 : 0);
+}
+
+static i32 PreviewHexAsciiColumn(i32 offset_digits, usize index) {
+  return PreviewHexByteColumn(offset_digits, PREVIEW_HEX_ROW_BYTES) + 1 +
+         (i32)index;
+}
+
+static void PreviewRenderHex(preview_state *state, ui_context *ui,
+                             rect text_bounds, font *text_font) {
+  preview_content *content = &state->current;
+  const u8 *data = (const u8 *)content->text;
+  i32 line_height = Max(Font_GetLineHeight(text_font), 1);
+  i32 cell_width = Max(Font_MeasureWidth(text_font, "M"), 1);
+  i32 offset_digits = 8;
+  u64 match_end = state->match_offset + state->search_pattern_len;
+  b32 show_match = state->has_match &&
+                   state->search_generation == content->generation;
+  color highlight = ui->theme->accent;
+  u64 at = content->view_offset;
+  char buffer[PREVIEW_LINE_BUFFER];
+
+  while (offset_digits < 16 &&
+         ((u64)(content->text_len - 1) >> (offset_digits * 4)) != 0) {
+    offset_digits++;
+  }
+  highlight.a = 90;
+
+  content->row_columns = PREVIEW_HEX_ROW_BYTES;
+  state->mapped_rows = Max(text_bounds.h / line_height, 1);
+  state->mapped_line_height = line_height;
+  ScrollContainer_SetContentSize(&state->scroll, 0.0f);
+
+  Render_SetClipRect(ui->renderer, text_bounds);
+  for (i32 y = text_bounds.y;
+       y < text_bounds.y + text_bounds.h && at < content->text_len;
+       y += line_height) {
+    usize count = (usize)Min((u64)PREVIEW_HEX_ROW_BYTES, content->text_len - at);
+
+    if (show_match && state->match_offset < at + count && match_end > at) {
+      usize first = (usize)(Max(state->match_offset, at) - at);
+      usize last = (usize)(Min(match_end, at + count) - at) - 1;
+      i32 hex_x = PreviewHexByteColumn(offset_digits, first);
+      i32 hex_end = PreviewHexByteColumn(offset_digits, last) + 2;
+      i32 ascii_x = PreviewHexAsciiColumn(offset_digits, first);
+      i32 ascii_end = PreviewHexAsciiColumn(offset_digits, last) + 1;
+      Render_DrawRect(ui->renderer,
+                      (rect){text_bounds.x + hex_x * cell_width, y,
+                             (hex_end - hex_x) * cell_width, line_height},
+                      highlight);
+      Render_DrawRect(ui->renderer,
+                      (rect){text_bounds.x + ascii_x * cell_width, y,
+                             (ascii_end - ascii_x) * cell_width, line_height},
+                      highlight);
+    }
+
+    PreviewFormatHexRow(buffer, data + at, at, count, offset_digits);
+    Render_DrawText(ui->renderer, (v2i){text_bounds.x, y}, buffer, text_font,
+                    ui->theme->text);
+    at += count;
   }
-  Platform_UnlockMutex(state->mutex);
+  Render_ResetClipRect(ui->renderer);
 
-  if (!has_result) {
-    return;
+  if (content->view_offset > 0 || at < content->text_len) {
+    PreviewDrawMappedScrollbar(state, ui);
   }
+}
 
-  if (result.generation != state->current_generation) {
-    PreviewContent_Clear(&result);
-    return;
+/* Search progress, or the view position in the hex view */
+static void PreviewUpdatePositionDetail(preview_state *state) {
+  preview_content *content = &state->current;
+  b32 searching = state->search_generation == content->generation;
+  i32 percent = 0;
+
+  if (searching && state->search_running) {
+    u64 done = state->search_wrapped
+                   ? content->text_len - state->search_start + state->search_pos
+                   : state->search_pos - state->search_start;
+    percent = (i32)((f64)done * 100.0 / (f64)Max(content->text_len, 1));
+    snprintf(content->detail, sizeof(content->detail), "Searching... %d%%",
+             percent);
+  } else if (searching && state->search_failed) {
+    PreviewCopyString(content->detail, sizeof(content->detail),
+                      "Pattern not found");
+  } else if (searching && state->has_match) {
+    snprintf(content->detail, sizeof(content->detail), "Match at 0x%llx",
+             (unsigned long long)state->match_offset);
+  } else if (content->type == WB_PREVIEW_CONTENT_HEX) {
+    snprintf(content->detail, sizeof(content->detail), "Offset 0x%llx of 0x%llx",
+             (unsigned long long)content->view_offset,
+             (unsigned long long)content->text_len);
+  } else if (content->lines) {
+    PreviewMappedUpdateDetail(state);
   }
+}
 
-  if (PreviewContentIsCacheable(&state->current)) {
-    PreviewContent_Move(&state->previous, &state->current);
+/* Last wrapped row starting at or before 'offset' */
+static u32 PreviewRowAt(const preview_content *content, u64 offset) {
+  u32 low = 0;
+  u32 high = content->row_count - 1;
+
+  while (low < high) {
+    u32 mid = low + (high - low + 1) / 2;
+    if (content->row_starts[mid] <= offset) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
   }
-  PreviewContent_Move(&state->current, &result);
-  ScrollContainer_Init(&state->scroll);
+  return low;
 }
 
-static b32 PreviewContentMatches(const preview_content *content,
-                                 const fs_entry *entry) {
-  if (!content || !entry || !content->path[0]) {
-    return false;
+/* Apply a jump requested through PreviewPanel_Jump. Called once the text
+ * geometry of this frame is known. */
+static void PreviewResolveJump(preview_state *state, font *text_font) {
+  preview_content *content = &state->current;
+  b32 mapped = PreviewIsMapped(content);
+  u64 value = state->pending_jump_value;
+  u64 line = value > 0 ? value - 1 : 0;
+  u64 offset = 0;
+
+  switch (state->pending_jump) {
+  case WB_PREVIEW_JUMP_START:
+    if (mapped) {
+      content->view_offset = 0;
+    } else {
+      PreviewScrollTo(state, 0.0f);
+    }
+    break;
+  case WB_PREVIEW_JUMP_END:
+    if (mapped) {
+      content->view_offset = PreviewMappedEndOffset(state);
+    } else {
+      PreviewScrollTo(state, ScrollContainer_GetMaxScroll(&state->scroll));
+    }
+    break;
+  case WB_PREVIEW_JUMP_LINE:
+    if (content->type == WB_PREVIEW_CONTENT_HEX) {
+      offset = line < content->text_len / PREVIEW_HEX_ROW_BYTES + 1
+                   ? line * PREVIEW_HEX_ROW_BYTES
+                   : content->text_len;
+      content->view_offset = Min(offset, PreviewMappedEndOffset(state));
+    } else if (content->lines) {
+      if (!LineIndex_FindLine(content->lines, line, &offset)) {
+        return; /* Still indexing, try again next frame */
+      }
+      content->view_offset = Min(offset, PreviewMappedEndOffset(state));
+    } else if (content->row_count > 0) {
+      /* Find the line start, then the row starting there */
+      for (u64 i = 0; i < line && offset < content->text_len; i++) {
+        const char *newline = (const char *)memchr(
+            content->text + offset, '\n', content->text_len - (usize)offset);
+        if (!newline || (usize)(newline - content->text) + 1 >= content->text_len) {
+          break;
+        }
+        offset = (u64)(newline - content->text) + 1;
+      }
+      PreviewScrollTo(state, (f32)((i64)PreviewRowAt(content, offset) *
+                                   Font_GetLineHeight(text_font)));
+    }
+    break;
+  case WB_PREVIEW_JUMP_OFFSET:
+    if (mapped) {
+      content->view_offset = Min(PreviewMappedRowStart(content, value),
+                                 PreviewMappedEndOffset(state));
+    } else if (content->row_count > 0) {
+      PreviewScrollTo(state, (f32)((i64)PreviewRowAt(content, value) *
+                                   Font_GetLineHeight(text_font)));
+    }
+    break;
+  case WB_PREVIEW_JUMP_NONE:
+  default:
+    break;
   }
 
-  return strcmp(content->path, entry->path) == 0 && content->size == entry->size &&
-         content->modified_time == entry->modified_time;
+  state->pending_jump = WB_PREVIEW_JUMP_NONE;
 }
 
-static preview_load_kind PreviewGetLoadKind(const fs_entry *entry) {
-  if (!entry) {
-    return WB_PREVIEW_LOAD_NONE;
+/* ===== Follow Mode =====
+ * The folder of the previewed text file is watched. When the file grows,
+ * only the appended bytes are read (or mapped) and indexed, and a view that
+ * was at the bottom stays there. Anything else (truncation, rotation, an
+ * in-memory preview outgrowing the text budget) reloads the preview.
+ */
+
+static void PreviewPanel_Reload(preview_state *state, const file_info *info) {
+  fs_entry entry;
+
+  memset(&entry, 0, sizeof(entry));
+  PreviewCopyString(entry.path, sizeof(entry.path), state->current.path);
+  PreviewCopyString(entry.name, sizeof(entry.name), state->current.name);
+  entry.icon = state->current.icon;
+  entry.size = info->size;
+  entry.modified_time = info->modified_time;
+  PreviewPanel_BeginLoading(state, &entry, WB_PREVIEW_LOAD_TEXT,
+                            "Reloading text preview...");
+}
+
+static b32 PreviewFollowAtBottom(preview_state *state) {
+  if (state->current.lines) {
+    return state->current.row_columns > 0 &&
+           state->current.view_offset >= PreviewMappedEndOffset(state);
   }
-  if (entry->is_directory) {
-    return WB_PREVIEW_LOAD_NONE;
+  return state->scroll.target_offset.y >=
+         ScrollContainer_GetMaxScroll(&state->scroll) - 1.0f;
+}
+
+/* fseek with a 64-bit offset (long is 32 bits on Windows) */
+static b32 PreviewSeek(FILE *file, u64 offset) {
+#if defined(_WIN32)
+  return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+  return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+/* Read the bytes appended to an in-memory preview */
+static b32 PreviewFollowAppendText(preview_content *content, u64 new_size) {
+  usize old_len = content->text_len;
+  usize grow = (usize)(new_size - old_len);
+  usize read_bytes = 0;
+  char *text = (char *)realloc(content->text, old_len + grow + 1);
+
+  if (!text) {
+    return false;
   }
-  if (entry->icon == WB_FILE_ICON_IMAGE) {
-    return WB_PREVIEW_LOAD_IMAGE;
+  content->text = text;
+
+  FILE *file = fopen(content->path, "rb");
+  if (!file) {
+    return false;
   }
-  if (PreviewPathLooksText(entry)) {
-    return WB_PREVIEW_LOAD_TEXT;
+  if (PreviewSeek(file, old_len)) {
+    read_bytes = fread(text + old_len, 1, grow, file);
   }
-  return WB_PREVIEW_LOAD_NONE;
-}
+  fclose(file);
 
-static void PreviewPanel_BeginLoading(preview_state *state, const fs_entry *entry,
-                                      preview_load_kind load_kind,
-                                      const char *detail) {
-  state->current_generation++;
-  PreviewPanel_PreserveCurrent(state);
-  PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_LOADING, entry,
-                           state->current_generation, detail);
-  state->current.load_kind = load_kind;
-  state->has_pending_request = true;
-  memset(&state->pending_request, 0, sizeof(state->pending_request));
-  state->pending_request.generation = state->current_generation;
-  state->pending_request.load_kind = load_kind;
-  PreviewCopyString(state->pending_request.path,
-                    sizeof(state->pending_request.path), entry->path);
-  PreviewCopyString(state->pending_request.name,
-                    sizeof(state->pending_request.name), entry->name);
-  state->pending_request.icon = entry->icon;
-  state->pending_request.is_directory = entry->is_directory;
-  state->pending_request.size = entry->size;
-  state->pending_request.modified_time = entry->modified_time;
-  state->pending_due_time_ms =
-      Platform_GetTimeMs() + (u64)Max(state->selection_debounce_ms, 0);
-  ScrollContainer_Init(&state->scroll);
+  content->text_len = old_len + read_bytes;
+  text[content->text_len] = '\0';
+  PreviewExtendRowIndex(content, old_len);
+  return true;
 }
 
-static void PreviewPanel_ApplySelection(preview_state *state,
-                                        struct explorer_state_s *explorer) {
-  i32 selection_count = 0;
-  fs_entry *entry = NULL;
+/* Map the grown file again; the line index continues where it stopped */
+static b32 PreviewFollowRemap(preview_content *content) {
+  platform_file_map map;
 
-  if (explorer) {
-    selection_count = FS_GetSelectionCount(&explorer->fs);
-    entry = FS_GetSelectedEntry(&explorer->fs);
+  if (!Platform_MapFile(content->path, &map)) {
+    return false;
   }
-
-  if (PreviewEntryEquals(state, selection_count, entry)) {
-    return;
+  if (map.size < content->text_len) {
+    Platform_UnmapFile(&map);
+    return false;
   }
 
-  PreviewRememberSelection(state, selection_count, entry);
-  state->has_pending_request = false;
+  LineIndex_Remap(content->lines, map);
+  content->text = (char *)content->lines->map.data;
+  content->text_len = (usize)content->lines->map.size;
+  return true;
+}
 
-  if (selection_count <= 0 || !entry) {
-    state->current_generation++;
-    PreviewPanel_PreserveCurrent(state);
-    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_EMPTY, NULL,
-                             state->current_generation, "No selection");
-    ScrollContainer_Init(&state->scroll);
+static void PreviewPanel_UpdateFollow(preview_state *state) {
+  preview_content *content = &state->current;
+  char dir[FS_MAX_PATH];
+  b32 started = false;
+  file_info info;
+
+  if (!state->follow || !state->follow_watcher_ready || !content->path[0] ||
+      content->in_archive ||
+      (content->type != WB_PREVIEW_CONTENT_TEXT &&
+       content->type != WB_PREVIEW_CONTENT_LOADING)) {
+    if (state->follow_dir[0]) {
+      FSWatcher_StopWatching(&state->follow_watcher);
+      state->follow_dir[0] = '\0';
+    }
     return;
   }
 
-  if (selection_count > 1) {
-    state->current_generation++;
-    PreviewPanel_PreserveCurrent(state);
-    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_MULTI_SELECTION,
-                             entry, state->current_generation,
-                             "Multiple items selected");
-    ScrollContainer_Init(&state->scroll);
+  if (content->type != WB_PREVIEW_CONTENT_TEXT) {
     return;
   }
 
-  if (PreviewContentMatches(&state->current, entry) &&
-      (state->current.type == WB_PREVIEW_CONTENT_TEXT ||
-       state->current.type == WB_PREVIEW_CONTENT_IMAGE ||
-       state->current.type == WB_PREVIEW_CONTENT_DIRECTORY ||
-       state->current.type == WB_PREVIEW_CONTENT_METADATA)) {
-    return;
+  PreviewCopyString(dir, sizeof(dir), content->path);
+  {
+    char *separator = (char *)FS_FindLastSeparator(dir);
+    if (!separator) {
+      return;
+    }
+    separator[separator == dir ? 1 : 0] = '\0';
   }
 
-  if (PreviewContentMatches(&state->previous, entry)) {
-    preview_content temp = state->current;
-    state->current = state->previous;
-    state->previous = temp;
-    ScrollContainer_Init(&state->scroll);
+  if (strcmp(dir, state->follow_dir) != 0) {
+    /* Remembered even on failure so a bad folder isn't retried per frame */
+    FSWatcher_WatchDirectory(&state->follow_watcher, dir);
+    PreviewCopyString(state->follow_dir, sizeof(state->follow_dir), dir);
+    started = true; /* Catch up on writes made since the load */
+  }
+
+  if (!FSWatcher_Poll(&state->follow_watcher) && !started) {
+    return;
+  }
+  if (!Platform_GetFileInfo(content->path, &info)) {
     return;
   }
 
-  if (entry->is_directory) {
-    state->current_generation++;
-    PreviewPanel_PreserveCurrent(state);
-    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_DIRECTORY, entry,
-                             state->current_generation, "Directory");
-    ScrollContainer_Init(&state->scroll);
+  if (info.size == content->text_len) {
+    if (info.modified_time != content->modified_time && !started) {
+      PreviewPanel_Reload(state, &info); /* Rewritten in place */
+    }
     return;
   }
 
-  switch (PreviewGetLoadKind(entry)) {
-  case WB_PREVIEW_LOAD_TEXT:
-    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_TEXT,
-                              "Loading text preview...");
-    break;
-  case WB_PREVIEW_LOAD_IMAGE:
-    PreviewPanel_BeginLoading(state, entry, WB_PREVIEW_LOAD_IMAGE,
-                              "Loading image preview...");
-    break;
-  case WB_PREVIEW_LOAD_NONE:
-  default:
-    state->current_generation++;
-    PreviewPanel_PreserveCurrent(state);
-    PreviewContent_SetSimple(&state->current, WB_PREVIEW_CONTENT_METADATA, entry,
-                             state->current_generation, "Preview not available");
-    ScrollContainer_Init(&state->scroll);
-    break;
+  b32 at_bottom = PreviewFollowAtBottom(state);
+  b32 appended = false;
+  if (info.size > content->text_len) {
+    if (content->lines) {
+      appended = PreviewFollowRemap(content);
+    } else if (info.size <= (u64)Max(state->text_max_bytes, 1024)) {
+      appended = PreviewFollowAppendText(content, info.size);
+    }
   }
-}
 
-static void PreviewPanel_UpdateSplitter(preview_state *state, ui_context *ui) {
-  if (state->last_splitter_bounds.w <= 0 || state->host_bounds.w <= 0) {
+  if (!appended) {
+    PreviewPanel_Reload(state, &info);
     return;
   }
 
-  b32 hover = UI_PointInRect(ui->input.mouse_pos, state->last_splitter_bounds);
-  if (!state->dragging_splitter && ui->active == UI_ID_NONE && hover &&
-      ui->input.mouse_pressed[WB_MOUSE_LEFT]) {
-    ui->active = state->splitter_id;
-    state->dragging_splitter = true;
-    state->drag_start_x = (f32)ui->input.mouse_pos.x;
-    state->drag_start_ratio = state->width_ratio;
+  content->size = info.size;
+  content->modified_time = info.modified_time;
+  if (at_bottom) {
+    state->pending_jump = WB_PREVIEW_JUMP_END;
   }
+}
 
-  if (ui->active != state->splitter_id) {
+/* ===== Byte Search =====
+ * PreviewPanel_Find scans forward from the view with the vectorized
+ * literal finder, one chunk per frame so the UI stays responsive on files
+ * far larger than RAM, and wraps around at the end.
+ */
+
+static void PreviewPanel_UpdateSearch(preview_state *state) {
+  preview_content *content = &state->current;
+  usize pattern_len = state->search_pattern_len;
+
+  if (!state->search_running) {
+    return;
+  }
+  if (content->generation != state->search_generation || !content->text ||
+      (content->type != WB_PREVIEW_CONTENT_TEXT &&
+       content->type != WB_PREVIEW_CONTENT_HEX)) {
+    state->search_running = false; /* The content went away */
     return;
   }
 
-  if (ui->input.mouse_down[WB_MOUSE_LEFT]) {
-    i32 usable_width = state->host_bounds.w - PREVIEW_SPLITTER_WIDTH;
-    i32 min_preview = Min(PREVIEW_MIN_WIDTH, Max(usable_width - 1, 0));
-    i32 min_list = Min(PREVIEW_MIN_LIST_WIDTH,
-                       Max(usable_width - min_preview, 0));
-    i32 max_preview = Max(usable_width - min_list, min_preview);
-    i32 right_edge = state->host_bounds.x + state->host_bounds.w;
-    i32 preview_width =
-        right_edge - (ui->input.mouse_pos.x + (PREVIEW_SPLITTER_WIDTH / 2));
+  /* Matches starting in [search_pos, limit) are looked for this pass */
+  u64 size = content->text_len;
+  u64 limit = state->search_wrapped ? Min(state->search_start, size) : size;
+  u64 from = Min(state->search_pos, limit);
+  u64 to = Min(from + PREVIEW_SEARCH_CHUNK, limit);
+  u64 window_end = Min(to + pattern_len - 1, size);
+
+  if (from < to) {
+    isize found = ByteScan_FindLiteral(
+        (const u8 *)content->text + from, (usize)(window_end - from),
+        state->search_pattern, pattern_len, false);
+    if (found >= 0) {
+      state->search_running = false;
+      state->has_match = true;
+      state->match_offset = from + (u64)found;
+      PreviewPanel_Jump(state, WB_PREVIEW_JUMP_OFFSET, state->match_offset);
+      return;
+    }
 
-    if (usable_width > 0) {
-      preview_width = Clamp(preview_width, min_preview, max_preview);
-      state->width_ratio =
-          (f32)preview_width / (f32)Max(usable_width, 1);
-      state->width_ratio =
-          Clamp(state->width_ratio, PREVIEW_MIN_RATIO, PREVIEW_MAX_RATIO);
+    /* Searched pages of a mapping are not needed again */
+    if (content->lines) {
+      Platform_ReleaseFileMapRange(&content->lines->map, from, to - from);
+    } else if (content->map.data) {
+      Platform_ReleaseFileMapRange(&content->map, from, to - from);
+    }
+  }
+
+  state->search_pos = to;
+  if (to >= limit) {
+    if (!state->search_wrapped && state->search_start > 0) {
+      state->search_wrapped = true;
+      state->search_pos = 0;
+    } else {
+      state->search_running = false;
+      state->search_failed = true;
     }
-  } else {
-    ui->active = UI_ID_NONE;
-    state->dragging_splitter = false;
-    Config_SetF64("preview.width_ratio", state->width_ratio);
-    Config_Save();
   }
 }
 
@@ -668,6 +2833,7 @@ void PreviewPanel_Update(preview_state *state, ui_context *ui,
                          struct explorer_state_s *explorer,
                          b32 preview_allowed) {
   PreviewPanel_ConsumeWorkerResult(state);
+  PreviewPanel_ConsumePrefetchResults(state);
 
   if (!PreviewPanel_IsVisible(state, preview_allowed)) {
     state->has_pending_request = false;
@@ -678,9 +2844,14 @@ void PreviewPanel_Update(preview_state *state, ui_context *ui,
 
   if (state->content_bounds.w > 0 && state->content_bounds.h > 0) {
     ScrollContainer_Update(&state->scroll, ui, state->content_bounds);
+    PreviewPanel_UpdateMappedScroll(state, ui);
   }
 
   PreviewPanel_ApplySelection(state, explorer);
+  PreviewPanel_CancelStale(state);
+  PreviewPanel_QueueThumbnails(state, explorer ? &explorer->fs : NULL);
+  PreviewPanel_UpdateFollow(state);
+  PreviewPanel_UpdateSearch(state);
 
   if (state->has_pending_request &&
       Platform_GetTimeMs() >= state->pending_due_time_ms) {
@@ -689,54 +2860,6 @@ void PreviewPanel_Update(preview_state *state, ui_context *ui,
   }
 }
 
-static i32 PreviewDrawWrappedText(ui_context *ui, rect bounds, const char *text,
-                                  f32 scroll_y, b32 draw_text) {
-  font *font_to_use = ui->mono_font ? ui->mono_font : ui->font;
-  i32 line_height = Font_GetLineHeight(font_to_use);
-  i32 cell_width = Max(Font_MeasureWidth(font_to_use, "M"), 1);
-  i32 columns = Max(bounds.w / cell_width, 1);
-  i32 total_lines = 0;
-  i32 y = bounds.y - (i32)scroll_y;
-  usize at = 0;
-  usize text_len = strlen(text);
-  char buffer[PREVIEW_LINE_BUFFER];
-
-  while (at < text_len) {
-    i32 out_len = 0;
-    while (at < text_len && text[at] != '\n' && out_len < columns &&
-           out_len < (PREVIEW_LINE_BUFFER - 1)) {
-      buffer[out_len++] = text[at++];
-    }
-    buffer[out_len] = '\0';
-
-    if (draw_text && y + line_height >= bounds.y && y <= bounds.y + bounds.h) {
-      Render_DrawText(ui->renderer, (v2i){bounds.x, y}, buffer, font_to_use,
-                      ui->theme->text);
-    }
-
-    total_lines++;
-    y += line_height;
-
-    if (at < text_len && text[at] == '\n') {
-      at++;
-      if (out_len == 0) {
-        total_lines++;
-        if (draw_text && y + line_height >= bounds.y && y <= bounds.y + bounds.h) {
-          Render_DrawText(ui->renderer, (v2i){bounds.x, y}, "", font_to_use,
-                          ui->theme->text);
-        }
-        y += line_height;
-      }
-    }
-
-    if (out_len == 0 && at < text_len && text[at] != '\n') {
-      at++;
-    }
-  }
-
-  return total_lines * line_height;
-}
-
 static void PreviewRenderMeta(ui_context *ui, rect bounds,
                               const preview_content *content) {
   const theme *th = ui->theme;
@@ -757,6 +2880,7 @@ static void PreviewRenderMeta(ui_context *ui, rect bounds,
                ? "Directory"
                : (content->type == WB_PREVIEW_CONTENT_IMAGE ? "Image"
                   : content->type == WB_PREVIEW_CONTENT_TEXT ? "Text"
+                  : content->type == WB_PREVIEW_CONTENT_HEX  ? "Binary"
                                                              : "File"));
   Render_DrawText(ui->renderer, (v2i){bounds.x, y}, line, ui->font, th->text_muted);
   y += line_height;
@@ -778,8 +2902,8 @@ static void PreviewRenderMeta(ui_context *ui, rect bounds,
   }
 
   if (content->type == WB_PREVIEW_CONTENT_IMAGE && content->img) {
-    snprintf(line, sizeof(line), "Dimensions: %d x %d", content->img->width,
-             content->img->height);
+    snprintf(line, sizeof(line), "Dimensions: %d x %d", content->image_width,
+             content->image_height);
     Render_DrawText(ui->renderer, (v2i){bounds.x, y}, line, ui->font,
                     th->text_muted);
     y += line_height;
@@ -819,20 +2943,59 @@ void PreviewPanel_Render(preview_state *state, ui_context *ui, rect bounds) {
     return;
   }
 
+  if (state->current.type != WB_PREVIEW_CONTENT_TEXT &&
+      state->current.type != WB_PREVIEW_CONTENT_HEX &&
+      state->current.type != WB_PREVIEW_CONTENT_LOADING) {
+    state->pending_jump = WB_PREVIEW_JUMP_NONE;
+  }
+
+  if (state->current.type == WB_PREVIEW_CONTENT_TEXT ||
+      state->current.type == WB_PREVIEW_CONTENT_HEX) {
+    PreviewUpdatePositionDetail(state);
+  }
+
   PreviewRenderMeta(ui, meta_bounds, &state->current);
 
-  if (state->current.type == WB_PREVIEW_CONTENT_TEXT && state->current.text) {
+  if (state->current.type == WB_PREVIEW_CONTENT_HEX && state->current.text) {
+    rect text_bounds = {inner.x, inner.y + meta_height, inner.w,
+                        Max(inner.h - meta_height, 0)};
+    font *text_font = ui->mono_font ? ui->mono_font : ui->font;
+
+    PreviewRenderHex(state, ui, text_bounds, text_font);
+    PreviewResolveJump(state, text_font);
+    return;
+  }
+
+  if ((state->current.type == WB_PREVIEW_CONTENT_TEXT ||
+       state->current.type == WB_PREVIEW_CONTENT_DIRECTORY) &&
+      state->current.text) {
     rect text_bounds = {inner.x, inner.y + meta_height, inner.w,
                         Max(inner.h - meta_height, 0)};
 
+    font *text_font = ui->mono_font ? ui->mono_font : ui->font;
+    i32 columns = PreviewTextColumns(text_font, text_bounds.w);
+
+    if (state->current.lines) {
+      PreviewRenderMappedText(state, ui, text_bounds, text_font, columns);
+      PreviewResolveJump(state, text_font);
+      return;
+    }
+
+    /* A splitter drag rewraps once, when it ends */
+    if (state->current.row_columns != columns &&
+        (!state->dragging_splitter || state->current.row_columns <= 0) &&
+        !PreviewUseRowIndex(&state->current, columns)) {
+      return;
+    }
+
     ScrollContainer_SetContentSize(
         &state->scroll,
-        (f32)PreviewDrawWrappedText(ui, text_bounds, state->current.text,
-                                    state->scroll.offset.y, false));
+        (f32)((i32)state->current.row_count * Font_GetLineHeight(text_font)));
+    PreviewResolveJump(state, text_font);
 
     Render_SetClipRect(ctx, text_bounds);
-    PreviewDrawWrappedText(ui, text_bounds, state->current.text,
-                           state->scroll.offset.y, true);
+    PreviewDrawTextRows(state, ui, text_bounds, text_font,
+                        state->scroll.offset.y);
     Render_ResetClipRect(ctx);
     ScrollContainer_RenderScrollbar(&state->scroll, ui);
     return;
@@ -841,6 +3004,7 @@ void PreviewPanel_Render(preview_state *state, ui_context *ui, rect bounds) {
   if (state->current.type == WB_PREVIEW_CONTENT_IMAGE && state->current.img) {
     rect image_bounds = {inner.x, inner.y + meta_height, inner.w,
                          Max(inner.h - meta_height, 0)};
+    state->image_bounds = image_bounds;
     f32 scale_x = (f32)image_bounds.w / (f32)Max(state->current.img->width, 1);
     f32 scale_y = (f32)image_bounds.h / (f32)Max(state->current.img->height, 1);
     f32 scale = Min(scale_x, scale_y);
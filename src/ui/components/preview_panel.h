@@ -2,7 +2,11 @@
 #define PREVIEW_PANEL_H
 
 #include "../../core/fs.h"
+#include "../../core/fs_watcher.h"
 #include "../../core/image.h"
+#include "../../core/line_index.h"
+#include "../../core/syntax.h"
+#include "../../core/thumbnail_cache.h"
 #include "scroll_container.h"
 
 struct explorer_state_s;
@@ -12,6 +16,7 @@ typedef enum {
   WB_PREVIEW_CONTENT_MULTI_SELECTION,
   WB_PREVIEW_CONTENT_LOADING,
   WB_PREVIEW_CONTENT_TEXT,
+  WB_PREVIEW_CONTENT_HEX,
   WB_PREVIEW_CONTENT_IMAGE,
   WB_PREVIEW_CONTENT_DIRECTORY,
   WB_PREVIEW_CONTENT_METADATA,
@@ -22,8 +27,31 @@ typedef enum {
   WB_PREVIEW_LOAD_NONE,
   WB_PREVIEW_LOAD_TEXT,
   WB_PREVIEW_LOAD_IMAGE,
+  WB_PREVIEW_LOAD_HEX,
+  WB_PREVIEW_LOAD_ARCHIVE, /* Member listing of a zip archive */
+  WB_PREVIEW_LOAD_DIRECTORY, /* Summary of a folder's children */
 } preview_load_kind;
 
+typedef enum {
+  WB_PREVIEW_JUMP_NONE,
+  WB_PREVIEW_JUMP_START,
+  WB_PREVIEW_JUMP_END,
+  WB_PREVIEW_JUMP_LINE,   /* 1-based line (row of 16 bytes in hex view) */
+  WB_PREVIEW_JUMP_OFFSET, /* Byte offset */
+} preview_jump;
+
+#define PREVIEW_HEX_ROW_BYTES 16
+#define PREVIEW_WRAP_CACHE 3 /* Row indexes kept for other wrap widths */
+#define PREVIEW_SEARCH_MAX_PATTERN 128
+
+/* Start of every wrapped row of text at one wrap width */
+typedef struct {
+  u32 *row_starts;
+  u32 row_count;
+  u32 row_capacity;
+  i32 columns;
+} preview_wrap;
+
 typedef struct {
   preview_content_type type;
   preview_load_kind load_kind;
@@ -37,9 +65,44 @@ typedef struct {
   char detail[160];
   char *text;
   usize text_len;
+  i32 image_width;  /* Before downscaling */
+  i32 image_height;
+  u32 *row_starts;  /* Byte offset of every wrapped row of text */
+  u32 row_count;
+  u32 row_capacity;
+  i32 row_columns;  /* Wrap width the row index was built for (0 = none) */
+  preview_wrap wraps[PREVIEW_WRAP_CACHE]; /* Other widths, most recent first */
+  line_index *lines; /* Files over text_max_bytes: text is mapped, not owned */
+  platform_file_map map; /* Hex view: text points into this mapping */
+  u64 view_offset;   /* Mapped text and hex: byte offset of the top row */
+  syntax_lines syntax; /* Text: language and lexer states at line starts */
   image *img;
+  b32 in_archive; /* An archive listing or member: never followed */
+  b32 partial;    /* Folder summary still counting: not cached */
 } preview_content;
 
+#define PREVIEW_CACHE_SLOTS 32
+#define PREVIEW_PREFETCH_MAX 4
+#define PREVIEW_WORKER_MAX 4
+
+/* Previews shown recently, keyed like PreviewContentMatches (path, size and
+ * modified time). The least recently used go first once the entries exceed
+ * max_bytes. */
+typedef struct {
+  preview_content entries[PREVIEW_CACHE_SLOTS];
+  u64 last_used[PREVIEW_CACHE_SLOTS];
+  u64 entry_bytes[PREVIEW_CACHE_SLOTS];
+  i32 count;
+  u64 bytes;
+  u64 max_bytes; /* preview.cache.max_bytes */
+  u64 clock;
+
+  /* Counters for tuning */
+  u32 hits;
+  u32 misses;
+  u32 evictions;
+} preview_cache;
+
 typedef struct {
   u64 generation;
   preview_load_kind load_kind;
@@ -49,15 +112,37 @@ typedef struct {
   b32 is_directory;
   u64 size;
   u64 modified_time;
+  i32 image_fit_width; /* Images are downscaled to fit this box */
+  i32 image_fit_height;
 } preview_request;
 
+struct preview_state_s;
+
+/* One loading thread and the request it is working on */
 typedef struct {
+  struct preview_state_s *owner;
+  void *thread;
+  b32 busy;
+  b32 is_prefetch;
+  b32 cancelled; /* The UI moved on; checked between chunks of work */
+  preview_request request;
+} preview_worker;
+
+typedef struct preview_state_s {
   b32 enabled;
   f32 width_ratio;
   i64 text_max_bytes;
   i64 image_max_decode_bytes;
   i64 image_max_dimension;
+  i64 image_thumbnail_size;
+  b32 thumbnail_cache; /* Use the shared freedesktop thumbnail cache */
   i64 selection_debounce_ms;
+  b32 follow; /* Keep previewed text files live as they grow */
+  i64 prefetch_ahead; /* Neighbours loaded ahead of the selection */
+  i64 worker_threads; /* preview.workers, read once at init */
+  b32 syntax_highlight;
+  i64 directory_budget_ms; /* Time a folder summary may count for */
+  i64 archive_max_member_bytes; /* Largest member inflated to preview */
 
   ui_id splitter_id;
   b32 dragging_splitter;
@@ -65,9 +150,43 @@ typedef struct {
   f32 drag_start_ratio;
   rect host_bounds;
   rect content_bounds;
+  rect image_bounds; /* Area images were last drawn into */
   rect last_splitter_bounds;
   scroll_container_state scroll;
 
+  /* Mapped text and hex scroll by rows, not pixels (geometry of the last
+   * render) */
+  i32 mapped_rows;
+  i32 mapped_line_height;
+  b32 mapped_dragging;
+  f32 mapped_drag_start_mouse;
+  u64 mapped_drag_start_offset;
+
+  /* Follow mode: the folder of the previewed file is watched */
+  fs_watcher follow_watcher;
+  b32 follow_watcher_ready;
+  char follow_dir[FS_MAX_PATH];
+
+  /* Jump requested from a command, resolved on the next render */
+  preview_jump pending_jump;
+  u64 pending_jump_value;
+
+  /* Byte search over the previewed content, a chunk per frame */
+  u8 search_pattern[PREVIEW_SEARCH_MAX_PATTERN];
+  usize search_pattern_len;
+  u64 search_generation; /* Content the search runs over */
+  b32 search_running;
+  u64 search_start; /* Wraps around the end back to here */
+  u64 search_pos;
+  b32 search_wrapped;
+  b32 search_failed;
+  b32 has_match;
+  u64 match_offset;
+
+  /* Selection index last seen, for the direction of travel */
+  i32 observed_index;
+  i32 travel;
+
   i32 observed_selection_count;
   char observed_path[FS_MAX_PATH];
   u64 observed_size;
@@ -79,7 +198,10 @@ typedef struct {
   preview_request pending_request;
   u64 pending_due_time_ms;
 
-  void *thread;
+  /* Loading threads. A new request cancels the ones still working on
+   * stale requests; the newest result wins. */
+  preview_worker workers[PREVIEW_WORKER_MAX];
+  i32 worker_count;
   void *mutex;
   void *cond_var;
   b32 shutdown_requested;
@@ -88,8 +210,23 @@ typedef struct {
   b32 worker_has_result;
   preview_content worker_result;
 
+  /* Speculative loads of the selection's neighbours, taken only by idle
+   * workers, text first; results go to the cache */
+  preview_request prefetch_queue[PREVIEW_PREFETCH_MAX];
+  i32 prefetch_count;
+  i32 prefetch_next;
+  i32 prefetch_in_flight;
+  preview_content prefetch_results[PREVIEW_PREFETCH_MAX];
+  i32 prefetch_result_count;
+
   preview_content current;
-  preview_content previous;
+  preview_cache cache;
+
+  /* Thumbnails of a folder of images are generated ahead of time, once
+   * per listing */
+  thumbnail_generator *thumbnails;
+  char thumbnail_dir[FS_MAX_PATH];
+  u32 thumbnail_dir_generation;
 } preview_state;
 
 void PreviewPanel_Init(preview_state *state);
@@ -99,6 +236,15 @@ void PreviewPanel_Update(preview_state *state, ui_context *ui,
                          struct explorer_state_s *explorer,
                          b32 preview_allowed);
 void PreviewPanel_Render(preview_state *state, ui_context *ui, rect bounds);
+/* Toggle follow mode (persisted as preview.follow) */
+void PreviewPanel_ToggleFollow(preview_state *state);
+/* Jump the preview to its start, its end, a 1-based line or a byte offset.
+ * On large files a line past the indexed part is reached once indexing gets
+ * there. */
+void PreviewPanel_Jump(preview_state *state, preview_jump jump, u64 value);
+/* Find the next occurrence of a byte pattern after the current match (or
+ * the top of the view), wrapping around at the end */
+void PreviewPanel_Find(preview_state *state, const u8 *pattern, usize length);
 b32 PreviewPanel_IsVisible(preview_state *state, b32 preview_allowed);
 void PreviewPanel_ComputeBounds(preview_state *state, rect bounds,
                                 rect *out_list_bounds,
@@ -8,6 +8,7 @@
 #include "../../core/input.h"
 #include "../../core/text.h"
 #include "../../core/theme.h"
+#include <stdio.h>
 #include <string.h>
 
 /* ===== Configuration ===== */
@@ -247,6 +248,15 @@ void QuickFilter_Render(quick_filter_state *state, ui_context *ui,
   Render_DrawRectRounded(renderer, hint_bg, 4.0f, hint_bg_color);
 
   Render_DrawText(renderer, hint_pos, hint, f, hint_color);
+
+  /* Progress text left of the hint */
+  if (state->status[0] != '\0') {
+    i32 status_width = Font_MeasureWidth(f, state->status);
+    v2i status_pos = {hint_bg.x - status_width - FILTER_PADDING, text_y};
+    color status_color = th->text_muted;
+    status_color.a = (u8)(status_color.a * fade);
+    Render_DrawText(renderer, status_pos, state->status, f, status_color);
+  }
 }
 
 /* ===== Utility ===== */
@@ -254,6 +264,7 @@ void QuickFilter_Render(quick_filter_state *state, ui_context *ui,
 /* Clear the filter and hide the UI */
 void QuickFilter_Clear(quick_filter_state *state) {
   state->buffer[0] = '\0';
+  state->status[0] = '\0';
   state->input_state.cursor_pos = 0;
   state->input_state.selection_start = -1;
   state->active = false;
@@ -279,6 +290,10 @@ void QuickFilter_SetBuffer(quick_filter_state *state, const char *text) {
   state->fade_anim.target = 1.0f;
 }
 
+void QuickFilter_SetStatus(quick_filter_state *state, const char *status) {
+  snprintf(state->status, sizeof(state->status), "%s", status);
+}
+
 b32 QuickFilter_IsActive(quick_filter_state *state) { return state->active; }
 
 const char *QuickFilter_GetQuery(quick_filter_state *state) {
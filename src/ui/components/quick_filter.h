@@ -30,6 +30,9 @@ typedef struct {
   /* State flags */
   b32 active; /* Filter is currently active (has content) */
 
+  /* Progress text shown next to the input (e.g. recursive matches) */
+  char status[64];
+
   /* Cached bounds for rendering */
   rect bounds;
 } quick_filter_state;
@@ -55,6 +58,9 @@ void QuickFilter_ClearBuffer(quick_filter_state *state);
 /* Set the filter buffer text and force active */
 void QuickFilter_SetBuffer(quick_filter_state *state, const char *text);
 
+/* Set the progress text shown at the right of the bar ("" to hide) */
+void QuickFilter_SetStatus(quick_filter_state *state, const char *status);
+
 /* Check if filter is currently active (has content) */
 b32 QuickFilter_IsActive(quick_filter_state *state);
 
@@ -6,7 +6,10 @@
  */
 
 #include "terminal_panel.h"
+#include "text_input.h"
+#include "../../config/config.h"
 #include "../../core/input.h"
+#include "../../core/text.h"
 #include "../../core/theme.h"
 #include "../../platform/platform.h"
 #include "../../renderer/renderer.h"
@@ -19,6 +22,10 @@
 #define TERMINAL_DEFAULT_ROWS 24
 #define TERMINAL_DEFAULT_HEIGHT_RATIO 0.35f
 
+/* Search bar */
+#define TERMINAL_SEARCH_BAR_WIDTH 320
+#define TERMINAL_SEARCH_BAR_PADDING 6
+
 /* 16-color ANSI palette (matches common terminal colors) */
 static const color ansi_colors[16] = {
     {30, 30, 30, 255},    /* 0: Black */
@@ -87,6 +94,17 @@ void TerminalPanel_Init(terminal_panel_state *state) {
 #endif
   state->suggestions = Suggestion_Create(NULL); /* Default history path */
   state->selection_scroll_accumulator = 0.0f;
+  TerminalPanel_RefreshConfig(state);
+}
+
+void TerminalPanel_RefreshConfig(terminal_panel_state *state) {
+  i64 lines = Config_GetI64("terminal.scrollback_lines",
+                            TERMINAL_SCROLLBACK_LINES);
+  state->scrollback_lines =
+      (u32)Min(Max(lines, 0), (i64)SCROLLBACK_MAX_LINES);
+  if (state->terminal) {
+    Terminal_SetScrollbackLines(state->terminal, state->scrollback_lines);
+  }
 }
 
 void TerminalPanel_Destroy(terminal_panel_state *state) {
@@ -102,6 +120,59 @@ void TerminalPanel_Destroy(terminal_panel_state *state) {
     Suggestion_Destroy(state->suggestions);
     state->suggestions = NULL;
   }
+
+  TerminalSearch_Reset(&state->search);
+}
+
+void TerminalPanel_OpenSearch(terminal_panel_state *state) {
+  if (!state || !state->terminal || !state->visible)
+    return;
+
+  state->search_open = true;
+  state->search_input.selection_start = -1;
+  state->search_input.cursor_pos = Text_UTF8Length(state->search_buffer);
+  state->search_input.cursor_blink = 0.0f;
+}
+
+static void TerminalPanel_CloseSearch(terminal_panel_state *state) {
+  state->search_open = false;
+  state->search_buffer[0] = '\0';
+  state->search_input.cursor_pos = 0;
+  state->search_input.selection_start = -1;
+  TerminalSearch_Reset(&state->search);
+  if (state->terminal) {
+    state->terminal->dirty = true;
+  }
+}
+
+/* Keys for the open search bar: typing searches as you go, Enter or Up
+ * moves to the previous (older) match, Shift+Enter or Down to the next */
+static void TerminalPanel_UpdateSearchInput(terminal_panel_state *state,
+                                            ui_context *ui, f32 dt) {
+  Terminal *term = state->terminal;
+  u32 mods = Input_GetModifiers();
+
+  if (Input_KeyPressed(WB_KEY_ESCAPE)) {
+    TerminalPanel_CloseSearch(state);
+  } else if (Input_KeyPressed(WB_KEY_RETURN)) {
+    TerminalSearch_Next(&state->search, term, !(mods & MOD_SHIFT));
+  } else if (Input_KeyRepeat(WB_KEY_UP)) {
+    TerminalSearch_Next(&state->search, term, true);
+  } else if (Input_KeyRepeat(WB_KEY_DOWN)) {
+    TerminalSearch_Next(&state->search, term, false);
+  } else if (UI_ProcessTextInput(&state->search_input, state->search_buffer,
+                                 sizeof(state->search_buffer), &ui->input) &&
+             strcmp(state->search_buffer, state->search.query) != 0) {
+    TerminalSearch_SetQuery(&state->search, term, state->search_buffer);
+  }
+
+  state->search_input.cursor_blink += dt * 2.0f;
+  if (state->search_input.cursor_blink > 2.0f) {
+    state->search_input.cursor_blink -= 2.0f;
+  }
+
+  Input_ConsumeKeys();
+  Input_ConsumeText();
 }
 
 void TerminalPanel_Toggle(terminal_panel_state *state, const char *cwd) {
@@ -121,6 +192,7 @@ void TerminalPanel_Toggle(terminal_panel_state *state, const char *cwd) {
       state->terminal =
           Terminal_Create(TERMINAL_DEFAULT_COLS, TERMINAL_DEFAULT_ROWS);
       if (state->terminal) {
+        Terminal_SetScrollbackLines(state->terminal, state->scrollback_lines);
         const char *shell = NULL;
         if (state->shell_mode == WB_SHELL_FISH) {
           shell = "fish";
@@ -141,7 +213,6 @@ void TerminalPanel_Toggle(terminal_panel_state *state, const char *cwd) {
 
 void TerminalPanel_Update(terminal_panel_state *state, ui_context *ui, f32 dt,
                           b32 is_active, f32 available_height) {
-  (void)ui; /* Used to be for ui->input, now using centralized Input_* API */
   if (!state)
     return;
 
@@ -344,6 +415,25 @@ void TerminalPanel_Update(terminal_panel_state *state, ui_context *ui, f32 dt,
     Terminal_Update(state->terminal);
   }
 
+  /* ===== Scrollback Search ===== */
+  if (state->has_focus && state->terminal &&
+      Input_HasFocus(WB_INPUT_TARGET_TERMINAL)) {
+    u32 mods = Input_GetModifiers();
+    if (Input_KeyPressed(WB_KEY_F) && (mods & MOD_CTRL) &&
+        (mods & MOD_SHIFT)) {
+      TerminalPanel_OpenSearch(state);
+      Input_ConsumeKeys();
+      Input_ConsumeText();
+    } else if (state->search_open) {
+      TerminalPanel_UpdateSearchInput(state, ui, dt);
+    }
+  }
+
+  /* A search through a long scrollback runs a slice per frame */
+  if (state->terminal && state->search_open) {
+    TerminalSearch_Update(&state->search, state->terminal);
+  }
+
   /* Handle keyboard input when focused */
   if (state->has_focus && state->terminal &&
       Terminal_IsAlive(state->terminal) &&
@@ -691,12 +781,33 @@ void TerminalPanel_Render(terminal_panel_state *state, ui_context *ui,
   u32 rows = state->terminal->rows;
   u32 cols = state->terminal->cols;
 
+  const u8 *marks =
+      state->search_open
+          ? TerminalSearch_MarkViewport(&state->search, state->terminal)
+          : NULL;
+
   for (u32 y = 0; y < rows && y < visible_rows; y++) {
     for (u32 x = 0; x < cols && x < visible_cols; x++) {
       const terminal_cell *cell = Terminal_GetCell(state->terminal, x, y);
       if (!cell)
         continue;
 
+      /* A wide character is drawn with its spacer, which must not paint
+       * over the glyph's right half; an orphaned spacer draws as a blank */
+      i32 span = 1;
+      if (cell->codepoint == TERM_WIDE_SPACER && x > 0) {
+        const terminal_cell *lead =
+            Terminal_GetCell(state->terminal, x - 1, y);
+        if (lead && lead->codepoint != TERM_WIDE_SPACER &&
+            Text_CodepointColumns(lead->codepoint) == 2)
+          continue;
+      } else if (x + 1 < cols && x + 1 < visible_cols) {
+        const terminal_cell *next =
+            Terminal_GetCell(state->terminal, x + 1, y);
+        if (next && next->codepoint == TERM_WIDE_SPACER)
+          span = 2;
+      }
+
       i32 px = content.x + (i32)x * cell_width;
       i32 py = content.y + (i32)y * cell_height;
 
@@ -715,7 +826,7 @@ void TerminalPanel_Render(terminal_panel_state *state, ui_context *ui,
       /* Draw background if not default OR selected */
       b32 selected = Terminal_IsCellSelected(state->terminal, x, y);
       if (attr.bg != TERM_DEFAULT_BG || attr.reverse || selected) {
-        rect cell_rect = {px, py, cell_width, cell_height};
+        rect cell_rect = {px, py, cell_width * span, cell_height};
         color actual_bg = bg_cell;
         if (selected) {
           /* Highlight color: light blue with some transparency */
@@ -724,11 +835,20 @@ void TerminalPanel_Render(terminal_panel_state *state, ui_context *ui,
         Render_DrawRect(r, cell_rect, actual_bg);
       }
 
+      /* Search matches, the current one brighter */
+      if (marks && marks[y * cols + x] != TERMINAL_SEARCH_MARK_NONE) {
+        rect mark_rect = {px, py, cell_width * span, cell_height};
+        color mark_color = th->accent;
+        mark_color.a =
+            marks[y * cols + x] == TERMINAL_SEARCH_MARK_CURRENT ? 200 : 90;
+        Render_DrawRect(r, mark_rect, mark_color);
+      }
+
       /* Draw cursor */
       if (Terminal_IsCursorAt(state->terminal, x, y) && state->has_focus) {
         b32 cursor_visible = state->cursor_blink.current > 0.5f;
         if (cursor_visible) {
-          rect cursor_rect = {px, py, cell_width, cell_height};
+          rect cursor_rect = {px, py, cell_width * span, cell_height};
           color cursor_color = th->accent;
           Render_DrawRect(r, cursor_rect, cursor_color);
           /* Invert text on cursor */
@@ -736,14 +856,15 @@ void TerminalPanel_Render(terminal_panel_state *state, ui_context *ui,
         }
       }
 
-      /* Draw character */
+      /* Draw character (a wide one covers its spacer cell too) */
       u32 cp = cell->codepoint;
       if (cp > 32 && cp < 127) {
         char str[2] = {(char)cp, '\0'};
         v2i char_pos = {px, py};
         Render_DrawText(r, char_pos, str, mono_font, fg);
-      } else if (cp > 127) {
-        char str[2] = {'?', '\0'};
+      } else if (cp > 127 && cp != TERM_WIDE_SPACER) {
+        char str[5];
+        str[Text_UTF8Encode(cp, str)] = '\0';
         v2i char_pos = {px, py};
         Render_DrawText(r, char_pos, str, mono_font, fg);
       }
@@ -785,6 +906,59 @@ void TerminalPanel_Render(terminal_panel_state *state, ui_context *ui,
     }
   }
 
+  /* ===== Search Bar ===== */
+  if (state->search_open && ui->font) {
+    font *f = ui->font;
+    i32 line_height = Font_GetLineHeight(f);
+    i32 bar_height = line_height + TERMINAL_SEARCH_BAR_PADDING * 2;
+    i32 bar_width = TERMINAL_SEARCH_BAR_WIDTH;
+    if (bar_width > content.w)
+      bar_width = content.w;
+    rect bar = {content.x + content.w - bar_width, content.y, bar_width,
+                bar_height};
+
+    rect border_rect = {bar.x - 1, bar.y - 1, bar.w + 2, bar.h + 2};
+    color border = th->accent;
+    border.a = 200;
+    Render_DrawRectRounded(r, border_rect, th->radius_md + 1, border);
+
+    color bar_bg = th->panel;
+    bar_bg.a = 240;
+    Render_DrawRectRounded(r, bar, th->radius_md, bar_bg);
+
+    const char *status = NULL;
+    if (state->search.running)
+      status = "Searching...";
+    else if (state->search.failed)
+      status = "No matches";
+
+    i32 status_width = status ? Font_MeasureWidth(f, status) : 0;
+    rect text_bounds = {bar.x + TERMINAL_SEARCH_BAR_PADDING, bar.y,
+                        bar.w - TERMINAL_SEARCH_BAR_PADDING * 3 - status_width,
+                        bar.h};
+    v2i text_pos = {text_bounds.x, bar.y + TERMINAL_SEARCH_BAR_PADDING};
+
+    Render_SetClipRect(r, text_bounds);
+    if (state->search_buffer[0] != '\0') {
+      Render_DrawText(r, text_pos, state->search_buffer, f, th->text);
+    } else {
+      Render_DrawText(r, text_pos, "Find in terminal...", f, th->text_muted);
+    }
+    if (state->has_focus && state->search_input.cursor_blink < 1.0f) {
+      UI_DrawTextCursor(r, f, state->search_buffer,
+                        state->search_input.cursor_pos, text_bounds,
+                        th->accent, 2, line_height);
+    }
+    Render_ResetClipRect(r);
+
+    if (status) {
+      v2i status_pos = {bar.x + bar.w - TERMINAL_SEARCH_BAR_PADDING -
+                            status_width,
+                        text_pos.y};
+      Render_DrawText(r, status_pos, status, f, th->text_muted);
+    }
+  }
+
   /* ===== Scrollbar ===== */
   if (state->terminal->scrollback_count > 0) {
     i32 sb_width = 12;
@@ -10,7 +10,9 @@
 
 #include "../../core/animation.h"
 #include "../../core/types.h"
+#include "../../terminal/scrollback.h"
 #include "../../terminal/suggestion.h"
+#include "../../terminal/terminal_search.h"
 #include "../../terminal/terminal.h"
 #include "../ui.h"
 
@@ -33,12 +35,19 @@ typedef struct {
   rect last_bounds;   /* Panel bounds from last render (for click detection) */
 
   ShellMode shell_mode; /* Current shell mode */
+  u32 scrollback_lines; /* From terminal.scrollback_lines */
 
   /* Suggestion engine state */
   SuggestionEngine *suggestions;
   Suggestion current_suggestion;
   char last_input[1024]; /* Last input we generated suggestion for */
 
+  /* Scrollback search bar (Ctrl+Shift+F) */
+  b32 search_open;
+  char search_buffer[TERMINAL_SEARCH_MAX_QUERY];
+  ui_text_state search_input;
+  TerminalSearch search;
+
   /* Selection scrolling */
   f32 selection_scroll_accumulator; /* Accumulates scroll distance during
                                        selection drags */
@@ -54,6 +63,9 @@ typedef struct {
 /* Initialize terminal panel state */
 void TerminalPanel_Init(terminal_panel_state *state);
 
+/* Re-read terminal settings from config */
+void TerminalPanel_RefreshConfig(terminal_panel_state *state);
+
 /* Destroy terminal panel and free resources */
 void TerminalPanel_Destroy(terminal_panel_state *state);
 
@@ -76,6 +88,9 @@ i32 TerminalPanel_GetHeight(terminal_panel_state *state, i32 available_height);
 /* Check if terminal is visible */
 b32 TerminalPanel_IsVisible(terminal_panel_state *state);
 
+/* Open the search bar over the terminal's output */
+void TerminalPanel_OpenSearch(terminal_panel_state *state);
+
 /* Focus the terminal for keyboard input */
 void TerminalPanel_Focus(terminal_panel_state *state);
 
@@ -9,6 +9,7 @@
 #include "components/dialog.h"
 #include "components/progress_bar.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #define SPLITTER_WIDTH 4.0f
@@ -66,11 +67,26 @@ void Layout_Init(layout_state *layout, memory_arena *arena) {
   
   /* Initialize notification system */
   Notification_Init(&layout->notifications);
+
+  /* Frecency log lives next to the config file */
+  char frecency_path[FS_MAX_PATH];
+  const char *config_path = Config_GetPath();
+  const char *separator = FS_FindLastSeparator(config_path);
+  if (separator) {
+    snprintf(frecency_path, sizeof(frecency_path), "%.*s%s",
+             (int)(separator - config_path + 1), config_path, "frecency");
+  } else {
+    snprintf(frecency_path, sizeof(frecency_path), "frecency");
+  }
+  Frecency_Init(&layout->frecency, frecency_path);
 }
 
 void Layout_Shutdown(layout_state *layout) {
+  Explorer_Shutdown(&layout->panels[0].explorer);
+  Explorer_Shutdown(&layout->panels[1].explorer);
   PreviewPanel_Shutdown(&layout->preview);
   TaskQueue_Shutdown(&layout->tasks);
+  Frecency_Shutdown(&layout->frecency);
 }
 
 void Layout_RefreshConfig(layout_state *layout) {
@@ -82,6 +98,7 @@ void Layout_RefreshConfig(layout_state *layout) {
     /* Config_Poll happens before update/render, so checking directory again
        to handle new file visibility */
     Explorer_Refresh(&layout->panels[i].explorer);
+    TerminalPanel_RefreshConfig(&layout->panels[i].terminal);
   }
 
   PreviewPanel_RefreshConfig(&layout->preview);
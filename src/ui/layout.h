@@ -8,6 +8,7 @@
 #ifndef LAYOUT_H
 #define LAYOUT_H
 
+#include "../core/frecency.h"
 #include "../core/task_queue.h"
 #include "../core/types.h"
 #include "../renderer/renderer.h"
@@ -73,6 +74,9 @@ typedef struct layout_state_s {
   
   /* Notification system */
   notification_state notifications;
+
+  /* Visit history used to rank filter and palette matches */
+  frecency_db frecency;
 } layout_state;
 
 #define MIN_PANEL_WIDTH 100.0f
@@ -8,14 +8,25 @@
 #include "core/animation.c"
 #include "core/args.c"
 #include "core/assets_embedded.c"
+#include "core/byte_scan.c"
+#include "core/content_search.c"
+#include "core/frecency.c"
 #include "core/fs.c"
 #include "core/image.c"
 #include "core/fuzzy_match.c"
+#include "core/fuzzy_filter.c"
 #include "core/input.c"
 #include "core/key_repeat.c"
+#include "core/line_index.c"
+#include "core/syntax.c"
 #include "core/task_queue.c"
 #include "core/text.c"
 #include "core/theme.c"
+#include "core/thumbnail_cache.c"
+#include "core/thumbnail_pool.c"
+#include "core/tree_filter.c"
+#include "core/trigram_index.c"
+#include "core/zip_archive.c"
 
 /* === Platform (Windows) === */
 #include "platform/windows/windows_clipboard.c"
@@ -60,7 +71,9 @@
 #include "terminal/ansi_parser.c"
 #include "terminal/command_history.c"
 #include "terminal/suggestion.c"
+#include "terminal/scrollback.c"
 #include "terminal/terminal.c"
+#include "terminal/terminal_search.c"
 
 /* === Config === */
 #include "config/config.c"